@@ -18,7 +18,10 @@
 
 #include <algorithm>
 #include <set>
+#include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "analyzers/examples/account_access_defs.h"
 #include "base/vector.h"
@@ -30,9 +33,35 @@ namespace {
 const int kMaxMalformedLines = 1000000;
 const char kNullAccessGraphErr[] = "The access graph is null.";
 
+// The positions of the columns in the records of the projected input.
+enum Column {
+  kActorColumn,
+  kActorTitleColumn,
+  kActorManagerColumn,
+  kNumAccessesColumn,
+  kUserColumn,
+};
+
 }  // namespace
 
 namespace morphie {
+
+namespace {
+
+// The names of the projected columns in the order of the Column enum.
+const char* const kColumnNames[] = {access::kActor, access::kActorTitle,
+                                    access::kActorManager, access::kNumAccesses,
+                                    access::kUser};
+
+// The partial graph and the line counts of a worker thread.
+struct PartialGraph {
+  std::unique_ptr<AccountAccessGraph> graph;
+  int num_lines_read = 0;
+  int num_lines_skipped = 0;
+};
+
+}  // namespace
+
 // This function performs a series of checks, described by the error message
 // generated if the check fails.
 util::Status AccessAnalyzer::Initialize(
@@ -42,7 +71,16 @@ util::Status AccessAnalyzer::Initialize(
   if (row_it == csv_parser_->end()) {
     return util::Status(Code::INVALID_ARGUMENT, "The input is empty.");
   }
-  util::Status status = InitializeFieldMap();
+  util::Status status = InitializeFieldMap(row_it->fields());
+  if (!status.ok()) {
+    return status;
+  }
+  std::vector<util::ColumnSpec> columns;
+  for (const char* name : kColumnNames) {
+    columns.push_back({name, util::ColumnType::kString});
+  }
+  columns[kNumAccessesColumn].type = util::ColumnType::kInt64;
+  status = csv_parser_->Project(columns);
   if (!status.ok()) {
     return status;
   }
@@ -53,6 +91,31 @@ util::Status AccessAnalyzer::Initialize(
   return util::Status::OK;
 }
 
+// The header is parsed on its own, so that the field map is known before the
+// workers start.
+util::Status AccessAnalyzer::Initialize(std::istream* input, char delim,
+                                        int num_threads, size_t chunk_size) {
+  std::unique_ptr<std::istream> input_owner(input);
+  string header;
+  if (input == nullptr || !std::getline(*input, header)) {
+    return util::Status(Code::INVALID_ARGUMENT, "The input is empty.");
+  }
+  util::CSVParser header_parser(new std::istringstream(header), delim);
+  if (header_parser.begin() == header_parser.end()) {
+    return util::Status(Code::INVALID_ARGUMENT, "First line has no columns.");
+  }
+  util::Status status = InitializeFieldMap(header_parser.begin()->fields());
+  if (!status.ok()) {
+    return status;
+  }
+  if (input->peek() == std::char_traits<char>::eof()) {
+    return util::Status(Code::INVALID_ARGUMENT, "No data in the input.");
+  }
+  parallel_parser_.reset(new util::ParallelCSVParser(
+      input_owner.release(), delim, num_threads, chunk_size));
+  return util::Status::OK;
+}
+
 int AccessAnalyzer::NumGraphNodes() const {
   CHECK(access_graph_ != nullptr, kNullAccessGraphErr);
   return access_graph_->NumNodes();
@@ -64,7 +127,78 @@ int AccessAnalyzer::NumGraphEdges() const {
 }
 
 util::Status AccessAnalyzer::BuildAccessGraph() {
-  if (csv_parser_ == nullptr) {
+  util::Status status = CreateAccessGraph();
+  if (!status.ok()) {
+    return status;
+  }
+  if (parallel_parser_ != nullptr) {
+    return BuildAccessGraphInParallel();
+  }
+  AccessData access;
+  for (const util::Record& record : *csv_parser_) {
+    if (GetAccessData(record, &access)) {
+      access_graph_->ProcessAccessData(access);
+    }
+  }
+  return util::Status::OK;
+}
+
+// The position of a record in the input is the sequence number of its batch
+// followed by its index in the batch, which fits in 32 bits since a batch has
+// fewer records than bytes. A worker receives its batches in order, so the
+// positions of the accesses it processes increase.
+util::Status AccessAnalyzer::BuildAccessGraphInParallel() {
+  std::vector<PartialGraph> partial_graphs(parallel_parser_->num_threads());
+  for (PartialGraph& partial_graph : partial_graphs) {
+    partial_graph.graph.reset(new AccountAccessGraph(aggregate_accesses_));
+    util::Status status = partial_graph.graph->Initialize();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  util::Status status = parallel_parser_->Parse(
+      [this, &partial_graphs](int thread_index,
+                              const util::RecordBatch& batch) {
+        PartialGraph& partial_graph = partial_graphs[thread_index];
+        const uint64_t first_position =
+            static_cast<uint64_t>(batch.sequence_number()) << 32;
+        AccessData access;
+        for (size_t i = 0; i < batch.size(); ++i) {
+          ++partial_graph.num_lines_read;
+          if (GetAccessData(batch[i], &access)) {
+            partial_graph.graph->ProcessAccessData(access, first_position + i);
+          } else {
+            ++partial_graph.num_lines_skipped;
+          }
+        }
+      });
+  if (!status.ok()) {
+    return status;
+  }
+  std::vector<const AccountAccessGraph*> graphs;
+  for (const PartialGraph& partial_graph : partial_graphs) {
+    num_lines_read_ += partial_graph.num_lines_read;
+    num_lines_skipped_ += partial_graph.num_lines_skipped;
+    graphs.push_back(partial_graph.graph.get());
+  }
+  CheckSkipCounter();
+  access_graph_->MergeInOrder(graphs);
+  return util::Status::OK;
+}
+
+string AccessAnalyzer::AccessGraphAsDot() const {
+  return (access_graph_ == nullptr) ? "" : access_graph_->ToDot();
+}
+
+void AccessAnalyzer::WriteAccessGraphAsDot(bool group_styles, int num_threads,
+                                           std::ostream* out) const {
+  if (access_graph_ != nullptr) {
+    access_graph_->WriteDot(group_styles, num_threads, out);
+  }
+}
+
+util::Status AccessAnalyzer::CreateAccessGraph() {
+  if (csv_parser_ == nullptr && parallel_parser_ == nullptr) {
     return util::Status(Code::INVALID_ARGUMENT,
                         "The CSV parser has not been initialized.");
   }
@@ -72,42 +206,63 @@ util::Status AccessAnalyzer::BuildAccessGraph() {
     return util::Status(Code::INVALID_ARGUMENT,
                         "The access graph has already been created.");
   }
-  access_graph_.reset(new AccountAccessGraph);
+  access_graph_.reset(new AccountAccessGraph(aggregate_accesses_));
   util::Status status = access_graph_->Initialize();
   if (!status.ok()) {
     access_graph_.reset(nullptr);
-    return status;
   }
-  for (const util::Record& record : *csv_parser_) {
-    ++num_lines_read_;
-    if (record.fields().size() != field_to_index_.size()) {
-      IncrementSkipCounter();
-      continue;
-    }
-    access_graph_->ProcessAccessData(field_to_index_, record.fields());
+  return status;
+}
+
+bool AccessAnalyzer::GetAccessData(const util::Record& record,
+                                   AccessData* access) {
+  ++num_lines_read_;
+  if (!record.ok() || record.num_columns() != field_to_index_.size()) {
+    IncrementSkipCounter();
+    return false;
   }
-  return util::Status::OK;
+  access->actor = record.field(kActorColumn);
+  access->actor_title = record.field(kActorTitleColumn);
+  access->actor_manager = record.field(kActorManagerColumn);
+  access->user = record.field(kUserColumn);
+  access->num_accesses = record.int64_field(kNumAccessesColumn);
+  return true;
 }
 
-string AccessAnalyzer::AccessGraphAsDot() const {
-  return (access_graph_ == nullptr) ? "" : access_graph_->ToDot();
+bool AccessAnalyzer::GetAccessData(const util::RecordBatch::RecordView& record,
+                                   AccessData* access) const {
+  if (!record.ok() || record.size() != field_to_index_.size() ||
+      !util::ParseInt64(record.field(input_columns_[kNumAccessesColumn]),
+                        &access->num_accesses)) {
+    return false;
+  }
+  access->actor = record.field(input_columns_[kActorColumn]);
+  access->actor_title = record.field(input_columns_[kActorTitleColumn]);
+  access->actor_manager = record.field(input_columns_[kActorManagerColumn]);
+  access->user = record.field(input_columns_[kUserColumn]);
+  return true;
 }
 
 void AccessAnalyzer::IncrementSkipCounter() {
   ++num_lines_skipped_;
+  CheckSkipCounter();
+}
+
+void AccessAnalyzer::CheckSkipCounter() const {
   CHECK(num_lines_skipped_ < kMaxMalformedLines,
         util::StrCat("Over ", std::to_string(kMaxMalformedLines),
                      " malformed lines in input. Aborting."));
 }
 
-util::Status AccessAnalyzer::InitializeFieldMap() {
-  const std::vector<string>& field_names = csv_parser_->begin()->fields();
+util::Status AccessAnalyzer::InitializeFieldMap(
+    const std::vector<util::StringPiece>& field_names) {
   if (field_names.empty()) {
     return util::Status(Code::INVALID_ARGUMENT, "First line has no columns.");
   }
   int index = 0;
   std::set<string> provided_fields;
-  for (const string& field_name : field_names) {
+  for (const util::StringPiece& field_piece : field_names) {
+    const string field_name = field_piece.ToString();
     if (field_name.empty()) {
       return util::Status(
           Code::INVALID_ARGUMENT,
@@ -135,6 +290,15 @@ util::Status AccessAnalyzer::InitializeFieldMap() {
         Code::INVALID_ARGUMENT,
         util::StrCat("The following required fields are missing: ", fields));
   }
+  input_columns_.clear();
+  for (const char* name : kColumnNames) {
+    auto column_it = field_to_index_.find(name);
+    if (column_it == field_to_index_.end()) {
+      return util::Status(Code::INVALID_ARGUMENT,
+                          util::StrCat("No column named ", name, "."));
+    }
+    input_columns_.push_back(column_it->second);
+  }
   return util::Status::OK;
 }
 
@@ -19,8 +19,11 @@
 #ifndef LOGLE_ACCOUNT_ACCESS_ANALYZER_H_
 #define LOGLE_ACCOUNT_ACCESS_ANALYZER_H_
 
+#include <istream>
 #include <memory>
+#include <ostream>
 #include <unordered_map>
+#include <vector>
 
 #include "analyzers/examples/account_access_graph.h"
 #include "base/string.h"
@@ -33,16 +36,35 @@ namespace morphie {
 // present in the CSV input are defined in account_access_defs.h.
 class AccessAnalyzer {
  public:
-  AccessAnalyzer() : num_lines_read_(0), num_lines_skipped_(0) {}
+  AccessAnalyzer() : AccessAnalyzer(false) {}
+  // If 'aggregate_accesses' is true, the graph has one access edge per pair of
+  // actor and user, labelled with the total number of accesses.
+  explicit AccessAnalyzer(bool aggregate_accesses)
+      : aggregate_accesses_(aggregate_accesses),
+        num_lines_read_(0),
+        num_lines_skipped_(0) {}
 
   // Initializes the analyzer using a CSV parser. Returns
   //  * OK : if the following requirements are satisfied.
-  //    - The input contains the fields in access::kRequiredFields.
+  //    - The input contains the fields in access::kRequiredFields and the
+  //      field access::kActorManager.
   //    - There is at least one row of data after the CSV header.
   //  * INVALID_ARGUMENT : otherwise with the error message containing the
   //  reason why initialization failed.
   util::Status Initialize(std::unique_ptr<util::CSVParser> parser);
+  // Initializes the analyzer to parse 'input' with a ParallelCSVParser that
+  // uses 'num_threads' threads and chunks of 'chunk_size' bytes. The header is
+  // read before parsing starts and must be on a single line. The analyzer takes
+  // ownership of 'input'. Returns the same status as the function above.
+  util::Status Initialize(std::istream* input, char delim, int num_threads,
+                          size_t chunk_size);
 
+  // Builds the access graph from the records after the header. With a
+  // ParallelCSVParser, every worker thread builds one partial graph from all
+  // the batches it parses and the partial graphs are merged once, in the order
+  // of the input, so the graph does not depend on the number of threads.
+  // Returns INVALID_ARGUMENT if the analyzer is not initialized or the graph
+  // has already been built.
   util::Status BuildAccessGraph();
 
   // Utilities for accounting and error checking.
@@ -57,19 +79,43 @@ class AccessAnalyzer {
 
   // Returns the account access graph in GraphViz DOT format.
   string AccessGraphAsDot() const;
+  // Writes the account access graph in GraphViz DOT format to 'out', with
+  // nodes and edges grouped by style if 'group_styles' is true and rendered on
+  // 'num_threads' threads. Nothing is written if the graph has not been built.
+  void WriteAccessGraphAsDot(bool group_styles, int num_threads,
+                             std::ostream* out) const;
 
  private:
   void IncrementSkipCounter();
-  // Initializes field_to_index_ using the first line of csv_parser_.
-  util::Status InitializeFieldMap();
+  // Crashes if there are too many malformed lines.
+  void CheckSkipCounter() const;
+  // Creates and initializes access_graph_.
+  util::Status CreateAccessGraph();
+  // Builds access_graph_ from the batches of parallel_parser_.
+  util::Status BuildAccessGraphInParallel();
+  // Counts 'record' as read and, if it is valid, stores its data in 'access'.
+  // Returns false and counts the record as skipped otherwise.
+  bool GetAccessData(const util::Record& record, AccessData* access);
+  // Stores the data of 'record' in 'access' and returns true if 'record' is
+  // valid. Returns false otherwise.
+  bool GetAccessData(const util::RecordBatch::RecordView& record,
+                     AccessData* access) const;
+  // Initializes field_to_index_ and input_columns_ using the names of the
+  // columns in 'field_names'.
+  util::Status InitializeFieldMap(
+      const std::vector<util::StringPiece>& field_names);
 
   // A map from input field names to the input column with that data.
   unordered_map<string, int> field_to_index_;
+  // The input column of each entry of the Column enum in the .cc file.
+  std::vector<int> input_columns_;
   std::unique_ptr<AccountAccessGraph> access_graph_;
+  bool aggregate_accesses_;
 
   int num_lines_read_;
   int num_lines_skipped_;
   std::unique_ptr<util::CSVParser> csv_parser_;
+  std::unique_ptr<util::ParallelCSVParser> parallel_parser_;
 };
 
 }  // namespace morphie
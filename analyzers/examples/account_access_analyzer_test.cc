@@ -14,6 +14,7 @@
 
 #include "analyzers/examples/account_access_analyzer.h"
 
+#include <random>
 #include <sstream>
 
 #include "gtest.h"
@@ -30,6 +31,9 @@ void TestCSVInitialization(const char* kInput, Code code) {
   AccessAnalyzer access_analyzer;
   util::Status s = access_analyzer.Initialize(std::move(parser));
   EXPECT_EQ(code, s.code());
+  AccessAnalyzer parallel_analyzer;
+  s = parallel_analyzer.Initialize(new std::stringstream(kInput), ',', 2, 64);
+  EXPECT_EQ(code, s.code());
 }
 
 void TestInvalidCSVInitialization(const char* kInput) {
@@ -102,5 +106,84 @@ TEST(AccessAnalyzerTest, TestGraphConstruction) {
   TestGraphConstruction(util::StrCat(header, content1, content2).c_str(), 3, 2);
 }
 
+// Lines whose access count is not an integer are skipped.
+TEST(AccessAnalyzerTest, SkipsInvalidCounts) {
+  string content1 = "\nabc@xyz.tuv,def@tuv.xyz,Alpha,None,1,2,3,Engineer";
+  string content2 = "\nabc@xyz.tuv,ghi@tuv.xyz,Alpha,None,1,2,three,Engineer";
+  std::unique_ptr<util::CSVParser> parser(new util::CSVParser(
+      new std::stringstream(util::StrCat(header, content1, content2))));
+  AccessAnalyzer access_analyzer;
+  ASSERT_TRUE(access_analyzer.Initialize(std::move(parser)).ok());
+  ASSERT_TRUE(access_analyzer.BuildAccessGraph().ok());
+  EXPECT_EQ(2, access_analyzer.NumLinesRead());
+  EXPECT_EQ(1, access_analyzer.NumLinesSkipped());
+  EXPECT_EQ(2, access_analyzer.NumGraphNodes());
+}
+
+// Accesses between the same actor and user with different counts are separate
+// edges, unless the analyzer aggregates accesses.
+TEST(AccessAnalyzerTest, AggregatesAccesses) {
+  string content1 = "\nabc@xyz.tuv,def@tuv.xyz,Alpha,None,1,2,3,Engineer";
+  string content2 = "\nabc@xyz.tuv,def@tuv.xyz,Alpha,None,1,2,4,Engineer";
+  const string input = util::StrCat(header, content1, content2);
+  TestGraphConstruction(input.c_str(), 2, 2);
+  std::unique_ptr<util::CSVParser> parser(
+      new util::CSVParser(new std::stringstream(input)));
+  AccessAnalyzer access_analyzer(true);
+  ASSERT_TRUE(access_analyzer.Initialize(std::move(parser)).ok());
+  ASSERT_TRUE(access_analyzer.BuildAccessGraph().ok());
+  EXPECT_EQ(2, access_analyzer.NumGraphNodes());
+  EXPECT_EQ(1, access_analyzer.NumGraphEdges());
+}
+
+// Builds a graph from 'input', with a ParallelCSVParser if 'num_threads' is not
+// 1, and returns the graph in DOT format followed by the number of lines read
+// and skipped. The small chunks split the input into many batches.
+string BuildGraph(const string& input, bool aggregate_accesses,
+                  int num_threads) {
+  AccessAnalyzer access_analyzer(aggregate_accesses);
+  if (num_threads == 1) {
+    std::unique_ptr<util::CSVParser> parser(
+        new util::CSVParser(new std::stringstream(input)));
+    EXPECT_TRUE(access_analyzer.Initialize(std::move(parser)).ok());
+  } else {
+    EXPECT_TRUE(access_analyzer
+                    .Initialize(new std::stringstream(input), ',', num_threads,
+                                1024)
+                    .ok());
+  }
+  EXPECT_TRUE(access_analyzer.BuildAccessGraph().ok());
+  return util::StrCat(access_analyzer.AccessGraphAsDot(), "\n",
+                      std::to_string(access_analyzer.NumLinesRead()), ",",
+                      std::to_string(access_analyzer.NumLinesSkipped()));
+}
+
+// Actors and users recur across batches, so the partial graphs of the threads
+// overlap.
+TEST(AccessAnalyzerTest, ParallelBuildMatchesSerialBuild) {
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> actor_dist(0, 49);
+  std::uniform_int_distribution<int> user_dist(0, 199);
+  std::uniform_int_distribution<int> count_dist(1, 5);
+  string input = header;
+  for (int i = 0; i < 20000; ++i) {
+    const string count =
+        (i % 1000 == 0) ? "many" : std::to_string(count_dist(rng));
+    util::StrAppend(&input, "\nactor", std::to_string(actor_dist(rng)),
+                    ",user", std::to_string(user_dist(rng)));
+    util::StrAppend(&input, ",Alpha,None,1,2,", count, ",Engineer");
+  }
+  for (bool aggregate_accesses : {false, true}) {
+    const string serial = BuildGraph(input, aggregate_accesses, 1);
+    for (int num_threads : {2, 3, 4}) {
+      EXPECT_EQ(serial, BuildGraph(input, aggregate_accesses, num_threads));
+    }
+  }
+  string content1 = "\nabc@xyz.tuv,def@tuv.xyz,Alpha,None,1,2,3,Engineer";
+  string content2 = "\nabc@xyz.tuv,ghi@tuv.xyz,Alpha,None,1,2,3,Engineer";
+  input = util::StrCat(header, content1, content2, content1);
+  EXPECT_EQ(BuildGraph(input, false, 1), BuildGraph(input, false, 2));
+}
+
 }  // namespace
 }  // namespace morphie
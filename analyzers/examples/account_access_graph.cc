@@ -14,10 +14,9 @@
 
 #include "analyzers/examples/account_access_graph.h"
 
-#include <cstdint>
-#include <unordered_map>
+#include <algorithm>
+#include <vector>
 
-#include "analyzers/examples/account_access_defs.h"
 #include "graph/dot_printer.h"
 #include "graph/type.h"
 #include "graph/type_checker.h"
@@ -26,14 +25,16 @@
 #include "util/string_utils.h"
 
 namespace {
-// These declarations are required because the using declaration in
-// base/string.h and below are within the logle namespace.
+// This declaration is required because the using declaration in
+// base/string.h is within the logle namespace.
 using std::string;
-using std::unordered_map;
 
 // Error messages.
 const char kInitializationErr[] = "The graph is not initialized.";
 const char kNoTagErr[] = "The graph has no type tagged :";
+const char kMergeModeErr[] =
+    "Only graphs that both aggregate accesses or both do not can be merged.";
+const char kNoPositionsErr[] = "The graph was not built with positions.";
 
 // Tags and names for components of labels.
 const char kActorTag[] = "Actor";
@@ -44,23 +45,6 @@ const char kManager[] = "Manager";
 const char kTitle[] = "Title";
 const char kUserTag[] = "User";
 
-// Returns the entry in 'fields' containing data for 'field_name'. The 'CHECK'
-// statements here are the main input validation checks.
-string GetField(const string& field_name,
-                const unordered_map<string, int>& field_index,
-                const std::vector<string>& fields) {
-  const auto field_it = field_index.find(field_name);
-  morphie::CHECK(
-      field_it != field_index.end(),
-      (morphie::util::StrCat("No field named ", field_name, " in input.")));
-  morphie::CHECK(0 <= field_it->second,
-               (morphie::util::StrCat("Index of ", field_name, " is negative.")));
-  morphie::CHECK(
-      static_cast<int>(fields.size()) > field_it->second,
-      (morphie::util::StrCat("Index of ", field_name, " exceeds bounds.")));
-  return fields[field_it->second];
-}
-
 }  // namespace
 
 namespace morphie {
@@ -116,18 +100,109 @@ int AccountAccessGraph::NumLabeledEdges(const TaggedAST& label) const {
   return graph_.NumLabeledEdges(label);
 }
 
-void AccountAccessGraph::ProcessAccessData(
-    const unordered_map<string, int>& field_index,
-    const std::vector<string>& fields) {
+void AccountAccessGraph::ProcessAccessData(const AccessData& access) {
   CHECK(is_initialized_, kInitializationErr);
-  CHECK(!field_index.empty(), "The map 'field_index' is empty");
-  CHECK(!fields.empty(), "The vector 'fields' is empty");
-  TaggedAST actor = MakeActorLabel(field_index, fields);
+  TaggedAST actor = MakeActorLabel(access);
   NodeId actor_id = graph_.FindOrAddNode(actor);
-  TaggedAST user = MakeUserLabel(field_index, fields);
+  TaggedAST user = MakeUserLabel(access);
   NodeId user_id = graph_.FindOrAddNode(user);
-  TaggedAST count = MakeEdgeLabel(field_index, fields);
-  graph_.FindOrAddEdge(actor_id, user_id, count);
+  AddAccess(actor_id, user_id, access.num_accesses);
+}
+
+// Nodes and edges are only added by the first access that contains them, which
+// has the least position of all such accesses since positions increase.
+void AccountAccessGraph::ProcessAccessData(const AccessData& access,
+                                           uint64_t position) {
+  CHECK(is_initialized_, kInitializationErr);
+  CHECK(node_positions_.size() == static_cast<size_t>(graph_.NumNodes()) &&
+            edge_positions_.size() == static_cast<size_t>(graph_.NumEdges()),
+        kNoPositionsErr);
+  NodeId actor_id = graph_.FindOrAddNode(MakeActorLabel(access));
+  NodeId user_id = graph_.FindOrAddNode(MakeUserLabel(access));
+  node_positions_.resize(graph_.NumNodes(), position);
+  EdgeId edge_id = AddAccess(actor_id, user_id, access.num_accesses);
+  if (edge_positions_.size() < static_cast<size_t>(graph_.NumEdges())) {
+    edge_positions_.emplace_back(position, edge_id);
+  }
+}
+
+// The node ids of a LabeledGraph are consecutive integers in the order in
+// which nodes were added, so the nodes of 'other' are added in that order.
+// Edges are enumerated by source node and, for each source, in the order in
+// which they were added, which preserves the order of the out-edges of every
+// node.
+void AccountAccessGraph::Merge(const AccountAccessGraph& other) {
+  CHECK(is_initialized_, kInitializationErr);
+  CHECK(other.is_initialized_, kInitializationErr);
+  CHECK(aggregate_accesses_ == other.aggregate_accesses_, kMergeModeErr);
+  std::vector<NodeId> node_ids;
+  node_ids.reserve(other.NumNodes());
+  for (auto node_it = other.graph_.NodeSetBegin();
+       node_it != other.graph_.NodeSetEnd(); ++node_it) {
+    node_ids.push_back(
+        graph_.FindOrAddNode(other.graph_.GetNodeLabel(*node_it)));
+  }
+  for (auto edge_it = other.graph_.EdgeSetBegin();
+       edge_it != other.graph_.EdgeSetEnd(); ++edge_it) {
+    const TaggedAST& count = other.graph_.GetEdgeLabel(*edge_it);
+    AddAccess(node_ids[other.graph_.Source(*edge_it)],
+              node_ids[other.graph_.Target(*edge_it)],
+              count.ast().p_ast().val().int_val());
+  }
+}
+
+// The nodes of each graph are added in the order of their ids, which is the
+// order of their positions, and each edge is added after its source and target.
+// Ties between the actor and the user of one access are broken by node id.
+void AccountAccessGraph::MergeInOrder(
+    const std::vector<const AccountAccessGraph*>& graphs) {
+  CHECK(is_initialized_, kInitializationErr);
+  // The position of a node or edge and the index of its graph.
+  using Key = std::pair<uint64_t, size_t>;
+  std::vector<std::pair<Key, NodeId>> nodes;
+  std::vector<std::pair<Key, EdgeId>> edges;
+  for (size_t i = 0; i < graphs.size(); ++i) {
+    const AccountAccessGraph& other = *graphs[i];
+    CHECK(other.is_initialized_, kInitializationErr);
+    CHECK(aggregate_accesses_ == other.aggregate_accesses_, kMergeModeErr);
+    CHECK(other.node_positions_.size() ==
+                  static_cast<size_t>(other.graph_.NumNodes()) &&
+              other.edge_positions_.size() ==
+                  static_cast<size_t>(other.graph_.NumEdges()),
+          kNoPositionsErr);
+    for (size_t node_id = 0; node_id < other.node_positions_.size();
+         ++node_id) {
+      nodes.push_back({{other.node_positions_[node_id], i}, node_id});
+    }
+    for (const auto& edge_position : other.edge_positions_) {
+      edges.push_back({{edge_position.first, i}, edge_position.second});
+    }
+  }
+  auto less_key = [](const std::pair<Key, NodeId>& n1,
+                     const std::pair<Key, NodeId>& n2) {
+    return n1.first < n2.first;
+  };
+  std::stable_sort(nodes.begin(), nodes.end(), less_key);
+  std::sort(edges.begin(), edges.end(),
+            [](const std::pair<Key, EdgeId>& e1,
+               const std::pair<Key, EdgeId>& e2) {
+              return e1.first < e2.first;
+            });
+  std::vector<std::vector<NodeId>> node_ids(graphs.size());
+  for (size_t i = 0; i < graphs.size(); ++i) {
+    node_ids[i].resize(graphs[i]->node_positions_.size());
+  }
+  for (const auto& node : nodes) {
+    const LabeledGraph& other = graphs[node.first.second]->graph_;
+    node_ids[node.first.second][node.second] =
+        graph_.FindOrAddNode(other.GetNodeLabel(node.second));
+  }
+  for (const auto& edge : edges) {
+    const LabeledGraph& other = graphs[edge.first.second]->graph_;
+    const std::vector<NodeId>& ids = node_ids[edge.first.second];
+    AddAccess(ids[other.Source(edge.second)], ids[other.Target(edge.second)],
+              other.GetEdgeLabel(edge.second).ast().p_ast().val().int_val());
+  }
 }
 
 string AccountAccessGraph::ToDot() const {
@@ -135,19 +210,31 @@ string AccountAccessGraph::ToDot() const {
   return DotPrinter().DotGraph(graph_);
 }
 
-TaggedAST AccountAccessGraph::MakeActorLabel(
-    const unordered_map<string, int>& field_index,
-    const std::vector<string>& fields) {
+void AccountAccessGraph::WriteDot(bool group_styles, int num_threads,
+                                  std::ostream* out) const {
+  CHECK(is_initialized_, kInitializationErr);
+  DotPrinter dot_printer;
+  dot_printer.set_group_styles(group_styles);
+  if (num_threads > 1) {
+    dot_printer.WriteParallelDotGraph(graph_, num_threads, out);
+  } else {
+    dot_printer.WriteDotGraph(graph_, out);
+  }
+}
+
+TaggedAST AccountAccessGraph::MakeActorLabel(const AccessData& access) {
   // Create a tuple consisting of the actor, title and manager.
   AST actor_ast = value::MakeNullTuple(3);
   std::pair<bool, AST> result = graph_.GetNodeType(kActorTag);
   CHECK(result.first, (util::StrCat(kNoTagErr, kActorTag)));
-  string field = GetField(access::kActor, field_index, fields);
-  value::SetField(result.second, 0, value::MakeString(field), &actor_ast);
-  field = GetField(access::kActorTitle, field_index, fields);
-  value::SetField(result.second, 1, value::MakeString(field), &actor_ast);
-  field = GetField(access::kActorManager, field_index, fields);
-  value::SetField(result.second, 2, value::MakeString(field), &actor_ast);
+  value::SetField(result.second, 0, value::MakeString(access.actor.ToString()),
+                  &actor_ast);
+  value::SetField(result.second, 1,
+                  value::MakeString(access.actor_title.ToString()),
+                  &actor_ast);
+  value::SetField(result.second, 2,
+                  value::MakeString(access.actor_manager.ToString()),
+                  &actor_ast);
   // Add a tag to the tuple.
   TaggedAST actor;
   *actor.mutable_ast() = actor_ast;
@@ -155,27 +242,42 @@ TaggedAST AccountAccessGraph::MakeActorLabel(
   return actor;
 }
 
-TaggedAST AccountAccessGraph::MakeUserLabel(
-    const unordered_map<string, int>& field_index,
-    const std::vector<string>& fields) {
-  string user_str = GetField(access::kUser, field_index, fields);
-  AST user_ast = value::MakeString(user_str);
+TaggedAST AccountAccessGraph::MakeUserLabel(const AccessData& access) {
+  AST user_ast = value::MakeString(access.user.ToString());
   TaggedAST user;
   *user.mutable_ast() = user_ast;
   user.set_tag(kUserTag);
   return user;
 }
 
-TaggedAST AccountAccessGraph::MakeEdgeLabel(
-    const unordered_map<string, int>& field_index,
-    const std::vector<string>& fields) {
-  string count_str = GetField(access::kNumAccesses, field_index, fields);
-  // Convert a string to a 64 bit signed integer.
-  int64_t count_val = std::stoll(count_str);
+TaggedAST AccountAccessGraph::MakeEdgeLabel(int64_t num_accesses) {
   TaggedAST count;
-  *count.mutable_ast() = value::MakeInt(count_val);
+  *count.mutable_ast() = value::MakeInt(0);
+  count.mutable_ast()->mutable_p_ast()->mutable_val()->set_int_val(
+      num_accesses);
   count.set_tag(kAccessEdgeTag);
   return count;
 }
 
+EdgeId AccountAccessGraph::AddAccess(NodeId actor_id, NodeId user_id,
+                                     int64_t num_accesses) {
+  if (!aggregate_accesses_) {
+    return graph_.FindOrAddEdge(actor_id, user_id, MakeEdgeLabel(num_accesses));
+  }
+  auto edge_it = access_edges_.find({actor_id, user_id});
+  if (edge_it == access_edges_.end()) {
+    EdgeId edge_id =
+        graph_.FindOrAddEdge(actor_id, user_id, MakeEdgeLabel(num_accesses));
+    access_edges_.insert({{actor_id, user_id}, edge_id});
+    return edge_id;
+  }
+  // The edge is the only one between the actor and the user, so the updated
+  // label cannot clash with another label.
+  util::Status s = graph_.MutateEdgeValue(
+      edge_it->second,
+      [num_accesses](int64_t* count) { *count += num_accesses; });
+  CHECK(s.ok(), s.message());
+  return edge_it->second;
+}
+
 }  // namespace morphie
@@ -18,22 +18,40 @@
 // user account. An access edge goes from an actor to a user and is labelled
 // with the number of accesses that were made.
 //
+// By default, every distinct number of accesses between an actor and a user
+// is a separate edge. In aggregating mode, there is one access edge for each
+// pair of actor and user, labelled with the total number of accesses.
+//
 // Status: The purpose of this graph is to demonstrate potential applications of
 // graph-based log analysis. There is currently only support for construction
 // and rudimentary visualization of this graph.
 #ifndef LOGLE_ACCOUNT_ACCESS_GRAPH_H_
 #define LOGLE_ACCOUNT_ACCESS_GRAPH_H_
 
-#include <unordered_map>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
 
 #include "base/string.h"
-#include "base/vector.h"
 #include "graph/graph_interface.h"
 #include "graph/labeled_graph.h"
 #include "util/status.h"
+#include "util/string_piece.h"
 
 namespace morphie {
 
+// The data about a single access. The strings refer to memory owned by the
+// caller.
+struct AccessData {
+  util::StringPiece actor;
+  util::StringPiece actor_title;
+  util::StringPiece actor_manager;
+  util::StringPiece user;
+  int64_t num_accesses;
+};
+
 // The account access graph contains labels with the following names and types.
 // The labels are all unique, meaning there can be at most one node with each
 // label in the graph and at most one edge between two nodes with a given label.
@@ -48,7 +66,11 @@ namespace morphie {
 // initialized.
 class AccountAccessGraph : public GraphInterface {
  public:
-  AccountAccessGraph() : is_initialized_(false) {}
+  AccountAccessGraph() : AccountAccessGraph(false) {}
+  // If 'aggregate_accesses' is true, the accesses between an actor and a user
+  // are summed up in the label of a single edge.
+  explicit AccountAccessGraph(bool aggregate_accesses)
+      : is_initialized_(false), aggregate_accesses_(aggregate_accesses) {}
 
   // Initializes the graph. This function must be called before all other
   // functions in this class. Returns
@@ -65,36 +87,62 @@ class AccountAccessGraph : public GraphInterface {
   int NumEdges() const;
   int NumLabeledEdges(const TaggedAST& label) const;
 
-  // Extract data from 'fields' and add nodes and edges to the graph for a
-  // single access. The arguments are:
-  // - 'fields' - a vector of fields derived from the input.
-  // - 'field_index' - a map from field names to their position in 'fields'.
-  // Requires that
-  // * 'field_index' is not empty.
-  // * 'fields' is not empty.
-  // * for each pair (name, index) in 'field_index', 'index' is a valid index of
-  //   'fields'.
-  // This function does not perform data validation, meaning that every entry in
-  // 'fields' is assumed to be valid. If, for example, an empty string is used
-  // to represent an unknown user, there will be a user node in the graph
-  // labelled with the empty string.
-  void ProcessAccessData(const unordered_map<string, int>& field_index,
-                         const std::vector<string>& fields);
+  // Adds nodes and edges to the graph for a single access. This function does
+  // not perform data validation, meaning that every field of 'access' is
+  // assumed to be valid. If, for example, an empty string is used to represent
+  // an unknown user, there will be a user node in the graph labelled with the
+  // empty string. In aggregating mode, the number of accesses is added to the
+  // label of the existing edge from the actor to the user, if there is one.
+  void ProcessAccessData(const AccessData& access);
+  // Processes 'access' like the function above and records 'position', the
+  // position of the access in the input, with the nodes and the edge that
+  // 'access' adds. The positions of successive calls must increase.
+  void ProcessAccessData(const AccessData& access, uint64_t position);
+
+  // Adds the nodes and edges of 'other' to this graph. The graphs must be in
+  // the same mode. Nodes and edges that are not in this graph are added in the
+  // order in which they were added to 'other', so merging the graphs built
+  // from consecutive parts of the input, in order, yields the same graph as
+  // processing the whole input. In aggregating mode, the counts of edges in
+  // both graphs are summed up.
+  void Merge(const AccountAccessGraph& other);
+  // Adds the nodes and edges of 'graphs' to this graph in the order of the
+  // positions at which they were first added. The graphs must be in the same
+  // mode as this graph and must have been built with positions. If the graphs
+  // were built from disjoint parts of the input, with the positions of the
+  // accesses in the input, the result is the graph obtained by processing the
+  // whole input in order, no matter how the input was split.
+  void MergeInOrder(const std::vector<const AccountAccessGraph*>& graphs);
 
   // Return a representation of the graph in Graphviz DOT format.
   string ToDot() const;
+  // Writes the representation returned by ToDot to 'out'. If 'group_styles'
+  // is true, nodes and edges are grouped by style as described for
+  // DotPrinter::set_group_styles. If 'num_threads' is greater than 1, the
+  // graph is rendered on that many threads with
+  // DotPrinter::WriteParallelDotGraph.
+  void WriteDot(bool group_styles, int num_threads, std::ostream* out) const;
 
  private:
   // The functions below create each of the three types of labels in the graph.
-  TaggedAST MakeActorLabel(const unordered_map<string, int>& field_index,
-                           const std::vector<string>& fields);
-  TaggedAST MakeUserLabel(const unordered_map<string, int>& field_index,
-                          const std::vector<string>& fields);
-  TaggedAST MakeEdgeLabel(const unordered_map<string, int>& field_index,
-                          const std::vector<string>& fields);
+  TaggedAST MakeActorLabel(const AccessData& access);
+  TaggedAST MakeUserLabel(const AccessData& access);
+  TaggedAST MakeEdgeLabel(int64_t num_accesses);
+  // Adds an access edge from 'actor_id' to 'user_id' or, in aggregating mode,
+  // adds 'num_accesses' to the count of an existing edge.
+  // Returns the id of the edge.
+  EdgeId AddAccess(NodeId actor_id, NodeId user_id, int64_t num_accesses);
 
   bool is_initialized_;
+  bool aggregate_accesses_;
   LabeledGraph graph_;
+  // In aggregating mode, the access edge between each actor and user.
+  std::map<std::pair<NodeId, NodeId>, EdgeId> access_edges_;
+  // If the graph is built with positions, the position at which each node was
+  // added, indexed by node id, and the edges with the positions at which they
+  // were added, in the order in which they were added.
+  std::vector<uint64_t> node_positions_;
+  std::vector<std::pair<uint64_t, EdgeId>> edge_positions_;
 };  // class AccountAccessGraph
 
 }  // namespace morphie
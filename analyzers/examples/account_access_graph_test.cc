@@ -14,7 +14,9 @@
 
 #include "analyzers/examples/account_access_graph.h"
 
-#include "analyzers/examples/account_access_defs.h"
+#include <vector>
+
+#include "graph/value.h"
 #include "gtest.h"
 
 namespace morphie {
@@ -22,8 +24,7 @@ namespace {
 
 TEST(AccountAccessGraphDeathTest, UninitializedCall) {
   AccountAccessGraph graph;
-  EXPECT_DEATH({ graph.ProcessAccessData(unordered_map<string, int>(), {}); },
-               ".*");
+  EXPECT_DEATH({ graph.ProcessAccessData(AccessData()); }, ".*");
 }
 
 class AccountAccessGraphTest : public ::testing::Test {
@@ -36,45 +37,121 @@ class AccountAccessGraphTest : public ::testing::Test {
   AccountAccessGraph graph_;
 };
 
-static std::vector<string> fields1{"bad-person@logle", "manager-person@logle",
-                                   "Bad Actor", "32", "user@fake-mail"};
-
-static std::vector<string> fields2{"good-person@logle", "manager-person@logle",
-                                   "Good Actor", "32", "user@logle-mail"};
-
-unordered_map<string, int> GetIndex() {
-  unordered_map<string, int> index;
-  index.insert({access::kActor, 0});
-  index.insert({access::kActorManager, 1});
-  index.insert({access::kActorTitle, 2});
-  index.insert({access::kNumAccesses, 3});
-  index.insert({access::kUser, 4});
-  return index;
+AccessData MakeAccess(const char* actor, const char* user) {
+  AccessData access;
+  access.actor = actor;
+  access.actor_title = "Bad Actor";
+  access.actor_manager = "manager-person@logle";
+  access.user = user;
+  access.num_accesses = 32;
+  return access;
 }
 
 TEST_F(AccountAccessGraphTest, ProcessSingleAccess) {
   EXPECT_EQ(0, graph_.NumNodes());
   EXPECT_EQ(0, graph_.NumEdges());
-  graph_.ProcessAccessData(GetIndex(), fields1);
+  AccessData access = MakeAccess("bad-person@logle", "user@fake-mail");
+  graph_.ProcessAccessData(access);
   EXPECT_EQ(2, graph_.NumNodes());
   EXPECT_EQ(1, graph_.NumEdges());
   // Processing the same data multiple times will not change the graph.
-  graph_.ProcessAccessData(GetIndex(), fields1);
+  graph_.ProcessAccessData(access);
   EXPECT_EQ(2, graph_.NumNodes());
   EXPECT_EQ(1, graph_.NumEdges());
   // Changing the user but not the actor should add only one new node to the
   // graph.
-  fields1[4] = "user2@fake-mail";
-  graph_.ProcessAccessData(GetIndex(), fields1);
+  access.user = "user2@fake-mail";
+  graph_.ProcessAccessData(access);
   EXPECT_EQ(3, graph_.NumNodes());
   EXPECT_EQ(2, graph_.NumEdges());
   // Changing the actor but not the user should also only one new node to the
   // graph.
-  fields1[0] = "another-actor@logle";
-  graph_.ProcessAccessData(GetIndex(), fields1);
+  access.actor = "another-actor@logle";
+  graph_.ProcessAccessData(access);
   EXPECT_EQ(4, graph_.NumNodes());
   EXPECT_EQ(3, graph_.NumEdges());
 }
 
+// Returns the label of an access edge for 'count' accesses.
+TaggedAST MakeCountLabel(int count) {
+  TaggedAST label;
+  *label.mutable_ast() = ast::value::MakeInt(count);
+  label.set_tag("Access");
+  return label;
+}
+
+TEST(AccountAccessGraphAggregationTest, SumsAccesses) {
+  AccountAccessGraph graph(true);
+  ASSERT_TRUE(graph.Initialize().ok());
+  AccessData access = MakeAccess("bad-person@logle", "user@fake-mail");
+  graph.ProcessAccessData(access);
+  access.num_accesses = 10;
+  graph.ProcessAccessData(access);
+  EXPECT_EQ(2, graph.NumNodes());
+  EXPECT_EQ(1, graph.NumEdges());
+  EXPECT_EQ(0, graph.NumLabeledEdges(MakeCountLabel(32)));
+  EXPECT_EQ(1, graph.NumLabeledEdges(MakeCountLabel(42)));
+  // Accesses to another user are counted separately.
+  access.user = "user2@fake-mail";
+  graph.ProcessAccessData(access);
+  EXPECT_EQ(3, graph.NumNodes());
+  EXPECT_EQ(2, graph.NumEdges());
+  EXPECT_EQ(1, graph.NumLabeledEdges(MakeCountLabel(42)));
+  EXPECT_EQ(1, graph.NumLabeledEdges(MakeCountLabel(10)));
+}
+
+// Merging graphs built from two parts of the input yields the graph built from
+// the whole input.
+TEST(AccountAccessGraphMergeTest, MergeMatchesProcessing) {
+  std::vector<AccessData> accesses = {MakeAccess("actor1", "user1"),
+                                      MakeAccess("actor2", "user1"),
+                                      MakeAccess("actor1", "user2"),
+                                      MakeAccess("actor1", "user1"),
+                                      MakeAccess("actor3", "user2")};
+  accesses[3].num_accesses = 5;
+  for (bool aggregate_accesses : {false, true}) {
+    AccountAccessGraph whole(aggregate_accesses);
+    AccountAccessGraph first(aggregate_accesses);
+    AccountAccessGraph second(aggregate_accesses);
+    ASSERT_TRUE(whole.Initialize().ok());
+    ASSERT_TRUE(first.Initialize().ok());
+    ASSERT_TRUE(second.Initialize().ok());
+    for (size_t i = 0; i < accesses.size(); ++i) {
+      whole.ProcessAccessData(accesses[i]);
+      (i < 2 ? first : second).ProcessAccessData(accesses[i]);
+    }
+    first.Merge(second);
+    EXPECT_EQ(whole.ToDot(), first.ToDot());
+  }
+}
+
+// Merging graphs built from interleaved parts of the input in the order of
+// positions yields the graph built from the whole input.
+TEST(AccountAccessGraphMergeTest, MergeInOrderMatchesProcessing) {
+  std::vector<AccessData> accesses = {MakeAccess("actor1", "user1"),
+                                      MakeAccess("actor2", "user1"),
+                                      MakeAccess("actor3", "user3"),
+                                      MakeAccess("actor1", "user2"),
+                                      MakeAccess("actor1", "user1"),
+                                      MakeAccess("actor3", "user2")};
+  accesses[4].num_accesses = 5;
+  for (bool aggregate_accesses : {false, true}) {
+    AccountAccessGraph whole(aggregate_accesses);
+    AccountAccessGraph merged(aggregate_accesses);
+    AccountAccessGraph even(aggregate_accesses);
+    AccountAccessGraph odd(aggregate_accesses);
+    ASSERT_TRUE(whole.Initialize().ok());
+    ASSERT_TRUE(merged.Initialize().ok());
+    ASSERT_TRUE(even.Initialize().ok());
+    ASSERT_TRUE(odd.Initialize().ok());
+    for (size_t i = 0; i < accesses.size(); ++i) {
+      whole.ProcessAccessData(accesses[i]);
+      (i % 2 == 0 ? even : odd).ProcessAccessData(accesses[i], i);
+    }
+    merged.MergeInOrder({&odd, &even});
+    EXPECT_EQ(whole.ToDot(), merged.ToDot());
+  }
+}
+
 }  // namespace
 }  // namespace morphie
@@ -15,7 +15,9 @@
 #include "analyzers/examples/curio_analyzer.h"
 
 #include <algorithm>
+#include <vector>
 
+#include "util/json_events.h"
 #include "util/logging.h"
 #include "util/status.h"
 #include "util/string_utils.h"
@@ -66,20 +68,23 @@ util::Status CurioAnalyzer::BuildDependencyGraph() {
   if (!status.ok()) {
     return status;
   }
-  for (const auto& consumer_id : json_doc_->getMemberNames()) {
+  std::set<std::pair<string, string>> expanded_streams;
+  for (auto consumer_it = json_doc_->begin(); consumer_it != json_doc_->end();
+       ++consumer_it) {
+    const string consumer_id = consumer_it.name();
     // Every stream depends on the clock so the clock stream is not added to the
     // dependency graph to reduce structural and visual noise.
     if (consumer_id == kClockId) {
       continue;
     }
-    if (!HasRequiredFields((*json_doc_)[consumer_id])) {
+    if (!HasRequiredFields(*consumer_it)) {
       status = IncrementSkipCounter();
       if (!status.ok()) {
         return status;
       }
       continue;
     }
-    status = AddDependencies(consumer_id, (*json_doc_)[consumer_id]);
+    status = AddDependencies(consumer_id, *consumer_it, &expanded_streams);
     ++num_streams_processed_;
     if (!status.ok()) {
       return status;
@@ -96,20 +101,51 @@ int CurioAnalyzer::NumGraphEdges() const {
   return dependency_graph_ == nullptr ? 0 : dependency_graph_->NumEdges();
 }
 
-// Recursively traverse the dependency tree rooted at 'consumer_tree'. The
-// traversal skips a subtree below a node if that node is not well defined.
-util::Status CurioAnalyzer::AddDependencies(const string& consumer_id,
-                                            const Json::Value& consumer_tree) {
+// The traversal is depth-first and keeps an explicit stack of iterators over
+// the children of the streams being expanded, so that deep dependency trees do
+// not overflow the call stack. Subtrees are visited by reference, without
+// copying them. A Curio dump repeats the dependencies of a stream wherever the
+// stream occurs, so a stream is expanded only at its first occurrence, which
+// bounds the traversal by the size of the document instead of the number of
+// paths in the dependency graph. Every occurrence still adds an edge from its
+// consumer and counts as a processed stream. The traversal skips a subtree
+// below a node if that node is not well defined.
+util::Status CurioAnalyzer::AddDependencies(
+    const string& consumer_id, const Json::Value& consumer_tree,
+    std::set<std::pair<string, string>>* expanded_streams) {
+  struct Expansion {
+    string id;
+    string name;
+    Json::Value::const_iterator child_it;
+    Json::Value::const_iterator child_end;
+  };
+  std::vector<Expansion> expansions;
+  auto expand = [&expansions, expanded_streams](const string& id,
+                                                const string& name,
+                                                const Json::Value& tree) {
+    if (!expanded_streams->insert({id, name}).second) {
+      return;
+    }
+    const Json::Value& children = tree["Children"];
+    expansions.push_back({id, name, children.begin(), children.end()});
+  };
+  expand(consumer_id, consumer_tree["Node"]["ID"]["Name"].asString(),
+         consumer_tree);
   util::Status status = util::Status::OK;
-  string consumer_name = consumer_tree["Node"]["ID"]["Name"].asString();
-  Json::Value producer_tree;
-  for (const auto& producer_id : consumer_tree["Children"].getMemberNames()) {
-    // Every stream depends on the clock the clock stream is not added to the
+  while (!expansions.empty()) {
+    Expansion& consumer = expansions.back();
+    if (consumer.child_it == consumer.child_end) {
+      expansions.pop_back();
+      continue;
+    }
+    const string producer_id = consumer.child_it.name();
+    const Json::Value& producer_tree = *consumer.child_it;
+    ++consumer.child_it;
+    // Every stream depends on the clock so the clock stream is not added to the
     // dependency graph to reduce structural and visual noise.
     if (producer_id == kClockId) {
       continue;
     }
-    producer_tree = consumer_tree["Children"][producer_id];
     if (!HasRequiredFields(producer_tree)) {
       status = IncrementSkipCounter();
       if (!status.ok()) {
@@ -117,22 +153,252 @@ util::Status CurioAnalyzer::AddDependencies(const string& consumer_id,
       }
       continue;
     }
-    string producer_name = producer_tree["Node"]["ID"]["Name"].asString();
-    dependency_graph_->AddDependency(consumer_id, consumer_name, producer_id,
+    const string producer_name = producer_tree["Node"]["ID"]["Name"].asString();
+    dependency_graph_->AddDependency(consumer.id, consumer.name, producer_id,
                                      producer_name);
-    status = AddDependencies(producer_id, producer_tree);
     ++num_streams_processed_;
-    if (!status.ok()) {
-      return status;
-    }
+    // The reference 'consumer' is invalidated if an expansion is added.
+    expand(producer_id, producer_name, producer_tree);
+  }
+  return status;
+}
+
+// The handler keeps a stack with the role of each open array or object and a
+// stack with the open stream objects. The role of a value is determined by the
+// role of the enclosing object and the key of the value. Streams are added to
+// the graph when both their name and their children have been seen, which, for
+// streams that list the Node before the Children, is before the children are
+// read, as in AddDependencies.
+class CurioAnalyzer::EventHandler : public util::JSONEventHandler {
+ public:
+  explicit EventHandler(CurioAnalyzer* analyzer)
+      : analyzer_(analyzer), num_top_level_streams_(0) {}
+
+  util::Status StartObject() override { return StartContainer(true); }
+  util::Status EndObject() override;
+  util::Status StartArray() override { return StartContainer(false); }
+  util::Status EndArray() override {
+    roles_.pop_back();
+    return util::Status::OK;
+  }
+  util::Status Key(const string& key) override {
+    key_ = key;
+    return util::Status::OK;
+  }
+  util::Status String(const string& value) override { return Scalar(value); }
+  // Json::Value::asString() converts null to the empty string and other
+  // literals to their text.
+  util::Status Literal(const string& text) override {
+    return Scalar(text == "null" ? "" : text);
+  }
+
+ private:
+  enum class Role {
+    // The document, which maps stream ids to streams.
+    kDocument,
+    kStream,
+    kNode,
+    kID,
+    // The children of a stream, which map stream ids to streams.
+    kChildren,
+    // A value that does not contribute to the graph.
+    kIgnored,
+  };
+
+  struct Stream {
+    string id;
+    string name;
+    bool has_name;
+    bool has_children;
+    // True if the stream is well defined and has been added to the graph.
+    bool is_defined;
+  };
+
+  util::Status StartContainer(bool is_object);
+  util::Status Scalar(const string& value);
+  // Returns the role of an object or array that begins in the current context
+  // and starts a stream if the value is one.
+  util::Status GetRole(bool is_object, Role* role);
+  // Marks the innermost stream as having children and returns the role of the
+  // children.
+  util::Status StartChildren(bool is_object, Role* role);
+  // Adds the dependency of the consumer of the innermost stream on that stream,
+  // if it has a consumer.
+  void DefineStream();
+
+  CurioAnalyzer* analyzer_;
+  std::vector<Role> roles_;
+  std::vector<Stream> streams_;
+  // The key of the last member of an object read.
+  string key_;
+  int num_top_level_streams_;
+  std::set<std::pair<string, string>> expanded_streams_;
+};
+
+util::Status CurioAnalyzer::EventHandler::StartContainer(bool is_object) {
+  Role role = Role::kIgnored;
+  util::Status status = GetRole(is_object, &role);
+  if (status.ok()) {
+    roles_.push_back(role);
   }
   return status;
 }
 
+util::Status CurioAnalyzer::EventHandler::GetRole(bool is_object,
+                                                  Role* role) {
+  *role = Role::kIgnored;
+  if (roles_.empty()) {
+    if (!is_object) {
+      return util::Status(Code::INVALID_ARGUMENT,
+                          "The document must be an object.");
+    }
+    *role = Role::kDocument;
+    return util::Status::OK;
+  }
+  switch (roles_.back()) {
+    case Role::kDocument:
+    case Role::kChildren:
+      // Every stream depends on the clock so the clock stream is not added to
+      // the dependency graph to reduce structural and visual noise.
+      if (key_ == kClockId) {
+        return util::Status::OK;
+      }
+      if (roles_.back() == Role::kDocument) {
+        ++num_top_level_streams_;
+      }
+      if (!is_object) {
+        return analyzer_->IncrementSkipCounter();
+      }
+      streams_.push_back({key_, "", false, false, false});
+      *role = Role::kStream;
+      return util::Status::OK;
+    case Role::kStream:
+      if (key_ == "Node" && is_object) {
+        *role = Role::kNode;
+      } else if (key_ == "Children") {
+        return StartChildren(is_object, role);
+      }
+      return util::Status::OK;
+    case Role::kNode:
+      if (key_ == "ID" && is_object) {
+        *role = Role::kID;
+      }
+      return util::Status::OK;
+    default:
+      return util::Status::OK;
+  }
+}
+
+// The children of a stream are read only if the stream is defined when they
+// begin and has not been expanded before.
+util::Status CurioAnalyzer::EventHandler::StartChildren(bool is_object,
+                                                        Role* role) {
+  *role = Role::kIgnored;
+  Stream& stream = streams_.back();
+  if (stream.has_children) {
+    return util::Status::OK;
+  }
+  stream.has_children = true;
+  if (!stream.has_name) {
+    return util::Status::OK;
+  }
+  DefineStream();
+  if (is_object && expanded_streams_.insert({stream.id, stream.name}).second) {
+    *role = Role::kChildren;
+  }
+  return util::Status::OK;
+}
+
+util::Status CurioAnalyzer::EventHandler::Scalar(const string& value) {
+  if (roles_.empty()) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "The document must be an object.");
+  }
+  switch (roles_.back()) {
+    case Role::kDocument:
+    case Role::kChildren:
+      if (key_ == kClockId) {
+        return util::Status::OK;
+      }
+      if (roles_.back() == Role::kDocument) {
+        ++num_top_level_streams_;
+      }
+      return analyzer_->IncrementSkipCounter();
+    case Role::kStream:
+      if (key_ == "Children") {
+        Role role;
+        return StartChildren(false, &role);
+      }
+      return util::Status::OK;
+    case Role::kID:
+      if (key_ == "Name" && !streams_.back().has_name) {
+        Stream& stream = streams_.back();
+        stream.name = value;
+        stream.has_name = true;
+        if (stream.has_children) {
+          DefineStream();
+        }
+      }
+      return util::Status::OK;
+    default:
+      return util::Status::OK;
+  }
+}
+
+util::Status CurioAnalyzer::EventHandler::EndObject() {
+  const Role role = roles_.back();
+  roles_.pop_back();
+  if (role == Role::kDocument && num_top_level_streams_ == 0) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "The input document must not be empty.");
+  }
+  if (role != Role::kStream) {
+    return util::Status::OK;
+  }
+  const bool is_defined = streams_.back().is_defined;
+  streams_.pop_back();
+  return is_defined ? util::Status::OK : analyzer_->IncrementSkipCounter();
+}
+
+// The consumer of a stream that is not at the top level of the document is the
+// stream before it on the stack, which is defined because its children are
+// read.
+void CurioAnalyzer::EventHandler::DefineStream() {
+  Stream& producer = streams_.back();
+  producer.is_defined = true;
+  ++analyzer_->num_streams_processed_;
+  if (streams_.size() < 2) {
+    return;
+  }
+  const Stream& consumer = streams_[streams_.size() - 2];
+  analyzer_->dependency_graph_->AddDependency(consumer.id, consumer.name,
+                                              producer.id, producer.name);
+}
+
+util::Status CurioAnalyzer::BuildDependencyGraph(std::istream* input) {
+  num_streams_processed_ = 0;
+  num_streams_skipped_ = 0;
+  dependency_graph_.reset(new StreamDependencyGraph);
+  util::Status status = dependency_graph_->Initialize();
+  if (!status.ok()) {
+    return status;
+  }
+  EventHandler handler(this);
+  return util::ParseJSONEvents(input, &handler);
+}
+
 string CurioAnalyzer::DependencyGraphAsDot() const {
   return dependency_graph_ == nullptr ? "" : dependency_graph_->ToDot();
 }
 
+void CurioAnalyzer::WriteDependencyGraphAsDot(bool group_styles,
+                                              int num_threads,
+                                              std::ostream* out) const {
+  if (dependency_graph_ != nullptr) {
+    dependency_graph_->WriteDot(group_styles, num_threads, out);
+  }
+}
+
 util::Status CurioAnalyzer::IncrementSkipCounter() {
   ++num_streams_skipped_;
   if (num_streams_skipped_ >= kMaxMalformedObjects) {
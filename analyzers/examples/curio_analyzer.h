@@ -18,7 +18,11 @@
 #ifndef LOGLE_CURIO_ANALYZER_H_
 #define LOGLE_CURIO_ANALYZER_H_
 
+#include <istream>
 #include <memory>
+#include <ostream>
+#include <set>
+#include <utility>
 
 #include "analyzers/examples/stream_dependency_graph.h"
 #include "base/string.h"
@@ -47,6 +51,20 @@ class CurioAnalyzer {
   // to Initialize.
   util::Status BuildDependencyGraph();
 
+  // Constructs a StreamDependencyGraph object from the JSON document in 'input'
+  // as the document is read, without building a Json::Value for it, and resets
+  // the counters of streams processed and skipped. The memory used for parsing
+  // is proportional to the depth of the document. The graph is the one that
+  // BuildDependencyGraph() constructs from the document, provided that the
+  // Node of each stream precedes its Children, which is the order in which
+  // Curio writes streams. The dependencies of a stream whose name has not been
+  // read when its Children begin are skipped. Streams are processed in the
+  // order of the document rather than in the order of their ids. Returns
+  //  - INVALID_ARGUMENT if the input is not JSON, if the document is not an
+  //    object or is empty, or if too many streams are malformed.
+  //  - OK otherwise.
+  util::Status BuildDependencyGraph(std::istream* input);
+
   int NumStreamsProcessed() const { return num_streams_processed_; }
   int NumStreamsSkipped() const { return num_streams_skipped_; }
 
@@ -55,16 +73,29 @@ class CurioAnalyzer {
 
   // Returns a GraphViz DOT representation of the dependency graph.
   string DependencyGraphAsDot() const;
+  // Writes a GraphViz DOT representation of the dependency graph to 'out',
+  // with nodes and edges grouped by style if 'group_styles' is true and
+  // rendered on 'num_threads' threads. Nothing is written if the graph has not
+  // been built.
+  void WriteDependencyGraphAsDot(bool group_styles, int num_threads,
+                                 std::ostream* out) const;
 
  private:
-  // Recursively adds nodes and edges to the dependency graph for each stream in
+  // The handler of the events of the JSON parser used to read a document as a
+  // stream.
+  class EventHandler;
+
+  // Adds nodes and edges to the dependency graph for each stream in
   // 'consumer_tree'. The 'consumer_tree' is assumed to contain only one JSON
-  // object at the top level. Returns:
+  // object at the top level. The dependencies of a stream whose id and name
+  // are in 'expanded_streams' are not added again, and the streams whose
+  // dependencies are added are inserted into 'expanded_streams'. Returns:
   //  - INVALID_ARGUMENT : if the number of malformed stream definitions exceeds
   //    a predefined threshold (kMaxMalformedObjects in curio_analyzer.cc).
   //  - OK : otherwise.
-  util::Status AddDependencies(const string& consumer_id,
-                               const Json::Value& consumer_tree);
+  util::Status AddDependencies(
+      const string& consumer_id, const Json::Value& consumer_tree,
+      std::set<std::pair<string, string>>* expanded_streams);
 
   // Increments a global counter of the number of objects in the JSON input that
   // have been skipped. Returns
@@ -14,8 +14,11 @@
 
 #include "analyzers/examples/curio_analyzer.h"
 
+#include <sstream>
+
 #include "gtest.h"
 #include "util/status.h"
+#include "util/string_utils.h"
 
 namespace morphie {
 namespace {
@@ -342,5 +345,136 @@ TEST(CurioAnalyzerTest, MalformedChainMid) {
   EXPECT_EQ(0, curio_analyzer.NumGraphEdges());
 }
 
+// The dependencies of stream4 are listed under both stream2 and stream3.
+//  stream1 -> stream2 -> stream4 -> stream5
+//     |                     ^
+//     +-----> stream3 ------+
+// The subtree below stream4 is expanded once, so stream5 is processed once.
+TEST(CurioAnalyzerTest, SharedSubtrees) {
+  const string stream4 = R"("[/path/to/stream:stream4]" :
+      {"Node":{"ID":{"Package":"/path/to/stream4", "Name":"stream4"}},
+        "Children": {"[/path/to/stream:stream5]" :
+      {"Node":{"ID":{"Package":"/path/to/stream5", "Name":"stream5"}},
+        "Children": {}}}})";
+  const string stream = util::StrCat(R"({"[/path/to/stream:stream1]" :
+      {"Node":{"ID":{"Package":"/path/to/stream1", "Name":"stream1"}},
+       "Children": {"[/path/to/stream:stream2]" :
+      {"Node":{"ID":{"Package":"/path/to/stream2", "Name":"stream2"}},
+        "Children": {)", stream4, R"(}},
+      "[/path/to/stream:stream3]" :
+      {"Node":{"ID":{"Package":"/path/to/stream3", "Name":"stream3"}},
+        "Children": {)", stream4, "}}}}}");
+  CurioAnalyzer curio_analyzer;
+  ASSERT_TRUE(curio_analyzer.Initialize(CreateJSON(stream)).ok());
+  EXPECT_TRUE(curio_analyzer.BuildDependencyGraph().ok());
+  EXPECT_EQ(6, curio_analyzer.NumStreamsProcessed());
+  EXPECT_EQ(0, curio_analyzer.NumStreamsSkipped());
+  EXPECT_EQ(5, curio_analyzer.NumGraphNodes());
+  EXPECT_EQ(5, curio_analyzer.NumGraphEdges());
+}
+
+// A chain of dependencies deeper than the recursion depth of the JSON parser.
+TEST(CurioAnalyzerTest, DeepChains) {
+  const int kDepth = 2000;
+  ::Json::Value tree;
+  tree["Children"] = ::Json::Value(::Json::objectValue);
+  for (int i = kDepth; i > 0; --i) {
+    const string name = util::StrCat("stream", std::to_string(i));
+    tree["Node"]["ID"]["Name"] = name;
+    ::Json::Value parent;
+    parent["Children"][util::StrCat("[/path/to/stream:", name, "]")].swap(tree);
+    tree.swap(parent);
+  }
+  std::unique_ptr<::Json::Value> doc(new ::Json::Value);
+  (*doc)["[/path/to/stream:stream0]"].swap(tree);
+  (*doc)["[/path/to/stream:stream0]"]["Node"]["ID"]["Name"] = "stream0";
+  CurioAnalyzer curio_analyzer;
+  ASSERT_TRUE(curio_analyzer.Initialize(std::move(doc)).ok());
+  EXPECT_TRUE(curio_analyzer.BuildDependencyGraph().ok());
+  EXPECT_EQ(kDepth + 1, curio_analyzer.NumStreamsProcessed());
+  EXPECT_EQ(kDepth + 1, curio_analyzer.NumGraphNodes());
+  EXPECT_EQ(kDepth, curio_analyzer.NumGraphEdges());
+}
+
+// Builds graphs from 'input' with and without a JSON document in memory and
+// checks that they agree.
+void ExpectSameGraphs(const string& input) {
+  CurioAnalyzer dom_analyzer;
+  ASSERT_TRUE(dom_analyzer.Initialize(CreateJSON(input)).ok()) << input;
+  ASSERT_TRUE(dom_analyzer.BuildDependencyGraph().ok()) << input;
+  CurioAnalyzer stream_analyzer;
+  std::istringstream stream(input);
+  ASSERT_TRUE(stream_analyzer.BuildDependencyGraph(&stream).ok()) << input;
+  EXPECT_EQ(dom_analyzer.NumStreamsProcessed(),
+            stream_analyzer.NumStreamsProcessed()) << input;
+  EXPECT_EQ(dom_analyzer.NumStreamsSkipped(),
+            stream_analyzer.NumStreamsSkipped()) << input;
+  EXPECT_EQ(dom_analyzer.DependencyGraphAsDot(),
+            stream_analyzer.DependencyGraphAsDot()) << input;
+}
+
+// Returns the definition of a stream with 'children', which is a list of
+// definitions of streams.
+string Stream(const string& name, const string& children) {
+  return util::StrCat(R"("[/path/to/stream:)", name, R"(]" : {"Node":{"ID":{)",
+                      R"("Package":"/path/to/stream", "Name":")", name,
+                      util::StrCat(R"("}}, "Children": {)", children, "}}"));
+}
+
+TEST(CurioAnalyzerTest, StreamingMatchesDocument) {
+  const string stream3 = Stream("stream3", "");
+  const string stream2 = Stream("stream2", stream3);
+  for (const auto& stream_data : malformed_data) {
+    ExpectSameGraphs(stream_data.first);
+  }
+  for (const auto& stream_data : streams) {
+    ExpectSameGraphs(stream_data.first);
+  }
+  // A chain, a directed acyclic graph and a loop.
+  ExpectSameGraphs(util::StrCat("{", Stream("stream1", stream2), "}"));
+  ExpectSameGraphs(util::StrCat(
+      "{", Stream("stream1", util::StrCat(stream2, ",", stream3)), "}"));
+  ExpectSameGraphs(util::StrCat(
+      "{", Stream("stream1", Stream("stream1", "")), "}"));
+  // Streams that are defined at the top level and as children, and the clock.
+  ExpectSameGraphs(util::StrCat("{", Stream("stream1", stream2), ",", stream2,
+                                ",", util::StrCat(stream3, R"(,"[:clock]" : {}})")));
+  // Malformed children.
+  ExpectSameGraphs(util::StrCat(
+      "{", Stream("stream1", R"("[/path/to/stream:stream2]" : {"Node":{}},
+                                "[/path/to/stream:stream3]" :
+                                {"Node":{"ID":{"Name":"stream3"}}})"),
+      "}"));
+}
+
+TEST(CurioAnalyzerTest, StreamingRejectsInvalidDocuments) {
+  for (const string input : {"", "[]", "{}", "{\"a\": }"}) {
+    CurioAnalyzer curio_analyzer;
+    std::istringstream stream(input);
+    EXPECT_EQ(Code::INVALID_ARGUMENT,
+              curio_analyzer.BuildDependencyGraph(&stream).code())
+        << input;
+  }
+}
+
+// The children of a stream are skipped if they precede the name of the stream,
+// but the stream itself depends on its consumer.
+TEST(CurioAnalyzerTest, StreamingChildrenBeforeNode) {
+  const string input = R"({"[/path/to/stream:stream1]" :
+      {"Node":{"ID":{"Package":"/path/to/stream1", "Name":"stream1"}},
+       "Children": {"[/path/to/stream:stream2]" :
+      {"Children": {"[/path/to/stream:stream3]" :
+      {"Node":{"ID":{"Package":"/path/to/stream3", "Name":"stream3"}},
+        "Children": {}}},
+       "Node":{"ID":{"Package":"/path/to/stream2", "Name":"stream2"}}}}}})";
+  CurioAnalyzer curio_analyzer;
+  std::istringstream stream(input);
+  ASSERT_TRUE(curio_analyzer.BuildDependencyGraph(&stream).ok());
+  EXPECT_EQ(2, curio_analyzer.NumStreamsProcessed());
+  EXPECT_EQ(0, curio_analyzer.NumStreamsSkipped());
+  EXPECT_EQ(2, curio_analyzer.NumGraphNodes());
+  EXPECT_EQ(1, curio_analyzer.NumGraphEdges());
+}
+
 }  // namespace
 }  // namespace morphie
@@ -15,6 +15,7 @@
 #include "analyzers/examples/stream_dependency_graph.h"
 
 #include <set>
+#include <sstream>
 #include <utility>
 
 #include "analyzers/examples/curio_defs.h"
@@ -111,6 +112,13 @@ void StreamDependencyGraph::AddDependency(const string& consumer_id,
 }
 
 string StreamDependencyGraph::ToDot() const {
+  std::ostringstream dot_graph;
+  WriteDot(false /* Do not group styles. */, 1, &dot_graph);
+  return dot_graph.str();
+}
+
+void StreamDependencyGraph::WriteDot(bool group_styles, int num_threads,
+                                     std::ostream* out) const {
   CHECK(is_initialized_, kInitializationErr);
   AttributeFn node_attribute = [](const string& tag, const AST& ast) {
     return DotPrinter::NodeAttribute(tag, ast.c_ast().arg(1));
@@ -118,9 +126,16 @@ string StreamDependencyGraph::ToDot() const {
   AttributeFn edge_attribute = DotPrinter::EdgeAttribute;
 
   DotPrinter dot_printer(node_attribute, edge_attribute);
-  string dot_graph = dot_printer.AllNodesInDot(graph_);
-  util::StrAppend(&dot_graph, dot_printer.AllEdgesInDot(graph_), "\n");
-  return util::StrCat("digraph stream_dependencies {\n", dot_graph, "}");
+  dot_printer.set_group_styles(group_styles);
+  *out << "digraph stream_dependencies {\n";
+  if (num_threads > 1) {
+    dot_printer.WriteParallelAllNodes(graph_, num_threads, out);
+    dot_printer.WriteParallelAllEdges(graph_, num_threads, out);
+  } else {
+    dot_printer.WriteAllNodes(graph_, out);
+    dot_printer.WriteAllEdges(graph_, out);
+  }
+  *out << "\n}";
 }
 
 }  // namespace morphie
@@ -24,6 +24,8 @@
 #ifndef LOGLE_STREAM_DEPENDENCY_GRAPH_H_
 #define LOGLE_STREAM_DEPENDENCY_GRAPH_H_
 
+#include <ostream>
+
 #include "base/string.h"
 #include "graph/graph_interface.h"
 #include "graph/labeled_graph.h"
@@ -61,6 +63,11 @@ class StreamDependencyGraph : public GraphInterface {
 
   // Return a representation of the graph in Graphviz DOT format.
   string ToDot() const;
+  // Writes the representation returned by ToDot to 'out'. If 'group_styles'
+  // is true, nodes and edges are grouped by style as described for
+  // DotPrinter::set_group_styles. If 'num_threads' is greater than 1, the
+  // nodes and edges are rendered on that many threads.
+  void WriteDot(bool group_styles, int num_threads, std::ostream* out) const;
 
  private:
   // This variable is set to false by the constructor and is set to 'true' if
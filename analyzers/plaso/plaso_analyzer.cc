@@ -51,6 +51,11 @@ void PlasoAnalyzer::BuildPlasoGraph() {
   return BuildPlasoGraphFromJSON();
 }
 
+bool PlasoAnalyzer::SummarizePlasoGraph(size_t max_nodes, size_t max_edges) {
+  return plaso_graph_ != nullptr &&
+         plaso_graph_->Summarize(max_nodes, max_edges);
+}
+
 string PlasoAnalyzer::PlasoGraphDot() const {
   return (plaso_graph_ == nullptr) ? "" : plaso_graph_->ToDot();
 }
@@ -59,6 +64,27 @@ string PlasoAnalyzer::PlasoGraphPbTxt() const {
   return (plaso_graph_ == nullptr) ? "" : plaso_graph_->ToPbTxt();
 }
 
+void PlasoAnalyzer::WritePlasoGraphDot(bool group_styles, int num_threads,
+                                       std::ostream* out) const {
+  if (plaso_graph_ != nullptr) {
+    plaso_graph_->WriteDot(group_styles, num_threads, out);
+  }
+}
+
+void PlasoAnalyzer::WritePlasoGraphPbTxt(int num_threads,
+                                         std::ostream* out) const {
+  if (plaso_graph_ != nullptr) {
+    plaso_graph_->WritePbTxt(num_threads, out);
+  }
+}
+
+void PlasoAnalyzer::WritePlasoGraphPb(bool delimited, int num_threads,
+                                      std::ostream* out) const {
+  if (plaso_graph_ != nullptr) {
+    plaso_graph_->WritePb(delimited, num_threads, out);
+  }
+}
+
 string PlasoAnalyzer::PlasoGraphStats() const {
   if (plaso_graph_ == nullptr) {
     return "Graph has not been created!";
@@ -21,7 +21,9 @@
 #define LOGLE_PLASO_ANALYZER_H_
 
 #include <algorithm>
+#include <cstddef>
 #include <memory>
+#include <ostream>
 #include <unordered_map>
 
 #include "analyzers/plaso/plaso_event_graph.h"
@@ -72,9 +74,23 @@ class PlasoAnalyzer {
     return (plaso_graph_ == nullptr) ? 0 : plaso_graph_->NumEdges();
   }
 
+  // Replaces the graph in the output below with a summary within the bounds,
+  // as described for PlasoEventGraph::Summarize. Returns true if the graph has
+  // been built and was summarized.
+  bool SummarizePlasoGraph(size_t max_nodes, size_t max_edges);
   string PlasoGraphStats() const;
   string PlasoGraphDot() const;
   string PlasoGraphPbTxt() const;
+  // Write the representations above to 'out', rendered on 'num_threads'
+  // threads. Nothing is written if the graph has not been built. If
+  // 'group_styles' is true, the nodes and edges in the DOT output are grouped
+  // by style.
+  void WritePlasoGraphDot(bool group_styles, int num_threads,
+                          std::ostream* out) const;
+  void WritePlasoGraphPbTxt(int num_threads, std::ostream* out) const;
+  // Writes the graph in the binary format of PlasoEventGraph::WritePb.
+  void WritePlasoGraphPb(bool delimited, int num_threads,
+                         std::ostream* out) const;
 
  private:
   // Constructs a Plaso graph using a JSON document.
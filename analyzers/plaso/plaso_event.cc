@@ -240,6 +240,31 @@ File ParseFilename(const string& filename) {
   return file;
 }
 
+vector<string> GetParsedDataTypes() {
+  vector<string> data_types;
+  for (const auto& parse_action : kParseActions) {
+    data_types.push_back(parse_action.first);
+  }
+  return data_types;
+}
+
+map<string, FieldKind> GetDataTypeFields(const string& data_type) {
+  map<string, FieldKind> fields;
+  auto action_it = kParseActions.find(data_type);
+  if (action_it == kParseActions.end()) {
+    return fields;
+  }
+  for (const auto& action : (action_it->second).second) {
+    const FieldKind kind = action.first == ParseOption::kMakeFile
+                               ? FieldKind::kFile
+                               : FieldKind::kString;
+    for (const auto& field_pair : action.second) {
+      fields[field_pair.first] = kind;
+    }
+  }
+  return fields;
+}
+
 PlasoEvent ParseJSON(const ::Json::Value& json_event) {
   PlasoEvent event;
   // Convert the nanosecond timestamp from the JSON input to a microsecond
@@ -18,7 +18,10 @@
 #ifndef LOGLE_PLASO_EVENT_H_
 #define LOGLE_PLASO_EVENT_H_
 
+#include <map>
+
 #include "base/string.h"
+#include "base/vector.h"
 #include "json/json.h"
 #include "plaso_event.pb.h"
 #include "ast.pb.h"
@@ -45,6 +48,20 @@ File ParseFilename(const string& filename);
 // Constructs an event proto from a JSON object generated by Timesketch.
 PlasoEvent ParseJSON(const ::Json::Value& json_event);
 
+// The kind of contents ParseJSON expects in a member of a JSON event.
+enum class FieldKind { kString, kFile };
+
+// Returns the Plaso 'data_type' values for which ParseJSON extracts data
+// specific to the type, in sorted order. Events of other types are parsed as
+// events of the type EventType::DEFAULT.
+vector<string> GetParsedDataTypes();
+
+// Returns the JSON members that ParseJSON reads from an event with the given
+// 'data_type', in addition to the fields in plaso::kRequiredFields, with the
+// kind of contents expected in each member. ParseJSON crashes if one of these
+// members is missing.
+std::map<string, FieldKind> GetDataTypeFields(const string& data_type);
+
 // Return a PlasoEventGraph AST representing a file.
 AST ToAST(const File& file);
 
@@ -17,7 +17,6 @@
 // (ASTs) representing either types for labels or values for labels.
 #include "analyzers/plaso/plaso_event_graph.h"
 
-#include <boost/algorithm/string/join.hpp>  // NOLINT
 #include <sstream>
 #include <utility>
 
@@ -25,6 +24,7 @@
 #include "graph/ast.h"
 #include "graph/dot_printer.h"
 #include "graph/graph_exporter.h"
+#include "graph/graph_summarizer.h"
 #include "graph/type.h"
 #include "graph/type_checker.h"
 #include "graph/value.h"
@@ -54,25 +54,27 @@ const char kSystemTag[] = "System";
 // A timeline for the Dot output is a vertical line annotated with timestamps in
 // order with the earliest timestamp at the top.  Events are displayed at the
 // same horizontal level as their timestamp in the timeline.
-string GetTimeline(const std::map<int64_t, std::set<NodeId>>& time_index) {
-  string timeline = "// Sub-graph showing timeline\n{\n";
-  std::vector<string> timestamps;
-  string node_name;
-  string time_aligned_nodes;
+// Writes a subgraph with a node for each timestamp in 'time_index', a chain of
+// edges through the timestamps and a rank constraint that aligns each timestamp
+// with the events at that time.
+void WriteTimeline(const std::map<int64_t, std::set<NodeId>>& time_index,
+                   std::ostream* out) {
+  *out << "// Sub-graph showing timeline\n{\n";
   for (const auto& timed_events : time_index) {
-    node_name = util::StrCat("T", std::to_string(timed_events.first));
-    util::StrAppend(&timeline, "  ", node_name, " [shape=plaintext, ",
-                    R"(label=")", util::UnixMicrosToRFC3339(timed_events.first),
-                    "\"];\n");
-    timestamps.emplace_back(node_name);
-    util::StrAppend(&time_aligned_nodes, "  {rank=same; ", node_name, "; ",
-                    util::SetJoin(timed_events.second, "; "), "}\n");
+    *out << "  T" << timed_events.first << " [shape=plaintext, "
+         << R"(label=")" << util::UnixMicrosToRFC3339(timed_events.first)
+         << "\"];\n";
   }
-  util::StrAppend(&timeline, "  ", boost::algorithm::join(timestamps, " -> "),
-                  ";\n");
-  util::StrAppend(&timeline, time_aligned_nodes);
-  util::StrAppend(&timeline, "}  // subgraph for timeline \n");
-  return timeline;
+  *out << "  ";
+  for (auto it = time_index.begin(); it != time_index.end(); ++it) {
+    *out << (it == time_index.begin() ? "T" : " -> T") << it->first;
+  }
+  *out << ";\n";
+  for (const auto& timed_events : time_index) {
+    *out << "  {rank=same; T" << timed_events.first << "; "
+         << util::SetJoin(timed_events.second, "; ") << "}\n";
+  }
+  *out << "}  // subgraph for timeline \n";
 }
 
 }  // namespace
@@ -274,19 +276,76 @@ TaggedAST PlasoEventGraph::MakeEventLabel(const AST& timestamp,
   return event;
 }
 
+bool PlasoEventGraph::Summarize(size_t max_nodes, size_t max_edges) {
+  CHECK(is_initialized_, kInitializationErr);
+  if (graph::FitsBudget(graph_, max_nodes, max_edges)) {
+    return false;
+  }
+  summary_ = graph::SummarizeGraph(graph_, max_nodes, max_edges);
+  return true;
+}
+
+const LabeledGraph& PlasoEventGraph::OutputGraph() const {
+  return summary_ == nullptr ? graph_ : *summary_;
+}
+
 string PlasoEventGraph::ToDot() const {
+  std::ostringstream dot_graph;
+  WriteDot(false /* Do not group styles. */, 1, &dot_graph);
+  return dot_graph.str();
+}
+
+void PlasoEventGraph::WriteDot(bool group_styles, int num_threads,
+                               std::ostream* out) const {
   CHECK(is_initialized_, kInitializationErr);
   DotPrinter dot_printer;
-  string dot_graph = dot_printer.AllNodesInDot(graph_);
-  util::StrAppend(&dot_graph, GetTimeline(time_index_), "\n");
-  util::StrAppend(&dot_graph, dot_printer.AllEdgesInDot(graph_), "\n");
-  return util::StrCat("digraph logle_graph {\n", dot_graph, "}");
+  dot_printer.set_group_styles(group_styles);
+  const bool is_parallel = num_threads > 1;
+  if (summary_ != nullptr) {
+    if (is_parallel) {
+      dot_printer.WriteParallelDotGraph(*summary_, num_threads, out);
+    } else {
+      dot_printer.WriteDotGraph(*summary_, out);
+    }
+    return;
+  }
+  *out << "digraph logle_graph {\n";
+  if (is_parallel) {
+    dot_printer.WriteParallelAllNodes(graph_, num_threads, out);
+  } else {
+    dot_printer.WriteAllNodes(graph_, out);
+  }
+  WriteTimeline(time_index_, out);
+  *out << "\n";
+  if (is_parallel) {
+    dot_printer.WriteParallelAllEdges(graph_, num_threads, out);
+  } else {
+    dot_printer.WriteAllEdges(graph_, out);
+  }
+  *out << "\n}";
 }
 
 string PlasoEventGraph::ToPbTxt() const {
   CHECK(is_initialized_, kInitializationErr);
-  viz::GraphExporter exporter(graph_);
+  viz::GraphExporter exporter(OutputGraph());
   return exporter.GraphAsString();
 }
 
+void PlasoEventGraph::WritePbTxt(int num_threads, std::ostream* out) const {
+  CHECK(is_initialized_, kInitializationErr);
+  viz::GraphExporter exporter(OutputGraph());
+  *out << exporter.Graph(num_threads).DebugString();
+}
+
+void PlasoEventGraph::WritePb(bool delimited, int num_threads,
+                              std::ostream* out) const {
+  CHECK(is_initialized_, kInitializationErr);
+  viz::GraphExporter exporter(OutputGraph());
+  if (delimited) {
+    exporter.WriteDelimitedNodes(num_threads, out);
+  } else {
+    exporter.WriteGraph(num_threads, out);
+  }
+}
+
 }  // namespace morphie
@@ -27,7 +27,10 @@
 #ifndef LOGLE_PLASO_EVENT_GRAPH_H_
 #define LOGLE_PLASO_EVENT_GRAPH_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <ostream>
 #include <set>
 #include <vector>
 
@@ -101,11 +104,30 @@ class PlasoEventGraph : public GraphInterface {
   // before 'e4'.
   void AddTemporalEdges();
 
+  // Replaces the graph in the output of the functions below with a summary
+  // that has at most 'max_nodes' nodes and 'max_edges' edges, if the graph
+  // is larger. A bound of 0 means that the number is not bounded. See
+  // graph/graph_summarizer.h for how the summary is computed. The DOT output
+  // of a summary has no timeline. Returns true if the graph was summarized.
+  // Requires that no events are added to the graph after this call.
+  bool Summarize(size_t max_nodes, size_t max_edges);
+
   // Returns a representation of the graph in Graphviz DOT format.
   string ToDot() const;
+  // Writes the representation returned by ToDot to 'out'. If 'group_styles'
+  // is true, nodes and edges are grouped by style as described for
+  // DotPrinter::set_group_styles. The Write functions render the graph on
+  // 'num_threads' threads if it is greater than 1, with the same output.
+  void WriteDot(bool group_styles, int num_threads, std::ostream* out) const;
 
   // Returns a human-readable, protobuf representation of the graph.
   string ToPbTxt() const;
+  // Writes the representation returned by ToPbTxt to 'out'.
+  void WritePbTxt(int num_threads, std::ostream* out) const;
+  // Writes the protobuf representation of the graph to 'out' in the binary wire
+  // format. If 'delimited' is true, the nodes are written as a sequence of
+  // length-delimited messages instead of as a single GraphDef.
+  void WritePb(bool delimited, int num_threads, std::ostream* out) const;
 
  private:
   // Adds 'file' as a node to the graph if it does not already exist. If
@@ -127,6 +149,8 @@ class PlasoEventGraph : public GraphInterface {
   // Returns an event label with the timestamp and source ASTs set to the
   // arguments provided.
   TaggedAST MakeEventLabel(const AST& timestamp, const AST& source);
+  // Returns the summary of the graph if there is one, and the graph otherwise.
+  const LabeledGraph& OutputGraph() const;
 
   bool is_initialized_;
   // True if temporal edges have been added to 'graph_'.
@@ -138,6 +162,8 @@ class PlasoEventGraph : public GraphInterface {
   // Maps from a timestamp to the set of event nodes with that timestamp. This
   // index allows for conveniently processing events in chronological order.
   std::map<int64_t, std::set<NodeId>> time_index_;
+  // The summary that is output instead of 'graph_', if any.
+  std::unique_ptr<LabeledGraph> summary_;
 };
 
 }  // namespace morphie
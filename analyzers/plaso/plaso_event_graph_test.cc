@@ -15,6 +15,7 @@
 #include "analyzers/plaso/plaso_event_graph.h"
 
 #include <memory>  // for __alloc_traits<>::value_type
+#include <sstream>
 
 #include "analyzers/plaso/plaso_event.h"
 #include "graph/value.h"
@@ -134,5 +135,52 @@ TEST_F(PlasoEventGraphTest, ProcessEventsWithURLs) {
   EXPECT_EQ(2, graph_.NumEdges());
 }
 
+// Concurrent events that use the same URL are merged in a summary.
+TEST_F(PlasoEventGraphTest, SummarizesLargeGraph) {
+  PlasoEvent event = GetProto();
+  event.set_source_url("www.google.com");
+  for (int i = 0; i < 10; ++i) {
+    graph_.ProcessEvent(event);
+  }
+  graph_.AddTemporalEdges();
+  EXPECT_FALSE(graph_.Summarize(11, 10));
+  EXPECT_NE(string::npos, graph_.ToDot().find("Sub-graph showing timeline"));
+  EXPECT_TRUE(graph_.Summarize(5, 0));
+  EXPECT_EQ(11, graph_.NumNodes());
+  EXPECT_EQ(string::npos, graph_.ToDot().find("Sub-graph showing timeline"));
+  EXPECT_NE(string::npos, graph_.ToPbTxt().find("EventSummary"));
+}
+
+// Writes the graph in DOT and text protobuf formats on 'num_threads' threads.
+string WriteGraph(const PlasoEventGraph& graph, bool group_styles,
+                  int num_threads) {
+  std::ostringstream out;
+  graph.WriteDot(group_styles, num_threads, &out);
+  graph.WritePbTxt(num_threads, &out);
+  return out.str();
+}
+
+// The output rendered on several threads is the output rendered on one, with
+// and without a summary.
+TEST_F(PlasoEventGraphTest, ParallelOutputMatchesSerial) {
+  PlasoEvent event = GetProto();
+  for (int i = 0; i < 20; ++i) {
+    event.set_source_url(i % 3 == 0 ? "www.google.com" : "www.example.com");
+    event.set_timestamp(event.timestamp() + (i % 2) * 1000000);
+    graph_.ProcessEvent(event);
+  }
+  graph_.AddTemporalEdges();
+  for (bool is_summary : {false, true}) {
+    if (is_summary) {
+      EXPECT_TRUE(graph_.Summarize(5, 0));
+    }
+    for (bool group_styles : {false, true}) {
+      const string serial = WriteGraph(graph_, group_styles, 1);
+      EXPECT_EQ(serial, WriteGraph(graph_, group_styles, 3));
+      EXPECT_EQ(serial, WriteGraph(graph_, group_styles, 64));
+    }
+  }
+}
+
 }  // namespace
 }  // namespace morphie
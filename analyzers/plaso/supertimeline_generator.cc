@@ -0,0 +1,347 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "analyzers/plaso/supertimeline_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <utility>
+
+#include "analyzers/plaso/plaso_defs.h"
+#include "analyzers/plaso/plaso_event.h"
+#include "base/string.h"
+#include "base/vector.h"
+#include "util/string_utils.h"
+
+namespace morphie {
+namespace plaso {
+
+namespace {
+
+const int64_t kMicrosPerSecond = 1000000;
+// Output is written to the stream in blocks of about this many bytes.
+const size_t kBlockSize = 1 << 20;
+
+// The relative frequencies of 'data_type' values. Types handled by ParseJSON
+// that are not listed here have a weight of 1. The last two types are not
+// handled by ParseJSON and are parsed as default events.
+const std::map<string, int> kDataTypeWeights = {
+    {"chrome:cache:entry", 20},
+    {"chrome:cookie:entry", 10},
+    {"chrome:extension_activity:activity_log", 2},
+    {"chrome:history:file_downloaded", 2},
+    {"chrome:history:page_visited", 30},
+    {"firefox:cache:record", 4},
+    {"firefox:cookie:entry", 4},
+    {"firefox:places:page_visited", 8},
+    {"windows:evt:record", 3},
+    {"windows:evtx:record", 25},
+    {"windows:prefetch:execution", 6},
+    {"windows:registry:appcompatcache", 4},
+    {"windows:shell_item:file_entry", 8},
+    {"task_scheduler:task_cache:entry", 2},
+    {"fs:stat", 60},
+    {"windows:registry:key_value", 20}};
+
+const char* const kTimestampDescriptions[] = {
+    "Last Visited Time", "Creation Time", "Last Access Time",
+    "Content Modification Time", "Expiration Time"};
+
+const char* const kParentDirectories[] = {
+    "Documents", "Downloads", "AppData/Local", "AppData/Roaming/Mozilla",
+    "Desktop/projects/2015"};
+
+const char* const kExtensions[] = {".exe", ".dll", ".pdf", ".log", ".txt",
+                                   ".jpg"};
+
+// Appends 'str' as a JSON string to 'out'.
+void AppendJSONString(const string& str, string* out) {
+  out->push_back('"');
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      static const char kHex[] = "0123456789abcdef";
+      out->append("\\u00");
+      out->push_back(kHex[(c >> 4) & 0xf]);
+      out->push_back(kHex[c & 0xf]);
+    } else {
+      out->push_back(c);
+    }
+  }
+  out->push_back('"');
+}
+
+// Samples the integers 0 to n - 1 with the probability of 'i' proportional to
+// 1 / (i + 1)^s, by a binary search of the cumulative distribution.
+class ZipfSampler {
+ public:
+  ZipfSampler(int n, double s) : cdf_(n) {
+    double sum = 0;
+    for (int i = 0; i < n; ++i) {
+      sum += std::pow(i + 1, -s);
+      cdf_[i] = sum;
+    }
+  }
+
+  // Returns the sample for 'u', which must be in [0, 1).
+  int Sample(double u) const {
+    const auto it = std::upper_bound(cdf_.begin(), cdf_.end(), u * cdf_.back());
+    return std::min<int>(it - cdf_.begin(), cdf_.size() - 1);
+  }
+
+ private:
+  vector<double> cdf_;
+};
+
+// Generates the events of a timeline one at a time. The random numbers are
+// derived directly from the output of a std::mt19937_64, which is specified by
+// the standard, so the output depends only on the options.
+class TimelineGenerator {
+ public:
+  explicit TimelineGenerator(const TimelineOptions& options)
+      : options_(options),
+        rng_(options.seed),
+        files_(options.num_files, options.zipf_exponent),
+        directories_(options.num_directories, options.zipf_exponent),
+        urls_(options.num_urls, options.zipf_exponent),
+        names_(256, options.zipf_exponent),
+        required_fields_(util::SplitToVector(kRequiredFields, ',')),
+        seconds_(options.start_seconds),
+        micros_(0),
+        burst_remaining_(0) {
+    double total_weight = 0;
+    for (const string& data_type : GetParsedDataTypes()) {
+      data_types_.push_back(data_type);
+    }
+    for (const auto& type_weight : kDataTypeWeights) {
+      if (std::find(data_types_.begin(), data_types_.end(),
+                    type_weight.first) == data_types_.end()) {
+        data_types_.push_back(type_weight.first);
+      }
+    }
+    for (const string& data_type : data_types_) {
+      auto weight_it = kDataTypeWeights.find(data_type);
+      total_weight += weight_it == kDataTypeWeights.end() ? 1 : weight_it->second;
+      type_cdf_.push_back(total_weight);
+      type_fields_.push_back(GetDataTypeFields(data_type));
+    }
+    // Each file is in a directory, and popular directories contain many files.
+    file_directories_.reserve(options.num_files);
+    for (int i = 0; i < options.num_files; ++i) {
+      file_directories_.push_back(directories_.Sample(Uniform()));
+    }
+  }
+
+  // Appends the next event, terminated by a newline, to 'out'.
+  void AppendEvent(string* out) {
+    const int64_t timestamp = NextTimestamp();
+    const size_t type_index =
+        std::upper_bound(type_cdf_.begin(), type_cdf_.end(),
+                         Uniform() * type_cdf_.back()) -
+        type_cdf_.begin();
+    const string& data_type = data_types_[type_index];
+    string missing_field;
+    if (Uniform() < options_.malformed_rate) {
+      missing_field = required_fields_[static_cast<size_t>(
+          Uniform() * required_fields_.size())];
+    }
+    vector<std::pair<string, string>> fields = {
+        {kDataTypeName, data_type},
+        {kSourceFileName, SourceFile(data_type)},
+        {kDescriptionName,
+         kTimestampDescriptions[static_cast<int>(
+             Uniform() * sizeof(kTimestampDescriptions) /
+             sizeof(kTimestampDescriptions[0]))]},
+        {kMessageName, util::StrCat("Synthetic ", data_type, " event")}};
+    for (const auto& field : type_fields_[type_index]) {
+      fields.emplace_back(field.first, FieldValue(field.first, field.second));
+    }
+    out->push_back('{');
+    if (missing_field != kTimestampName) {
+      util::StrAppend(out, "\"", kTimestampName, "\":",
+                      std::to_string(timestamp * 1000));
+    }
+    for (const auto& field : fields) {
+      if (field.first == missing_field) {
+        continue;
+      }
+      if (out->back() != '{') {
+        out->push_back(',');
+      }
+      AppendJSONString(field.first, out);
+      out->push_back(':');
+      AppendJSONString(field.second, out);
+    }
+    out->append("}\n");
+  }
+
+ private:
+  // Returns a number in [0, 1).
+  double Uniform() { return (rng_() >> 11) * (1.0 / (UINT64_C(1) << 53)); }
+
+  // Returns a geometrically distributed number with the given mean, which is
+  // at least 1.
+  int64_t Geometric(double mean) {
+    if (mean <= 1) {
+      return 1;
+    }
+    return 1 + static_cast<int64_t>(std::floor(std::log(1 - Uniform()) /
+                                               std::log(1 - 1 / mean)));
+  }
+
+  // Returns the timestamp of the next event in microseconds. Timestamps do not
+  // decrease. The events of a burst are spread over one second.
+  int64_t NextTimestamp() {
+    if (options_.shape == TimelineShape::kSingleTimestamp) {
+      return options_.start_seconds * kMicrosPerSecond;
+    }
+    if (burst_remaining_ == 0) {
+      if (micros_ > 0) {
+        seconds_ += Geometric(options_.mean_gap_seconds);
+      }
+      burst_remaining_ = Geometric(options_.mean_burst_size);
+      micros_ = 0;
+    }
+    micros_ += static_cast<int64_t>(Uniform() * (kMicrosPerSecond - micros_) /
+                                    burst_remaining_);
+    --burst_remaining_;
+    // A non-zero offset marks that a burst has started.
+    micros_ = std::max<int64_t>(micros_, 1);
+    return seconds_ * kMicrosPerSecond + micros_;
+  }
+
+  string DirectoryPath(int directory) const {
+    return util::StrCat(
+        "C:/Users/user", std::to_string(directory % options_.num_users), "/",
+        kParentDirectories[directory % (sizeof(kParentDirectories) /
+                                        sizeof(kParentDirectories[0]))],
+        "/dir", std::to_string(directory));
+  }
+
+  string FilePath(int file) const {
+    return util::StrCat(
+        DirectoryPath(file_directories_[file]), "/file", std::to_string(file),
+        kExtensions[file % (sizeof(kExtensions) / sizeof(kExtensions[0]))]);
+  }
+
+  // Returns the file from which Plaso extracted an event.
+  string SourceFile(const string& data_type) {
+    if (options_.shape == TimelineShape::kHubFile) {
+      return FilePath(0);
+    }
+    string database = data_type;
+    std::replace(database.begin(), database.end(), ':', '_');
+    return util::StrCat(
+        "C:/Users/user",
+        std::to_string(static_cast<int>(Uniform() * options_.num_users)),
+        "/AppData/", database, ".db");
+  }
+
+  string FieldValue(const string& name, FieldKind kind) {
+    if (kind == FieldKind::kFile) {
+      return FilePath(options_.shape == TimelineShape::kHubFile
+                          ? 0
+                          : files_.Sample(Uniform()));
+    }
+    if (name.find("url") != string::npos || name == "from_visit") {
+      const int url = urls_.Sample(Uniform());
+      return util::StrCat("http://site", std::to_string(url % 997),
+                          ".example.com/page", std::to_string(url), ".html");
+    }
+    return util::StrCat(name, "-", std::to_string(names_.Sample(Uniform())));
+  }
+
+  const TimelineOptions options_;
+  std::mt19937_64 rng_;
+  ZipfSampler files_;
+  ZipfSampler directories_;
+  ZipfSampler urls_;
+  // Samples application, extension and other names.
+  ZipfSampler names_;
+  vector<string> required_fields_;
+  vector<string> data_types_;
+  // The cumulative weights and the type-specific fields of 'data_types_'.
+  vector<double> type_cdf_;
+  vector<std::map<string, FieldKind>> type_fields_;
+  vector<int> file_directories_;
+  // The second of the current burst, the offset in microseconds of the last
+  // event within that second and the number of events left in the burst.
+  int64_t seconds_;
+  int64_t micros_;
+  int64_t burst_remaining_;
+};
+
+util::Status CheckOptions(const TimelineOptions& options) {
+  if (options.num_events < 0 || options.num_bytes < 0 ||
+      (options.num_events == 0 && options.num_bytes == 0)) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "The number of events or bytes must be limited.");
+  }
+  if (options.num_files < 1 || options.num_directories < 1 ||
+      options.num_urls < 1 || options.num_users < 1) {
+    return util::Status(
+        Code::INVALID_ARGUMENT,
+        "There must be at least one file, directory, URL and user.");
+  }
+  if (!(options.zipf_exponent > 0)) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "The Zipf exponent must be positive.");
+  }
+  if (!(options.mean_burst_size >= 1) || !(options.mean_gap_seconds >= 1)) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "The mean burst size and gap must be at least 1.");
+  }
+  if (!(options.malformed_rate >= 0 && options.malformed_rate <= 1)) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "The malformed rate must be between 0 and 1.");
+  }
+  return util::Status::OK;
+}
+
+}  // namespace
+
+util::Status WriteSupertimeline(const TimelineOptions& options,
+                                std::ostream* out) {
+  util::Status status = CheckOptions(options);
+  if (!status.ok()) {
+    return status;
+  }
+  TimelineGenerator generator(options);
+  string block;
+  int64_t num_bytes = 0;
+  for (int64_t num_events = 0;
+       (options.num_events == 0 || num_events < options.num_events) &&
+       (options.num_bytes == 0 ||
+        num_bytes + static_cast<int64_t>(block.size()) < options.num_bytes);
+       ++num_events) {
+    generator.AppendEvent(&block);
+    if (block.size() >= kBlockSize) {
+      num_bytes += block.size();
+      out->write(block.data(), block.size());
+      block.clear();
+    }
+  }
+  out->write(block.data(), block.size());
+  if (out->fail()) {
+    return util::Status(Code::EXTERNAL, "Could not write the timeline.");
+  }
+  return util::Status::OK;
+}
+
+}  // namespace plaso
+}  // namespace morphie
@@ -0,0 +1,113 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// This file defines a generator of synthetic Plaso supertimelines in the JSON
+// stream format read by StreamJson, with one JSON event per line. The output is
+// meant for benchmarking and stress testing the PlasoAnalyzer on inputs that
+// are much larger than the hand-written test inputs.
+//
+// A realistic timeline has
+//  - events of the 'data_type' values handled by ParseJSON, in proportions
+//    resembling the output of Plaso on a desktop machine, and some events of
+//    a type that ParseJSON does not handle specially,
+//  - files, directories and URLs whose popularity follows a Zipf distribution,
+//    so that a few files and URLs occur in many events,
+//  - bursts of many events within the same second, separated by gaps, and
+//  - a configurable fraction of malformed events, which lack one of the fields
+//    in plaso::kRequiredFields and are skipped by the PlasoAnalyzer.
+// Every line is valid JSON, since StreamJson does not recover from lines that
+// are not.
+//
+// Adversarial timelines stress a single part of the analysis: all events can
+// have the same timestamp, or every file in every event can be the same file.
+//
+// Example. Write one million events.
+//   TimelineOptions options;
+//   options.num_events = 1000000;
+//   std::ofstream out("timeline.jsonl");
+//   util::Status status = WriteSupertimeline(options, &out);
+#ifndef LOGLE_SUPERTIMELINE_GENERATOR_H_
+#define LOGLE_SUPERTIMELINE_GENERATOR_H_
+
+#include <cstdint>
+#include <ostream>
+
+#include "util/status.h"
+
+namespace morphie {
+namespace plaso {
+
+enum class TimelineShape {
+  kRealistic,
+  // All events have the same timestamp.
+  kSingleTimestamp,
+  // Every file in every event is the same file.
+  kHubFile
+};
+
+struct TimelineOptions {
+  TimelineOptions()
+      : num_events(100000),
+        num_bytes(0),
+        seed(1),
+        shape(TimelineShape::kRealistic),
+        num_files(100000),
+        num_directories(5000),
+        num_urls(50000),
+        num_users(8),
+        zipf_exponent(1.1),
+        mean_burst_size(20),
+        mean_gap_seconds(30),
+        malformed_rate(0),
+        start_seconds(1420070400) {}
+
+  // Generation stops after 'num_events' events or once at least 'num_bytes'
+  // bytes have been written, whichever comes first. A value of 0 means there
+  // is no limit of that kind, but at least one limit must be set.
+  int64_t num_events;
+  int64_t num_bytes;
+  // The output is determined by the options, including the seed.
+  uint64_t seed;
+  TimelineShape shape;
+  // The number of distinct files, directories, URLs and users.
+  int num_files;
+  int num_directories;
+  int num_urls;
+  int num_users;
+  // The exponent of the Zipf distributions of files, directories and URLs,
+  // which must be positive. Larger exponents concentrate events on fewer
+  // items.
+  double zipf_exponent;
+  // Events occur in bursts within one second. The sizes of bursts and the
+  // gaps in seconds between them are geometrically distributed with these
+  // means, which must be at least 1.
+  double mean_burst_size;
+  double mean_gap_seconds;
+  // The fraction of events that lack a required field, between 0 and 1.
+  double malformed_rate;
+  // The Unix time in seconds of the first event.
+  int64_t start_seconds;
+};
+
+// Writes a supertimeline to 'out'. Returns
+//  - INVALID_ARGUMENT if the options are not valid.
+//  - EXTERNAL if writing to 'out' fails.
+//  - OK otherwise.
+util::Status WriteSupertimeline(const TimelineOptions& options,
+                                std::ostream* out);
+
+}  // namespace plaso
+}  // namespace morphie
+
+#endif  // LOGLE_SUPERTIMELINE_GENERATOR_H_
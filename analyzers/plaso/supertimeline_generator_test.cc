@@ -0,0 +1,178 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "analyzers/plaso/supertimeline_generator.h"
+
+#include <cstdint>
+#include <set>
+#include <sstream>
+
+#include "analyzers/plaso/plaso_defs.h"
+#include "analyzers/plaso/plaso_event.h"
+#include "base/string.h"
+#include "base/vector.h"
+#include "gtest.h"
+#include "json/json.h"
+#include "util/string_utils.h"
+
+namespace morphie {
+namespace {
+
+// Generates a timeline and parses each line of it into 'events'.
+void Generate(const plaso::TimelineOptions& options,
+              vector<Json::Value>* events) {
+  std::ostringstream out;
+  ASSERT_TRUE(plaso::WriteSupertimeline(options, &out).ok());
+  std::istringstream in(out.str());
+  Json::Reader reader;
+  string line;
+  while (std::getline(in, line)) {
+    Json::Value event;
+    ASSERT_TRUE(reader.parse(line, event)) << line;
+    events->push_back(event);
+  }
+}
+
+bool IsWellFormed(const Json::Value& event) {
+  for (const string& field : util::SplitToVector(plaso::kRequiredFields, ',')) {
+    if (!event.isMember(field)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(SupertimelineGeneratorTest, RejectsInvalidOptions) {
+  std::ostringstream out;
+  plaso::TimelineOptions options;
+  options.num_events = 0;
+  EXPECT_EQ(Code::INVALID_ARGUMENT,
+            plaso::WriteSupertimeline(options, &out).code());
+  options = plaso::TimelineOptions();
+  options.zipf_exponent = 0;
+  EXPECT_EQ(Code::INVALID_ARGUMENT,
+            plaso::WriteSupertimeline(options, &out).code());
+  options = plaso::TimelineOptions();
+  options.mean_burst_size = 0.5;
+  EXPECT_EQ(Code::INVALID_ARGUMENT,
+            plaso::WriteSupertimeline(options, &out).code());
+  options = plaso::TimelineOptions();
+  options.malformed_rate = 1.5;
+  EXPECT_EQ(Code::INVALID_ARGUMENT,
+            plaso::WriteSupertimeline(options, &out).code());
+  options = plaso::TimelineOptions();
+  options.num_files = 0;
+  EXPECT_EQ(Code::INVALID_ARGUMENT,
+            plaso::WriteSupertimeline(options, &out).code());
+  EXPECT_TRUE(out.str().empty());
+}
+
+// A realistic timeline consists of well-formed events that ParseJSON accepts,
+// with non-decreasing timestamps and a mix of data types.
+TEST(SupertimelineGeneratorTest, GeneratesRealisticTimelines) {
+  plaso::TimelineOptions options;
+  options.num_events = 2000;
+  options.num_files = 1000;
+  options.num_urls = 1000;
+  vector<Json::Value> events;
+  Generate(options, &events);
+  ASSERT_EQ(2000, events.size());
+  std::set<string> data_types;
+  std::set<int64_t> timestamps;
+  int64_t previous = 0;
+  for (const Json::Value& event : events) {
+    ASSERT_TRUE(IsWellFormed(event));
+    const int64_t timestamp = event[plaso::kTimestampName].asInt64();
+    EXPECT_LE(previous, timestamp);
+    previous = timestamp;
+    timestamps.insert(timestamp / 1000000000);
+    data_types.insert(event[plaso::kDataTypeName].asString());
+    PlasoEvent parsed = plaso::ParseJSON(event);
+    EXPECT_EQ(timestamp / 1000, parsed.timestamp());
+  }
+  // Events occur in bursts, so there are fewer seconds than events.
+  EXPECT_LT(timestamps.size(), events.size() / 2);
+  for (const string& data_type : plaso::GetParsedDataTypes()) {
+    EXPECT_EQ(1, data_types.count(data_type)) << data_type;
+  }
+  EXPECT_EQ(1, data_types.count("fs:stat"));
+}
+
+TEST(SupertimelineGeneratorTest, IsDeterministic) {
+  plaso::TimelineOptions options;
+  options.num_events = 500;
+  std::ostringstream out1, out2, out3;
+  ASSERT_TRUE(plaso::WriteSupertimeline(options, &out1).ok());
+  ASSERT_TRUE(plaso::WriteSupertimeline(options, &out2).ok());
+  options.seed = 2;
+  ASSERT_TRUE(plaso::WriteSupertimeline(options, &out3).ok());
+  EXPECT_EQ(out1.str(), out2.str());
+  EXPECT_NE(out1.str(), out3.str());
+}
+
+TEST(SupertimelineGeneratorTest, LimitsSize) {
+  plaso::TimelineOptions options;
+  options.num_events = 0;
+  options.num_bytes = 100000;
+  std::ostringstream out;
+  ASSERT_TRUE(plaso::WriteSupertimeline(options, &out).ok());
+  EXPECT_LE(100000, out.str().size());
+  EXPECT_GT(110000, out.str().size());
+}
+
+TEST(SupertimelineGeneratorTest, GeneratesMalformedEvents) {
+  plaso::TimelineOptions options;
+  options.num_events = 2000;
+  options.malformed_rate = 0.25;
+  vector<Json::Value> events;
+  Generate(options, &events);
+  ASSERT_EQ(2000, events.size());
+  int num_malformed = 0;
+  for (const Json::Value& event : events) {
+    num_malformed += IsWellFormed(event) ? 0 : 1;
+  }
+  EXPECT_LT(400, num_malformed);
+  EXPECT_GT(600, num_malformed);
+}
+
+TEST(SupertimelineGeneratorTest, GeneratesAdversarialShapes) {
+  plaso::TimelineOptions options;
+  options.num_events = 500;
+  options.shape = plaso::TimelineShape::kSingleTimestamp;
+  vector<Json::Value> events;
+  Generate(options, &events);
+  std::set<int64_t> timestamps;
+  for (const Json::Value& event : events) {
+    timestamps.insert(event[plaso::kTimestampName].asInt64());
+  }
+  EXPECT_EQ(1, timestamps.size());
+
+  options.shape = plaso::TimelineShape::kHubFile;
+  events.clear();
+  Generate(options, &events);
+  std::set<string> files;
+  for (const Json::Value& event : events) {
+    files.insert(event[plaso::kSourceFileName].asString());
+    for (const auto& field :
+         plaso::GetDataTypeFields(event[plaso::kDataTypeName].asString())) {
+      if (field.second == plaso::FieldKind::kFile) {
+        files.insert(event[field.first].asString());
+      }
+    }
+  }
+  EXPECT_EQ(1, files.size());
+}
+
+}  // namespace
+}  // namespace morphie
@@ -0,0 +1,96 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Benchmarks for building the graph of the account access analyzer from CSV
+// input. The first argument is the number of threads. With one thread, the
+// input is parsed by a CSVParser and the graph is built serially, which is the
+// baseline for the speedup of the parallel build with a ParallelCSVParser. The
+// second argument is 1 if accesses are aggregated.
+//
+// The benchmarks report bytes processed per second and the size of the graph,
+// which does not depend on the number of threads.
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <sstream>
+
+#include "analyzers/examples/account_access_analyzer.h"
+#include "base/string.h"
+#include "util/csv.h"
+#include "util/logging.h"
+#include "util/status.h"
+
+namespace morphie {
+namespace {
+
+const size_t kInputSize = 16 << 20;
+
+// Returns CSV input of approximately 'num_bytes' bytes with the columns the
+// analyzer requires. Each of 1000 actors accesses 8 of 7919 users with 5
+// different counts, so as in real logs, accesses recur and the graph is much
+// smaller than the input.
+string MakeAccessInput(size_t num_bytes) {
+  string input = "fromx,tox,attr_count,attr_actor_title,attr_actor_manager\n";
+  for (int i = 0; input.size() < num_bytes; ++i) {
+    const int actor = i % 1000;
+    const int user = (actor * 13 + (i / 1000) % 8) % 7919;
+    input += "actor" + std::to_string(actor) + "@example.com,";
+    input += "user" + std::to_string(user) + "@example.com,";
+    input += std::to_string(1 + (i / 8000) % 5) + ",";
+    input += "Engineer Level " + std::to_string(actor % 7) + ",";
+    input += "manager" + std::to_string(actor % 31) + "@example.com\n";
+  }
+  return input;
+}
+
+void BM_BuildAccessGraph(benchmark::State& state) {
+  const string input = MakeAccessInput(kInputSize);
+  const int num_threads = state.range(0);
+  const bool aggregate_accesses = state.range(1) != 0;
+  int num_nodes = 0;
+  int num_edges = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = new std::istringstream(input);
+    state.ResumeTiming();
+    AccessAnalyzer analyzer(aggregate_accesses);
+    util::Status status;
+    if (num_threads == 1) {
+      status = analyzer.Initialize(
+          std::unique_ptr<util::CSVParser>(new util::CSVParser(stream)));
+    } else {
+      status = analyzer.Initialize(stream, ',', num_threads,
+                                   util::ParallelCSVParser::kDefaultChunkSize);
+    }
+    CHECK(status.ok(), status.message());
+    status = analyzer.BuildAccessGraph();
+    CHECK(status.ok(), status.message());
+    num_nodes = analyzer.NumGraphNodes();
+    num_edges = analyzer.NumGraphEdges();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(input.size()));
+  state.counters["nodes"] = num_nodes;
+  state.counters["edges"] = num_edges;
+}
+BENCHMARK(BM_BuildAccessGraph)
+    ->ArgNames({"threads", "aggregate"})
+    ->ArgsProduct({{1, 2, 4, 8}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace morphie
+
+BENCHMARK_MAIN();
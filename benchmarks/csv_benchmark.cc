@@ -0,0 +1,139 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Throughput benchmarks for the CSV parser. The input resembles the output of a
+// mail access log export, with one header line and rows of five columns. The
+// benchmarks report bytes processed per second, so the output can be compared
+// directly against the rate at which input can be read from disk.
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <sstream>
+#include <vector>
+
+#include "base/string.h"
+#include "util/csv.h"
+#include "util/csv_scan.h"
+
+namespace morphie {
+namespace {
+
+// Returns CSV input of approximately 'num_bytes' bytes. If 'quote_fields' is
+// true, the title field on every line is quoted and contains a delimiter.
+string MakeAccessInput(size_t num_bytes, bool quote_fields) {
+  string input = "fromx,tox,attr_count,attr_actor_title,attr_actor_manager\n";
+  for (int i = 0; input.size() < num_bytes; ++i) {
+    input += "actor" + std::to_string(i % 1000) + "@example.com,";
+    input += "user" + std::to_string(i % 7919) + "@example.com,";
+    input += std::to_string(i % 100) + ",";
+    input += quote_fields ? "\"Engineer, Level " + std::to_string(i % 7) + "\","
+                          : "Engineer Level " + std::to_string(i % 7) + ",";
+    input += "manager" + std::to_string(i % 31) + "@example.com\n";
+  }
+  return input;
+}
+
+// Parses 'input' and accesses every field of every record.
+void ParseAll(benchmark::State& state, const string& input) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = new std::istringstream(input);
+    state.ResumeTiming();
+    util::CSVParser parser(stream);
+    size_t num_fields = 0;
+    for (const util::Record& record : parser) {
+      for (util::StringPiece field : record) {
+        num_fields += field.size() > 0;
+      }
+    }
+    benchmark::DoNotOptimize(num_fields);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(input.size()));
+}
+
+void BM_ParseUnquoted(benchmark::State& state) {
+  const string input = MakeAccessInput(state.range(0), false);
+  ParseAll(state, input);
+}
+BENCHMARK(BM_ParseUnquoted)->Arg(1 << 20)->Arg(64 << 20);
+
+void BM_ParseQuoted(benchmark::State& state) {
+  const string input = MakeAccessInput(state.range(0), true);
+  ParseAll(state, input);
+}
+BENCHMARK(BM_ParseQuoted)->Arg(1 << 20)->Arg(64 << 20);
+
+// Parses 64 MiB of unquoted input with a ParallelCSVParser using the number of
+// threads given by the argument.
+void BM_ParseParallel(benchmark::State& state) {
+  const string input = MakeAccessInput(64 << 20, false);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = new std::istringstream(input);
+    state.ResumeTiming();
+    util::ParallelCSVParser parser(stream, ',', state.range(0));
+    std::atomic<size_t> num_fields(0);
+    parser.Parse([&num_fields](int, const util::RecordBatch& batch) {
+      size_t batch_fields = 0;
+      for (size_t i = 0; i < batch.size(); ++i) {
+        for (util::StringPiece field : batch[i]) {
+          batch_fields += field.size() > 0;
+        }
+      }
+      num_fields += batch_fields;
+    });
+    benchmark::DoNotOptimize(num_fields.load());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(input.size()));
+}
+BENCHMARK(BM_ParseParallel)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Indexes the structural characters in 'input' with 'scan_fn'. The input fits
+// in the cache, so this measures the cost of the scan alone.
+void IndexAll(benchmark::State& state, util::scan::BlockScanFn scan_fn) {
+  string input = MakeAccessInput(1 << 20, false);
+  const size_t input_size = input.size();
+  input += "\n" + string(util::scan::kBlockSize, ' ');
+  std::vector<uint64_t> index;
+  for (auto _ : state) {
+    index.clear();
+    util::scan::IndexStructurals(scan_fn, ',', input.data(), input.data(),
+                                 input.data() + input_size, &index);
+    benchmark::DoNotOptimize(index.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(input_size));
+}
+
+void BM_IndexScalar(benchmark::State& state) {
+  IndexAll(state, util::scan::ScanBlockScalar);
+}
+BENCHMARK(BM_IndexScalar);
+
+void BM_IndexSSE2(benchmark::State& state) {
+  IndexAll(state, util::scan::ScanBlockSSE2);
+}
+BENCHMARK(BM_IndexSSE2);
+
+void BM_IndexBest(benchmark::State& state) {
+  IndexAll(state, util::scan::GetBlockScanFn());
+}
+BENCHMARK(BM_IndexBest);
+
+}  // namespace
+}  // namespace morphie
+
+BENCHMARK_MAIN();
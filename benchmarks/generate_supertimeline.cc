@@ -0,0 +1,85 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Writes a synthetic Plaso supertimeline in the JSON stream format to a file or
+// to standard output, for benchmarking the Plaso analyzer on large inputs.
+//
+// Example. Write a one gigabyte timeline in which 1% of events are malformed.
+//   generate_supertimeline --num_events=0 --num_bytes=1000000000
+//                          --malformed_rate=0.01 --output=timeline.jsonl
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "analyzers/plaso/supertimeline_generator.h"
+#include "gflags/gflags.h"
+#include "util/status.h"
+
+using std::string;
+
+DEFINE_int64(num_events, 100000, "Number of events, or 0 for no limit.");
+DEFINE_int64(num_bytes, 0, "Approximate output size, or 0 for no limit.");
+DEFINE_uint64(seed, 1, "Seed of the random number generator.");
+DEFINE_string(shape, "realistic",
+              "One of 'realistic', 'single_timestamp' or 'hub_file'.");
+DEFINE_int32(num_files, 100000, "Number of distinct files.");
+DEFINE_int32(num_directories, 5000, "Number of distinct directories.");
+DEFINE_int32(num_urls, 50000, "Number of distinct URLs.");
+DEFINE_int32(num_users, 8, "Number of distinct users.");
+DEFINE_double(zipf_exponent, 1.1,
+              "Exponent of the popularity of files, directories and URLs.");
+DEFINE_double(mean_burst_size, 20, "Mean number of events per burst.");
+DEFINE_double(mean_gap_seconds, 30, "Mean number of seconds between bursts.");
+DEFINE_double(malformed_rate, 0, "Fraction of events missing a field.");
+DEFINE_int64(start_seconds, 1420070400, "Unix time of the first event.");
+DEFINE_string(output, "", "Output file. Standard output if empty.");
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  morphie::plaso::TimelineOptions options;
+  options.num_events = FLAGS_num_events;
+  options.num_bytes = FLAGS_num_bytes;
+  options.seed = FLAGS_seed;
+  if (FLAGS_shape == "realistic") {
+    options.shape = morphie::plaso::TimelineShape::kRealistic;
+  } else if (FLAGS_shape == "single_timestamp") {
+    options.shape = morphie::plaso::TimelineShape::kSingleTimestamp;
+  } else if (FLAGS_shape == "hub_file") {
+    options.shape = morphie::plaso::TimelineShape::kHubFile;
+  } else {
+    std::cerr << "Unknown timeline shape: " << FLAGS_shape;
+    return -1;
+  }
+  options.num_files = FLAGS_num_files;
+  options.num_directories = FLAGS_num_directories;
+  options.num_urls = FLAGS_num_urls;
+  options.num_users = FLAGS_num_users;
+  options.zipf_exponent = FLAGS_zipf_exponent;
+  options.mean_burst_size = FLAGS_mean_burst_size;
+  options.mean_gap_seconds = FLAGS_mean_gap_seconds;
+  options.malformed_rate = FLAGS_malformed_rate;
+  options.start_seconds = FLAGS_start_seconds;
+  morphie::util::Status status;
+  if (FLAGS_output.empty()) {
+    status = morphie::plaso::WriteSupertimeline(options, &std::cout);
+  } else {
+    std::ofstream out(FLAGS_output);
+    status = morphie::plaso::WriteSupertimeline(options, &out);
+  }
+  if (!status.ok()) {
+    std::cerr << status.message();
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,320 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Benchmarks for the graph transformations in graph_transformer.h and for
+// partition refinement in graph_analyzer.h.
+//
+// Every transformation runs on four families of synthetic graphs from
+// test_graphs.h: random graphs, power-law graphs with hub nodes, random DAGs and
+// square grids. The random graphs, power-law graphs and DAGs have about four
+// edges per node and the grids have about two. The argument of a benchmark is
+// the number of nodes, and each family is a separate benchmark so that its
+// complexity is fitted separately. The complexity is fitted to the number of
+// nodes plus edges of the input, so super-linear behavior shows as a fit worse
+// than O(N).
+//
+// Besides time, every benchmark reports
+//  - output_nodes and output_edges, the size of the output graph or, for
+//    RefinePartition, the number of blocks of the refined partition,
+//  - bytes_allocated, the bytes allocated per iteration, and
+//  - peak_rss_kb, the peak resident set size of the process so far.
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "benchmarks/memory_report.h"
+#include "graph/graph_analyzer.h"
+#include "graph/graph_transformer.h"
+#include "graph/labeled_graph.h"
+#include "graph/test_graphs.h"
+#include "graph/value.h"
+
+namespace morphie {
+namespace {
+
+enum class GraphFamily { kRandom, kPowerLaw, kDAG, kGrid };
+
+const uint64_t kSeed = 1;
+const int kDegree = 4;
+// Every kStride-th node or edge is deleted, contracted or folded.
+const int kStride = 8;
+// The number of nodes in each block of the partitions.
+const int kBlockSize = 16;
+
+std::unique_ptr<test::WeightedGraph> MakeGraph(GraphFamily family,
+                                               int num_nodes) {
+  std::unique_ptr<test::WeightedGraph> graph(new test::WeightedGraph());
+  switch (family) {
+    case GraphFamily::kRandom:
+      test::GetRandomGraph(num_nodes, kDegree * num_nodes, kSeed, graph.get());
+      break;
+    case GraphFamily::kPowerLaw:
+      test::GetPowerLawGraph(num_nodes, kDegree, kSeed, graph.get());
+      break;
+    case GraphFamily::kDAG:
+      test::GetRandomDAG(num_nodes, kDegree * num_nodes, kSeed, graph.get());
+      break;
+    case GraphFamily::kGrid: {
+      const int side = std::sqrt(num_nodes);
+      test::GetGridGraph(side, side, graph.get());
+      break;
+    }
+  }
+  return graph;
+}
+
+// Returns every kStride-th node of 'graph'.
+std::set<NodeId> SelectNodes(const LabeledGraph& graph) {
+  std::set<NodeId> nodes;
+  int i = 0;
+  for (auto node_it = graph.NodeSetBegin(); node_it != graph.NodeSetEnd();
+       ++node_it) {
+    if (i++ % kStride == 0) {
+      nodes.insert(nodes.end(), *node_it);
+    }
+  }
+  return nodes;
+}
+
+// Returns every kStride-th edge of 'graph'.
+std::set<EdgeId> SelectEdges(const LabeledGraph& graph) {
+  std::set<EdgeId> edges;
+  int i = 0;
+  for (auto edge_it = graph.EdgeSetBegin(); edge_it != graph.EdgeSetEnd();
+       ++edge_it) {
+    if (i++ % kStride == 0) {
+      edges.insert(*edge_it);
+    }
+  }
+  return edges;
+}
+
+// Puts kBlockSize consecutive nodes into each block.
+std::map<NodeId, int> MakePartition(const LabeledGraph& graph) {
+  std::map<NodeId, int> partition;
+  int i = 0;
+  for (auto node_it = graph.NodeSetBegin(); node_it != graph.NodeSetEnd();
+       ++node_it) {
+    partition.emplace_hint(partition.end(), *node_it, i++ / kBlockSize);
+  }
+  return partition;
+}
+
+TaggedAST WeightLabel(const char* tag, int weight) {
+  TaggedAST label;
+  label.set_tag(tag);
+  *label.mutable_ast() = ast::value::MakeInt(weight);
+  return label;
+}
+
+// Labels a block with its lowest node id and the edges between two blocks
+// with one edge, weighted by the number of edges it replaces.
+TaggedAST BlockLabel(const LabeledGraph& graph, const std::set<NodeId>& nodes) {
+  return WeightLabel("Node-Weight", *nodes.begin());
+}
+
+std::vector<TaggedAST> BlockEdgeLabel(const LabeledGraph& graph,
+                                      const std::set<EdgeId>& edges) {
+  return {WeightLabel("Edge-Weight", edges.size())};
+}
+
+std::vector<TaggedAST> FoldLabel(const LabeledGraph& graph, NodeId node,
+                                 NodeId predecessor, NodeId successor) {
+  return {WeightLabel("Edge-Weight", node)};
+}
+
+void SetOutputCounters(const LabeledGraph& output, benchmark::State* state) {
+  state->counters["output_nodes"] = output.NumNodes();
+  state->counters["output_edges"] = output.NumEdges();
+}
+
+void SetComplexityN(const LabeledGraph& input, benchmark::State* state) {
+  state->SetComplexityN(input.NumNodes() + input.NumEdges());
+}
+
+template <GraphFamily family>
+void BM_DeleteNodes(benchmark::State& state) {
+  const auto weighted_graph = MakeGraph(family, state.range(0));
+  const LabeledGraph& graph = *weighted_graph->GetGraph();
+  const std::set<NodeId> nodes = SelectNodes(graph);
+  std::unique_ptr<graph::Morphism> morphism;
+  {
+    MemoryReport report(&state);
+    for (auto _ : state) {
+      report.PauseTiming();
+      morphism.reset();
+      report.ResumeTiming();
+      morphism = graph::DeleteNodes(graph, nodes);
+    }
+  }
+  SetOutputCounters(morphism->Output(), &state);
+  SetComplexityN(graph, &state);
+}
+
+template <GraphFamily family>
+void BM_DeleteEdgesNotNodes(benchmark::State& state) {
+  const auto weighted_graph = MakeGraph(family, state.range(0));
+  const LabeledGraph& graph = *weighted_graph->GetGraph();
+  const std::set<EdgeId> edges = SelectEdges(graph);
+  std::unique_ptr<graph::Morphism> morphism;
+  {
+    MemoryReport report(&state);
+    for (auto _ : state) {
+      report.PauseTiming();
+      morphism.reset();
+      report.ResumeTiming();
+      morphism = graph::DeleteEdgesNotNodes(graph, edges);
+    }
+  }
+  SetOutputCounters(morphism->Output(), &state);
+  SetComplexityN(graph, &state);
+}
+
+template <GraphFamily family>
+void BM_DeleteEdgesAndNodes(benchmark::State& state) {
+  const auto weighted_graph = MakeGraph(family, state.range(0));
+  const LabeledGraph& graph = *weighted_graph->GetGraph();
+  const std::set<EdgeId> edges = SelectEdges(graph);
+  std::unique_ptr<graph::Morphism> morphism;
+  {
+    MemoryReport report(&state);
+    for (auto _ : state) {
+      report.PauseTiming();
+      morphism.reset();
+      report.ResumeTiming();
+      morphism = graph::DeleteEdgesAndNodes(graph, edges);
+    }
+  }
+  SetOutputCounters(morphism->Output(), &state);
+  SetComplexityN(graph, &state);
+}
+
+template <GraphFamily family>
+void BM_QuotientGraph(benchmark::State& state) {
+  const auto weighted_graph = MakeGraph(family, state.range(0));
+  const LabeledGraph& graph = *weighted_graph->GetGraph();
+  const std::map<NodeId, int> partition = MakePartition(graph);
+  const graph::QuotientConfig config(graph, BlockLabel, BlockEdgeLabel, true);
+  std::unique_ptr<LabeledGraph> output;
+  {
+    MemoryReport report(&state);
+    for (auto _ : state) {
+      report.PauseTiming();
+      output.reset();
+      report.ResumeTiming();
+      output = graph::QuotientGraph(graph, partition, config);
+    }
+  }
+  SetOutputCounters(*output, &state);
+  SetComplexityN(graph, &state);
+}
+
+template <GraphFamily family>
+void BM_ContractEdges(benchmark::State& state) {
+  const auto weighted_graph = MakeGraph(family, state.range(0));
+  const LabeledGraph& graph = *weighted_graph->GetGraph();
+  const std::set<EdgeId> edges = SelectEdges(graph);
+  const graph::QuotientConfig config(graph, BlockLabel, BlockEdgeLabel, true);
+  std::unique_ptr<LabeledGraph> output;
+  {
+    MemoryReport report(&state);
+    for (auto _ : state) {
+      report.PauseTiming();
+      output.reset();
+      report.ResumeTiming();
+      output = graph::ContractEdges(graph, edges, config);
+    }
+  }
+  SetOutputCounters(*output, &state);
+  SetComplexityN(graph, &state);
+}
+
+// Folding a node adds an edge from each of its predecessors to each of its
+// successors, so the output of power-law graphs, whose hubs have many
+// predecessors, grows fastest.
+template <GraphFamily family>
+void BM_FoldNodes(benchmark::State& state) {
+  const auto weighted_graph = MakeGraph(family, state.range(0));
+  const LabeledGraph& graph = *weighted_graph->GetGraph();
+  const std::set<NodeId> nodes = SelectNodes(graph);
+  std::unique_ptr<LabeledGraph> output;
+  {
+    MemoryReport report(&state);
+    for (auto _ : state) {
+      report.PauseTiming();
+      output.reset();
+      report.ResumeTiming();
+      output = graph::FoldNodes(graph, FoldLabel, nodes);
+    }
+  }
+  SetOutputCounters(*output, &state);
+  SetComplexityN(graph, &state);
+}
+
+template <GraphFamily family>
+void BM_RefinePartition(benchmark::State& state) {
+  const auto weighted_graph = MakeGraph(family, state.range(0));
+  const LabeledGraph& graph = *weighted_graph->GetGraph();
+  const std::map<NodeId, int> partition = MakePartition(graph);
+  std::map<NodeId, int> refinement;
+  {
+    MemoryReport report(&state);
+    for (auto _ : state) {
+      report.PauseTiming();
+      refinement.clear();
+      report.ResumeTiming();
+      refinement = graph_analyzer::RefinePartition(graph, partition);
+    }
+  }
+  std::set<int> blocks;
+  for (const auto& node_block : refinement) {
+    blocks.insert(node_block.second);
+  }
+  state.counters["output_nodes"] = blocks.size();
+  state.counters["output_edges"] = 0;
+  SetComplexityN(graph, &state);
+}
+
+// Registers 'function' for graphs of 2^10 to 2^16 nodes of 'family', with a
+// complexity fit.
+#define GRAPH_BENCHMARK(function, family)            \
+  BENCHMARK_TEMPLATE(function, GraphFamily::family) \
+      ->ArgName("nodes")                             \
+      ->RangeMultiplier(4)                           \
+      ->Range(1 << 10, 1 << 16)                      \
+      ->Unit(benchmark::kMillisecond)                \
+      ->Complexity()
+
+#define GRAPH_BENCHMARKS(function)       \
+  GRAPH_BENCHMARK(function, kRandom);    \
+  GRAPH_BENCHMARK(function, kPowerLaw);  \
+  GRAPH_BENCHMARK(function, kDAG);       \
+  GRAPH_BENCHMARK(function, kGrid)
+
+GRAPH_BENCHMARKS(BM_DeleteNodes);
+GRAPH_BENCHMARKS(BM_DeleteEdgesNotNodes);
+GRAPH_BENCHMARKS(BM_DeleteEdgesAndNodes);
+GRAPH_BENCHMARKS(BM_QuotientGraph);
+GRAPH_BENCHMARKS(BM_ContractEdges);
+GRAPH_BENCHMARKS(BM_FoldNodes);
+GRAPH_BENCHMARKS(BM_RefinePartition);
+
+}  // namespace
+}  // namespace morphie
+
+BENCHMARK_MAIN();
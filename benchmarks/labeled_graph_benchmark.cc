@@ -0,0 +1,298 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Benchmarks for the core operations of a LabeledGraph: adding nodes and edges,
+// looking up nodes by label, querying adjacency and iterating over the graph.
+//
+// Each benchmark takes three arguments: the number of nodes in the graph, the
+// label shape, which is 0 for small labels (an int) and 1 for large labels (a
+// tuple with a timestamp, a string and a list of strings), and whether the
+// label tags are unique (1) or not (0). Non-unique labels repeat, so that label
+// lookups return sets of nodes.
+//
+// Besides time, every benchmark reports
+//  - items_per_second, the number of operations per second,
+//  - bytes_allocated, the bytes allocated per iteration, which is counted by
+//    replacing the global operator new and excludes untimed setup, and
+//  - peak_rss_kb, the peak resident set size of the process so far.
+// Results can be compared between commits by writing them as JSON with the
+// flags --benchmark_out=graph.json --benchmark_out_format=json.
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "base/string.h"
+#include "benchmarks/memory_report.h"
+#include "graph/labeled_graph.h"
+#include "graph/type.h"
+#include "graph/type_registry.h"
+#include "graph/value.h"
+#include "util/logging.h"
+
+namespace morphie {
+namespace {
+
+namespace type = ast::type;
+namespace value = ast::value;
+
+// The number of distinct labels of each non-unique tag.
+const int kNumRepeatedLabels = 64;
+// The number of edges out of each node.
+const int kOutDegree = 4;
+
+// The arguments of a benchmark.
+struct Shape {
+  explicit Shape(const benchmark::State& state)
+      : num_nodes(state.range(0)),
+        is_large(state.range(1) != 0),
+        is_unique(state.range(2) != 0) {}
+
+  int num_nodes;
+  bool is_large;
+  bool is_unique;
+};
+
+const char* NodeTag(const Shape& shape) {
+  if (shape.is_large) {
+    return shape.is_unique ? "UniqueLarge" : "Large";
+  }
+  return shape.is_unique ? "UniqueSmall" : "Small";
+}
+
+// Returns the registry of the graphs used in the benchmarks, which has a node
+// type for each label shape and a unique and a non-unique edge type.
+std::shared_ptr<const type::TypeRegistry> GetTypes() {
+  static std::shared_ptr<const type::TypeRegistry>* types = [] {
+    AST small = type::MakeInt("Id", false);
+    std::vector<AST> fields = {
+        type::MakeTimestamp("Time", false), type::MakeString("Source", false),
+        type::MakeList("Path", false, type::MakeString("Part", false))};
+    AST large = type::MakeTuple("Event", false, fields);
+    type::Types node_types = {{"Small", small},
+                              {"UniqueSmall", small},
+                              {"Large", large},
+                              {"UniqueLarge", large}};
+    type::Types edge_types = {{"Edge", small}, {"UniqueEdge", small}};
+    auto registry = new std::shared_ptr<const type::TypeRegistry>();
+    util::Status status = type::TypeRegistry::Create(
+        node_types, {"UniqueSmall", "UniqueLarge"}, edge_types, {"UniqueEdge"},
+        type::MakeNull("Graph"), registry);
+    CHECK(status.ok(), status.message());
+    return registry;
+  }();
+  return *types;
+}
+
+// Returns the label of node 'i'. Unique labels are distinct for every node.
+TaggedAST MakeNodeLabel(const Shape& shape, int i) {
+  const int id = shape.is_unique ? i : i % kNumRepeatedLabels;
+  TaggedAST label;
+  label.set_tag(NodeTag(shape));
+  if (!shape.is_large) {
+    *label.mutable_ast() = value::MakeInt(id);
+    return label;
+  }
+  AST path = value::MakeEmptyList();
+  for (const char* part : {"home", "user", "logs", "2015", "archive"}) {
+    *path.mutable_c_ast()->add_arg() = value::MakeString(part);
+  }
+  *path.mutable_c_ast()->add_arg() =
+      value::MakeString("file" + std::to_string(id) + ".log");
+  AST* tuple = label.mutable_ast();
+  tuple->mutable_c_ast()->set_op(Operator::TUPLE);
+  *tuple->mutable_c_ast()->add_arg() =
+      value::MakeTimestampFromUnixMicros(1433116800000000 + id);
+  *tuple->mutable_c_ast()->add_arg() = value::MakeString("syslog");
+  *tuple->mutable_c_ast()->add_arg() = path;
+  return label;
+}
+
+std::vector<TaggedAST> MakeNodeLabels(const Shape& shape) {
+  std::vector<TaggedAST> labels;
+  labels.reserve(shape.num_nodes);
+  for (int i = 0; i < shape.num_nodes; ++i) {
+    labels.push_back(MakeNodeLabel(shape, i));
+  }
+  return labels;
+}
+
+TaggedAST MakeEdgeLabel(const Shape& shape, int i) {
+  TaggedAST label;
+  label.set_tag(shape.is_unique ? "UniqueEdge" : "Edge");
+  *label.mutable_ast() = value::MakeInt(i % kOutDegree);
+  return label;
+}
+
+// The target of the edge 'i' out of 'source'.
+NodeId Target(const Shape& shape, NodeId source, int i) {
+  return (source * 7 + i * 13 + 1) % shape.num_nodes;
+}
+
+void AddNodes(const std::vector<TaggedAST>& labels, LabeledGraph* graph) {
+  for (const TaggedAST& label : labels) {
+    graph->FindOrAddNode(label);
+  }
+}
+
+void AddEdges(const Shape& shape, LabeledGraph* graph) {
+  const NodeId num_nodes = graph->NumNodes();
+  for (NodeId source = 0; source < num_nodes; ++source) {
+    for (int i = 0; i < kOutDegree; ++i) {
+      graph->FindOrAddEdge(source, Target(shape, source, i),
+                           MakeEdgeLabel(shape, i));
+    }
+  }
+}
+
+// Builds the graph with 'shape.num_nodes' nodes and kOutDegree edges out of
+// each node.
+std::unique_ptr<LabeledGraph> MakeGraph(const Shape& shape) {
+  std::unique_ptr<LabeledGraph> graph(new LabeledGraph());
+  CHECK(graph->Initialize(GetTypes()).ok(), "");
+  AddNodes(MakeNodeLabels(shape), graph.get());
+  AddEdges(shape, graph.get());
+  return graph;
+}
+
+// Applies the arguments of every benchmark: graph sizes, both label shapes and
+// both unique and non-unique tags.
+void GraphShapes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"nodes", "large", "unique"});
+  for (int num_nodes : {1 << 10, 1 << 14, 1 << 17}) {
+    for (int is_large : {0, 1}) {
+      for (int is_unique : {0, 1}) {
+        benchmark->Args({num_nodes, is_large, is_unique});
+      }
+    }
+  }
+}
+
+// Adds every node to an empty graph. Unique labels are each looked up once
+// before they are added. The graph of the previous iteration is destroyed
+// while timing is paused.
+void BM_FindOrAddNode(benchmark::State& state) {
+  const Shape shape(state);
+  const std::vector<TaggedAST> labels = MakeNodeLabels(shape);
+  std::unique_ptr<LabeledGraph> graph;
+  MemoryReport report(&state);
+  for (auto _ : state) {
+    report.PauseTiming();
+    graph.reset(new LabeledGraph());
+    graph->Initialize(GetTypes());
+    report.ResumeTiming();
+    AddNodes(labels, graph.get());
+    benchmark::DoNotOptimize(graph->NumNodes());
+  }
+  state.SetItemsProcessed(state.iterations() * shape.num_nodes);
+}
+BENCHMARK(BM_FindOrAddNode)->Apply(GraphShapes);
+
+// Adds every edge to a graph that already has its nodes.
+void BM_FindOrAddEdge(benchmark::State& state) {
+  const Shape shape(state);
+  const std::vector<TaggedAST> labels = MakeNodeLabels(shape);
+  std::unique_ptr<LabeledGraph> graph;
+  MemoryReport report(&state);
+  for (auto _ : state) {
+    report.PauseTiming();
+    graph.reset(new LabeledGraph());
+    graph->Initialize(GetTypes());
+    AddNodes(labels, graph.get());
+    report.ResumeTiming();
+    AddEdges(shape, graph.get());
+    benchmark::DoNotOptimize(graph->NumEdges());
+  }
+  state.SetItemsProcessed(state.iterations() * shape.num_nodes * kOutDegree);
+}
+BENCHMARK(BM_FindOrAddEdge)->Apply(GraphShapes);
+
+// Looks up the nodes of every label.
+void BM_GetNodes(benchmark::State& state) {
+  const Shape shape(state);
+  const std::unique_ptr<LabeledGraph> graph = MakeGraph(shape);
+  const std::vector<TaggedAST> labels = MakeNodeLabels(shape);
+  MemoryReport report(&state);
+  for (auto _ : state) {
+    size_t num_found = 0;
+    for (const TaggedAST& label : labels) {
+      num_found += graph->GetNodes(label).size();
+    }
+    benchmark::DoNotOptimize(num_found);
+  }
+  state.SetItemsProcessed(state.iterations() * shape.num_nodes);
+}
+BENCHMARK(BM_GetNodes)->Apply(GraphShapes);
+
+// Computes the predecessors of every node.
+void BM_GetPredecessors(benchmark::State& state) {
+  const Shape shape(state);
+  const std::unique_ptr<LabeledGraph> graph = MakeGraph(shape);
+  MemoryReport report(&state);
+  for (auto _ : state) {
+    size_t num_found = 0;
+    for (NodeId node_id = 0; node_id < static_cast<NodeId>(shape.num_nodes);
+         ++node_id) {
+      num_found += graph->GetPredecessors(node_id).size();
+    }
+    benchmark::DoNotOptimize(num_found);
+  }
+  state.SetItemsProcessed(state.iterations() * shape.num_nodes);
+}
+BENCHMARK(BM_GetPredecessors)->Apply(GraphShapes);
+
+// Checks that every edge of the graph exists.
+void BM_HasEdge(benchmark::State& state) {
+  const Shape shape(state);
+  const std::unique_ptr<LabeledGraph> graph = MakeGraph(shape);
+  const std::vector<EdgeId> edges(graph->EdgeSetBegin(), graph->EdgeSetEnd());
+  MemoryReport report(&state);
+  for (auto _ : state) {
+    size_t num_found = 0;
+    for (const EdgeId& edge_id : edges) {
+      num_found += graph->HasEdge(edge_id);
+    }
+    benchmark::DoNotOptimize(num_found);
+  }
+  state.SetItemsProcessed(state.iterations() * edges.size());
+}
+BENCHMARK(BM_HasEdge)->Apply(GraphShapes);
+
+// Visits every node and the edges out of it and reads their stored labels.
+void BM_Iterate(benchmark::State& state) {
+  const Shape shape(state);
+  const std::unique_ptr<LabeledGraph> graph = MakeGraph(shape);
+  MemoryReport report(&state);
+  for (auto _ : state) {
+    size_t label_bytes = 0;
+    for (auto node_it = graph->NodeSetBegin(); node_it != graph->NodeSetEnd();
+         ++node_it) {
+      label_bytes += graph->GetFlatNodeLabel(*node_it).ast().buffer().size();
+      for (auto edge_it = graph->OutEdgeBegin(*node_it);
+           edge_it != graph->OutEdgeEnd(*node_it); ++edge_it) {
+        label_bytes += graph->GetFlatEdgeLabel(*edge_it).ast().buffer().size();
+      }
+    }
+    benchmark::DoNotOptimize(label_bytes);
+  }
+  state.SetItemsProcessed(state.iterations() * shape.num_nodes *
+                          (1 + kOutDegree));
+}
+BENCHMARK(BM_Iterate)->Apply(GraphShapes);
+
+}  // namespace
+}  // namespace morphie
+
+BENCHMARK_MAIN();
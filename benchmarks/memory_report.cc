@@ -0,0 +1,80 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "benchmarks/memory_report.h"
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<bool> count_allocations(false);
+std::atomic<int64_t> allocated_bytes(0);
+
+}  // namespace
+
+void* operator new(size_t size) {
+  if (count_allocations.load(std::memory_order_relaxed)) {
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+// GCC 11 and later assume that the pointer passed to operator delete came from
+// operator new and warn that it is released with free. The replacement above
+// allocates with malloc, so the pair is matched.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace morphie {
+
+MemoryReport::MemoryReport(benchmark::State* state)
+    : state_(state), start_bytes_(allocated_bytes.load()) {
+  count_allocations = true;
+}
+
+MemoryReport::~MemoryReport() {
+  count_allocations = false;
+  state_->counters["bytes_allocated"] =
+      benchmark::Counter(allocated_bytes.load() - start_bytes_,
+                         benchmark::Counter::kAvgIterations);
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  state_->counters["peak_rss_kb"] = usage.ru_maxrss;
+}
+
+void MemoryReport::PauseTiming() {
+  state_->PauseTiming();
+  count_allocations = false;
+}
+
+void MemoryReport::ResumeTiming() {
+  count_allocations = true;
+  state_->ResumeTiming();
+}
+
+}  // namespace morphie
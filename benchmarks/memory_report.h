@@ -0,0 +1,59 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Memory measurements for benchmarks. Linking this file replaces the global
+// operator new with one that counts the bytes allocated while a MemoryReport
+// is counting.
+//
+// Example.
+//   void BM_Build(benchmark::State& state) {
+//     MemoryReport report(&state);
+//     for (auto _ : state) {
+//       report.PauseTiming();
+//       ...  // Setup, which is neither timed nor counted.
+//       report.ResumeTiming();
+//       ...  // The measured code.
+//     }
+//   }
+#ifndef LOGLE_MEMORY_REPORT_H_
+#define LOGLE_MEMORY_REPORT_H_
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace morphie {
+
+// Measures the allocations and peak memory of the timed part of a benchmark.
+// When the report is destroyed, it sets the counters
+//  - bytes_allocated, the bytes allocated per iteration, and
+//  - peak_rss_kb, the peak resident set size of the process so far.
+// PauseTiming and ResumeTiming must be used instead of the functions of the
+// same name in benchmark::State, so that setup is not counted.
+class MemoryReport {
+ public:
+  explicit MemoryReport(benchmark::State* state);
+  ~MemoryReport();
+
+  void PauseTiming();
+  void ResumeTiming();
+
+ private:
+  benchmark::State* state_;
+  int64_t start_bytes_;
+};
+
+}  // namespace morphie
+
+#endif  // LOGLE_MEMORY_REPORT_H_
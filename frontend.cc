@@ -18,16 +18,20 @@
 // an analyzer.
 #include "frontend.h"
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <memory>
+#include <ostream>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "analyzers/examples/account_access_analyzer.h"
 #include "analyzers/examples/curio_analyzer.h"
 #include "analyzers/plaso/plaso_analyzer.h"
 #include "base/string.h"
-#include "json/json.h"
 #include "util/csv.h"
 #include "util/json_reader.h"
 #include "util/logging.h"
@@ -38,15 +42,39 @@ namespace {
 
 namespace util = morphie::util;
 
+// A function that writes the output of an analyzer to a stream.
+using OutputFn = std::function<void(std::ostream*)>;
+
+// The size of the buffer of an output file. Analyzers write their output one
+// small declaration at a time, so the default buffer would mean many writes.
+const size_t kOutputBufferSize = 1 << 16;
+
 // Error messages.
 const char kInvalidAnalyzerErr[] =
     "Invalid analysis. The analysis must be one of 'curio', 'mail', or "
     "'plaso'.";
 const char kOpenFileErr[] = "Error opening file: ";
+const char kDotOutputOnlyErr[] =
+    "Unsupported output parameter. This analyzer supports only output_dot_file "
+    "and output_pbtxt_file.";
+const char kOutputBudgetErr[] =
+    "Unsupported output parameter. Only the plaso analyzer supports "
+    "output_budget.";
+const char kNegativeBudgetErr[] =
+    "The bounds in output_budget must not be negative.";
 const char kInvalidPlasoOption[] =
     "Unsupported input parameter. Plaso analyzer supports only json_file and "
     "json_stream_file.";
 
+// Returns the number of threads that render the output graph.
+int GetNumRenderThreads(const morphie::AnalysisOptions& options) {
+  const int num_threads = options.num_render_threads();
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  return std::max<int>(std::thread::hardware_concurrency(), 1);
+}
+
 // Returns a pair consisting of a status object and a CSV parser for 'filename'.
 // The return value is:
 //  - OK if 'filename' could be opened successfully. In this case, the second
@@ -71,24 +99,19 @@ std::pair<util::Status, std::unique_ptr<util::CSVParser>> GetCSVParser(
   return {util::Status::OK, std::move(parser)};
 }
 
-// Returns a JSON document extracted from 'filename'. Comments in the JSON
-// document will be ignored.
-std::unique_ptr<Json::Value> GetJsonDoc(const std::string& filename) {
-  Json::Reader json_reader;
-  std::unique_ptr<Json::Value> json_doc(new Json::Value);
-  std::ifstream json_stream(filename);
-  json_reader.parse(json_stream, *json_doc, false /*Do not parse comments*/);
-  return json_doc;
-}
-
-// Writes the string 'contents' to 'filename'. Returns
+// Writes the output of 'write_output' to 'filename' through a buffer, so that
+// the output is never held in memory as a whole. Returns
 //  - OK if 'filename' could be opened for writing, written to, and closed
 //    successfully.
 //  - an error code with explanation otherwise.
 util::Status WriteToFile(const std::string& filename,
-                         const std::string& contents) {
+                         const OutputFn& write_output,
+                         std::ios_base::openmode mode = std::ofstream::out) {
+  // The buffer is declared before the stream so that it outlives the stream.
+  std::vector<char> buffer(kOutputBufferSize);
   std::ofstream out_file;
-  out_file.open(filename, std::ofstream::out);
+  out_file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+  out_file.open(filename, mode);
   // An ofstream automatically closes a file when it goes out of scope, so the
   // early returns will not leave the file open. The file is nonetheless
   // explicitly closed only to be able to detect errors.
@@ -96,7 +119,7 @@ util::Status WriteToFile(const std::string& filename,
     return util::Status(morphie::Code::EXTERNAL,
                        util::StrCat("Error opening file: ", filename));
   }
-  out_file << contents;
+  write_output(&out_file);
 
   if (!out_file) {
     return util::Status(morphie::Code::INTERNAL,
@@ -110,40 +133,76 @@ util::Status WriteToFile(const std::string& filename,
   return util::Status::OK;
 }
 
+// Writes the output of 'write_output' to each output file named in 'options'.
+util::Status WriteOutput(const morphie::AnalysisOptions& options,
+                         const OutputFn& write_output) {
+  if (options.output_dot_file() != "") {
+    util::Status status = WriteToFile(options.output_dot_file(), write_output);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  if (options.output_pbtxt_file() != "") {
+    return WriteToFile(options.output_pbtxt_file(), write_output);
+  }
+  if (options.output_pb_file() != "") {
+    return WriteToFile(options.output_pb_file(), write_output,
+                       std::ofstream::out | std::ofstream::binary);
+  }
+  return util::Status::OK;
+}
+
 }  // namespace
 
 namespace morphie {
 namespace frontend {
 
-// Runs the Curio analyzer in curio_analyzer.h on the input. Returns an error
-// code if the input is not in JSON format.
-util::Status RunCurioAnalyzer(const AnalysisOptions& options,
-                              string* output_graph) {
+// Runs the Curio analyzer in curio_analyzer.h on the input and writes the
+// dependency graph to the output files. Returns an error code if the input is
+// not in JSON format.
+util::Status RunCurioAnalyzer(const AnalysisOptions& options) {
   if (!options.has_json_file()) {
     return util::Status(morphie::Code::INVALID_ARGUMENT,
                         "The Curio analyzer requires a JSON input file.");
   }
-  std::unique_ptr<Json::Value> json_doc = GetJsonDoc(options.json_file());
-  CurioAnalyzer curio_analyzer;
-  util::Status status = curio_analyzer.Initialize(std::move(json_doc));
-  if (!status.ok()) {
-    return status;
+  if (options.has_output_pb_file()) {
+    return util::Status(morphie::Code::INVALID_ARGUMENT, kDotOutputOnlyErr);
+  }
+  if (options.has_output_budget()) {
+    return util::Status(morphie::Code::INVALID_ARGUMENT, kOutputBudgetErr);
   }
-  status = curio_analyzer.BuildDependencyGraph();
+  // The document is parsed as it is read, so that large inputs are not held in
+  // memory.
+  std::ifstream json_stream(options.json_file());
+  if (!json_stream) {
+    return util::Status(morphie::Code::EXTERNAL,
+                        util::StrCat(kOpenFileErr, options.json_file()));
+  }
+  CurioAnalyzer curio_analyzer;
+  util::Status status = curio_analyzer.BuildDependencyGraph(&json_stream);
   if (!status.ok()) {
     return status;
   }
-  *output_graph = curio_analyzer.DependencyGraphAsDot();
-  return status;
+  const bool group_styles = options.output_dot_group_styles();
+  const int num_threads = GetNumRenderThreads(options);
+  return WriteOutput(
+      options, [&curio_analyzer, group_styles, num_threads](std::ostream* out) {
+        curio_analyzer.WriteDependencyGraphAsDot(group_styles, num_threads,
+                                                 out);
+      });
 }
 
 // Runs the Plaso analyzer in plaso_analyzer.h on the input. The input can be in
 // JSON or JSON stream format. Returns an error code if file I/O fails. If the
-// analyzer is run successfully, a GraphViz DOT representation of the
-// constructed graph is returned in 'output_graph'.
-util::Status RunPlasoAnalyzer(const AnalysisOptions& options,
-                              string* output_graph) {
+// analyzer is run successfully, a GraphViz DOT, text protobuf or binary
+// protobuf representation of the constructed graph, or of its summary if the
+// graph exceeds the output budget, is written to the output file.
+util::Status RunPlasoAnalyzer(const AnalysisOptions& options) {
   util::Status status;
+  const OutputBudget& budget = options.output_budget();
+  if (budget.max_nodes() < 0 || budget.max_edges() < 0) {
+    return util::Status(morphie::Code::INVALID_ARGUMENT, kNegativeBudgetErr);
+  }
 
   bool show_all_sources = options.has_plaso_options()
                               ? options.plaso_options().show_all_sources()
@@ -180,34 +239,74 @@ util::Status RunPlasoAnalyzer(const AnalysisOptions& options,
   }
   plaso_analyzer.BuildPlasoGraph();
   input_stream->close();
+  if (options.has_output_budget()) {
+    plaso_analyzer.SummarizePlasoGraph(budget.max_nodes(), budget.max_edges());
+  }
+  const int num_threads = GetNumRenderThreads(options);
   if (options.has_output_dot_file()) {
-    *output_graph = plaso_analyzer.PlasoGraphDot();
-  } else if (options.has_output_pbtxt_file()) {
-    *output_graph = plaso_analyzer.PlasoGraphPbTxt();
+    const bool group_styles = options.output_dot_group_styles();
+    return WriteOutput(
+        options,
+        [&plaso_analyzer, group_styles, num_threads](std::ostream* out) {
+          plaso_analyzer.WritePlasoGraphDot(group_styles, num_threads, out);
+        });
   }
-  return util::Status::OK;
+  if (options.has_output_pb_file()) {
+    const bool delimited = options.output_pb_delimited();
+    return WriteOutput(
+        options, [&plaso_analyzer, delimited, num_threads](std::ostream* out) {
+          plaso_analyzer.WritePlasoGraphPb(delimited, num_threads, out);
+        });
+  }
+  return WriteOutput(options, [&plaso_analyzer, num_threads](std::ostream* out) {
+    plaso_analyzer.WritePlasoGraphPbTxt(num_threads, out);
+  });
 }
 
 // Runs the analyzer in account_access_analyzer.h on the input. Returns
 //  - INVALID_ARGUMENT if the input is not in CSV format or if
 //    file I/O causes an error or if graph initialization or construction fails.
 //  - OK otherwise.
-// If OK is returned, 'output_graph' contains a GraphViz DOT graph.
-util::Status RunMailAccessAnalyzer(const AnalysisOptions& options,
-                                   string* output_graph) {
+// If OK is returned, a GraphViz DOT graph has been written to the output files.
+util::Status RunMailAccessAnalyzer(const AnalysisOptions& options) {
   if (!options.has_csv_file()) {
     return util::Status(morphie::Code::INVALID_ARGUMENT,
                         "The access analyzer requires a CSV input file.");
   }
-  AccessAnalyzer access_analyzer;
-  std::pair<util::Status, std::unique_ptr<util::CSVParser>> result =
-      GetCSVParser(options.csv_file());
-
-  util::Status status = result.first;
-  if (!status.ok()) {
-    return status;
+  if (options.has_output_pb_file()) {
+    return util::Status(morphie::Code::INVALID_ARGUMENT, kDotOutputOnlyErr);
+  }
+  if (options.has_output_budget()) {
+    return util::Status(morphie::Code::INVALID_ARGUMENT, kOutputBudgetErr);
+  }
+  bool aggregate_accesses =
+      options.has_access_options()
+          ? options.access_options().aggregate_accesses()
+          : false;
+  AccessAnalyzer access_analyzer(aggregate_accesses);
+  const int num_threads = options.access_options().num_threads();
+  util::Status status;
+  if (num_threads == 1) {
+    std::pair<util::Status, std::unique_ptr<util::CSVParser>> result =
+        GetCSVParser(options.csv_file());
+    status = result.first;
+    if (!status.ok()) {
+      return status;
+    }
+    status = access_analyzer.Initialize(std::move(result.second));
+  } else {
+    std::ifstream* csv_stream = new std::ifstream(options.csv_file());
+    if (!*csv_stream) {
+      delete csv_stream;
+      return util::Status(morphie::Code::EXTERNAL,
+                          util::StrCat(kOpenFileErr, options.csv_file()));
+    }
+    // The analyzer parses the input with a ParallelCSVParser, which takes
+    // ownership of the stream.
+    status = access_analyzer.Initialize(
+        csv_stream, ',', num_threads,
+        util::ParallelCSVParser::kDefaultChunkSize);
   }
-  status = access_analyzer.Initialize(std::move(result.second));
   if (!status.ok()) {
     return status;
   }
@@ -215,38 +314,28 @@ util::Status RunMailAccessAnalyzer(const AnalysisOptions& options,
   if (!status.ok()) {
     return status;
   }
-  *output_graph = access_analyzer.AccessGraphAsDot();
-  return util::Status::OK;
+  const bool group_styles = options.output_dot_group_styles();
+  const int num_render_threads = GetNumRenderThreads(options);
+  return WriteOutput(options, [&access_analyzer, group_styles,
+                               num_render_threads](std::ostream* out) {
+    access_analyzer.WriteAccessGraphAsDot(group_styles, num_render_threads,
+                                          out);
+  });
 }
 
-// Invokes the specified analyzer on an input data source and after analysis,
-// writes a graph to a file if required.
+// Invokes the specified analyzer on an input data source. After analysis, the
+// analyzer writes its graph directly to the output files, if any.
 util::Status Run(const AnalysisOptions& options) {
-  util::Status status = util::Status::OK;
-  string output_graph;
-  // Invoke an analyzer.
   if (!options.has_analyzer()) {
     return util::Status(Code::INVALID_ARGUMENT, kInvalidAnalyzerErr);
   } else if (options.analyzer() == "curio") {
-    status = RunCurioAnalyzer(options, &output_graph);
+    return RunCurioAnalyzer(options);
   } else if (options.analyzer() == "mail") {
-    status = RunMailAccessAnalyzer(options, &output_graph);
+    return RunMailAccessAnalyzer(options);
   } else if (options.analyzer() == "plaso") {
-    status = RunPlasoAnalyzer(options, &output_graph);
-  } else {
-    return util::Status(Code::INVALID_ARGUMENT, kInvalidAnalyzerErr);
-  }
-  // Write the output of the analysis and return.
-  if (!status.ok() || output_graph == "") {
-    return status;
-  }
-  if (options.output_dot_file() != "") {
-    status = WriteToFile(options.output_dot_file(), output_graph);
-  }
-  if (options.output_pbtxt_file() != "") {
-    status = WriteToFile(options.output_pbtxt_file(), output_graph);
+    return RunPlasoAnalyzer(options);
   }
-  return status;
+  return util::Status(Code::INVALID_ARGUMENT, kInvalidAnalyzerErr);
 }
 
 }  // namespace frontend
@@ -19,10 +19,8 @@
 // argument is true.
 #include "ast.h"
 
-#include <boost/algorithm/string/join.hpp>  // NOLINT
+#include <boost/functional/hash/hash.hpp>  // NOLINT
 
-#include "base/vector.h"
-#include "util/string_utils.h"
 #include "util/time_utils.h"
 
 namespace morphie {
@@ -44,47 +42,174 @@ bool IsPrimitive(const AST& ast, PrimitiveType type) {
   return ast.has_p_ast() && (ast.p_ast().type() == type);
 }
 
-// Returns a single whitespace string if the name and remaining output will be
-// non-empty. The remaining output will be non-empty if it includes a type or a
-// value because empty types and values serialize as "null".
-string GetNameSeparator(const string& name, PrintOption opt) {
-  if (name != "" && (Includes(PrintOption::kNameAndType, opt) ||
-                     Includes(PrintOption::kNameAndValue, opt))) {
-    return " ";
-  }
-  return "";
+// Returns true if a name should be followed by a single whitespace, which is
+// the case if the name and remaining output will be non-empty. The remaining
+// output will be non-empty if it includes a type or a value because empty types
+// and values serialize as "null".
+bool HasNameSeparator(const string& name, PrintOption opt) {
+  return name != "" && (Includes(PrintOption::kNameAndType, opt) ||
+                        Includes(PrintOption::kNameAndValue, opt));
 }
 
-// Returns the type of an AST.
-string ToTypeString(const AST& ast, PrintOption opt) {
+// Appends the type of an AST to 'out'.
+void AppendTypeString(const AST& ast, PrintOption opt, string* out) {
   if (!Includes(PrintOption::kType, opt)) {
-    return "";
+    return;
   }
   if (IsNull(ast)) {
-    return kNullStr;
+    out->append(kNullStr);
   } else if (ast.has_p_ast()) {
-    return ToString(ast.p_ast().type());
+    out->append(ToString(ast.p_ast().type()));
   } else if (ast.has_c_ast()) {
-    return ToString(ast.c_ast().op());
+    out->append(ToString(ast.c_ast().op()));
   }
-  return "";
 }
 
-// Returns the value in an AST.
-string ToValueString(const AST& ast, PrintOption opt) {
+// Appends the value in an AST to 'out'.
+void AppendValueString(const AST& ast, PrintOption opt, string* out) {
   if (!Includes(PrintOption::kValue, opt)) {
-    return "";
+    return;
   }
-  if (IsNull(ast)) {
-    return kNullStr;
+  if (IsNull(ast) || (ast.has_p_ast() && !ast.p_ast().has_val())) {
+    out->append(kNullStr);
   } else if (ast.has_p_ast()) {
-    if (ast.p_ast().has_val()) {
-      return ToString(ast.p_ast().val());
-    } else {
-      return kNullStr;
+    AppendToString(ast.p_ast().val(), out);
+  }
+}
+
+// The functions below compare and hash the parts of an AST. Presence of a field
+// is compared along with its value so that Equal agrees with comparison of
+// serializations.
+bool EqualValues(const PrimitiveValue& val1, const PrimitiveValue& val2) {
+  if (val1.val_case() != val2.val_case()) {
+    return false;
+  }
+  switch (val1.val_case()) {
+    case PrimitiveValue::kBoolVal:
+      return val1.bool_val() == val2.bool_val();
+    case PrimitiveValue::kIntVal:
+      return val1.int_val() == val2.int_val();
+    case PrimitiveValue::kStringVal:
+      return val1.string_val() == val2.string_val();
+    case PrimitiveValue::kTimeVal:
+      return val1.time_val() == val2.time_val();
+    case PrimitiveValue::VAL_NOT_SET:
+      return true;
+  }
+  return true;
+}
+
+bool EqualPrimitives(const PrimitiveAST& p_ast1, const PrimitiveAST& p_ast2) {
+  return p_ast1.has_type() == p_ast2.has_type() &&
+         p_ast1.type() == p_ast2.type() &&
+         p_ast1.has_val() == p_ast2.has_val() &&
+         EqualValues(p_ast1.val(), p_ast2.val());
+}
+
+bool EqualComposites(const CompositeAST& c_ast1, const CompositeAST& c_ast2) {
+  if (c_ast1.has_op() != c_ast2.has_op() || c_ast1.op() != c_ast2.op() ||
+      c_ast1.arg_size() != c_ast2.arg_size()) {
+    return false;
+  }
+  for (int i = 0; i < c_ast1.arg_size(); ++i) {
+    if (!Equal(c_ast1.arg(i), c_ast2.arg(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns a negative number, 0 or a positive number if 'a' is less than, equal
+// to or greater than 'b'.
+template <typename T>
+int CompareFields(const T& a, const T& b) {
+  return a < b ? -1 : (b < a ? 1 : 0);
+}
+
+int CompareValues(const PrimitiveValue& val1, const PrimitiveValue& val2) {
+  int cmp = CompareFields(val1.val_case(), val2.val_case());
+  if (cmp != 0) {
+    return cmp;
+  }
+  switch (val1.val_case()) {
+    case PrimitiveValue::kBoolVal:
+      return CompareFields(val1.bool_val(), val2.bool_val());
+    case PrimitiveValue::kIntVal:
+      return CompareFields(val1.int_val(), val2.int_val());
+    case PrimitiveValue::kStringVal:
+      return val1.string_val().compare(val2.string_val());
+    case PrimitiveValue::kTimeVal:
+      return CompareFields(val1.time_val(), val2.time_val());
+    case PrimitiveValue::VAL_NOT_SET:
+      return 0;
+  }
+  return 0;
+}
+
+int ComparePrimitives(const PrimitiveAST& p_ast1, const PrimitiveAST& p_ast2) {
+  int cmp = CompareFields(p_ast1.has_type(), p_ast2.has_type());
+  if (cmp == 0) {
+    cmp = CompareFields(p_ast1.type(), p_ast2.type());
+  }
+  if (cmp == 0) {
+    cmp = CompareFields(p_ast1.has_val(), p_ast2.has_val());
+  }
+  return cmp != 0 ? cmp : CompareValues(p_ast1.val(), p_ast2.val());
+}
+
+int CompareComposites(const CompositeAST& c_ast1, const CompositeAST& c_ast2) {
+  int cmp = CompareFields(c_ast1.has_op(), c_ast2.has_op());
+  if (cmp == 0) {
+    cmp = CompareFields(c_ast1.op(), c_ast2.op());
+  }
+  for (int i = 0; cmp == 0 && i < c_ast1.arg_size() && i < c_ast2.arg_size();
+       ++i) {
+    cmp = Compare(c_ast1.arg(i), c_ast2.arg(i));
+  }
+  return cmp != 0 ? cmp : CompareFields(c_ast1.arg_size(), c_ast2.arg_size());
+}
+
+template <typename T>
+void HashCombine(const T& value, size_t* seed) {
+  ::boost::hash_combine(*seed, value);
+}
+
+void HashInto(const AST& ast, size_t* seed) {
+  HashCombine(ast.has_is_nullable() ? 1 + ast.is_nullable() : 0, seed);
+  HashCombine(ast.has_name(), seed);
+  if (ast.has_name()) {
+    HashCombine(ast.name(), seed);
+  }
+  HashCombine(static_cast<int>(ast.node_case()), seed);
+  if (ast.has_p_ast()) {
+    const PrimitiveAST& p_ast = ast.p_ast();
+    HashCombine(static_cast<int>(p_ast.type()), seed);
+    const PrimitiveValue& val = p_ast.val();
+    HashCombine(p_ast.has_val() ? 1 + static_cast<int>(val.val_case()) : 0,
+                seed);
+    switch (val.val_case()) {
+      case PrimitiveValue::kBoolVal:
+        HashCombine(val.bool_val(), seed);
+        break;
+      case PrimitiveValue::kIntVal:
+        HashCombine(val.int_val(), seed);
+        break;
+      case PrimitiveValue::kStringVal:
+        HashCombine(val.string_val(), seed);
+        break;
+      case PrimitiveValue::kTimeVal:
+        HashCombine(val.time_val(), seed);
+        break;
+      case PrimitiveValue::VAL_NOT_SET:
+        break;
+    }
+  } else if (ast.has_c_ast()) {
+    HashCombine(static_cast<int>(ast.c_ast().op()), seed);
+    HashCombine(ast.c_ast().arg_size(), seed);
+    for (const AST& arg : ast.c_ast().arg()) {
+      HashInto(arg, seed);
     }
   }
-  return "";
 }
 
 }  // namespace
@@ -135,59 +260,142 @@ bool IsTuple(const AST& ast) {
   return (ast.has_c_ast() && ast.c_ast().op() == Operator::TUPLE);
 }
 
+bool Equal(const AST& ast1, const AST& ast2) {
+  if (ast1.has_is_nullable() != ast2.has_is_nullable() ||
+      ast1.is_nullable() != ast2.is_nullable() ||
+      ast1.has_name() != ast2.has_name() || ast1.name() != ast2.name() ||
+      ast1.node_case() != ast2.node_case()) {
+    return false;
+  }
+  if (ast1.has_p_ast()) {
+    return EqualPrimitives(ast1.p_ast(), ast2.p_ast());
+  }
+  if (ast1.has_c_ast()) {
+    return EqualComposites(ast1.c_ast(), ast2.c_ast());
+  }
+  return true;
+}
+
+int Compare(const AST& ast1, const AST& ast2) {
+  int cmp = CompareFields(ast1.has_is_nullable(), ast2.has_is_nullable());
+  if (cmp == 0) {
+    cmp = CompareFields(ast1.is_nullable(), ast2.is_nullable());
+  }
+  if (cmp == 0) {
+    cmp = CompareFields(ast1.has_name(), ast2.has_name());
+  }
+  if (cmp == 0) {
+    cmp = ast1.name().compare(ast2.name());
+  }
+  if (cmp == 0) {
+    cmp = CompareFields(ast1.node_case(), ast2.node_case());
+  }
+  if (cmp != 0) {
+    return cmp;
+  }
+  if (ast1.has_p_ast()) {
+    return ComparePrimitives(ast1.p_ast(), ast2.p_ast());
+  }
+  if (ast1.has_c_ast()) {
+    return CompareComposites(ast1.c_ast(), ast2.c_ast());
+  }
+  return 0;
+}
+
+size_t Hash(const AST& ast) {
+  size_t seed = 0;
+  HashInto(ast, &seed);
+  return seed;
+}
+
 // The string constant kTagStr is treated as the type name for a tag and
 // ast.tag() is the value. The print option determines which of these is added
 // as a prefix when pretty printing 'ast.ast()'.
 // If Includes(PrintOption::kType, opt) is true, the output should include type
 // information.
-string ToString(const TaggedAST& ast, const PrintConfig& config) {
-  string type_str = Includes(PrintOption::kType, config.opt()) ? kTagStr : "";
-  string type_sep = Includes(PrintOption::kValue, config.opt()) ? " : " : "";
-  string tag_str = ast.has_tag() ? ast.tag() : "";
-  string ast_str = ast.has_ast() ? ToString(ast.ast(), config) : kNullStr;
-  return util::StrCat(type_str, type_sep, tag_str, " :: ", ast_str);
+void AppendToString(const TaggedAST& ast, const PrintConfig& config,
+                    string* out) {
+  if (Includes(PrintOption::kType, config.opt())) {
+    out->append(kTagStr);
+  }
+  if (Includes(PrintOption::kValue, config.opt())) {
+    out->append(" : ");
+  }
+  if (ast.has_tag()) {
+    out->append(ast.tag());
+  }
+  out->append(" :: ");
+  if (ast.has_ast()) {
+    AppendToString(ast.ast(), config, out);
+  } else {
+    out->append(kNullStr);
+  }
 }
 
-string ToString(const AST& ast, const PrintConfig& config) {
-  string root = ToStringRoot(ast, config.opt());
+// The arguments of a composite AST are appended one after another, so printing
+// an AST takes time linear in the size of the output.
+void AppendToString(const AST& ast, const PrintConfig& config, string* out) {
+  AppendRootToString(ast, config.opt(), out);
   if (Includes(config.opt(), PrintOption::kName) || !ast.has_c_ast()) {
-    return root;
+    return;
   }
-  std::vector<string> arg_str;
+  out->append(config.open());
   if (ast.c_ast().arg_size() == 0) {
-    arg_str.emplace_back(kNullStr);
-  } else {
-    arg_str.emplace_back(ToString(ast.c_ast().arg(0), config));
+    out->append(kNullStr);
   }
-  for (int i = 1; i < ast.c_ast().arg_size(); ++i) {
-    arg_str.emplace_back(ToString(ast.c_ast().arg(i), config));
+  for (int i = 0; i < ast.c_ast().arg_size(); ++i) {
+    if (i > 0) {
+      out->append(config.sep());
+    }
+    AppendToString(ast.c_ast().arg(i), config, out);
   }
-  return util::StrCat(root, config.open(),
-                      boost::algorithm::join(arg_str, config.sep()),
-                      config.close());
-}
-
-string ToString(const PrimitiveAST& p_ast, const PrintConfig& config) {
-  AST ast;
-  *ast.mutable_p_ast() = p_ast;
-  return ToStringRoot(ast, config.opt());
+  out->append(config.close());
 }
 
-string ToString(const PrimitiveValue& val) {
+void AppendToString(const PrimitiveValue& val, string* out) {
   switch (val.val_case()) {
     case PrimitiveValue::ValCase::kBoolVal:
-      return val.bool_val() ? "true" : "false";
+      out->append(val.bool_val() ? "true" : "false");
+      break;
     case PrimitiveValue::ValCase::kIntVal:
-      return std::to_string(val.int_val());
+      out->append(std::to_string(val.int_val()));
+      break;
     case PrimitiveValue::ValCase::kStringVal:
-      return val.string_val();
+      out->append(val.string_val());
+      break;
     case PrimitiveValue::ValCase::kTimeVal:
-      return util::UnixMicrosToRFC3339(val.time_val());
+      out->append(util::UnixMicrosToRFC3339(val.time_val()));
+      break;
     case PrimitiveValue::ValCase::VAL_NOT_SET:
-      return kNullStr;
+      out->append(kNullStr);
+      break;
   }
 }
 
+string ToString(const TaggedAST& ast, const PrintConfig& config) {
+  string out;
+  AppendToString(ast, config, &out);
+  return out;
+}
+
+string ToString(const AST& ast, const PrintConfig& config) {
+  string out;
+  AppendToString(ast, config, &out);
+  return out;
+}
+
+string ToString(const PrimitiveAST& p_ast, const PrintConfig& config) {
+  AST ast;
+  *ast.mutable_p_ast() = p_ast;
+  return ToStringRoot(ast, config.opt());
+}
+
+string ToString(const PrimitiveValue& val) {
+  string out;
+  AppendToString(val, &out);
+  return out;
+}
+
 string ToString(const PrimitiveType& type) {
   switch (type) {
     case PrimitiveType::BOOL:
@@ -214,29 +422,33 @@ string ToString(const Operator& op) {
   }
 }
 
-// Returns a string whose output with the print option kAll is:
+// Appends a string whose output with the print option kAll is:
 //   [name] [type] : [value] for primitive ASTs and
 //   [name] [type] for composite ASTs.
 // A subset of this output will appear depending on the options chosen. The
 // separator " : " is added if the output contains both a type and a value.
-string ToStringRoot(const AST& ast, PrintOption opt) {
-  string name = "";
+void AppendRootToString(const AST& ast, PrintOption opt, string* out) {
   if (Includes(PrintOption::kName, opt) && ast.has_name()) {
-    name = ast.name();
+    out->append(ast.name());
+    if (HasNameSeparator(ast.name(), opt)) {
+      out->push_back(' ');
+    }
   }
-  string name_sep = GetNameSeparator(name, opt);
-  string type_str = ToTypeString(ast, opt);
-  string null_op = "";
+  AppendTypeString(ast, opt, out);
   if (Includes(PrintOption::kType, opt) && ast.has_is_nullable() &&
       ast.is_nullable()) {
-    null_op = kNullOpStr;
+    out->append(kNullOpStr);
   }
-  string type_sep = "";
   if (!ast.has_c_ast() && Includes(PrintOption::kTypeAndValue, opt)) {
-    type_sep = " : ";
+    out->append(" : ");
   }
-  string val_str = ToValueString(ast, opt);
-  return util::StrCat(name, name_sep, type_str, null_op, type_sep, val_str);
+  AppendValueString(ast, opt, out);
+}
+
+string ToStringRoot(const AST& ast, PrintOption opt) {
+  string out;
+  AppendRootToString(ast, opt, &out);
+  return out;
 }
 
 }  // namespace ast
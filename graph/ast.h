@@ -35,6 +35,8 @@
 #ifndef LOGLE_AST_H_
 #define LOGLE_AST_H_
 
+#include <cstddef>
+
 #include "base/string.h"
 #include "ast.pb.h"
 
@@ -131,6 +133,34 @@ bool IsList(const AST& ast);
 bool IsSet(const AST& ast);
 bool IsTuple(const AST& ast);
 
+// Returns true if 'ast1' and 'ast2' have the same fields set to the same
+// values, which is the case exactly if their serializations are equal. Unlike
+// comparing serializations, this function walks both ASTs once and allocates
+// no memory.
+bool Equal(const AST& ast1, const AST& ast2);
+
+// Returns a hash of 'ast' that is consistent with Equal. Like Equal, it walks
+// the AST once without allocating memory.
+size_t Hash(const AST& ast);
+
+// Compares 'ast1' and 'ast2' in a total order that is consistent with Equal.
+// Returns a negative number if 'ast1' is before 'ast2', 0 if they are equal
+// and a positive number otherwise. Primitive values of the same type are
+// ordered by their values, and composite ASTs with the same operator are
+// ordered lexicographically by their arguments. Like Equal, this function
+// walks the ASTs once without allocating memory.
+int Compare(const AST& ast1, const AST& ast2);
+
+// Function objects for using ASTs as keys of unordered containers.
+struct ASTHash {
+  size_t operator()(const AST& ast) const { return Hash(ast); }
+};
+struct ASTEqual {
+  bool operator()(const AST& ast1, const AST& ast2) const {
+    return Equal(ast1, ast2);
+  }
+};
+
 // The ToString methods pretty print the contents of an AST to a string. The
 // print config argument determines which contents of the AST to print. See the
 // example at the top of the file for how to use these methods.
@@ -143,6 +173,14 @@ string ToString(const PrimitiveValue& val);
 string ToString(const PrimitiveType& type);
 string ToString(const Operator& op);
 
+// The AppendToString methods append the same output as the ToString methods to
+// '*out'. Printing many ASTs into one buffer with these methods avoids building
+// a temporary string for every AST and every node of an AST.
+void AppendToString(const TaggedAST& ast, const PrintConfig& config,
+                    string* out);
+void AppendToString(const AST& ast, const PrintConfig& config, string* out);
+void AppendToString(const PrimitiveValue& val, string* out);
+
 // Returns only the root of the abstract syntax tree as a string. Unlike the
 // methods above, this function takes a PrintOption and not a PrintConfig as an
 // argument because the root of an AST is serialized without delimiters. For
@@ -152,6 +190,8 @@ string ToString(const Operator& op);
 //  ToStringRoot(ast, opt) returns "list" if 'opt' is kType or kTypeAndValue
 //  and returns the empty string otherwise.
 string ToStringRoot(const AST& ast, PrintOption opt);
+// Appends the output of ToStringRoot to '*out'.
+void AppendRootToString(const AST& ast, PrintOption opt, string* out);
 
 }  // namespace ast
 }  // namespace morphie
@@ -14,6 +14,7 @@
 #include "ast.h"
 
 #include "base/string.h"
+#include "util/string_utils.h"
 #include "gtest.h"
 
 namespace morphie {
@@ -59,6 +60,56 @@ TEST_F(ASTTest, IsAContainerAST) {
   EXPECT_TRUE(IsSet(ast_));
 }
 
+// Equal agrees with comparison of serializations, so the presence of a field
+// matters even if it has its default value.
+TEST_F(ASTTest, EqualAndHash) {
+  ast_.set_name("t");
+  ast_.mutable_c_ast()->set_op(Operator::LIST);
+  PrimitiveAST* p_ast = ast_.mutable_c_ast()->add_arg()->mutable_p_ast();
+  p_ast->set_type(PrimitiveType::STRING);
+  p_ast->mutable_val()->set_string_val("foo");
+  AST copy = ast_;
+  EXPECT_TRUE(Equal(ast_, copy));
+  EXPECT_EQ(Hash(ast_), Hash(copy));
+  copy.set_is_nullable(false);
+  EXPECT_FALSE(Equal(ast_, copy));
+  copy.clear_is_nullable();
+  p_ast = copy.mutable_c_ast()->mutable_arg(0)->mutable_p_ast();
+  p_ast->mutable_val()->set_string_val("bar");
+  EXPECT_FALSE(Equal(ast_, copy));
+  EXPECT_NE(Hash(ast_), Hash(copy));
+  copy = ast_;
+  copy.mutable_c_ast()->add_arg();
+  EXPECT_FALSE(Equal(ast_, copy));
+  copy = ast_;
+  copy.mutable_c_ast()->set_op(Operator::SET);
+  EXPECT_FALSE(Equal(ast_, copy));
+  EXPECT_TRUE(Equal(AST(), AST()));
+  EXPECT_FALSE(Equal(AST(), ast_));
+}
+
+// Compare orders primitive values by value and composite ASTs by their
+// arguments, and returns 0 exactly for equal ASTs.
+TEST_F(ASTTest, Compare) {
+  AST minus_one;
+  minus_one.mutable_p_ast()->set_type(PrimitiveType::INT);
+  minus_one.mutable_p_ast()->mutable_val()->set_int_val(-1);
+  AST two = minus_one;
+  two.mutable_p_ast()->mutable_val()->set_int_val(2);
+  EXPECT_LT(Compare(minus_one, two), 0);
+  EXPECT_GT(Compare(two, minus_one), 0);
+  EXPECT_EQ(0, Compare(two, two));
+  AST list1;
+  list1.mutable_c_ast()->set_op(Operator::LIST);
+  *list1.mutable_c_ast()->add_arg() = minus_one;
+  AST list2 = list1;
+  *list2.mutable_c_ast()->add_arg() = minus_one;
+  EXPECT_LT(Compare(list1, list2), 0);
+  *list1.mutable_c_ast()->mutable_arg(0) = two;
+  EXPECT_GT(Compare(list1, list2), 0);
+  EXPECT_LT(Compare(AST(), list1), 0);
+}
+
 // Test that a name field is serialized as the empty string if absent and that
 // if no fields in the AST are set, then the type and the value are both 'null'.
 TEST_F(ASTTest, PrintNull) {
@@ -222,6 +273,32 @@ TEST_F(ASTTest, PrintTuple) {
   EXPECT_EQ("0\nfoo", ToString(ast_, config));
 }
 
+// Appending to a buffer produces the same output as ToString after the
+// existing contents of the buffer.
+TEST_F(ASTTest, AppendToString) {
+  ast_.mutable_c_ast()->set_op(Operator::TUPLE);
+  ast_.set_name("t");
+  AST arg;
+  arg.mutable_p_ast()->set_type(PrimitiveType::INT);
+  arg.mutable_p_ast()->mutable_val()->set_int_val(3);
+  *(ast_.mutable_c_ast()->add_arg()) = arg;
+  *(ast_.mutable_c_ast()->add_arg()) = arg;
+  tast_.set_tag("Event");
+  *tast_.mutable_ast() = ast_;
+  PrintConfig config("[", "]", "/", PrintOption::kAll);
+  string buffer = "labels:";
+  AppendToString(ast_, config, &buffer);
+  AppendRootToString(arg, PrintOption::kTypeAndValue, &buffer);
+  AppendToString(tast_, config, &buffer);
+  EXPECT_EQ(util::StrCat("labels:", ToString(ast_, config),
+                         ToStringRoot(arg, PrintOption::kTypeAndValue),
+                         ToString(tast_, config)),
+            buffer);
+  EXPECT_EQ("labels:t tuple[int : 3/int : 3]int : 3tag : Event :: "
+            "t tuple[int : 3/int : 3]",
+            buffer);
+}
+
 TEST_F(ASTTest, PrintSet) {
   ast_.mutable_c_ast()->set_op(Operator::SET);
   ast_.set_is_nullable(true);
@@ -14,16 +14,19 @@
 
 #include "graph/dot_printer.h"
 
-#include <boost/algorithm/string/join.hpp>  // NOLINT
-#include <boost/algorithm/string/replace.hpp>  // NOLINT
 #include <boost/graph/directed_graph.hpp>  // NOLINT
 
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
 #include "graph/ast.h"
 #include "graph/type.h"
 #include "graph/type_checker.h"
 #include "graph/value.h"
 #include "graph/value_checker.h"
 #include "util/logging.h"
+#include "util/parallel.h"
 #include "util/status.h"
 #include "util/string_utils.h"
 
@@ -61,12 +64,30 @@ string GetListElement(const AST& ast, int pos) {
   return ast::value::GetString(ast.c_ast().arg(pos));
 }
 
-// Replace '<','>' and '&' with their corresponding escape sequences. The '&'
-// symbol must be replaced first to avoid '&lt;' being replaced by '&amp;lt;'.
-void AddEscapes(string* s) {
-  boost::replace_all(*s, "&", "&amp;");
-  boost::replace_all(*s, "<", "&lt;");
-  boost::replace_all(*s, ">", "&gt;");
+// Replace '<','>' and '&' in the suffix of '*s' starting at 'pos' with their
+// corresponding escape sequences. The suffix is only copied if it contains a
+// character to escape.
+void AddEscapes(size_t pos, string* s) {
+  if (s->find_first_of("&<>", pos) == string::npos) {
+    return;
+  }
+  const string suffix = s->substr(pos);
+  s->resize(pos);
+  for (char c : suffix) {
+    switch (c) {
+      case '&':
+        s->append("&amp;");
+        break;
+      case '<':
+        s->append("&lt;");
+        break;
+      case '>':
+        s->append("&gt;");
+        break;
+      default:
+        s->push_back(c);
+    }
+  }
 }
 
 // Returns a string of the form "[shape=Box, label="foo"]" that defines the
@@ -80,32 +101,141 @@ string JoinAttributes(const string& style, const string& label,
   return util::StrCat("[", style, ", ", quoted_label, "]");
 }
 
-// Returns an AST as an HTML-like DOT label. If the AST is a container, every
-// element in the container is a row of a table. Unlike standard HTML, the HTML
-// implemented in DOT is whitespace sensitive so indents are spaces.
-string ToDotIndent(const AST& ast, int indent) {
+// Appends an AST as an HTML-like DOT label to '*out'. If the AST is a
+// container, every element in the container is a row of a table. Unlike
+// standard HTML, the HTML implemented in DOT is whitespace sensitive so indents
+// are spaces.
+void AppendDotIndent(const AST& ast, int indent, string* out) {
   if (ast.has_p_ast()) {
-    string label = ast::ToStringRoot(ast, ast::PrintOption::kValue);
-    AddEscapes(&label);
-    return util::StrCat(string(indent, ' '), label);
+    out->append(indent, ' ');
+    const size_t label_pos = out->size();
+    ast::AppendRootToString(ast, ast::PrintOption::kValue, out);
+    AddEscapes(label_pos, out);
+    return;
   }
-  std::vector<string> arg_str;
-  for (const AST& arg : ast.c_ast().arg()) {
-    arg_str.emplace_back(ToDotIndent(arg, indent + 2));
+  out->append(kTableHeader);
+  out->append("\n<tr><td>");
+  for (int i = 0; i < ast.c_ast().arg_size(); ++i) {
+    if (i > 0) {
+      out->append("</td></tr>\n<tr><td>");
+    }
+    AppendDotIndent(ast.c_ast().arg(i), indent + 2, out);
+  }
+  out->append("</td></tr>\n</table>");
+}
+
+// Returns the attributes returned by JoinAttributes for an HTML-like label
+// that displays 'ast', which is rendered directly into the attributes.
+string HTMLAttributes(const string& style, const AST& ast) {
+  string attributes = util::StrCat("[", style, ", label=<");
+  AppendDotIndent(ast, 0, &attributes);
+  attributes.append(">]");
+  return attributes;
+}
+
+// In attributes returned by JoinAttributes, the style is separated from the
+// label by this string.
+const char kLabelSeparator[] = ", label=";
+const char kEmptyLabel[] = R"([label=""])";
+
+// Splits attributes of the form "[style, label=...]", as returned by
+// JoinAttributes, into the style and the attributes "[label=...]". Returns
+// false if 'attributes' are not of this form. Styles do not contain labels, so
+// the first separator is the one after the style.
+bool SplitStyle(const string& attributes, string* style, string* label) {
+  const size_t separator_pos = attributes.find(kLabelSeparator);
+  if (attributes.empty() || attributes[0] != '[' ||
+      separator_pos == string::npos) {
+    return false;
   }
-  return util::StrCat(kTableHeader, "\n<tr><td>",
-                      boost::algorithm::join(arg_str, "</td></tr>\n<tr><td>"),
-                      "</td></tr>\n</table>");
+  style->assign(attributes, 1, separator_pos - 1);
+  label->assign(util::StrCat("[", attributes.substr(separator_pos + 2)));
+  return true;
 }
 
+// Declarations of nodes or edges, grouped by the style in their attributes if
+// grouping is enabled. The declarations of a group are written in an anonymous
+// subgraph whose default attributes are the style of the group, so that the
+// style is written once instead of in every declaration. The defaults of a
+// subgraph do not apply outside it, so the styles of different groups do not
+// mix. Declarations whose attributes have no style, and all declarations if
+// grouping is disabled, are in a group with an empty style and are written
+// without a subgraph.
+class StyleGroups {
+ public:
+  explicit StyleGroups(bool is_grouped) : is_grouped_(is_grouped) {}
+
+  // Adds the declaration of 'element', which is a node id or an edge, with the
+  // given attributes. An empty edge label is omitted because edges are not
+  // labeled by default, unlike nodes.
+  void Add(const string& element, const string& attributes, bool is_edge) {
+    string style;
+    string label;
+    if (!is_grouped_ || !SplitStyle(attributes, &style, &label)) {
+      util::StrAppend(&declarations_[Group("")], "  ", element, " ",
+                      attributes, ";\n");
+      return;
+    }
+    string* declarations = &declarations_[Group(style)];
+    if (is_edge && label == kEmptyLabel) {
+      util::StrAppend(declarations, "    ", element, ";\n");
+    } else {
+      util::StrAppend(declarations, "    ", element, " ", label, ";\n");
+    }
+  }
+
+  // Appends the declarations of 'other' to the groups with the same styles.
+  void Append(const StyleGroups& other) {
+    for (size_t i = 0; i < other.styles_.size(); ++i) {
+      declarations_[Group(other.styles_[i])] += other.declarations_[i];
+    }
+  }
+
+  // Writes the groups in the order in which their styles were first added.
+  // The 'kind' of the declarations is "node" or "edge".
+  void Write(const char* kind, std::ostream* out) const {
+    for (size_t i = 0; i < styles_.size(); ++i) {
+      if (styles_[i].empty()) {
+        *out << declarations_[i];
+        continue;
+      }
+      *out << "  subgraph {\n    " << kind << " [" << styles_[i] << "];\n"
+           << declarations_[i] << "  }\n";
+    }
+  }
+
+ private:
+  // Returns the index of the group with 'style', which is added if needed.
+  size_t Group(const string& style) {
+    auto index_it = index_.find(style);
+    if (index_it != index_.end()) {
+      return index_it->second;
+    }
+    index_.emplace(style, styles_.size());
+    styles_.push_back(style);
+    declarations_.emplace_back();
+    return styles_.size() - 1;
+  }
+
+  bool is_grouped_;
+  std::vector<string> styles_;
+  // The declarations of each group, indexed like 'styles_'.
+  std::vector<string> declarations_;
+  std::unordered_map<string, size_t> index_;
+};
+
 }  // namespace
 
 DotPrinter::DotPrinter()
-    : node_attribute_(NodeAttribute), edge_attribute_(EdgeAttribute) {}
+    : node_attribute_(NodeAttribute),
+      edge_attribute_(EdgeAttribute),
+      group_styles_(false) {}
 
 DotPrinter::DotPrinter(const AttributeFn& node_attribute,
                        const AttributeFn& edge_attribute)
-    : node_attribute_(node_attribute), edge_attribute_(edge_attribute) {}
+    : node_attribute_(node_attribute),
+      edge_attribute_(edge_attribute),
+      group_styles_(false) {}
 
 string DotPrinter::FileAttribute(const AST& ast) {
   string err;
@@ -152,9 +282,7 @@ string DotPrinter::NodeAttribute(const string& tag, const AST& ast) {
   } else if (tag == ast::kURLTag) {
     return URLAttribute(ast);
   } else {
-    return JoinAttributes(kRoundedBoxStyle,
-                          ToDotIndent(ast, 0),
-                          true /*Use tags.*/);
+    return HTMLAttributes(kRoundedBoxStyle, ast);
   }
 }
 
@@ -163,57 +291,166 @@ string DotPrinter::EdgeAttribute(const string& tag, const AST& ast) {
   if (tag == ast::kPrecedesTag) {
     return JoinAttributes(kPrecedesStyle, "", false /*Do not use tags.*/);
   }
-  if (ast::value::Isomorphic(ast, ast::value::MakeNull())) {
+  if (ast::IsNull(ast)) {
     return JoinAttributes(kDashedGrayEdge, "", false /*Do not use tags.*/);
   }
-  return JoinAttributes(kDashedGrayEdge, ToDotIndent(ast, 0),
-                        true /*Use tags.*/);
+  return HTMLAttributes(kDashedGrayEdge, ast);
 }
 
 string DotPrinter::DotNode(NodeId node_id, const TaggedAST& tast) {
-  string attr = tast.has_ast() ? node_attribute_(tast.tag(), tast.ast())
-                               : JoinAttributes(kRoundedBoxStyle, tast.tag(),
-                                                false /*Do not use tags.*/);
-  return util::StrCat(std::to_string(node_id), " ", attr, ";");
+  return util::StrCat(std::to_string(node_id), " ", NodeAttributes(tast), ";");
 }
 
 string DotPrinter::DotEdge(NodeId source_id, NodeId target_id,
                            const TaggedAST& tast) {
-  string attr = tast.has_ast() ? edge_attribute_(tast.tag(), tast.ast())
-                               : JoinAttributes(kSolidGrayEdge, "",
-                                                false /*Do not use tags.*/);
   return util::StrCat(std::to_string(source_id), " -> ",
-                      std::to_string(target_id), " ", attr, ";");
+                      std::to_string(target_id), " ", EdgeAttributes(tast),
+                      ";");
+}
+
+string DotPrinter::NodeAttributes(const TaggedAST& tast) {
+  return tast.has_ast() ? node_attribute_(tast.tag(), tast.ast())
+                        : JoinAttributes(kRoundedBoxStyle, tast.tag(),
+                                         false /*Do not use tags.*/);
+}
+
+string DotPrinter::EdgeAttributes(const TaggedAST& tast) {
+  return tast.has_ast() ? edge_attribute_(tast.tag(), tast.ast())
+                        : JoinAttributes(kSolidGrayEdge, "",
+                                         false /*Do not use tags.*/);
 }
 
 string DotPrinter::AllNodesInDot(const LabeledGraph& graph) {
-  string dot_nodes;
-  string indent("  ");
+  std::ostringstream dot_nodes;
+  WriteAllNodes(graph, &dot_nodes);
+  return dot_nodes.str();
+}
+
+string DotPrinter::AllEdgesInDot(const LabeledGraph& graph) {
+  std::ostringstream dot_edges;
+  WriteAllEdges(graph, &dot_edges);
+  return dot_edges.str();
+}
+
+string DotPrinter::DotGraph(const LabeledGraph& graph) {
+  std::ostringstream dot_graph;
+  WriteDotGraph(graph, &dot_graph);
+  return dot_graph.str();
+}
+
+// Grouped declarations are held in memory until all of them have been
+// generated, because a group can only be written once it is complete.
+void DotPrinter::WriteAllNodes(const LabeledGraph& graph, std::ostream* out) {
+  if (group_styles_) {
+    StyleGroups groups(true);
+    for (auto node_it = graph.NodeSetBegin(); node_it != graph.NodeSetEnd();
+         ++node_it) {
+      groups.Add(std::to_string(*node_it),
+                 NodeAttributes(graph.GetNodeLabel(*node_it)),
+                 false /* Not an edge. */);
+    }
+    groups.Write("node", out);
+    return;
+  }
   for (auto node_it = graph.NodeSetBegin(); node_it != graph.NodeSetEnd();
        ++node_it) {
-    TaggedAST tast = graph.GetNodeLabel(*node_it);
-    util::StrAppend(&dot_nodes, indent, DotNode(*node_it, tast), "\n");
+    const TaggedAST& tast = graph.GetNodeLabel(*node_it);
+    *out << "  " << DotNode(*node_it, tast) << "\n";
   }
-  return dot_nodes;
 }
 
-string DotPrinter::AllEdgesInDot(const LabeledGraph& graph) {
-  string dot_edges;
-  string indent("  ");
+void DotPrinter::WriteAllEdges(const LabeledGraph& graph, std::ostream* out) {
+  if (group_styles_) {
+    StyleGroups groups(true);
+    for (auto edge_it = graph.EdgeSetBegin(); edge_it != graph.EdgeSetEnd();
+         ++edge_it) {
+      groups.Add(util::StrCat(std::to_string(graph.Source(*edge_it)), " -> ",
+                              std::to_string(graph.Target(*edge_it))),
+                 EdgeAttributes(graph.GetEdgeLabel(*edge_it)),
+                 true /* An edge. */);
+    }
+    groups.Write("edge", out);
+    return;
+  }
   for (auto edge_it = graph.EdgeSetBegin(); edge_it != graph.EdgeSetEnd();
        ++edge_it) {
-    TaggedAST tast = graph.GetEdgeLabel(*edge_it);
-    util::StrAppend(
-        &dot_edges, indent,
-        DotEdge(graph.Source(*edge_it), graph.Target(*edge_it), tast), "\n");
+    const TaggedAST& tast = graph.GetEdgeLabel(*edge_it);
+    *out << "  "
+         << DotEdge(graph.Source(*edge_it), graph.Target(*edge_it), tast)
+         << "\n";
   }
-  return dot_edges;
 }
 
-string DotPrinter::DotGraph(const LabeledGraph& graph) {
-  string dot_graph = AllNodesInDot(graph);
-  util::StrAppend(&dot_graph, AllEdgesInDot(graph));
-  return util::StrCat("digraph logle_graph {\n", dot_graph, "}");
+void DotPrinter::WriteDotGraph(const LabeledGraph& graph, std::ostream* out) {
+  *out << "digraph logle_graph {\n";
+  WriteAllNodes(graph, out);
+  WriteAllEdges(graph, out);
+  *out << "}";
+}
+
+string DotPrinter::ParallelDotGraph(const LabeledGraph& graph,
+                                    int num_threads) {
+  std::ostringstream dot_graph;
+  WriteParallelDotGraph(graph, num_threads, &dot_graph);
+  return dot_graph.str();
+}
+
+void DotPrinter::WriteParallelDotGraph(const LabeledGraph& graph,
+                                       int num_threads, std::ostream* out) {
+  *out << "digraph logle_graph {\n";
+  WriteParallelAllNodes(graph, num_threads, out);
+  WriteParallelAllEdges(graph, num_threads, out);
+  *out << "}";
+}
+
+// Node ids are the consecutive integers from zero, so appending the groups of
+// consecutive ranges of nodes yields the groups of WriteAllNodes. Likewise for
+// the edges below.
+void DotPrinter::WriteParallelAllNodes(const LabeledGraph& graph,
+                                       int num_threads, std::ostream* out) {
+  const size_t num_chunks = num_threads > 1 ? num_threads : 1;
+  std::vector<StyleGroups> groups(num_chunks, StyleGroups(group_styles_));
+  util::ParallelForChunks(
+      graph.NumNodes(), num_threads,
+      [this, &graph, &groups](int chunk, size_t begin, size_t end) {
+        for (NodeId node_id = begin; node_id < end; ++node_id) {
+          groups[chunk].Add(std::to_string(node_id),
+                            NodeAttributes(graph.GetNodeLabel(node_id)),
+                            false /* Not an edge. */);
+        }
+      });
+  for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+    groups[0].Append(groups[chunk]);
+  }
+  groups[0].Write("node", out);
+}
+
+// The edge iterators of the graph are not random access, so the edges are
+// collected first and each thread renders a range of consecutive edges.
+void DotPrinter::WriteParallelAllEdges(const LabeledGraph& graph,
+                                       int num_threads, std::ostream* out) {
+  std::vector<EdgeId> edges;
+  edges.reserve(graph.NumEdges());
+  for (auto edge_it = graph.EdgeSetBegin(); edge_it != graph.EdgeSetEnd();
+       ++edge_it) {
+    edges.push_back(*edge_it);
+  }
+  const size_t num_chunks = num_threads > 1 ? num_threads : 1;
+  std::vector<StyleGroups> groups(num_chunks, StyleGroups(group_styles_));
+  util::ParallelForChunks(
+      edges.size(), num_threads,
+      [this, &graph, &edges, &groups](int chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          groups[chunk].Add(
+              util::StrCat(std::to_string(graph.Source(edges[i])), " -> ",
+                           std::to_string(graph.Target(edges[i]))),
+              EdgeAttributes(graph.GetEdgeLabel(edges[i])), true /* An edge. */);
+        }
+      });
+  for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+    groups[0].Append(groups[chunk]);
+  }
+  groups[0].Write("edge", out);
 }
 
 }  // namespace morphie
@@ -31,10 +31,17 @@
 //   ConstructGraph(&graph);
 //   DotPrinter dot_printer(CustomRenderer, DotPrinter::EdgeAttribute);
 //   string dot_graph = dot_printer.DotGraph(graph);
+//
+// Example 3. Large graphs can be written to a stream one declaration at a time
+// instead of being built as a string.
+//
+//   std::ofstream dot_file("graph.dot");
+//   DotPrinter().WriteDotGraph(graph, &dot_file);
 #ifndef LOGLE_DOT_PRINTER_H_
 #define LOGLE_DOT_PRINTER_H_
 
 #include <functional>
+#include <ostream>
 
 #include "base/string.h"
 #include "graph/labeled_graph.h"
@@ -58,7 +65,7 @@ using AttributeFn = std::function<string(const string&, const AST&)>;
 //
 // The GraphViz DOT format declares nodes and edges and their attributes.
 //
-//  Example 3. A GraphViz DOT graph. The attributes are between square-brackets.
+//  Example 4. A GraphViz DOT graph. The attributes are between square-brackets.
 //  digraph ex3 {
 //    a [shape=Box, label="Rectangle"];  // Node declaration
 //    b [shape=Circle, label="Ellipse"];
@@ -112,11 +119,50 @@ class DotPrinter {
   // newline terminated.
   string DotGraph(const LabeledGraph& graph);
 
+  // The WriteXXX functions write the same output as the functions above to
+  // 'out', one declaration at a time, so that the DOT representation of the
+  // graph is never held in memory.
+  void WriteAllNodes(const LabeledGraph& graph, std::ostream* out);
+  void WriteAllEdges(const LabeledGraph& graph, std::ostream* out);
+  void WriteDotGraph(const LabeledGraph& graph, std::ostream* out);
+
+  // If 'group_styles' is true, the functions that declare all nodes or edges
+  // of a graph put the declarations with the same style in an anonymous
+  // subgraph whose default attributes are that style, so that the style is
+  // written once per subgraph instead of in every declaration. The style is
+  // the part of the attributes before the label, as in the attributes of the
+  // predefined attribute functions. Attributes not of that form are written
+  // in full. Grouping makes the output of large graphs much smaller and faster
+  // for GraphViz to parse, but the declarations are held in memory until all
+  // of them have been generated. Grouping is disabled by default.
+  void set_group_styles(bool group_styles) { group_styles_ = group_styles; }
+
+  // The functions below return and write the same output as DotGraph, but
+  // render the graph on 'num_threads' threads. Each thread renders a range of
+  // consecutive nodes and a range of consecutive edges into buffers of its
+  // own, and the buffers are concatenated in order. The attribute functions
+  // must be safe to call concurrently.
+  string ParallelDotGraph(const LabeledGraph& graph, int num_threads);
+  void WriteParallelDotGraph(const LabeledGraph& graph, int num_threads,
+                             std::ostream* out);
+  // Write the same output as WriteAllNodes and WriteAllEdges, rendered on
+  // 'num_threads' threads as above.
+  void WriteParallelAllNodes(const LabeledGraph& graph, int num_threads,
+                             std::ostream* out);
+  void WriteParallelAllEdges(const LabeledGraph& graph, int num_threads,
+                             std::ostream* out);
+
  private:
+  // Returns the attributes of a node or an edge labeled with 'tast'.
+  string NodeAttributes(const TaggedAST& tast);
+  string EdgeAttributes(const TaggedAST& tast);
+
   // The function used to generate node attributes.
   AttributeFn node_attribute_;
   // The function used to generate edge attributes.
   AttributeFn edge_attribute_;
+  // True if declarations are grouped by style.
+  bool group_styles_;
 };  // class DotPrinter
 
 }  // namespace morphie
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <boost/regex.hpp>
 #include <set>
+#include <sstream>
 
 #include "analyzers/plaso/plaso_event.h"
 #include "base/string.h"
@@ -375,5 +376,99 @@ TEST_F(LabeledGraphVisualizerTest, CompleteGraphDefaultAttributes) {
   }
 }
 
+// The streaming functions write the declarations in the same order and format
+// as the functions that return strings.
+// Nodes and edges with the same style are declared in one subgraph.
+TEST_F(LabeledGraphVisualizerTest, GroupsStyles) {
+  EXPECT_TRUE(Initialize(&graph_).ok());
+  AddNode(kRandomTag_, ast::value::MakeString("a"));
+  AddNode(ast::kURLTag, ast::value::MakeString("www.example-url.net"));
+  AddNode(kRandomTag_, ast::value::MakeString("b"));
+  AddEdge(0, 1, ast::kPrecedesTag, ast::value::MakeBool(true));
+  AddEdge(2, 1, ast::kPrecedesTag, ast::value::MakeBool(true));
+  AddEdge(0, 2, kEdgeTag_, ast::value::MakeString("c"));
+
+  dot_printer_.set_group_styles(true);
+  const string grouped = dot_printer_.DotGraph(graph_);
+  EXPECT_EQ(grouped, dot_printer_.ParallelDotGraph(graph_, 2));
+  EXPECT_EQ(
+      "digraph logle_graph {\n"
+      "  subgraph {\n"
+      "    node [shape=box,style=\"rounded,filled\",fillcolor=\"#F8F8F8\"];\n"
+      "    0 [label=<a>];\n"
+      "    2 [label=<b>];\n"
+      "  }\n"
+      "  subgraph {\n"
+      "    node [shape=component,style=filled,fillcolor=lightsteelblue,"
+      "fontname=Arial,fontsize=10];\n"
+      "    1 [label=\"www.example-url.net\"];\n"
+      "  }\n"
+      "  subgraph {\n"
+      "    edge [style=invis];\n"
+      "    0 -> 1;\n"
+      "    2 -> 1;\n"
+      "  }\n"
+      "  subgraph {\n"
+      "    edge [penwidth=.5,arrowsize=.5,arrowhead=onormal,color=gray,"
+      "style=dashed];\n"
+      "    0 -> 2 [label=<c>];\n"
+      "  }\n"
+      "}",
+      grouped);
+}
+
+TEST_F(LabeledGraphVisualizerTest, StreamingMatchesStrings) {
+  EXPECT_TRUE(Initialize(&graph_).ok());
+  AddNode(ast::kFileTag, MakeFilename("/example/of/a/file.txt"));
+  AddNode(ast::kURLTag, ast::value::MakeString("www.example-url.net"));
+  AddNode(kRandomTag_, ast::value::MakeString(kRandomTag_));
+  AddEdge(2, 0, kEdgeTag_, ast::value::MakeString("Edge 1"));
+  AddEdge(0, 1, ast::kPrecedesTag, ast::value::MakeBool(true));
+
+  std::ostringstream nodes;
+  dot_printer_.WriteAllNodes(graph_, &nodes);
+  EXPECT_EQ(dot_printer_.AllNodesInDot(graph_), nodes.str());
+  std::ostringstream edges;
+  dot_printer_.WriteAllEdges(graph_, &edges);
+  EXPECT_EQ(dot_printer_.AllEdgesInDot(graph_), edges.str());
+  std::ostringstream dot_graph;
+  dot_printer_.WriteDotGraph(graph_, &dot_graph);
+  EXPECT_EQ(util::StrCat("digraph logle_graph {\n", nodes.str(), edges.str(),
+                         "}"),
+            dot_graph.str());
+}
+
+// The parallel renderer produces the same output as DotGraph, including when
+// there are more threads than nodes.
+TEST_F(LabeledGraphVisualizerTest, ParallelMatchesSerial) {
+  EXPECT_TRUE(Initialize(&graph_).ok());
+  EXPECT_EQ(dot_printer_.DotGraph(graph_),
+            dot_printer_.ParallelDotGraph(graph_, 3));
+  const int kNumNodes = 60;
+  for (int i = 0; i < kNumNodes; ++i) {
+    if (i % 3 == 0) {
+      AddNode(ast::kFileTag,
+              MakeFilename(util::StrCat("/dir/", std::to_string(i), ".txt")));
+    } else {
+      AddNode(kRandomTag_, ast::value::MakeString(std::to_string(i)));
+    }
+  }
+  for (int i = 0; i < kNumNodes; ++i) {
+    AddEdge(i, (i * 7) % kNumNodes, kEdgeTag_, ast::value::MakeString("a"));
+    AddEdge(i, (i * 7) % kNumNodes, kEdgeTag_, ast::value::MakeString("b"));
+    AddEdge(i, (i + 1) % kNumNodes, ast::kPrecedesTag,
+            ast::value::MakeBool(true));
+  }
+  // Edges are written in the order in which they were added, not by source.
+  for (int i = 0; i < kNumNodes; ++i) {
+    AddEdge((i * 11) % kNumNodes, i, kEdgeTag_, ast::value::MakeString("c"));
+  }
+  const string dot_graph = dot_printer_.DotGraph(graph_);
+  for (int num_threads : {0, 1, 2, 3, 7, 100}) {
+    EXPECT_EQ(dot_graph, dot_printer_.ParallelDotGraph(graph_, num_threads))
+        << "Threads: " << num_threads;
+  }
+}
+
 }  // namespace
 }  // namespace morphie
@@ -0,0 +1,412 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// A FlatAST is encoded in two passes over the AST. The first pass computes the
+// number of nodes and the size of the string pool, so that the buffer can be
+// allocated once, and the second pass writes the records and the strings.
+#include "graph/flat_ast.h"
+
+#include <cstring>
+#include <limits>
+
+#include "util/logging.h"
+
+namespace morphie {
+namespace ast {
+
+namespace {
+
+const char kNotPrimitiveErr[] = "The node is not a primitive with a value.";
+const char kInvalidArgErr[] = "Invalid argument of a flat AST node.";
+
+enum Kind : uint8_t { kNull = 0, kPrimitive = 1, kComposite = 2 };
+
+enum Flag : uint8_t {
+  kHasIsNullable = 1,
+  kIsNullable = 2,
+  kHasName = 4,
+  kHasCode = 8,
+  kHasValue = 16,
+};
+
+// A node record. The record has no padding and unused fields are 0, so the
+// encoding of an AST is deterministic.
+struct Record {
+  uint8_t kind;
+  uint8_t flags;
+  // The PrimitiveType of a primitive node or the Operator of a composite node.
+  uint8_t code;
+  // The PrimitiveValue::ValCase of a primitive node.
+  uint8_t val_case;
+  uint32_t num_args;
+  // The number of records in the subtree rooted at the node.
+  uint32_t size;
+  uint32_t name_offset;
+  uint32_t name_size;
+  uint32_t string_size;
+  // The value of a bool, int or timestamp node, or the offset of the value of
+  // a string node.
+  int64_t value;
+};
+
+static_assert(sizeof(Record) == 32, "A flat AST record must not be padded.");
+
+// The header holds the number of nodes and is padded to 8 bytes.
+const size_t kHeaderSize = 8;
+
+size_t PoolOffset(uint32_t num_nodes) {
+  return kHeaderSize + num_nodes * sizeof(Record);
+}
+
+uint32_t GetNumNodes(const string& buffer) {
+  uint32_t num_nodes;
+  std::memcpy(&num_nodes, buffer.data(), sizeof(num_nodes));
+  return num_nodes;
+}
+
+// Records are copied out of the buffer because the buffer need not be
+// aligned for a Record.
+Record GetRecord(const string& buffer, uint32_t index) {
+  Record record;
+  std::memcpy(&record, buffer.data() + PoolOffset(index), sizeof(record));
+  return record;
+}
+
+// Replaces the value of the record 'index', which must hold a value of type
+// 'val_case'.
+void SetRecordValue(uint32_t index, PrimitiveValue::ValCase val_case,
+                    int64_t value, string* buffer) {
+  Record record = GetRecord(*buffer, index);
+  CHECK(record.val_case == val_case, kNotPrimitiveErr);
+  std::memcpy(&(*buffer)[PoolOffset(index) + offsetof(Record, value)], &value,
+              sizeof(value));
+}
+
+util::StringPiece GetPoolString(const string& buffer, uint32_t offset,
+                                uint32_t size) {
+  return util::StringPiece(
+      buffer.data() + PoolOffset(GetNumNodes(buffer)) + offset, size);
+}
+
+void Measure(const AST& ast, size_t* num_nodes, size_t* pool_size) {
+  ++*num_nodes;
+  *pool_size += ast.name().size();
+  if (ast.has_p_ast()) {
+    *pool_size += ast.p_ast().val().string_val().size();
+  } else if (ast.has_c_ast()) {
+    for (const AST& arg : ast.c_ast().arg()) {
+      Measure(arg, num_nodes, pool_size);
+    }
+  }
+}
+
+class Encoder {
+ public:
+  Encoder(char* records, char* pool)
+      : records_(records), pool_(pool), num_records_(0), pool_size_(0) {}
+
+  // Writes the records of the subtree rooted at 'ast' and returns the number
+  // of records written.
+  uint32_t Encode(const AST& ast) {
+    uint32_t index = num_records_++;
+    Record record;
+    std::memset(&record, 0, sizeof(record));
+    record.size = 1;
+    if (ast.has_is_nullable()) {
+      record.flags |= kHasIsNullable;
+      if (ast.is_nullable()) {
+        record.flags |= kIsNullable;
+      }
+    }
+    if (ast.has_name()) {
+      record.flags |= kHasName;
+      record.name_offset = AddString(ast.name());
+      record.name_size = ast.name().size();
+    }
+    if (ast.has_p_ast()) {
+      EncodePrimitive(ast.p_ast(), &record);
+    } else if (ast.has_c_ast()) {
+      const CompositeAST& c_ast = ast.c_ast();
+      record.kind = kComposite;
+      if (c_ast.has_op()) {
+        record.flags |= kHasCode;
+      }
+      record.code = static_cast<uint8_t>(c_ast.op());
+      record.num_args = c_ast.arg_size();
+      for (const AST& arg : c_ast.arg()) {
+        record.size += Encode(arg);
+      }
+    }
+    std::memcpy(records_ + index * sizeof(Record), &record, sizeof(record));
+    return record.size;
+  }
+
+ private:
+  void EncodePrimitive(const PrimitiveAST& p_ast, Record* record) {
+    record->kind = kPrimitive;
+    if (p_ast.has_type()) {
+      record->flags |= kHasCode;
+    }
+    record->code = static_cast<uint8_t>(p_ast.type());
+    if (!p_ast.has_val()) {
+      return;
+    }
+    record->flags |= kHasValue;
+    const PrimitiveValue& val = p_ast.val();
+    record->val_case = static_cast<uint8_t>(val.val_case());
+    switch (val.val_case()) {
+      case PrimitiveValue::kBoolVal:
+        record->value = val.bool_val();
+        break;
+      case PrimitiveValue::kIntVal:
+        record->value = val.int_val();
+        break;
+      case PrimitiveValue::kStringVal:
+        record->value = AddString(val.string_val());
+        record->string_size = val.string_val().size();
+        break;
+      case PrimitiveValue::kTimeVal:
+        record->value = val.time_val();
+        break;
+      case PrimitiveValue::VAL_NOT_SET:
+        break;
+    }
+  }
+
+  uint32_t AddString(const string& str) {
+    uint32_t offset = pool_size_;
+    if (!str.empty()) {
+      std::memcpy(pool_ + offset, str.data(), str.size());
+    }
+    pool_size_ += str.size();
+    return offset;
+  }
+
+  char* records_;
+  char* pool_;
+  uint32_t num_records_;
+  uint32_t pool_size_;
+};
+
+// Decodes the subtree rooted at the record 'index' into 'ast' and returns the
+// index of the record after the subtree.
+uint32_t Decode(const string& buffer, uint32_t index, AST* ast) {
+  Record record = GetRecord(buffer, index);
+  if (record.flags & kHasIsNullable) {
+    ast->set_is_nullable(record.flags & kIsNullable);
+  }
+  if (record.flags & kHasName) {
+    util::StringPiece name =
+        GetPoolString(buffer, record.name_offset, record.name_size);
+    ast->set_name(name.data(), name.size());
+  }
+  if (record.kind == kPrimitive) {
+    PrimitiveAST* p_ast = ast->mutable_p_ast();
+    if (record.flags & kHasCode) {
+      p_ast->set_type(static_cast<PrimitiveType>(record.code));
+    }
+    if (record.flags & kHasValue) {
+      PrimitiveValue* val = p_ast->mutable_val();
+      switch (record.val_case) {
+        case PrimitiveValue::kBoolVal:
+          val->set_bool_val(record.value != 0);
+          break;
+        case PrimitiveValue::kIntVal:
+          val->set_int_val(record.value);
+          break;
+        case PrimitiveValue::kStringVal: {
+          util::StringPiece str = GetPoolString(
+              buffer, static_cast<uint32_t>(record.value), record.string_size);
+          val->set_string_val(str.data(), str.size());
+          break;
+        }
+        case PrimitiveValue::kTimeVal:
+          val->set_time_val(record.value);
+          break;
+      }
+    }
+    return index + 1;
+  }
+  if (record.kind == kNull) {
+    return index + 1;
+  }
+  CompositeAST* c_ast = ast->mutable_c_ast();
+  if (record.flags & kHasCode) {
+    c_ast->set_op(static_cast<Operator>(record.code));
+  }
+  c_ast->mutable_arg()->Reserve(record.num_args);
+  uint32_t arg_index = index + 1;
+  for (uint32_t i = 0; i < record.num_args; ++i) {
+    arg_index = Decode(buffer, arg_index, c_ast->add_arg());
+  }
+  return arg_index;
+}
+
+}  // namespace
+
+bool FlatNode::IsNull() const {
+  return GetRecord(ast_->buffer_, index_).kind == kNull;
+}
+
+bool FlatNode::IsBool() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return record.kind == kPrimitive && record.code == PrimitiveType::BOOL;
+}
+
+bool FlatNode::IsInt() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return record.kind == kPrimitive && record.code == PrimitiveType::INT;
+}
+
+bool FlatNode::IsString() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return record.kind == kPrimitive && record.code == PrimitiveType::STRING;
+}
+
+bool FlatNode::IsTimestamp() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return record.kind == kPrimitive && record.code == PrimitiveType::TIMESTAMP;
+}
+
+bool FlatNode::IsContainer() const { return IsList() || IsSet() || IsTuple(); }
+
+bool FlatNode::IsInterval() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return record.kind == kComposite && record.code == Operator::INTERVAL;
+}
+
+bool FlatNode::IsList() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return record.kind == kComposite && record.code == Operator::LIST;
+}
+
+bool FlatNode::IsSet() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return record.kind == kComposite && record.code == Operator::SET;
+}
+
+bool FlatNode::IsTuple() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return record.kind == kComposite && record.code == Operator::TUPLE;
+}
+
+bool FlatNode::has_is_nullable() const {
+  return GetRecord(ast_->buffer_, index_).flags & kHasIsNullable;
+}
+
+bool FlatNode::is_nullable() const {
+  return GetRecord(ast_->buffer_, index_).flags & kIsNullable;
+}
+
+bool FlatNode::has_name() const {
+  return GetRecord(ast_->buffer_, index_).flags & kHasName;
+}
+
+util::StringPiece FlatNode::name() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  return GetPoolString(ast_->buffer_, record.name_offset, record.name_size);
+}
+
+bool FlatNode::HasValue() const {
+  return GetRecord(ast_->buffer_, index_).flags & kHasValue;
+}
+
+bool FlatNode::GetBool() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  CHECK(record.val_case == PrimitiveValue::kBoolVal, kNotPrimitiveErr);
+  return record.value != 0;
+}
+
+int64_t FlatNode::GetInt() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  CHECK(record.val_case == PrimitiveValue::kIntVal, kNotPrimitiveErr);
+  return record.value;
+}
+
+util::StringPiece FlatNode::GetString() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  CHECK(record.val_case == PrimitiveValue::kStringVal, kNotPrimitiveErr);
+  return GetPoolString(ast_->buffer_, static_cast<uint32_t>(record.value),
+                       record.string_size);
+}
+
+int64_t FlatNode::GetTimestamp() const {
+  Record record = GetRecord(ast_->buffer_, index_);
+  CHECK(record.val_case == PrimitiveValue::kTimeVal, kNotPrimitiveErr);
+  return record.value;
+}
+
+int FlatNode::NumArgs() const {
+  return GetRecord(ast_->buffer_, index_).num_args;
+}
+
+FlatNode FlatNode::Arg(int i) const {
+  CHECK(i >= 0 && i < NumArgs(), kInvalidArgErr);
+  uint32_t arg_index = index_ + 1;
+  for (int j = 0; j < i; ++j) {
+    arg_index += GetRecord(ast_->buffer_, arg_index).size;
+  }
+  return FlatNode(ast_, arg_index);
+}
+
+FlatAST::FlatAST() : FlatAST(AST()) {}
+
+FlatAST::FlatAST(const AST& ast) {
+  size_t num_nodes = 0;
+  size_t pool_size = 0;
+  Measure(ast, &num_nodes, &pool_size);
+  CHECK(PoolOffset(num_nodes) + pool_size <=
+            std::numeric_limits<uint32_t>::max(),
+        "The AST is too large for a flat encoding.");
+  buffer_.assign(PoolOffset(num_nodes) + pool_size, '\0');
+  uint32_t num_records = num_nodes;
+  std::memcpy(&buffer_[0], &num_records, sizeof(num_records));
+  Encoder encoder(&buffer_[kHeaderSize], &buffer_[0] + PoolOffset(num_nodes));
+  encoder.Encode(ast);
+}
+
+AST FlatAST::ToAST() const {
+  AST ast;
+  Decode(buffer_, 0, &ast);
+  return ast;
+}
+
+int FlatAST::NumNodes() const { return GetNumNodes(buffer_); }
+
+void FlatAST::SetInt(int64_t val) {
+  SetRecordValue(0, PrimitiveValue::kIntVal, val, &buffer_);
+}
+
+void FlatAST::SetTimestamp(int64_t val) {
+  SetRecordValue(0, PrimitiveValue::kTimeVal, val, &buffer_);
+}
+
+FlatTaggedAST::FlatTaggedAST(const TaggedAST& tagged_ast)
+    : tag_(tagged_ast.tag()), has_ast_(tagged_ast.has_ast()) {
+  if (has_ast_) {
+    ast_ = FlatAST(tagged_ast.ast());
+  }
+}
+
+TaggedAST FlatTaggedAST::ToTaggedAST() const {
+  TaggedAST tagged_ast;
+  tagged_ast.set_tag(tag_);
+  if (has_ast_) {
+    *tagged_ast.mutable_ast() = ast_.ToAST();
+  }
+  return tagged_ast;
+}
+
+}  // namespace ast
+}  // namespace morphie
@@ -0,0 +1,167 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// An AST proto uses several heap objects per node of the syntax tree, so even
+// a label like tuple(timestamp, string) takes a handful of allocations. This
+// file defines a flat, read-only encoding of an AST that is stored in a single
+// contiguous buffer, and a flat encoding of a TaggedAST.
+//
+// The buffer of a FlatAST consists of
+//  - a header with the number of nodes,
+//  - an array of fixed size node records in preorder, in which boolean,
+//    integer and timestamp values are stored inline, and
+//  - a string pool with the names and string values of the nodes, which node
+//    records refer to by offset and size.
+// Each record stores the number of records in its subtree, so the arguments of
+// a composite node can be visited without decoding the nodes below them.
+//
+// The encoding is deterministic: two ASTs are ast::Equal exactly if their flat
+// encodings have the same buffer. FlatASTs can therefore be hashed and compared
+// as strings. Conversion to and from the AST proto is meant for the boundaries
+// of code that stores many labels, such as the LabeledGraph. The only change
+// that can be made to an encoded AST is to the inline value of an integer or
+// timestamp root, which is enough to maintain counters without decoding them.
+//
+// Example.
+//   AST ast = ...;  // The value tuple(timestamp(10), string("foo")).
+//   FlatAST flat(ast);
+//   FlatNode root = flat.Root();
+//   CHECK(root.IsTuple() && root.NumArgs() == 2, "");
+//   CHECK(root.Arg(1).GetString() == "foo", "");
+//   CHECK(ast::Equal(flat.ToAST(), ast), "");
+#ifndef LOGLE_FLAT_AST_H_
+#define LOGLE_FLAT_AST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "base/string.h"
+#include "ast.pb.h"
+#include "util/string_piece.h"
+
+namespace morphie {
+namespace ast {
+
+class FlatAST;
+
+// A read-only view of a node of a FlatAST. A FlatNode refers to the buffer of
+// the FlatAST and must not outlive it. The Is[TypeFamily] and Get[Type]
+// functions mirror the functions of the same name in graph/ast.h and
+// graph/value.h.
+class FlatNode {
+ public:
+  bool IsNull() const;
+  bool IsBool() const;
+  bool IsInt() const;
+  bool IsString() const;
+  bool IsTimestamp() const;
+  bool IsContainer() const;
+  bool IsInterval() const;
+  bool IsList() const;
+  bool IsSet() const;
+  bool IsTuple() const;
+
+  bool has_is_nullable() const;
+  bool is_nullable() const;
+  bool has_name() const;
+  util::StringPiece name() const;
+
+  // Returns true if the node is primitive and has a value.
+  bool HasValue() const;
+  // The Get[Type] functions require that the node is a primitive node with a
+  // value of the type in the function name.
+  bool GetBool() const;
+  int64_t GetInt() const;
+  util::StringPiece GetString() const;
+  int64_t GetTimestamp() const;
+
+  // Returns the number of arguments of a composite node and 0 for other nodes.
+  int NumArgs() const;
+  // Returns the argument 'i' of a composite node. Requires that 0 <= i <
+  // NumArgs(). Takes time linear in 'i'.
+  FlatNode Arg(int i) const;
+
+ private:
+  friend class FlatAST;
+
+  FlatNode(const FlatAST* ast, uint32_t index) : ast_(ast), index_(index) {}
+
+  const FlatAST* ast_;
+  uint32_t index_;
+};
+
+class FlatAST {
+ public:
+  // Constructs the encoding of the null AST.
+  FlatAST();
+  explicit FlatAST(const AST& ast);
+
+  // Returns the AST that was encoded.
+  AST ToAST() const;
+  FlatNode Root() const { return FlatNode(this, 0); }
+  // Returns the number of nodes of the AST.
+  int NumNodes() const;
+  // The Set[Type] functions replace the value of the root in the buffer. They
+  // require that the root is a primitive node with a value of the type in the
+  // function name.
+  void SetInt(int64_t val);
+  void SetTimestamp(int64_t val);
+  // Returns the buffer, which is equal for ASTs that are ast::Equal.
+  const string& buffer() const { return buffer_; }
+
+  friend bool operator==(const FlatAST& a, const FlatAST& b) {
+    return a.buffer_ == b.buffer_;
+  }
+  friend bool operator!=(const FlatAST& a, const FlatAST& b) {
+    return !(a == b);
+  }
+
+ private:
+  friend class FlatNode;
+
+  string buffer_;
+};
+
+// The hash function used by unordered containers with FlatAST keys.
+struct FlatASTHash {
+  size_t operator()(const FlatAST& ast) const {
+    return std::hash<string>()(ast.buffer());
+  }
+};
+
+// The flat encoding of a TaggedAST, which records whether the TaggedAST has an
+// AST field. The AST of a FlatTaggedAST without an AST field is the null AST,
+// as for TaggedAST::ast().
+class FlatTaggedAST {
+ public:
+  FlatTaggedAST() : has_ast_(false) {}
+  explicit FlatTaggedAST(const TaggedAST& tagged_ast);
+
+  TaggedAST ToTaggedAST() const;
+  const string& tag() const { return tag_; }
+  bool has_ast() const { return has_ast_; }
+  const FlatAST& ast() const { return ast_; }
+  FlatAST* mutable_ast() { return &ast_; }
+
+ private:
+  string tag_;
+  bool has_ast_;
+  FlatAST ast_;
+};
+
+}  // namespace ast
+}  // namespace morphie
+
+#endif  // LOGLE_FLAT_AST_H_
@@ -0,0 +1,132 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/flat_ast.h"
+
+#include <vector>
+
+#include "graph/ast.h"
+#include "graph/value.h"
+#include "gtest.h"
+
+namespace morphie {
+namespace ast {
+namespace {
+
+// Returns the value tuple(list(int(1), int(2)), timestamp(10), string(val)),
+// in which the tuple and the string are named.
+AST GetTuple(const string& val) {
+  AST tuple;
+  tuple.set_name("event");
+  tuple.mutable_c_ast()->set_op(Operator::TUPLE);
+  AST* list = tuple.mutable_c_ast()->add_arg();
+  list->mutable_c_ast()->set_op(Operator::LIST);
+  *list->mutable_c_ast()->add_arg() = value::MakeInt(1);
+  *list->mutable_c_ast()->add_arg() = value::MakeInt(2);
+  *tuple.mutable_c_ast()->add_arg() = value::MakeTimestampFromUnixMicros(10);
+  AST* str = tuple.mutable_c_ast()->add_arg();
+  *str = value::MakeString(val);
+  str->set_name("file");
+  str->set_is_nullable(true);
+  return tuple;
+}
+
+TEST(FlatASTTest, RoundTrips) {
+  AST tuple = GetTuple("foo");
+  for (const AST& ast :
+       {AST(), value::MakeNull(), value::MakeBool(true), value::MakeString(""),
+        value::MakeIntInterval(1, 5), tuple}) {
+    FlatAST flat(ast);
+    EXPECT_TRUE(Equal(ast, flat.ToAST()));
+  }
+  EXPECT_EQ(6, FlatAST(tuple).NumNodes());
+  EXPECT_EQ(FlatAST(), FlatAST(AST()));
+}
+
+// The accessors of a FlatNode agree with those of the AST and Arg() skips the
+// subtrees of earlier arguments.
+TEST(FlatASTTest, AccessesNodes) {
+  FlatAST flat(GetTuple("foo"));
+  FlatNode root = flat.Root();
+  EXPECT_TRUE(root.IsTuple());
+  EXPECT_TRUE(root.IsContainer());
+  EXPECT_FALSE(root.HasValue());
+  EXPECT_EQ("event", root.name().ToString());
+  ASSERT_EQ(3, root.NumArgs());
+  FlatNode list = root.Arg(0);
+  EXPECT_TRUE(list.IsList());
+  ASSERT_EQ(2, list.NumArgs());
+  EXPECT_EQ(2, list.Arg(1).GetInt());
+  EXPECT_TRUE(root.Arg(1).IsTimestamp());
+  EXPECT_EQ(10, root.Arg(1).GetTimestamp());
+  FlatNode str = root.Arg(2);
+  EXPECT_TRUE(str.IsString());
+  EXPECT_EQ("foo", str.GetString().ToString());
+  EXPECT_EQ("file", str.name().ToString());
+  EXPECT_TRUE(str.has_is_nullable());
+  EXPECT_TRUE(str.is_nullable());
+  EXPECT_FALSE(list.has_name());
+  EXPECT_EQ(0, str.NumArgs());
+  EXPECT_TRUE(FlatAST().Root().IsNull());
+}
+
+// Changing the value of a root gives the encoding of the changed AST.
+TEST(FlatASTTest, SetsRootValues) {
+  FlatAST flat(value::MakeInt(1));
+  flat.SetInt(int64_t{1} << 40);
+  AST ast = value::MakeInt(0);
+  ast.mutable_p_ast()->mutable_val()->set_int_val(int64_t{1} << 40);
+  EXPECT_EQ(FlatAST(ast), flat);
+  EXPECT_EQ(int64_t{1} << 40, flat.Root().GetInt());
+  FlatAST timestamp(value::MakeTimestampFromUnixMicros(10));
+  timestamp.SetTimestamp(20);
+  EXPECT_EQ(FlatAST(value::MakeTimestampFromUnixMicros(20)), timestamp);
+}
+
+// Two flat ASTs are equal exactly if the ASTs they encode are equal.
+TEST(FlatASTTest, EqualityAgreesWithASTs) {
+  AST named = value::MakeInt(1);
+  named.set_name("one");
+  AST nullable = value::MakeInt(1);
+  nullable.set_is_nullable(false);
+  std::vector<AST> asts = {AST(),           value::MakeInt(1), named,
+                           nullable,        value::MakeInt(2), GetTuple("foo"),
+                           GetTuple("bar"), GetTuple("foo")};
+  for (const AST& ast1 : asts) {
+    for (const AST& ast2 : asts) {
+      EXPECT_EQ(Equal(ast1, ast2), FlatAST(ast1) == FlatAST(ast2));
+    }
+  }
+}
+
+TEST(FlatASTTest, EncodesTaggedASTs) {
+  TaggedAST tagged_ast;
+  tagged_ast.set_tag("File");
+  FlatTaggedAST without_ast(tagged_ast);
+  EXPECT_EQ("File", without_ast.tag());
+  EXPECT_FALSE(without_ast.has_ast());
+  EXPECT_EQ(FlatAST(), without_ast.ast());
+  EXPECT_FALSE(without_ast.ToTaggedAST().has_ast());
+
+  *tagged_ast.mutable_ast() = GetTuple("foo");
+  FlatTaggedAST with_ast(tagged_ast);
+  EXPECT_TRUE(with_ast.has_ast());
+  TaggedAST decoded = with_ast.ToTaggedAST();
+  EXPECT_EQ("File", decoded.tag());
+  EXPECT_TRUE(Equal(tagged_ast.ast(), decoded.ast()));
+}
+
+}  // namespace
+}  // namespace ast
+}  // namespace morphie
@@ -14,31 +14,51 @@
 
 #include "graph/graph_exporter.h"
 
-#include <unordered_map>
+#include <algorithm>
 
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "graph/ast.h"
+#include "util/parallel.h"
 #include "util/string_utils.h"
 
 namespace morphie {
 namespace viz {
 
+namespace pb = ::google::protobuf;
+
 GraphExporter::GraphExporter(const LabeledGraph& graph)
-    : graph_(graph), node_label_(TextLabel) {}
+    : graph_(graph), node_label_(TextLabel), is_text_label_(true) {}
 
 GraphExporter::GraphExporter(const LabeledGraph& graph,
                              const LabelFn& node_label)
-    : graph_(graph), node_label_(node_label) {}
+    : graph_(graph), node_label_(node_label), is_text_label_(false) {}
+
+GraphExporter::GraphExporter(const LabeledGraph& graph,
+                             const LabelFn& node_label,
+                             const EdgeAttributeFn& edge_attributes)
+    : graph_(graph),
+      node_label_(node_label),
+      is_text_label_(false),
+      edge_attributes_(edge_attributes) {}
 
 // Returns a serialization of 'ast' with '/' as a separator and no bounding
 // delimiters. The serialization is prefixed by "tag/".
 string GraphExporter::TextLabel(const string& tag, const AST& ast) {
-  string label = tag;
-  label += "/";
-  label += ast::ToString(
-      ast, ast::PrintConfig("", "", "/", ast::PrintOption::kValue));
+  string label;
+  AppendTextLabel(tag, ast, &label);
   return label;
 }
 
+void GraphExporter::AppendTextLabel(const string& tag, const AST& ast,
+                                    string* out) {
+  out->append(tag);
+  out->push_back('/');
+  ast::AppendToString(
+      ast, ast::PrintConfig("", "", "/", ast::PrintOption::kValue), out);
+}
+
 string GraphExporter::HTMLLabel(const string& tag, const AST& ast) {
   ast::PrintConfig config;
   if (tag == "Event") {
@@ -50,68 +70,204 @@ string GraphExporter::HTMLLabel(const string& tag, const AST& ast) {
   return ast::ToString(ast, config);
 }
 
-ge::GraphDef GraphExporter::Graph() {
+void GraphExporter::TextEdgeAttributes(const string& tag, const AST& ast,
+                                       Attributes* attributes) {
+  (*attributes)["label"] = TextLabel(tag, ast);
+}
+
+ge::GraphDef GraphExporter::Graph() { return Graph(1); }
+
+// The names are computed before the nodes because the node for a node id
+// refers to the names of its predecessors.
+ge::GraphDef GraphExporter::Graph(int num_threads) {
+  ComputeNames(num_threads);
+  const size_t num_nodes = name_ends_.size();
   ge::GraphDef vis_graph;
-  for (auto node_it = graph_.NodeSetBegin(); node_it != graph_.NodeSetEnd();
-       ++node_it) {
-    ge::Node* vis_node = vis_graph.add_node();
-    *vis_node = Node(*node_it);
+  vis_graph.mutable_node()->Reserve(num_nodes);
+  if (num_threads <= 1) {
+    for (NodeId node_id = 0; node_id < num_nodes; ++node_id) {
+      *vis_graph.add_node() = Node(node_id);
+    }
+    return vis_graph;
+  }
+  std::vector<ge::Node> vis_nodes(num_nodes);
+  util::ParallelForChunks(
+      num_nodes, num_threads, [this, &vis_nodes](int, size_t begin, size_t end) {
+        for (NodeId node_id = begin; node_id < end; ++node_id) {
+          vis_nodes[node_id] = Node(node_id);
+        }
+      });
+  for (ge::Node& vis_node : vis_nodes) {
+    vis_graph.add_node()->Swap(&vis_node);
   }
   return vis_graph;
 }
 
 string GraphExporter::GraphAsString() { return Graph().DebugString(); }
 
-string GraphExporter::NodeName(NodeId node_id, const string& tag,
-                               const AST& ast) {
-  string label = TextLabel(tag, ast);
-  label += "/";
-  label += std::to_string(node_id);
-  return label;
+bool GraphExporter::WriteGraph(std::ostream* out) { return WriteGraph(1, out); }
+
+bool GraphExporter::WriteDelimitedNodes(std::ostream* out) {
+  return WriteDelimitedNodes(1, out);
 }
 
-string GraphExporter::FindOrAddName(NodeId node_id) {
-  auto node_name_it = node_name_.find(node_id);
-  if (node_name_it != node_name_.end()) {
-    return node_name_it->second;
-  } else {
-    TaggedAST node_label = graph_.GetNodeLabel(node_id);
-    string label = NodeName(node_id, node_label.tag(), node_label.ast());
-    node_name_.emplace(node_id, label);
-    return label;
+// A serialized GraphDef is the concatenation of its nodes, each of which is
+// encoded as the length-delimited field 1.
+bool GraphExporter::WriteGraph(int num_threads, std::ostream* out) {
+  return WriteNodes(pb::internal::WireFormatLite::MakeTag(
+                        ge::GraphDef::kNodeFieldNumber,
+                        pb::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED),
+                    num_threads, out);
+}
+
+bool GraphExporter::WriteDelimitedNodes(int num_threads, std::ostream* out) {
+  return WriteNodes(0, num_threads, out);
+}
+
+void GraphExporter::AppendNodeName(NodeId node_id, const string& tag,
+                                   const AST& ast, string* out) {
+  AppendTextLabel(tag, ast, out);
+  out->push_back('/');
+  out->append(std::to_string(node_id));
+}
+
+util::StringPiece GraphExporter::Name(NodeId node_id) const {
+  const size_t begin = node_id == 0 ? 0 : name_ends_[node_id - 1];
+  return util::StringPiece(names_.data() + begin, name_ends_[node_id] - begin);
+}
+
+// Each chunk of node ids appends its names to its own buffer, with the ends of
+// the names relative to that buffer. The buffers of consecutive chunks are
+// then concatenated and the ends shifted by the size of the preceding buffers.
+void GraphExporter::ComputeNames(int num_threads) {
+  const size_t num_nodes = graph_.NumNodes();
+  if (name_ends_.size() == num_nodes) {
+    return;
+  }
+  const size_t num_chunks = num_threads > 1 ? num_threads : 1;
+  std::vector<string> chunk_names(num_chunks);
+  std::vector<size_t> chunk_ends(num_chunks, 0);
+  name_ends_.resize(num_nodes);
+  util::ParallelForChunks(
+      num_nodes, num_threads,
+      [this, &chunk_names, &chunk_ends](int chunk, size_t begin, size_t end) {
+        string* names = &chunk_names[chunk];
+        for (NodeId node_id = begin; node_id < end; ++node_id) {
+          const TaggedAST& node_label = graph_.GetNodeLabel(node_id);
+          AppendNodeName(node_id, node_label.tag(), node_label.ast(), names);
+          name_ends_[node_id] = names->size();
+        }
+        chunk_ends[chunk] = end;
+      });
+  names_.clear();
+  size_t node_id = 0;
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    const size_t offset = names_.size();
+    for (; node_id < chunk_ends[chunk]; ++node_id) {
+      name_ends_[node_id] += offset;
+    }
+    if (chunk == 0) {
+      names_.swap(chunk_names[0]);
+    } else {
+      names_ += chunk_names[chunk];
+    }
   }
 }
 
-ge::Node GraphExporter::Node(NodeId node_id) {
+ge::Node GraphExporter::Node(NodeId node_id) const {
   ge::Node vis_node;
   if (!graph_.HasNode(node_id)) {
     return vis_node;
   }
   // The node name is an identifier for the node.
-  string node_name = FindOrAddName(node_id);
-  vis_node.set_name(node_name);
+  const util::StringPiece node_name = Name(node_id);
+  vis_node.set_name(node_name.data(), node_name.size());
   // The label is the string displayed on the node.
-  TaggedAST label_ast = graph_.GetNodeLabel(node_id);
-  string label_str = node_label_(label_ast.tag(), label_ast.ast());
-  // vis_node.set_label(HTMLLabel(node_label.tag(), node_label.ast()));
-  // Set node attributes.
   auto& node_attr = *vis_node.mutable_node_attr();
-  node_attr["label"] = label_str;
+  if (is_text_label_) {
+    const string& name = vis_node.name();
+    node_attr["label"] = name.substr(0, name.rfind('/'));
+  } else {
+    const TaggedAST& label_ast = graph_.GetNodeLabel(node_id);
+    node_attr["label"] = node_label_(label_ast.tag(), label_ast.ast());
+  }
   // The value of this field can be used to automatically color a metanode by
   // the frequency of types of nodes within the metanode.
   node_attr["op"] = "op";
-  std::set<NodeId> in_nodes = graph_.GetPredecessors(node_id);
-  string in_node_name;
-  for (auto in_node : in_nodes) {
-    in_node_name = FindOrAddName(in_node);
-    TaggedAST in_node_label = graph_.GetNodeLabel(in_node);
-    string in_node_name =
-        NodeName(in_node, in_node_label.tag(), in_node_label.ast());
-    ge::Edge* edge = vis_node.add_edge();
-    edge->set_input(in_node_name);
+  auto in_edge_begin = graph_.InEdgeBegin(node_id);
+  auto in_edge_end = graph_.InEdgeEnd(node_id);
+  if (edge_attributes_) {
+    for (auto in_edge_it = in_edge_begin; in_edge_it != in_edge_end;
+         ++in_edge_it) {
+      ge::Edge* edge = vis_node.add_edge();
+      const util::StringPiece input = Name(graph_.Source(*in_edge_it));
+      edge->set_input(input.data(), input.size());
+      const TaggedAST& edge_label = graph_.GetEdgeLabel(*in_edge_it);
+      edge_attributes_(edge_label.tag(), edge_label.ast(),
+                       edge->mutable_edge_attr());
+    }
+    return vis_node;
+  }
+  // Without edge attributes, there is one input for each predecessor, in the
+  // order of node identifiers.
+  std::vector<NodeId> in_nodes;
+  for (auto in_edge_it = in_edge_begin; in_edge_it != in_edge_end;
+       ++in_edge_it) {
+    in_nodes.push_back(graph_.Source(*in_edge_it));
+  }
+  std::sort(in_nodes.begin(), in_nodes.end());
+  in_nodes.erase(std::unique(in_nodes.begin(), in_nodes.end()), in_nodes.end());
+  for (NodeId in_node : in_nodes) {
+    const util::StringPiece input = Name(in_node);
+    vis_node.add_edge()->set_input(input.data(), input.size());
   }
   return vis_node;
 }
 
+// The streams below buffer their output and write it to the next stream when
+// they are destroyed, so 'out' is only checked after both have gone out of
+// scope.
+bool GraphExporter::WriteNodes(uint32_t tag, int num_threads,
+                               std::ostream* out) {
+  ComputeNames(num_threads);
+  if (num_threads > 1) {
+    std::vector<string> buffers(num_threads);
+    util::ParallelForChunks(
+        name_ends_.size(), num_threads,
+        [this, tag, &buffers](int chunk, size_t begin, size_t end) {
+          pb::io::StringOutputStream raw_output(&buffers[chunk]);
+          pb::io::CodedOutputStream output(&raw_output);
+          for (NodeId node_id = begin; node_id < end; ++node_id) {
+            WriteNode(tag, node_id, &output);
+          }
+        });
+    for (const string& buffer : buffers) {
+      out->write(buffer.data(), buffer.size());
+    }
+    return !out->fail();
+  }
+  bool has_error = false;
+  {
+    pb::io::OstreamOutputStream raw_output(out);
+    pb::io::CodedOutputStream output(&raw_output);
+    for (auto node_it = graph_.NodeSetBegin();
+         node_it != graph_.NodeSetEnd() && !has_error; ++node_it) {
+      WriteNode(tag, *node_it, &output);
+      has_error = output.HadError();
+    }
+  }
+  return !has_error && !out->fail();
+}
+
+void GraphExporter::WriteNode(uint32_t tag, NodeId node_id,
+                              pb::io::CodedOutputStream* output) const {
+  const ge::Node vis_node = Node(node_id);
+  if (tag != 0) {
+    output->WriteTag(tag);
+  }
+  output->WriteVarint64(vis_node.ByteSizeLong());
+  vis_node.SerializeWithCachedSizes(output);
+}
+
 }  // namespace viz
 }  // namespace morphie
@@ -18,12 +18,18 @@
 #ifndef LOGLE_GRAPH_EXPORTER_H_
 #define LOGLE_GRAPH_EXPORTER_H_
 
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <vector>
 
 #include "base/string.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/map.h"
 #include "graph/labeled_graph.h"
 #include "ast.pb.h"
 #include "graph_explorer.pb.h"
+#include "util/string_piece.h"
 
 namespace morphie {
 
@@ -41,13 +47,27 @@ namespace ge = ::graph_explorer;
 // and returns a TensorFlow label. See ast.proto for more on ASTs.
 using LabelFn = std::function<string(const string&, const AST&)>;
 
-// The GraphExporter class below uses an internal map from LabeledGraph node ids
-// to GraphDef node identifiers. A separate GraphExporter object has to be
-// created for each graph that is to be exported.
+// The attributes of a GraphDef node or edge, such as "label" and "color".
+using Attributes = ::google::protobuf::Map<string, string>;
+
+// An edge attribute function takes the tag and the AST that label a graph edge
+// and sets the attributes of the GraphDef edge that represents it.
+using EdgeAttributeFn =
+    std::function<void(const string&, const AST&, Attributes*)>;
+
+// The GraphExporter class below computes the GraphDef node identifiers of all
+// nodes of a LabeledGraph once, when the graph is first exported. A separate
+// GraphExporter object has to be created for each graph that is to be
+// exported, and the graph must not be modified while it is exported.
+//
+// By default, a GraphDef node has one input for each predecessor of the node,
+// and the edges have no attributes. If an edge attribute function is provided,
+// there is one input for each edge into the node, in the order in which the
+// edges were added, with the attributes generated by the function.
 class GraphExporter {
  public:
   // This constructor sets the default node label function, which is
-  // GraphExporter::NodeLabel.
+  // GraphExporter::TextLabel.
   GraphExporter(const LabeledGraph& graph);
 
   // This constructor uses the 'node_label' argument to customize the generation
@@ -56,35 +76,84 @@ class GraphExporter {
   // class-level comment.
   GraphExporter(const LabeledGraph& graph, const LabelFn& node_label);
 
+  // This constructor also uses 'edge_attributes' to generate the attributes of
+  // edges.
+  GraphExporter(const LabeledGraph& graph, const LabelFn& node_label,
+                const EdgeAttributeFn& edge_attributes);
+
   // Returns the tag and contents of the AST as a slash-delimited string.
   static string TextLabel(const string& tag, const AST& ast);
+  // Appends the TextLabel of the tag and the AST to '*out'.
+  static void AppendTextLabel(const string& tag, const AST& ast, string* out);
   // Returns the AST as an HTML string. Primary AST values are treated as plain
   // strings and composite values are represented as a table.
   static string HTMLLabel(const string& tag, const AST& ast);
+  // Sets the "label" attribute to the TextLabel of the tag and the AST.
+  static void TextEdgeAttributes(const string& tag, const AST& ast,
+                                 Attributes* attributes);
 
   // Returns the TensorFlow graph for the internally stored LabeledGraph.
   ge::GraphDef Graph();
+  // Returns the same graph as Graph(), with the names and the nodes computed on
+  // 'num_threads' threads, each of which handles a range of node ids. The label
+  // functions must be safe to call concurrently.
+  ge::GraphDef Graph(int num_threads);
 
   // Returns a human-readable serialization of the GraphDef proto above.
   string GraphAsString();
 
+  // The functions below write the graph to 'out' in the binary wire format,
+  // one node at a time, so that the GraphDef is never held in memory. They
+  // return false if writing to 'out' fails.
+  //
+  // Writes a serialized GraphDef equal to the one returned by Graph().
+  bool WriteGraph(std::ostream* out);
+  // Writes each node of the graph as a message preceded by its size in bytes as
+  // a varint. This is the format read by, for example, parseDelimitedFrom in
+  // the Java protobuf API.
+  bool WriteDelimitedNodes(std::ostream* out);
+  // The functions below write the same output as those above, with the names
+  // and the serialized nodes computed on 'num_threads' threads, each of which
+  // handles a range of node ids. Each thread serializes its nodes into a buffer
+  // of its own, so the output is held in memory until all threads are done.
+  // The label functions must be safe to call concurrently.
+  bool WriteGraph(int num_threads, std::ostream* out);
+  bool WriteDelimitedNodes(int num_threads, std::ostream* out);
+
  private:
-  // Returns the node label as a text string followed by the node identifier
-  // from the internal representation of the graph.
-  string NodeName(NodeId node_id, const string& tag, const AST& ast);
-  // Returns the label string for 'node_id' in 'graph'. Returns a cached string
-  // if this label has been computed previously and generates a new label
-  // otherwise.
-  string FindOrAddName(NodeId node_id);
+  // Appends the node label as a text string followed by the node identifier
+  // from the internal representation of the graph to '*out'.
+  static void AppendNodeName(NodeId node_id, const string& tag, const AST& ast,
+                             string* out);
+  // Returns the name of 'node_id'. Requires that the names have been computed.
+  util::StringPiece Name(NodeId node_id) const;
+  // Computes the names of all nodes on 'num_threads' threads, if they have not
+  // been computed yet.
+  void ComputeNames(int num_threads);
   // Returns a representation of 'node_id' and its predecessors for
-  // visualization.
-  ge::Node Node(NodeId node_id);
+  // visualization. Requires that the names have been computed.
+  ge::Node Node(NodeId node_id) const;
+  // Writes the nodes of the graph to 'out' on 'num_threads' threads, each
+  // preceded by 'tag' if 'tag' is not zero and by the size of the node.
+  bool WriteNodes(uint32_t tag, int num_threads, std::ostream* out);
+  // Writes 'node_id' to 'output' as WriteNodes does. Requires that the names
+  // have been computed.
+  void WriteNode(uint32_t tag, NodeId node_id,
+                 ::google::protobuf::io::CodedOutputStream* output) const;
 
   const LabeledGraph& graph_;
   // The function used to generate node labels.
   LabelFn node_label_;
-  // The map from LabeledGraph node identifiers to TensorFlow NodeDef names.
-  unordered_map<NodeId, string> node_name_;
+  // True if 'node_label_' is TextLabel, in which case a node label is a prefix
+  // of the name of the node and is not computed again.
+  bool is_text_label_;
+  // The function used to generate edge attributes, if any.
+  EdgeAttributeFn edge_attributes_;
+  // The GraphDef node identifiers, stored one after another in a single
+  // buffer. The name of a node ends at the offset in 'name_ends_' indexed by
+  // its LabeledGraph node identifier, and starts where the previous name ends.
+  string names_;
+  std::vector<size_t> name_ends_;
 };  // class GraphExporter
 
 }  // namespace viz
@@ -0,0 +1,135 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/graph_exporter.h"
+
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "graph/test_graphs.h"
+#include "gtest.h"
+
+namespace morphie {
+namespace viz {
+namespace {
+
+namespace pb = ::google::protobuf;
+
+// Initializes 'graph' with a few nodes and edges between them.
+void MakeGraph(test::WeightedGraph* graph) {
+  ASSERT_TRUE(graph->Initialize().ok());
+  const int kNumNodes = 50;
+  for (int i = 0; i < kNumNodes; ++i) {
+    graph->AddNode(i % 7);
+  }
+  for (int i = 0; i < kNumNodes; ++i) {
+    graph->AddEdge(i, (i * 3) % kNumNodes, 1);
+    graph->AddEdge((i + 1) % kNumNodes, i, 2);
+  }
+}
+
+// The parallel export produces the same graph as the serial export. The graphs
+// are compared as text because the serialization of maps is not ordered.
+TEST(GraphExporterTest, ParallelMatchesSerial) {
+  test::WeightedGraph graph;
+  MakeGraph(&graph);
+  const string serial_graph =
+      GraphExporter(*graph.GetGraph()).Graph().DebugString();
+  for (int num_threads : {1, 2, 3, 64}) {
+    GraphExporter exporter(*graph.GetGraph());
+    EXPECT_EQ(serial_graph, exporter.Graph(num_threads).DebugString())
+        << "Threads: " << num_threads;
+  }
+}
+
+TEST(GraphExporterTest, WritesBinaryGraph) {
+  test::WeightedGraph graph;
+  MakeGraph(&graph);
+  const ge::GraphDef expected = GraphExporter(*graph.GetGraph()).Graph();
+  for (int num_threads : {1, 2, 3, 64}) {
+    std::ostringstream out;
+    EXPECT_TRUE(GraphExporter(*graph.GetGraph()).WriteGraph(num_threads, &out));
+    ge::GraphDef actual;
+    ASSERT_TRUE(actual.ParseFromString(out.str()));
+    EXPECT_EQ(expected.DebugString(), actual.DebugString())
+        << "Threads: " << num_threads;
+  }
+}
+
+TEST(GraphExporterTest, WritesDelimitedNodes) {
+  test::WeightedGraph graph;
+  MakeGraph(&graph);
+  const ge::GraphDef expected = GraphExporter(*graph.GetGraph()).Graph();
+  for (int num_threads : {1, 2, 3, 64}) {
+    std::ostringstream out;
+    EXPECT_TRUE(GraphExporter(*graph.GetGraph())
+                    .WriteDelimitedNodes(num_threads, &out));
+    const string data = out.str();
+    pb::io::ArrayInputStream raw_input(data.data(), data.size());
+    pb::io::CodedInputStream input(&raw_input);
+    ge::GraphDef actual;
+    uint32_t size;
+    while (input.ReadVarint32(&size)) {
+      pb::io::CodedInputStream::Limit limit = input.PushLimit(size);
+      ASSERT_TRUE(actual.add_node()->ParseFromCodedStream(&input));
+      input.PopLimit(limit);
+    }
+    EXPECT_EQ(expected.DebugString(), actual.DebugString())
+        << "Threads: " << num_threads;
+  }
+}
+
+// By default, parallel edges are represented by a single input. With edge
+// attributes, every edge is an input with its own attributes.
+TEST(GraphExporterTest, ExportsEdges) {
+  test::WeightedGraph graph;
+  ASSERT_TRUE(graph.Initialize().ok());
+  NodeId node0 = graph.AddNode(0);
+  NodeId node1 = graph.AddNode(1);
+  graph.AddEdge(node1, node0, 3);
+  graph.AddEdge(node0, node0, 4);
+  graph.AddEdge(node1, node0, 5);
+
+  ge::GraphDef vis_graph = GraphExporter(*graph.GetGraph()).Graph();
+  ASSERT_EQ(2, vis_graph.node_size());
+  const ge::Node& vis_node = vis_graph.node(0);
+  EXPECT_EQ("Node-Weight/0/0", vis_node.name());
+  EXPECT_EQ("Node-Weight/0", vis_node.node_attr().at("label"));
+  ASSERT_EQ(2, vis_node.edge_size());
+  EXPECT_EQ("Node-Weight/0/0", vis_node.edge(0).input());
+  EXPECT_EQ("Node-Weight/1/1", vis_node.edge(1).input());
+  EXPECT_EQ(0, vis_node.edge(0).edge_attr_size());
+
+  GraphExporter exporter(*graph.GetGraph(), GraphExporter::TextLabel,
+                         GraphExporter::TextEdgeAttributes);
+  vis_graph = exporter.Graph();
+  ASSERT_EQ(3, vis_graph.node(0).edge_size());
+  const std::vector<std::pair<string, string>> expected_edges = {
+      {"Node-Weight/1/1", "Edge-Weight/3"},
+      {"Node-Weight/0/0", "Edge-Weight/4"},
+      {"Node-Weight/1/1", "Edge-Weight/5"}};
+  for (int i = 0; i < 3; ++i) {
+    const ge::Edge& edge = vis_graph.node(0).edge(i);
+    EXPECT_EQ(expected_edges[i].first, edge.input());
+    EXPECT_EQ(expected_edges[i].second, edge.edge_attr().at("label"));
+  }
+  EXPECT_EQ(0, vis_graph.node(1).edge_size());
+}
+
+}  // namespace
+}  // namespace viz
+}  // namespace morphie
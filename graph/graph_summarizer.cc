@@ -0,0 +1,336 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/graph_summarizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "graph/graph_analyzer.h"
+#include "graph/graph_transformer.h"
+#include "graph/morphism.h"
+#include "graph/type.h"
+#include "graph/value.h"
+#include "util/logging.h"
+#include "util/status.h"
+#include "util/string_utils.h"
+
+namespace morphie {
+namespace graph {
+
+const char kSummaryTagSuffix[] = "Summary";
+
+namespace {
+
+namespace type = ast::type;
+namespace value = ast::value;
+
+const char kElidedField[] = "Elided";
+const char kGraphTypeErr[] = "Could not create a graph of the summary type.";
+const char kSummaryTypeErr[] = "The graph already has a summary type: ";
+
+// A summary is a graph together with the number of nodes of the input graph
+// that each of its nodes stands for, indexed by node identifier.
+struct Summary {
+  std::unique_ptr<LabeledGraph> graph;
+  std::vector<int64_t> sizes;
+};
+
+// Returns the member of a block whose label is the label of the block.
+using RepresentativeFn = std::function<NodeId(const std::set<NodeId>&)>;
+
+NodeId SmallestMember(const std::set<NodeId>& members) {
+  return *members.begin();
+}
+
+// Returns the number of edges into and out of 'node_id'.
+size_t Degree(const LabeledGraph& graph, NodeId node_id) {
+  return std::distance(graph.InEdgeBegin(node_id), graph.InEdgeEnd(node_id)) +
+         std::distance(graph.OutEdgeBegin(node_id), graph.OutEdgeEnd(node_id));
+}
+
+std::vector<size_t> Degrees(const LabeledGraph& graph) {
+  std::vector<size_t> degrees(graph.NumNodes());
+  NodeIterator end_it = graph.NodeSetEnd();
+  for (NodeIterator node_it = graph.NodeSetBegin(); node_it != end_it;
+       ++node_it) {
+    degrees[*node_it] = Degree(graph, *node_it);
+  }
+  return degrees;
+}
+
+// Returns one label for each tag of the labels of 'edges', which is the label
+// of the first edge with that tag. Edges between two blocks of a summary are
+// thus merged unless they have different tags.
+std::vector<TaggedAST> FirstLabelPerTag(const LabeledGraph& graph,
+                                        const std::set<EdgeId>& edges) {
+  std::map<string, TaggedAST> tag_labels;
+  for (EdgeId edge_id : edges) {
+    TaggedAST label = graph.GetEdgeLabel(edge_id);
+    if (tag_labels.find(label.tag()) == tag_labels.end()) {
+      tag_labels.emplace(label.tag(), std::move(label));
+    }
+  }
+  std::vector<TaggedAST> labels;
+  for (auto& tag_label : tag_labels) {
+    labels.push_back(std::move(tag_label.second));
+  }
+  return labels;
+}
+
+// Returns the quotient of 'graph' with respect to 'partition', in which each
+// block is labeled with the label of its representative. The size of a block
+// is the total size of its members, given by 'sizes'.
+Summary Merge(const LabeledGraph& graph, const std::vector<int64_t>& sizes,
+              const std::map<NodeId, int>& partition,
+              const RepresentativeFn& representative) {
+  QuotientConfig config(
+      graph,
+      [&representative](const LabeledGraph& input,
+                        const std::set<NodeId>& members) {
+        return input.GetNodeLabel(representative(members));
+      },
+      FirstLabelPerTag, false /* No self-edges. */);
+  std::map<NodeId, NodeId> node_map;
+  Summary summary;
+  summary.graph = QuotientGraph(graph, partition, config, &node_map);
+  CHECK(summary.graph != nullptr, kGraphTypeErr);
+  summary.sizes.assign(summary.graph->NumNodes(), 0);
+  for (const auto& node_block : node_map) {
+    summary.sizes[node_block.second] += sizes[node_block.first];
+  }
+  return summary;
+}
+
+// Returns the coarsest partition of the nodes of 'graph' into blocks of nodes
+// with the same tag that is stable with respect to the edges.
+std::map<NodeId, int> BisimulationPartition(const LabeledGraph& graph) {
+  std::map<string, int> tag_blocks;
+  std::map<NodeId, int> partition;
+  NodeIterator end_it = graph.NodeSetEnd();
+  for (NodeIterator node_it = graph.NodeSetBegin(); node_it != end_it;
+       ++node_it) {
+    const int num_blocks = tag_blocks.size();
+    auto block_it =
+        tag_blocks.emplace(graph.GetNodeLabel(*node_it).tag(), num_blocks)
+            .first;
+    partition.emplace(*node_it, block_it->second);
+  }
+  // The blocks are renumbered in the order of their smallest members, so that
+  // the nodes of the quotient are in the same order as the nodes they stand
+  // for.
+  std::map<int, int> block_numbers;
+  for (const auto& node_block :
+       graph_analyzer::RefinePartition(graph, partition)) {
+    const int num_blocks = block_numbers.size();
+    partition[node_block.first] =
+        block_numbers.emplace(node_block.second, num_blocks).first->second;
+  }
+  return partition;
+}
+
+// Keeps the 'max_nodes' nodes of the summary of highest degree, with ties
+// broken in favor of larger nodes and then of smaller identifiers. The other
+// nodes are merged into an adjacent kept node or removed.
+void SparsifyNodes(size_t max_nodes, Summary* summary) {
+  const LabeledGraph& graph = *summary->graph;
+  const size_t num_nodes = graph.NumNodes();
+  if (max_nodes == 0 || num_nodes <= max_nodes) {
+    return;
+  }
+  const std::vector<size_t> degrees = Degrees(graph);
+  const std::vector<int64_t>& sizes = summary->sizes;
+  std::vector<NodeId> nodes(graph.NodeSetBegin(), graph.NodeSetEnd());
+  std::sort(nodes.begin(), nodes.end(),
+            [&degrees, &sizes](NodeId node1, NodeId node2) {
+              if (degrees[node1] != degrees[node2]) {
+                return degrees[node1] > degrees[node2];
+              }
+              if (sizes[node1] != sizes[node2]) {
+                return sizes[node1] > sizes[node2];
+              }
+              return node1 < node2;
+            });
+  std::vector<bool> is_kept(num_nodes, false);
+  for (size_t i = 0; i < max_nodes; ++i) {
+    is_kept[nodes[i]] = true;
+  }
+  // A block of the partition is identified by the kept node in it.
+  std::map<NodeId, NodeId> blocks;
+  std::set<NodeId> removed;
+  for (NodeId node_id : nodes) {
+    if (is_kept[node_id]) {
+      blocks.emplace(node_id, node_id);
+      continue;
+    }
+    bool has_block = false;
+    NodeId block = node_id;
+    auto consider = [&degrees, &is_kept, &has_block, &block](NodeId neighbor) {
+      if (is_kept[neighbor] &&
+          (!has_block || degrees[neighbor] > degrees[block] ||
+           (degrees[neighbor] == degrees[block] && neighbor < block))) {
+        has_block = true;
+        block = neighbor;
+      }
+    };
+    InEdgeIterator in_end = graph.InEdgeEnd(node_id);
+    for (InEdgeIterator edge_it = graph.InEdgeBegin(node_id); edge_it != in_end;
+         ++edge_it) {
+      consider(graph.Source(*edge_it));
+    }
+    OutEdgeIterator out_end = graph.OutEdgeEnd(node_id);
+    for (OutEdgeIterator edge_it = graph.OutEdgeBegin(node_id);
+         edge_it != out_end; ++edge_it) {
+      consider(graph.Target(*edge_it));
+    }
+    if (has_block) {
+      blocks.emplace(node_id, block);
+    } else {
+      removed.insert(node_id);
+    }
+  }
+  std::unique_ptr<Morphism> morphism = DeleteNodes(graph, removed);
+  CHECK(morphism->HasOutputGraph(), kGraphTypeErr);
+  const std::unordered_map<NodeId, NodeId>& node_map = morphism->NodeMap();
+  std::vector<int64_t> remaining_sizes(morphism->Output().NumNodes());
+  std::map<NodeId, int> partition;
+  for (const auto& node_block : blocks) {
+    const NodeId node_id = node_map.at(node_block.first);
+    remaining_sizes[node_id] = sizes[node_block.first];
+    partition.emplace(node_id, node_map.at(node_block.second));
+  }
+  *summary = Merge(morphism->Output(), remaining_sizes, partition,
+                   [&partition](const std::set<NodeId>& members) {
+                     return partition.at(*members.begin());
+                   });
+}
+
+// Keeps the 'max_edges' edges of the summary whose endpoints have the highest
+// total degree, with ties broken in favor of edges that come first in the
+// edge set.
+void SparsifyEdges(size_t max_edges, Summary* summary) {
+  const LabeledGraph& graph = *summary->graph;
+  if (max_edges == 0 || static_cast<size_t>(graph.NumEdges()) <= max_edges) {
+    return;
+  }
+  const std::vector<size_t> degrees = Degrees(graph);
+  std::vector<std::pair<size_t, EdgeId>> edges;
+  EdgeIterator end_it = graph.EdgeSetEnd();
+  for (EdgeIterator edge_it = graph.EdgeSetBegin(); edge_it != end_it;
+       ++edge_it) {
+    edges.emplace_back(
+        degrees[graph.Source(*edge_it)] + degrees[graph.Target(*edge_it)],
+        *edge_it);
+  }
+  std::stable_sort(edges.begin(), edges.end(),
+                   [](const std::pair<size_t, EdgeId>& edge1,
+                      const std::pair<size_t, EdgeId>& edge2) {
+                     return edge1.first > edge2.first;
+                   });
+  std::set<EdgeId> removed;
+  for (size_t i = max_edges; i < edges.size(); ++i) {
+    removed.insert(edges[i].second);
+  }
+  std::unique_ptr<Morphism> morphism = DeleteEdgesNotNodes(graph, removed);
+  CHECK(morphism->HasOutputGraph(), kGraphTypeErr);
+  std::vector<int64_t> sizes(morphism->Output().NumNodes());
+  for (const auto& node_pair : morphism->NodeMap()) {
+    sizes[node_pair.second] = summary->sizes[node_pair.first];
+  }
+  summary->sizes.swap(sizes);
+  summary->graph = morphism->TakeOutput();
+}
+
+// Returns a copy of the summary graph in which each node that stands for more
+// than one node has a summary label.
+std::unique_ptr<LabeledGraph> LabelSummaryNodes(const Summary& summary) {
+  const LabeledGraph& graph = *summary.graph;
+  const type::Types node_types = graph.GetNodeTypes();
+  type::Types summary_types = node_types;
+  for (const auto& node_type : node_types) {
+    const string tag = SummaryTag(node_type.first);
+    AST summary_type =
+        type::MakeTuple(tag, false /* Not nullable. */,
+                        {node_type.second, type::MakeInt(kElidedField, false)});
+    const bool is_new = summary_types.emplace(tag, summary_type).second;
+    CHECK(is_new, util::StrCat(kSummaryTypeErr, tag));
+  }
+  std::unique_ptr<LabeledGraph> output(new LabeledGraph());
+  util::Status status = output->Initialize(
+      summary_types, graph.GetUniqueNodeTags(), graph.GetEdgeTypes(),
+      graph.GetUniqueEdgeTags(), graph.GetGraphType());
+  CHECK(status.ok(), status.message());
+  std::vector<NodeId> node_ids(graph.NumNodes());
+  NodeIterator node_end = graph.NodeSetEnd();
+  for (NodeIterator node_it = graph.NodeSetBegin(); node_it != node_end;
+       ++node_it) {
+    TaggedAST label = graph.GetNodeLabel(*node_it);
+    const int64_t num_elided = summary.sizes[*node_it] - 1;
+    if (num_elided > 0) {
+      const string tag = SummaryTag(label.tag());
+      const AST& summary_type = summary_types.at(tag);
+      AST summary_ast = value::MakeNullTuple(2);
+      value::SetField(summary_type, 0,
+                      label.has_ast() ? label.ast() : value::MakeNull(),
+                      &summary_ast);
+      // The count is set directly because MakeInt takes an int.
+      AST elided = value::MakePrimitiveNull(PrimitiveType::INT);
+      elided.mutable_p_ast()->mutable_val()->set_int_val(num_elided);
+      value::SetField(summary_type, 1, elided, &summary_ast);
+      label.set_tag(tag);
+      *label.mutable_ast() = summary_ast;
+    }
+    node_ids[*node_it] = output->FindOrAddNode(label);
+  }
+  EdgeIterator edge_end = graph.EdgeSetEnd();
+  for (EdgeIterator edge_it = graph.EdgeSetBegin(); edge_it != edge_end;
+       ++edge_it) {
+    output->FindOrAddEdge(node_ids[graph.Source(*edge_it)],
+                          node_ids[graph.Target(*edge_it)],
+                          graph.GetEdgeLabel(*edge_it));
+  }
+  return output;
+}
+
+}  // namespace
+
+string SummaryTag(const string& tag) {
+  return util::StrCat(tag, kSummaryTagSuffix);
+}
+
+bool FitsBudget(const LabeledGraph& graph, size_t max_nodes, size_t max_edges) {
+  return (max_nodes == 0 ||
+          static_cast<size_t>(graph.NumNodes()) <= max_nodes) &&
+         (max_edges == 0 || static_cast<size_t>(graph.NumEdges()) <= max_edges);
+}
+
+std::unique_ptr<LabeledGraph> SummarizeGraph(const LabeledGraph& graph,
+                                             size_t max_nodes,
+                                             size_t max_edges) {
+  const std::vector<int64_t> sizes(graph.NumNodes(), 1);
+  Summary summary =
+      Merge(graph, sizes, BisimulationPartition(graph), SmallestMember);
+  SparsifyNodes(max_nodes, &summary);
+  SparsifyEdges(max_edges, &summary);
+  return LabelSummaryNodes(summary);
+}
+
+}  // namespace graph
+}  // namespace morphie
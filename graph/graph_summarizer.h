@@ -0,0 +1,73 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// A graph with millions of nodes cannot be laid out or read by a person. This
+// file contains utilities for summarizing a graph to a graph of bounded size,
+// which can be visualized instead.
+//
+// A summary is computed in three steps, of which the last two are only applied
+// if the graph obtained so far does not fit the bounds.
+//  1. Nodes that are bisimilar, meaning that they have the same tag and their
+//     successors are bisimilar, are merged using graph_analyzer::RefinePartition
+//     and graph::QuotientGraph. This step only merges nodes that play the same
+//     role in the graph.
+//  2. If there are too many nodes, the nodes of highest degree are kept. Every
+//     other node is merged into its adjacent kept node of highest degree, or
+//     removed if it has no adjacent kept node.
+//  3. If there are too many edges, the edges whose endpoints have the highest
+//     total degree are kept.
+//
+// A node of the summary that stands for more than one node of the input graph
+// records the number of nodes that were elided. If the node stands for the
+// nodes N with the tag "Tag", its label has the tag "TagSummary" and the AST
+// tuple(label, num_elided), where 'label' is the label of one of the nodes in N
+// and 'num_elided' is the number of other nodes in N.
+#ifndef LOGLE_GRAPH_SUMMARIZER_H_
+#define LOGLE_GRAPH_SUMMARIZER_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "base/string.h"
+#include "graph/labeled_graph.h"
+
+namespace morphie {
+namespace graph {
+
+// The suffix of the tag of a summary node.
+extern const char kSummaryTagSuffix[];
+
+// Returns the tag of the label of a summary node that stands for nodes with
+// the tag 'tag'.
+string SummaryTag(const string& tag);
+
+// Returns true if 'graph' has at most 'max_nodes' nodes and at most
+// 'max_edges' edges. A bound of 0 means that the number is not bounded.
+bool FitsBudget(const LabeledGraph& graph, size_t max_nodes, size_t max_edges);
+
+// Returns a summary of 'graph' with at most 'max_nodes' nodes and at most
+// 'max_edges' edges, computed as described at the top of this file. A bound of
+// 0 means that the number is not bounded, in which case only the nodes that are
+// bisimilar are merged. The summary has the node and edge types of 'graph' and
+// a summary node type for every node type of 'graph'.
+//  - Requires that no node type of 'graph' has a tag ending with
+//    kSummaryTagSuffix, so a summary cannot be summarized again.
+std::unique_ptr<LabeledGraph> SummarizeGraph(const LabeledGraph& graph,
+                                             size_t max_nodes,
+                                             size_t max_edges);
+
+}  // namespace graph
+}  // namespace morphie
+
+#endif  // LOGLE_GRAPH_SUMMARIZER_H_
@@ -0,0 +1,120 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/graph_summarizer.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "graph/test_graphs.h"
+#include "gtest.h"
+
+namespace morphie {
+namespace graph {
+namespace {
+
+// Returns the number of elided nodes of each node of 'graph', which is 0 for a
+// node that is not a summary node.
+std::map<NodeId, int> NumElided(const LabeledGraph& graph) {
+  std::map<NodeId, int> num_elided;
+  for (NodeIterator node_it = graph.NodeSetBegin();
+       node_it != graph.NodeSetEnd(); ++node_it) {
+    TaggedAST label = graph.GetNodeLabel(*node_it);
+    num_elided[*node_it] =
+        label.tag() == SummaryTag("Node-Weight")
+            ? label.ast().c_ast().arg(1).p_ast().val().int_val()
+            : 0;
+  }
+  return num_elided;
+}
+
+// Returns a path of 'num_nodes' nodes.
+void GetPath(int num_nodes, test::WeightedGraph* path) {
+  ASSERT_TRUE(path->Initialize().ok());
+  for (int i = 0; i < num_nodes; ++i) {
+    path->AddNode(i);
+  }
+  for (int i = 0; i + 1 < num_nodes; ++i) {
+    path->AddEdge(i, i + 1, 0);
+  }
+}
+
+TEST(GraphSummarizerTest, FitsBudget) {
+  test::WeightedGraph path;
+  GetPath(3, &path);
+  const LabeledGraph& graph = *path.GetGraph();
+  EXPECT_TRUE(FitsBudget(graph, 0, 0));
+  EXPECT_TRUE(FitsBudget(graph, 3, 2));
+  EXPECT_FALSE(FitsBudget(graph, 2, 0));
+  EXPECT_FALSE(FitsBudget(graph, 0, 1));
+}
+
+// The leaves of a star are bisimilar and are merged even without bounds.
+TEST(GraphSummarizerTest, MergesBisimilarNodes) {
+  test::WeightedGraph star;
+  ASSERT_TRUE(star.Initialize().ok());
+  NodeId hub = star.AddNode(0);
+  for (int i = 1; i <= 5; ++i) {
+    star.AddEdge(hub, star.AddNode(i), 0);
+  }
+  std::unique_ptr<LabeledGraph> summary =
+      SummarizeGraph(*star.GetGraph(), 0, 0);
+  ASSERT_NE(nullptr, summary);
+  EXPECT_EQ(2, summary->NumNodes());
+  EXPECT_EQ(1, summary->NumEdges());
+  std::map<NodeId, int> expected = {{0, 0}, {1, 4}};
+  EXPECT_EQ(expected, NumElided(*summary));
+  EXPECT_EQ(SummaryTag("Node-Weight"), summary->GetNodeLabel(1).tag());
+}
+
+// The nodes of a path are not bisimilar. With a budget of three nodes, the
+// nodes 1, 2 and 3 of highest degree are kept, 0 is merged into 1, 4 is merged
+// into 3 and 5, which has no kept neighbor, is removed.
+TEST(GraphSummarizerTest, KeepsNodesOfHighestDegree) {
+  test::WeightedGraph path;
+  GetPath(6, &path);
+  std::unique_ptr<LabeledGraph> summary =
+      SummarizeGraph(*path.GetGraph(), 3, 0);
+  ASSERT_NE(nullptr, summary);
+  EXPECT_TRUE(FitsBudget(*summary, 3, 0));
+  EXPECT_EQ(3, summary->NumNodes());
+  EXPECT_EQ(2, summary->NumEdges());
+  std::map<NodeId, int> expected = {{0, 1}, {1, 0}, {2, 1}};
+  EXPECT_EQ(expected, NumElided(*summary));
+}
+
+// The edges of a path whose endpoints have the highest total degree are those
+// in the middle, and the earliest of them are kept.
+TEST(GraphSummarizerTest, KeepsEdgesOfHighestDegree) {
+  test::WeightedGraph path;
+  GetPath(6, &path);
+  std::unique_ptr<LabeledGraph> summary =
+      SummarizeGraph(*path.GetGraph(), 0, 2);
+  ASSERT_NE(nullptr, summary);
+  EXPECT_EQ(6, summary->NumNodes());
+  ASSERT_EQ(2, summary->NumEdges());
+  std::set<std::pair<NodeId, NodeId>> edges;
+  for (EdgeIterator edge_it = summary->EdgeSetBegin();
+       edge_it != summary->EdgeSetEnd(); ++edge_it) {
+    edges.emplace(summary->Source(*edge_it), summary->Target(*edge_it));
+  }
+  std::set<std::pair<NodeId, NodeId>> expected = {{1, 2}, {2, 3}};
+  EXPECT_EQ(expected, edges);
+}
+
+}  // namespace
+}  // namespace graph
+}  // namespace morphie
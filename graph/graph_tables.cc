@@ -0,0 +1,622 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/graph_tables.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/gzip_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "graph/flat_ast.h"
+#include "graph/type_checker.h"
+#include "util/parallel.h"
+#include "util/string_utils.h"
+
+namespace morphie {
+namespace graph {
+
+namespace pb = ::google::protobuf;
+
+namespace {
+
+using pb::internal::WireFormatLite;
+
+const char kMagic[] = "MGT";
+const size_t kMagicSize = 3;
+const char kUncompressed = 0;
+const char kGzipped = 1;
+
+const uint64_t kNodeKind = 0;
+const uint64_t kEdgeKind = 1;
+
+enum class Encoding : uint32_t { kVarint = 0, kDelta = 1, kBytes = 2 };
+
+// A column of a table. The values of a column with the kBytes encoding are in
+// 'strings' and the values of other columns are in 'integers'.
+struct Column {
+  explicit Column(Encoding encoding) : encoding(encoding) {}
+
+  uint64_t NumRows() const {
+    return encoding == Encoding::kBytes ? strings.size() : integers.size();
+  }
+
+  Encoding encoding;
+  std::vector<uint64_t> integers;
+  std::vector<string> strings;
+};
+
+using Table = std::vector<Column>;
+using Schema = std::vector<Encoding>;
+
+// The schemas of the tables described at the top of graph_tables.h.
+const Schema kNodeSchema = {Encoding::kDelta, Encoding::kVarint,
+                            Encoding::kVarint};
+const Schema kEdgeSchema = {Encoding::kDelta, Encoding::kVarint,
+                            Encoding::kVarint, Encoding::kVarint};
+const Schema kTagSchema = {Encoding::kBytes, Encoding::kVarint,
+                           Encoding::kVarint, Encoding::kBytes};
+const Schema kLabelSchema = {Encoding::kVarint, Encoding::kBytes};
+const Schema kGraphSchema = {Encoding::kBytes, Encoding::kBytes};
+
+Table MakeTable(const Schema& schema) {
+  Table table;
+  for (Encoding encoding : schema) {
+    table.emplace_back(encoding);
+  }
+  return table;
+}
+
+util::Status InvalidTables(const string& msg) {
+  return util::Status(Code::INVALID_ARGUMENT,
+                      util::StrCat("Invalid graph tables: ", msg));
+}
+
+// Encodes the values of a column with the kVarint or kDelta encoding one at a
+// time.
+class ColumnEncoder {
+ public:
+  ColumnEncoder(Encoding encoding, pb::io::CodedOutputStream* output)
+      : is_delta_(encoding == Encoding::kDelta), previous_(0), output_(output) {}
+
+  void Add(uint64_t value) {
+    if (is_delta_) {
+      output_->WriteVarint64(WireFormatLite::ZigZagEncode64(
+          static_cast<int64_t>(value - previous_)));
+      previous_ = value;
+    } else {
+      output_->WriteVarint64(value);
+    }
+  }
+
+ private:
+  bool is_delta_;
+  uint64_t previous_;
+  pb::io::CodedOutputStream* output_;
+};
+
+// Numbers the tags of a graph, with node tags before edge tags.
+class TagIds {
+ public:
+  explicit TagIds(const LabeledGraph& graph) {
+    AddTags(kNodeKind, graph.GetNodeTypes(), graph.GetUniqueNodeTags(),
+            &node_ids_);
+    AddTags(kEdgeKind, graph.GetEdgeTypes(), graph.GetUniqueEdgeTags(),
+            &edge_ids_);
+  }
+
+  uint64_t NodeTagId(const string& tag) const { return node_ids_.at(tag); }
+  uint64_t EdgeTagId(const string& tag) const { return edge_ids_.at(tag); }
+  // The tag table described in graph_tables.h.
+  const Table& table() const { return table_; }
+
+ private:
+  void AddTags(uint64_t kind, const ast::type::Types& types,
+               const set<string>& unique_tags,
+               std::unordered_map<string, uint64_t>* tag_ids) {
+    for (const auto& tag_type : types) {
+      (*tag_ids)[tag_type.first] = table_[0].strings.size();
+      table_[0].strings.push_back(tag_type.first);
+      table_[1].integers.push_back(kind);
+      table_[2].integers.push_back(unique_tags.count(tag_type.first));
+      table_[3].strings.push_back(tag_type.second.SerializeAsString());
+    }
+  }
+
+  Table table_ = MakeTable(kTagSchema);
+  std::unordered_map<string, uint64_t> node_ids_;
+  std::unordered_map<string, uint64_t> edge_ids_;
+};
+
+// Numbers the distinct labels of a graph in the order in which they are first
+// used. Labels are identified by their tag id and a pointer to the label
+// stored in the graph, so the dictionary holds no copies of labels.
+class LabelDictionary {
+ public:
+  uint64_t LabelId(uint64_t tag_id, const ast::FlatTaggedAST& label) {
+    auto inserted = ids_.emplace(Key{tag_id, &label}, labels_.size());
+    if (inserted.second) {
+      labels_.push_back(Key{tag_id, &label});
+    }
+    return inserted.first->second;
+  }
+
+  // Writes the label table described in graph_tables.h.
+  void WriteTable(pb::io::CodedOutputStream* output) const {
+    output->WriteVarint64(kLabelSchema.size());
+    output->WriteVarint64(labels_.size());
+    for (Encoding encoding : kLabelSchema) {
+      output->WriteVarint32(static_cast<uint32_t>(encoding));
+    }
+    for (const Key& key : labels_) {
+      output->WriteVarint64(key.tag_id);
+    }
+    string ast;
+    for (const Key& key : labels_) {
+      ast.clear();
+      key.label->ast().ToAST().AppendToString(&ast);
+      output->WriteVarint64(ast.size());
+      output->WriteString(ast);
+    }
+  }
+
+ private:
+  struct Key {
+    uint64_t tag_id;
+    const ast::FlatTaggedAST* label;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return ast::FlatASTHash()(key.label->ast()) * 31 + key.tag_id;
+    }
+  };
+
+  struct KeyEqual {
+    bool operator()(const Key& a, const Key& b) const {
+      return a.tag_id == b.tag_id &&
+             a.label->has_ast() == b.label->has_ast() &&
+             a.label->ast() == b.label->ast();
+    }
+  };
+
+  std::unordered_map<Key, uint64_t, KeyHash, KeyEqual> ids_;
+  std::vector<Key> labels_;
+};
+
+// Writes one column of a table to 'output' by a pass over the graph.
+using ColumnWriter = std::function<void(pb::io::CodedOutputStream* output)>;
+
+// Writes a table with the given schema and number of rows. Each column is
+// written by the writer with the same index. If 'num_threads' is greater than
+// 1, the columns are encoded into buffers on separate threads and the buffers
+// are written in order. At most one writer may have side effects, such as
+// assigning label ids, since each writer runs on one thread.
+void WriteTable(const Schema& schema, uint64_t num_rows,
+                const std::vector<ColumnWriter>& columns, int num_threads,
+                pb::io::CodedOutputStream* output) {
+  output->WriteVarint64(schema.size());
+  output->WriteVarint64(num_rows);
+  for (Encoding encoding : schema) {
+    output->WriteVarint32(static_cast<uint32_t>(encoding));
+  }
+  if (num_threads <= 1) {
+    for (const ColumnWriter& column : columns) {
+      column(output);
+    }
+    return;
+  }
+  std::vector<string> encoded(columns.size());
+  const int num_chunks =
+      std::min(num_threads, static_cast<int>(columns.size()));
+  util::ParallelForChunks(
+      columns.size(), num_chunks,
+      [&columns, &encoded](int, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          pb::io::StringOutputStream raw_output(&encoded[i]);
+          pb::io::CodedOutputStream column_output(&raw_output);
+          columns[i](&column_output);
+        }
+      });
+  for (const string& column : encoded) {
+    output->WriteRaw(column.data(), column.size());
+  }
+}
+
+// Writes a table that is held in memory. Used for the small dictionary tables.
+void WriteTable(const Table& table, pb::io::CodedOutputStream* output) {
+  std::vector<ColumnWriter> columns;
+  for (const Column& column : table) {
+    columns.push_back([&column](pb::io::CodedOutputStream* column_output) {
+      if (column.encoding == Encoding::kBytes) {
+        for (const string& value : column.strings) {
+          column_output->WriteVarint64(value.size());
+          column_output->WriteString(value);
+        }
+        return;
+      }
+      ColumnEncoder encoder(column.encoding, column_output);
+      for (uint64_t value : column.integers) {
+        encoder.Add(value);
+      }
+    });
+  }
+  std::vector<Encoding> schema;
+  for (const Column& column : table) {
+    schema.push_back(column.encoding);
+  }
+  WriteTable(schema, table.empty() ? 0 : table[0].NumRows(), columns, 1,
+             output);
+}
+
+// Returns a writer for a column of the node table that encodes 'value_fn'
+// of each node.
+ColumnWriter NodeColumn(const LabeledGraph& graph, Encoding encoding,
+                        const std::function<uint64_t(NodeId)>& value_fn) {
+  return [&graph, encoding, value_fn](pb::io::CodedOutputStream* output) {
+    ColumnEncoder encoder(encoding, output);
+    for (NodeIterator node_it = graph.NodeSetBegin();
+         node_it != graph.NodeSetEnd(); ++node_it) {
+      encoder.Add(value_fn(*node_it));
+    }
+  };
+}
+
+ColumnWriter EdgeColumn(const LabeledGraph& graph, Encoding encoding,
+                        const std::function<uint64_t(EdgeId)>& value_fn) {
+  return [&graph, encoding, value_fn](pb::io::CodedOutputStream* output) {
+    ColumnEncoder encoder(encoding, output);
+    for (EdgeIterator edge_it = graph.EdgeSetBegin();
+         edge_it != graph.EdgeSetEnd(); ++edge_it) {
+      encoder.Add(value_fn(*edge_it));
+    }
+  };
+}
+
+void WriteNodeTable(const LabeledGraph& graph, const TagIds& tag_ids,
+                    LabelDictionary* labels, int num_threads,
+                    pb::io::CodedOutputStream* output) {
+  auto tag_id = [&graph, &tag_ids](NodeId node_id) {
+    return tag_ids.NodeTagId(graph.GetFlatNodeLabel(node_id).tag());
+  };
+  std::vector<ColumnWriter> columns = {
+      NodeColumn(graph, kNodeSchema[0],
+                 [](NodeId node_id) { return node_id; }),
+      NodeColumn(graph, kNodeSchema[1], tag_id),
+      NodeColumn(graph, kNodeSchema[2],
+                 [&graph, &tag_id, labels](NodeId node_id) {
+                   return labels->LabelId(tag_id(node_id),
+                                          graph.GetFlatNodeLabel(node_id));
+                 })};
+  WriteTable(kNodeSchema, graph.NumNodes(), columns, num_threads, output);
+}
+
+void WriteEdgeTable(const LabeledGraph& graph, const TagIds& tag_ids,
+                    LabelDictionary* labels, int num_threads,
+                    pb::io::CodedOutputStream* output) {
+  auto tag_id = [&graph, &tag_ids](EdgeId edge_id) {
+    return tag_ids.EdgeTagId(graph.GetFlatEdgeLabel(edge_id).tag());
+  };
+  std::vector<ColumnWriter> columns = {
+      EdgeColumn(graph, kEdgeSchema[0],
+                 [&graph](EdgeId edge_id) { return graph.Source(edge_id); }),
+      EdgeColumn(graph, kEdgeSchema[1],
+                 [&graph](EdgeId edge_id) { return graph.Target(edge_id); }),
+      EdgeColumn(graph, kEdgeSchema[2], tag_id),
+      EdgeColumn(graph, kEdgeSchema[3],
+                 [&graph, &tag_id, labels](EdgeId edge_id) {
+                   return labels->LabelId(tag_id(edge_id),
+                                          graph.GetFlatEdgeLabel(edge_id));
+                 })};
+  WriteTable(kEdgeSchema, graph.NumEdges(), columns, num_threads, output);
+}
+
+// Writes the header to 'out' followed by the tables written by 'write_fn'.
+// Returns false if writing fails.
+bool WriteStream(
+    TableCompression compression,
+    const std::function<void(pb::io::CodedOutputStream*)>& write_fn,
+    std::ostream* out) {
+  bool is_gzipped = compression == TableCompression::kGzip;
+  out->write(kMagic, kMagicSize);
+  out->put(is_gzipped ? kGzipped : kUncompressed);
+  bool ok = true;
+  {
+    pb::io::OstreamOutputStream raw_output(out);
+    std::unique_ptr<pb::io::GzipOutputStream> gzip_output;
+    pb::io::ZeroCopyOutputStream* output = &raw_output;
+    if (is_gzipped) {
+      gzip_output.reset(new pb::io::GzipOutputStream(&raw_output));
+      output = gzip_output.get();
+    }
+    {
+      pb::io::CodedOutputStream coded_output(output);
+      write_fn(&coded_output);
+      ok = !coded_output.HadError();
+    }
+    if (gzip_output != nullptr) {
+      ok = gzip_output->Close() && ok;
+    }
+  }
+  return ok && !out->fail();
+}
+
+// Reads a column with 'num_rows' rows. Values are appended one at a time, so a
+// corrupt number of rows fails when the input ends instead of allocating a
+// large column.
+bool ReadColumn(uint64_t num_rows, pb::io::CodedInputStream* input,
+                Column* column) {
+  uint64_t value;
+  uint64_t previous = 0;
+  for (uint64_t row = 0; row < num_rows; ++row) {
+    if (!input->ReadVarint64(&value)) {
+      return false;
+    }
+    switch (column->encoding) {
+      case Encoding::kVarint:
+        column->integers.push_back(value);
+        break;
+      case Encoding::kDelta:
+        previous += WireFormatLite::ZigZagDecode64(value);
+        column->integers.push_back(previous);
+        break;
+      case Encoding::kBytes:
+        if (value > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+          return false;
+        }
+        column->strings.emplace_back();
+        if (!input->ReadString(&column->strings.back(),
+                               static_cast<int>(value))) {
+          return false;
+        }
+        break;
+    }
+  }
+  return true;
+}
+
+util::Status ReadTable(const Schema& schema, pb::io::CodedInputStream* input,
+                       Table* table) {
+  uint64_t num_columns;
+  uint64_t num_rows;
+  if (!input->ReadVarint64(&num_columns) || !input->ReadVarint64(&num_rows) ||
+      num_columns != schema.size()) {
+    return InvalidTables("A table has the wrong number of columns.");
+  }
+  *table = MakeTable(schema);
+  for (Encoding encoding : schema) {
+    uint32_t stored_encoding;
+    if (!input->ReadVarint32(&stored_encoding) ||
+        stored_encoding != static_cast<uint32_t>(encoding)) {
+      return InvalidTables("A column has the wrong encoding.");
+    }
+  }
+  for (Column& column : *table) {
+    if (!ReadColumn(num_rows, input, &column)) {
+      return InvalidTables("A column is truncated.");
+    }
+  }
+  return util::Status::OK;
+}
+
+// Reads the header and tables with the schemas 'schemas' from 'in'.
+util::Status ReadStream(const std::vector<const Schema*>& schemas,
+                        std::istream* in, std::vector<Table>* tables) {
+  char header[kMagicSize + 1];
+  in->read(header, sizeof(header));
+  if (!*in || std::memcmp(header, kMagic, kMagicSize) != 0 ||
+      (header[kMagicSize] != kUncompressed &&
+       header[kMagicSize] != kGzipped)) {
+    return InvalidTables("A stream has no valid header.");
+  }
+  pb::io::IstreamInputStream raw_input(in);
+  std::unique_ptr<pb::io::GzipInputStream> gzip_input;
+  pb::io::ZeroCopyInputStream* input = &raw_input;
+  if (header[kMagicSize] == kGzipped) {
+    gzip_input.reset(new pb::io::GzipInputStream(&raw_input));
+    input = gzip_input.get();
+  }
+  pb::io::CodedInputStream coded_input(input);
+  coded_input.SetTotalBytesLimit(std::numeric_limits<int>::max());
+  tables->clear();
+  for (const Schema* schema : schemas) {
+    tables->emplace_back();
+    util::Status status = ReadTable(*schema, &coded_input, &tables->back());
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return util::Status::OK;
+}
+
+// Type checks the labels in the dictionary. A label is checked once here
+// rather than every time it is used, so that adding the nodes and edges of the
+// graph cannot fail a CHECK.
+util::Status ParseLabels(const Table& tags, const Table& labels,
+                         const ast::type::Types& node_types,
+                         const ast::type::Types& edge_types,
+                         std::vector<TaggedAST>* parsed_labels) {
+  for (uint64_t row = 0; row < labels[0].NumRows(); ++row) {
+    uint64_t tag_id = labels[0].integers[row];
+    if (tag_id >= tags[0].NumRows()) {
+      return InvalidTables("A label has an unknown tag.");
+    }
+    TaggedAST label;
+    label.set_tag(tags[0].strings[tag_id]);
+    string err;
+    if (!label.mutable_ast()->ParseFromString(labels[1].strings[row]) ||
+        !ast::type::IsTyped(
+            tags[1].integers[tag_id] == kNodeKind ? node_types : edge_types,
+            label, &err)) {
+      return InvalidTables(util::StrCat("A label is not typed. ", err));
+    }
+    parsed_labels->push_back(std::move(label));
+  }
+  return util::Status::OK;
+}
+
+// Returns true if 'label_id' is the id of a label whose tag has the tag id
+// 'tag_id' and the kind 'kind'.
+bool IsLabelOf(const Table& tags, const Table& labels, uint64_t kind,
+               uint64_t tag_id, uint64_t label_id) {
+  return label_id < labels[0].NumRows() &&
+         labels[0].integers[label_id] == tag_id &&
+         tags[1].integers[tag_id] == kind;
+}
+
+}  // namespace
+
+bool WriteGraphTables(const LabeledGraph& graph, TableCompression compression,
+                      int num_threads, std::ostream* nodes,
+                      std::ostream* edges, std::ostream* dictionary) {
+  const TagIds tag_ids(graph);
+  LabelDictionary labels;
+  bool ok = WriteStream(
+      compression,
+      [&graph, &tag_ids, &labels, num_threads](
+          pb::io::CodedOutputStream* output) {
+        WriteNodeTable(graph, tag_ids, &labels, num_threads, output);
+      },
+      nodes);
+  ok = WriteStream(compression,
+                   [&graph, &tag_ids, &labels, num_threads](
+                       pb::io::CodedOutputStream* output) {
+                     WriteEdgeTable(graph, tag_ids, &labels, num_threads,
+                                    output);
+                   },
+                   edges) &&
+       ok;
+  Table graph_table = MakeTable(kGraphSchema);
+  graph_table[0].strings.push_back(graph.GetGraphType().SerializeAsString());
+  graph_table[1].strings.push_back(graph.GetGraphLabel().SerializeAsString());
+  return WriteStream(compression,
+                     [&tag_ids, &labels, &graph_table](
+                         pb::io::CodedOutputStream* output) {
+                       WriteTable(tag_ids.table(), output);
+                       labels.WriteTable(output);
+                       WriteTable(graph_table, output);
+                     },
+                     dictionary) &&
+         ok;
+}
+
+util::Status ReadGraphTables(std::istream* nodes, std::istream* edges,
+                             std::istream* dictionary,
+                             std::unique_ptr<LabeledGraph>* graph) {
+  std::vector<Table> dictionary_tables;
+  util::Status status = ReadStream({&kTagSchema, &kLabelSchema, &kGraphSchema},
+                                   dictionary, &dictionary_tables);
+  if (!status.ok()) {
+    return status;
+  }
+  const Table& tags = dictionary_tables[0];
+  const Table& labels = dictionary_tables[1];
+  const Table& graph_table = dictionary_tables[2];
+  ast::type::Types node_types;
+  ast::type::Types edge_types;
+  set<string> unique_node_tags;
+  set<string> unique_edge_tags;
+  for (uint64_t row = 0; row < tags[0].NumRows(); ++row) {
+    const string& tag = tags[0].strings[row];
+    uint64_t kind = tags[1].integers[row];
+    if (kind != kNodeKind && kind != kEdgeKind) {
+      return InvalidTables("A tag has an unknown kind.");
+    }
+    AST type;
+    if (!type.ParseFromString(tags[3].strings[row])) {
+      return InvalidTables("A tag has an invalid type.");
+    }
+    (kind == kNodeKind ? node_types : edge_types)[tag] = type;
+    if (tags[2].integers[row] != 0) {
+      (kind == kNodeKind ? unique_node_tags : unique_edge_tags).insert(tag);
+    }
+  }
+  AST graph_type;
+  AST graph_label;
+  if (graph_table[0].NumRows() != 1 ||
+      !graph_type.ParseFromString(graph_table[0].strings[0]) ||
+      !graph_label.ParseFromString(graph_table[1].strings[0])) {
+    return InvalidTables("The graph table is invalid.");
+  }
+  std::vector<TaggedAST> parsed_labels;
+  status = ParseLabels(tags, labels, node_types, edge_types, &parsed_labels);
+  if (!status.ok()) {
+    return status;
+  }
+  std::unique_ptr<LabeledGraph> result(new LabeledGraph());
+  status = result->Initialize(node_types, unique_node_tags, edge_types,
+                              unique_edge_tags, graph_type);
+  if (!status.ok()) {
+    return InvalidTables(status.message());
+  }
+  if (!graph_table[1].strings[0].empty()) {
+    string err;
+    if (!ast::type::IsTyped(graph_type, graph_label, &err)) {
+      return InvalidTables(util::StrCat("The graph label is not typed. ", err));
+    }
+    result->SetGraphLabel(graph_label);
+  }
+
+  std::vector<Table> node_tables;
+  status = ReadStream({&kNodeSchema}, nodes, &node_tables);
+  if (!status.ok()) {
+    return status;
+  }
+  const Table& node_table = node_tables[0];
+  for (uint64_t row = 0; row < node_table[0].NumRows(); ++row) {
+    uint64_t tag_id = node_table[1].integers[row];
+    uint64_t label_id = node_table[2].integers[row];
+    if (node_table[0].integers[row] != row ||
+        !IsLabelOf(tags, labels, kNodeKind, tag_id, label_id)) {
+      return InvalidTables("A node has an invalid id or label.");
+    }
+    if (result->FindOrAddNode(parsed_labels[label_id]) != row) {
+      return InvalidTables("Two nodes have the same unique label.");
+    }
+  }
+
+  std::vector<Table> edge_tables;
+  status = ReadStream({&kEdgeSchema}, edges, &edge_tables);
+  if (!status.ok()) {
+    return status;
+  }
+  const Table& edge_table = edge_tables[0];
+  uint64_t num_nodes = node_table[0].NumRows();
+  for (uint64_t row = 0; row < edge_table[0].NumRows(); ++row) {
+    uint64_t source = edge_table[0].integers[row];
+    uint64_t target = edge_table[1].integers[row];
+    uint64_t tag_id = edge_table[2].integers[row];
+    uint64_t label_id = edge_table[3].integers[row];
+    if (source >= num_nodes || target >= num_nodes ||
+        !IsLabelOf(tags, labels, kEdgeKind, tag_id, label_id)) {
+      return InvalidTables("An edge has an invalid endpoint or label.");
+    }
+    result->FindOrAddEdge(source, target, parsed_labels[label_id]);
+  }
+  *graph = std::move(result);
+  return util::Status::OK;
+}
+
+}  // namespace graph
+}  // namespace morphie
@@ -0,0 +1,83 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// This file contains utilities for exporting a LabeledGraph as binary tables,
+// which other tools can load much faster than a DOT or text protobuf
+// representation, and for reading the tables back into a LabeledGraph.
+//
+// A graph is written to three streams.
+//  - The node table has one row per node, with the columns
+//      id, tag id, label id.
+//  - The edge table has one row per edge, in the order of the edge set of the
+//    graph, with the columns
+//      source id, target id, tag id, label id.
+//  - The dictionary consists of three tables. The tag table has one row per
+//    node and edge type, with the columns
+//      name, kind (0 for nodes and 1 for edges), is unique (0 or 1), type,
+//    where the type is a serialized AST. The label table has one row per
+//    distinct label, with the columns
+//      tag id, label,
+//    where the label is a serialized TaggedAST without a tag. The graph table
+//    has one row, with the columns
+//      graph type, graph label.
+// The ids of tags and labels are their row numbers in the dictionary.
+//
+// A stream starts with the 3 bytes "MGT" and a byte that is 0 if the rest of
+// the stream is uncompressed and 1 if it is compressed with gzip. A table
+// starts with its number of columns and rows, followed by the encoding of each
+// column, followed by the data of the columns, one column after another. An
+// integer is a varint. In a column with the delta encoding, each value is
+// stored as the zigzag encoded difference from the previous value, which keeps
+// sorted columns such as node ids small. A string is its length followed by
+// its bytes.
+#ifndef LOGLE_GRAPH_TABLES_H_
+#define LOGLE_GRAPH_TABLES_H_
+
+#include <istream>
+#include <memory>
+#include <ostream>
+
+#include "graph/labeled_graph.h"
+#include "util/status.h"
+
+namespace morphie {
+namespace graph {
+
+enum class TableCompression { kNone, kGzip };
+
+// Writes the tables of 'graph' to the streams. Each column of the node and edge
+// tables is encoded by one pass over the graph. If 'num_threads' is 1 or less,
+// the values are written to the stream as they are encoded, so the memory used
+// is independent of the size of the graph apart from the label dictionary,
+// which refers to the labels stored in the graph instead of copying them. If
+// 'num_threads' is greater than 1, the columns of a table are encoded in
+// parallel into buffers of encoded bytes, which are written in order. Returns
+// false if writing to a stream fails.
+bool WriteGraphTables(const LabeledGraph& graph, TableCompression compression,
+                      int num_threads, std::ostream* nodes,
+                      std::ostream* edges, std::ostream* dictionary);
+
+// Reads tables written by WriteGraphTables into a new graph, which has the
+// same types, nodes, edges and node ids as the graph that was written. Returns
+//  - INVALID_ARGUMENT if the streams do not contain valid tables or the
+//    labels in the tables do not have the types in the dictionary.
+//  - OK otherwise, in which case '*graph' is set to the graph.
+util::Status ReadGraphTables(std::istream* nodes, std::istream* edges,
+                             std::istream* dictionary,
+                             std::unique_ptr<LabeledGraph>* graph);
+
+}  // namespace graph
+}  // namespace morphie
+
+#endif  // LOGLE_GRAPH_TABLES_H_
@@ -0,0 +1,142 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/graph_tables.h"
+
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "graph/test_graphs.h"
+#include "gtest.h"
+
+namespace morphie {
+namespace graph {
+namespace {
+
+// A graph with repeated node and edge weights, so that the dictionary has
+// fewer labels than the graph has nodes and edges.
+void GetGraph(test::WeightedGraph* graph) {
+  ASSERT_TRUE(graph->Initialize().ok());
+  for (int i = 0; i < 10; ++i) {
+    graph->AddNode(i % 3);
+  }
+  for (int i = 0; i < 10; ++i) {
+    graph->AddEdge(i, (i * 7) % 10, i % 2);
+    graph->AddEdge((i * 3) % 10, i, i % 4);
+  }
+}
+
+// Returns the label of each node and the endpoints and label of each edge, in
+// the order of the node and edge sets.
+std::vector<string> Contents(const LabeledGraph& graph) {
+  std::vector<string> contents;
+  for (NodeIterator node_it = graph.NodeSetBegin();
+       node_it != graph.NodeSetEnd(); ++node_it) {
+    contents.push_back(graph.GetNodeLabel(*node_it).DebugString());
+  }
+  for (EdgeIterator edge_it = graph.EdgeSetBegin();
+       edge_it != graph.EdgeSetEnd(); ++edge_it) {
+    std::ostringstream edge;
+    edge << graph.Source(*edge_it) << " " << graph.Target(*edge_it) << " "
+         << graph.GetEdgeLabel(*edge_it).DebugString();
+    contents.push_back(edge.str());
+  }
+  return contents;
+}
+
+struct Streams {
+  std::stringstream nodes;
+  std::stringstream edges;
+  std::stringstream dictionary;
+};
+
+bool Write(const LabeledGraph& graph, TableCompression compression,
+           int num_threads, Streams* streams) {
+  return WriteGraphTables(graph, compression, num_threads, &streams->nodes,
+                          &streams->edges, &streams->dictionary);
+}
+
+util::Status Read(Streams* streams, std::unique_ptr<LabeledGraph>* graph) {
+  return ReadGraphTables(&streams->nodes, &streams->edges,
+                         &streams->dictionary, graph);
+}
+
+TEST(GraphTablesTest, RoundTrips) {
+  test::WeightedGraph weighted_graph;
+  GetGraph(&weighted_graph);
+  const LabeledGraph& graph = *weighted_graph.GetGraph();
+  for (TableCompression compression :
+       {TableCompression::kNone, TableCompression::kGzip}) {
+    Streams streams;
+    ASSERT_TRUE(Write(graph, compression, 1, &streams));
+    std::unique_ptr<LabeledGraph> read_graph;
+    ASSERT_TRUE(Read(&streams, &read_graph).ok());
+    EXPECT_EQ(graph.NumNodes(), read_graph->NumNodes());
+    EXPECT_EQ(graph.NumEdges(), read_graph->NumEdges());
+    EXPECT_EQ(Contents(graph), Contents(*read_graph));
+    EXPECT_EQ(graph.GetNodeTypes().size(), read_graph->GetNodeTypes().size());
+    EXPECT_EQ(graph.GetGraphType().DebugString(),
+              read_graph->GetGraphType().DebugString());
+  }
+}
+
+// Encoding columns in parallel does not change the output.
+TEST(GraphTablesTest, WritesColumnsInParallel) {
+  test::WeightedGraph weighted_graph;
+  GetGraph(&weighted_graph);
+  const LabeledGraph& graph = *weighted_graph.GetGraph();
+  Streams serial;
+  Streams parallel;
+  ASSERT_TRUE(Write(graph, TableCompression::kNone, 1, &serial));
+  ASSERT_TRUE(Write(graph, TableCompression::kNone, 3, &parallel));
+  EXPECT_EQ(serial.nodes.str(), parallel.nodes.str());
+  EXPECT_EQ(serial.edges.str(), parallel.edges.str());
+  EXPECT_EQ(serial.dictionary.str(), parallel.dictionary.str());
+}
+
+TEST(GraphTablesTest, RejectsInvalidTables) {
+  test::WeightedGraph weighted_graph;
+  GetGraph(&weighted_graph);
+  Streams streams;
+  ASSERT_TRUE(
+      Write(*weighted_graph.GetGraph(), TableCompression::kNone, 1, &streams));
+  string nodes = streams.nodes.str();
+  string edges = streams.edges.str();
+  string dictionary = streams.dictionary.str();
+
+  // Each pair is a stream to modify and its modified contents.
+  std::vector<std::pair<int, string>> corruptions = {
+      std::make_pair(0, "XYZ" + nodes.substr(3)),
+      std::make_pair(0, nodes.substr(0, nodes.size() - 1)),
+      std::make_pair(1, edges.substr(0, edges.size() / 2)),
+      std::make_pair(2, dictionary.substr(0, 4)),
+      std::make_pair(2, edges)};
+  for (const auto& corruption : corruptions) {
+    Streams corrupt;
+    corrupt.nodes.str(corruption.first == 0 ? corruption.second : nodes);
+    corrupt.edges.str(corruption.first == 1 ? corruption.second : edges);
+    corrupt.dictionary.str(
+        corruption.first == 2 ? corruption.second : dictionary);
+    std::unique_ptr<LabeledGraph> read_graph;
+    util::Status status = Read(&corrupt, &read_graph);
+    EXPECT_EQ(Code::INVALID_ARGUMENT, status.code());
+    EXPECT_EQ(nullptr, read_graph);
+  }
+}
+
+}  // namespace
+}  // namespace graph
+}  // namespace morphie
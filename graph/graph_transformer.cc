@@ -62,12 +62,11 @@ struct Transformation {
 // Returns a pointer to a graph whose type is the same as the input graph.
 // Returns a nullptr if a new graph could not be created. The returned graph
 // will be empty (no nodes and no edges) because only the type of the graph is
-// copied, not the contents of the graph.
+// copied, not the contents of the graph. The new graph shares the type registry
+// of 'graph', so the time taken does not depend on the size of the types.
 std::unique_ptr<LabeledGraph> CloneGraphType(const LabeledGraph& graph) {
   std::unique_ptr<LabeledGraph> new_graph(new LabeledGraph());
-  util::Status status = new_graph->Initialize(
-      graph.GetNodeTypes(), graph.GetUniqueNodeTags(), graph.GetEdgeTypes(),
-      graph.GetUniqueEdgeTags(), graph.GetGraphType());
+  util::Status status = new_graph->Initialize(graph.GetTypeRegistry());
   if (!status.ok()) {
     new_graph.reset(nullptr);
   }
@@ -402,6 +401,13 @@ std::unique_ptr<Morphism> DeleteEdgesAndNodes(const LabeledGraph& graph,
 std::unique_ptr<LabeledGraph> QuotientGraph(
     const LabeledGraph& input_graph, const std::map<NodeId, int>& partition,
     const QuotientConfig& config) {
+  std::map<NodeId, NodeId> node_map;
+  return QuotientGraph(input_graph, partition, config, &node_map);
+}
+
+std::unique_ptr<LabeledGraph> QuotientGraph(
+    const LabeledGraph& input_graph, const std::map<NodeId, int>& partition,
+    const QuotientConfig& config, std::map<NodeId, NodeId>* node_map) {
   Transformation transform(input_graph);
   transform.output = CloneGraphType(config.output_graph_type);
   if (transform.output == nullptr) {
@@ -413,6 +419,13 @@ std::unique_ptr<LabeledGraph> QuotientGraph(
   std::map<int, NodeId> block_node_ids;
   AddQuotientNodes(config.node_label_fn, block_members,
                    &block_node_ids, &transform);
+  node_map->clear();
+  for (const auto& block : block_members) {
+    NodeId block_node_id = block_node_ids[block.first];
+    for (NodeId member : block.second) {
+      node_map->emplace(member, block_node_id);
+    }
+  }
 
   std::map<std::pair<NodeId, NodeId>, std::set<EdgeId>> block_edge_members;
   BuildQuotientEdgeMap(config, partition,
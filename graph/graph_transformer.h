@@ -56,6 +56,9 @@ using FoldLabelFn =
 // - The flag 'allow_self_edges' dictates if the output graph should contain
 //    self-edges.
 //
+// The label functions are copied, so they may be temporaries such as lambdas,
+// but 'output_graph_type' must outlive the config.
+//
 // Requires that:
 // - Both 'node_label_fn' and 'edge_label_fn' respect the types of
 //   'output_graph_type'.
@@ -70,8 +73,8 @@ struct QuotientConfig {
       edge_label_fn(edge_label_fn),
       allow_self_edges(allow_self_edges) {}
   const LabeledGraph& output_graph_type;
-  const NodeLabelFn& node_label_fn;
-  const EdgeLabelFn& edge_label_fn;
+  NodeLabelFn node_label_fn;
+  EdgeLabelFn edge_label_fn;
   bool allow_self_edges;
 };  // struct QuotientConfig
 
@@ -129,6 +132,11 @@ std::unique_ptr<Morphism> DeleteEdgesAndNodes(const LabeledGraph& graph,
 std::unique_ptr<LabeledGraph> QuotientGraph(
     const LabeledGraph& input_graph, const std::map<NodeId, int>& partition,
     const QuotientConfig& config);
+// Returns the same graph as the function above and also sets 'node_map' to map
+// each node of the input graph to the node of its block in the output graph.
+std::unique_ptr<LabeledGraph> QuotientGraph(
+    const LabeledGraph& input_graph, const std::map<NodeId, int>& partition,
+    const QuotientConfig& config, std::map<NodeId, NodeId>* node_map);
 
 // Edge contraction replaces an edge (u, v) with a new node w such that for each
 // edge (x, u) or (x, v) in the input graph there is an edge (x, w) in the
@@ -0,0 +1,278 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+
+#include "graph/hierarchy_exporter.h"
+
+#include <boost/algorithm/string/join.hpp>  // NOLINT
+
+#include <algorithm>
+#include <limits>
+
+#include "util/string_utils.h"
+
+namespace morphie {
+namespace viz {
+
+namespace {
+
+const NodeId kNoParent = std::numeric_limits<NodeId>::max();
+const size_t kNoRepresentative = std::numeric_limits<size_t>::max();
+
+const char kInvalidNodeMapErr[] =
+    "The node map does not map nodes of the top level to nodes of the summary.";
+const char kInvalidMetanodeErr[] = "Not the name of a metanode: ";
+
+string Segment(int level, NodeId node_id) {
+  return util::StrCat(std::to_string(level), "_", std::to_string(node_id));
+}
+
+// Parses a decimal number that is the whole of 'text'.
+bool ParseNumber(const string& text, size_t* number) {
+  if (text.empty() || text.size() > 18) {
+    return false;
+  }
+  *number = 0;
+  for (char c : text) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    *number = *number * 10 + (c - '0');
+  }
+  return true;
+}
+
+}  // namespace
+
+HierarchyExporter::HierarchyExporter(const LabeledGraph& graph)
+    : HierarchyExporter(graph, GraphExporter::TextLabel) {}
+
+HierarchyExporter::HierarchyExporter(const LabeledGraph& graph,
+                                     const LabelFn& node_label)
+    : node_label_(node_label) {
+  levels_.push_back(
+      {&graph, std::vector<NodeId>(graph.NumNodes(), kNoParent), {}});
+}
+
+util::Status HierarchyExporter::AddLevel(
+    const LabeledGraph& summary, const std::map<NodeId, NodeId>& node_map) {
+  Level& top = levels_.back();
+  for (const auto& node_pair : node_map) {
+    if (!top.graph->HasNode(node_pair.first) ||
+        !summary.HasNode(node_pair.second)) {
+      return util::Status(Code::INVALID_ARGUMENT, kInvalidNodeMapErr);
+    }
+  }
+  Level level = {&summary, std::vector<NodeId>(summary.NumNodes(), kNoParent),
+                 std::vector<std::vector<NodeId>>(summary.NumNodes())};
+  for (const auto& node_pair : node_map) {
+    top.parent[node_pair.first] = node_pair.second;
+    level.children[node_pair.second].push_back(node_pair.first);
+  }
+  levels_.push_back(std::move(level));
+  return util::Status::OK;
+}
+
+util::Status HierarchyExporter::AddLevel(const graph::Morphism& morphism) {
+  if (&morphism.Input() != levels_.back().graph) {
+    return util::Status(
+        Code::INVALID_ARGUMENT,
+        "The input graph of the morphism is not the top level.");
+  }
+  std::map<NodeId, NodeId> node_map(morphism.NodeMap().begin(),
+                                    morphism.NodeMap().end());
+  return AddLevel(morphism.Output(), node_map);
+}
+
+ge::GraphDef HierarchyExporter::Graph(size_t node_budget) {
+  std::vector<HierarchyNode> nodes;
+  std::vector<string> names;
+  for (int level = NumLevels() - 1; level >= 0; --level) {
+    const size_t num_nodes = levels_[level].parent.size();
+    for (NodeId node_id = 0; node_id < num_nodes; ++node_id) {
+      if (!HasParent({level, node_id})) {
+        nodes.emplace_back(level, node_id);
+        names.push_back(Segment(level, node_id));
+      }
+    }
+  }
+  return Export(nodes, names, node_budget, NumLevels() - 1);
+}
+
+util::Status HierarchyExporter::Expand(const string& name, size_t node_budget,
+                                       ge::GraphDef* graph) {
+  const util::Status invalid_name(Code::INVALID_ARGUMENT,
+                                  util::StrCat(kInvalidMetanodeErr, name));
+  // Each segment must name a node that is in the metanode named by the
+  // previous segment, and the first segment a node at the top.
+  bool is_first = true;
+  HierarchyNode node;
+  for (const string& segment : util::SplitToVector(name, '/')) {
+    const size_t separator = segment.find('_');
+    size_t level;
+    size_t node_id;
+    if (separator == string::npos ||
+        !ParseNumber(segment.substr(0, separator), &level) ||
+        !ParseNumber(segment.substr(separator + 1), &node_id) ||
+        level >= levels_.size() || node_id >= levels_[level].parent.size()) {
+      return invalid_name;
+    }
+    HierarchyNode next(level, node_id);
+    if (is_first ? HasParent(next)
+                 : (level + 1 != static_cast<size_t>(node.first) ||
+                    levels_[level].parent[node_id] != node.second)) {
+      return invalid_name;
+    }
+    node = next;
+    is_first = false;
+  }
+  if (is_first || Children(node).empty()) {
+    return invalid_name;
+  }
+  std::vector<HierarchyNode> nodes;
+  std::vector<string> names;
+  for (NodeId child : Children(node)) {
+    nodes.emplace_back(node.first - 1, child);
+    names.push_back(util::StrCat(name, "/", Segment(node.first - 1, child)));
+  }
+  *graph = Export(nodes, names, node_budget, node.first);
+  return util::Status::OK;
+}
+
+const std::vector<NodeId>& HierarchyExporter::Children(
+    const HierarchyNode& node) const {
+  static const std::vector<NodeId>* const kNoChildren =
+      new std::vector<NodeId>();
+  return node.first == 0 ? *kNoChildren
+                         : levels_[node.first].children[node.second];
+}
+
+bool HierarchyExporter::HasParent(const HierarchyNode& node) const {
+  return levels_[node.first].parent[node.second] != kNoParent;
+}
+
+string HierarchyExporter::Name(const HierarchyNode& node) const {
+  std::vector<string> segments;
+  HierarchyNode current = node;
+  segments.push_back(Segment(current.first, current.second));
+  while (HasParent(current)) {
+    current = {current.first + 1,
+               levels_[current.first].parent[current.second]};
+    segments.push_back(Segment(current.first, current.second));
+  }
+  std::reverse(segments.begin(), segments.end());
+  return boost::algorithm::join(segments, "/");
+}
+
+// The nodes of the export are found breadth first. The nodes that are not
+// expanded are the units between which edges are drawn: each node of level 0
+// is represented by the unexpanded node that contains it, or, if it is not in
+// the export, by the node that contains it at 'max_level'.
+ge::GraphDef HierarchyExporter::Export(const std::vector<HierarchyNode>& nodes,
+                                       const std::vector<string>& names,
+                                       size_t node_budget, int max_level) {
+  std::vector<HierarchyNode> exported = nodes;
+  std::vector<string> exported_names = names;
+  std::vector<bool> is_expanded;
+  bool is_full = false;
+  for (size_t i = 0; i < exported.size(); ++i) {
+    const std::vector<NodeId>& children = Children(exported[i]);
+    is_full = is_full || (!children.empty() &&
+                          exported.size() + children.size() > node_budget);
+    is_expanded.push_back(!children.empty() && !is_full);
+    if (!is_expanded.back()) {
+      continue;
+    }
+    const int child_level = exported[i].first - 1;
+    for (NodeId child : children) {
+      exported.emplace_back(child_level, child);
+      exported_names.push_back(util::StrCat(exported_names[i], "/",
+                                            Segment(child_level, child)));
+    }
+  }
+
+  // The representative of each node of level 0, as an index into
+  // 'exported_names', and the level 0 nodes of each unexpanded node.
+  const LabeledGraph& graph = *levels_[0].graph;
+  std::vector<size_t> representative(graph.NumNodes(), kNoRepresentative);
+  std::vector<std::vector<NodeId>> members(exported.size());
+  for (size_t i = 0; i < exported.size(); ++i) {
+    if (is_expanded[i]) {
+      continue;
+    }
+    std::vector<HierarchyNode> stack = {exported[i]};
+    while (!stack.empty()) {
+      HierarchyNode node = stack.back();
+      stack.pop_back();
+      if (node.first == 0) {
+        representative[node.second] = i;
+        members[i].push_back(node.second);
+        continue;
+      }
+      for (NodeId child : Children(node)) {
+        stack.emplace_back(node.first - 1, child);
+      }
+    }
+  }
+  std::map<HierarchyNode, size_t> outside_representatives;
+  auto find_representative = [&](NodeId node_id) {
+    if (representative[node_id] != kNoRepresentative) {
+      return representative[node_id];
+    }
+    HierarchyNode node(0, node_id);
+    while (node.first < max_level && HasParent(node)) {
+      node = {node.first + 1, levels_[node.first].parent[node.second]};
+    }
+    auto inserted = outside_representatives.insert(
+        {node, exported_names.size()});
+    if (inserted.second) {
+      exported_names.push_back(Name(node));
+    }
+    return representative[node_id] = inserted.first->second;
+  };
+
+  ge::GraphDef vis_graph;
+  std::vector<size_t> inputs;
+  for (size_t i = 0; i < exported.size(); ++i) {
+    const HierarchyNode& node = exported[i];
+    ge::Node* vis_node = vis_graph.add_node();
+    vis_node->set_name(exported_names[i]);
+    const TaggedAST& label = levels_[node.first].graph->GetNodeLabel(node.second);
+    auto& node_attr = *vis_node->mutable_node_attr();
+    node_attr["label"] = node_label_(label.tag(), label.ast());
+    node_attr["op"] = "op";
+    if (!Children(node).empty()) {
+      node_attr["isMetanode"] = "true";
+    }
+    inputs.clear();
+    for (NodeId member : members[i]) {
+      for (auto edge_it = graph.InEdgeBegin(member);
+           edge_it != graph.InEdgeEnd(member); ++edge_it) {
+        size_t input = find_representative(graph.Source(*edge_it));
+        if (input != i) {
+          inputs.push_back(input);
+        }
+      }
+    }
+    std::sort(inputs.begin(), inputs.end());
+    inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+    for (size_t input : inputs) {
+      vis_node->add_edge()->set_input(exported_names[input]);
+    }
+  }
+  return vis_graph;
+}
+
+}  // namespace viz
+}  // namespace morphie
@@ -0,0 +1,128 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+
+// This file contains an exporter that represents a graph and a series of
+// summaries of it as a hierarchical graph for GraphExplorer. A summary is a
+// graph obtained from the previous level by a transformation that maps nodes to
+// nodes, such as a quotient. Each node of a summary becomes a metanode that
+// contains the nodes that map to it, which may be metanodes in turn.
+//
+// Large graphs are exported incrementally. The initial export contains the
+// nodes of the most summarized level and the contents of metanodes, level by
+// level, as long as the number of nodes stays within a budget. The contents of
+// a metanode that was not expanded can be exported later on demand.
+//
+// Example. Exporting a graph and its quotient.
+//   std::map<NodeId, NodeId> node_map;
+//   std::unique_ptr<LabeledGraph> quotient =
+//       graph::QuotientGraph(graph, partition, config, &node_map);
+//   HierarchyExporter exporter(graph);
+//   util::Status status = exporter.AddLevel(*quotient, node_map);
+//   ge::GraphDef top_level = exporter.Graph(1000);
+//   // When the viewer expands the metanode named 'name':
+//   ge::GraphDef contents;
+//   status = exporter.Expand(name, 1000, &contents);
+#ifndef LOGLE_HIERARCHY_EXPORTER_H_
+#define LOGLE_HIERARCHY_EXPORTER_H_
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/string.h"
+#include "graph/graph_exporter.h"
+#include "graph/labeled_graph.h"
+#include "graph/morphism.h"
+#include "graph_explorer.pb.h"
+#include "util/status.h"
+
+namespace morphie {
+namespace viz {
+
+// The levels of the hierarchy are numbered from 0, which is the graph passed to
+// the constructor, and each call to AddLevel adds a level above the previous
+// ones. The name of a node in an exported graph is the path of the node from
+// the top of the hierarchy, with one segment "<level>_<id>" for each node on
+// the path, so the name "2_0/1_4/0_17" refers to node 17 of the graph, which is
+// in the metanode for node 4 of level 1, which in turn is in the metanode for
+// node 0 of level 2. A node that no node of the next level maps to is at the
+// top of the hierarchy.
+//
+// An exported node has a label generated by the label function and the
+// attribute "op". A metanode also has the attribute "isMetanode". The nodes
+// that are not expanded in an export have an input for each node of the export
+// that is connected to them by an edge of the level 0 graph. The graphs must
+// outlive the exporter and must not be modified while they are exported.
+class HierarchyExporter {
+ public:
+  // This constructor uses GraphExporter::TextLabel to label nodes.
+  explicit HierarchyExporter(const LabeledGraph& graph);
+  HierarchyExporter(const LabeledGraph& graph, const LabelFn& node_label);
+
+  // Adds 'summary' as a level above the current top level. Returns
+  //  - INVALID_ARGUMENT if 'node_map' has a key that is not a node of the
+  //    current top level or a value that is not a node of 'summary'.
+  //  - OK otherwise.
+  util::Status AddLevel(const LabeledGraph& summary,
+                        const std::map<NodeId, NodeId>& node_map);
+  // Adds the output graph of 'morphism' as a level. Returns INVALID_ARGUMENT if
+  // the input graph of 'morphism' is not the current top level.
+  util::Status AddLevel(const graph::Morphism& morphism);
+
+  int NumLevels() const { return levels_.size(); }
+
+  // Returns the nodes at the top of the hierarchy and expands metanodes, level
+  // by level and in the order of their identifiers, until the next metanode
+  // would take the number of nodes over 'node_budget'. The top nodes are
+  // always exported.
+  ge::GraphDef Graph(size_t node_budget);
+
+  // Exports the contents of the metanode 'name', expanded within 'node_budget'
+  // as Graph does, to 'graph'. The names are in the namespace of the metanode.
+  // An edge from a node outside the metanode is an input named after the node
+  // at the level of the metanode that contains the source of the edge. Returns
+  // INVALID_ARGUMENT if 'name' is not the name of a metanode.
+  util::Status Expand(const string& name, size_t node_budget,
+                      ge::GraphDef* graph);
+
+ private:
+  // A node of the hierarchy is a level and a node of the graph at that level.
+  using HierarchyNode = std::pair<int, NodeId>;
+
+  struct Level {
+    const LabeledGraph* graph;
+    // The node of the next level that each node maps to, if any.
+    std::vector<NodeId> parent;
+    // The nodes of the previous level that map to each node, in order.
+    std::vector<std::vector<NodeId>> children;
+  };
+
+  const std::vector<NodeId>& Children(const HierarchyNode& node) const;
+  bool HasParent(const HierarchyNode& node) const;
+  // Returns the name of 'node' in the exported graphs.
+  string Name(const HierarchyNode& node) const;
+  // Exports 'nodes', named 'names', and their contents within 'node_budget'.
+  ge::GraphDef Export(const std::vector<HierarchyNode>& nodes,
+                      const std::vector<string>& names, size_t node_budget,
+                      int max_level);
+
+  LabelFn node_label_;
+  std::vector<Level> levels_;
+};  // class HierarchyExporter
+
+}  // namespace viz
+}  // namespace morphie
+#endif  // LOGLE_HIERARCHY_EXPORTER_H_
@@ -0,0 +1,152 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/hierarchy_exporter.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "graph/graph_transformer.h"
+#include "graph/test_graphs.h"
+#include "gtest.h"
+
+namespace morphie {
+namespace viz {
+namespace {
+
+// The test hierarchy has a cycle of six nodes at level 0. At level 1, the
+// nodes are merged in pairs. At level 2, the first two pairs are merged and
+// the third pair is at the top of the hierarchy.
+class HierarchyExporterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(graph_.Initialize().ok());
+    ASSERT_TRUE(pairs_.Initialize().ok());
+    ASSERT_TRUE(top_.Initialize().ok());
+    for (int i = 0; i < 6; ++i) {
+      graph_.AddNode(i);
+    }
+    for (int i = 0; i < 6; ++i) {
+      graph_.AddEdge(i, (i + 1) % 6, 0);
+    }
+    for (int i = 0; i < 3; ++i) {
+      pairs_.AddNode(10 + i);
+    }
+    top_.AddNode(20);
+    exporter_.reset(new HierarchyExporter(*graph_.GetGraph()));
+    ASSERT_TRUE(exporter_
+                    ->AddLevel(*pairs_.GetGraph(),
+                               {{0, 0}, {1, 0}, {2, 1}, {3, 1}, {4, 2}, {5, 2}})
+                    .ok());
+    ASSERT_TRUE(exporter_->AddLevel(*top_.GetGraph(), {{0, 0}, {1, 0}}).ok());
+  }
+
+  test::WeightedGraph graph_;
+  test::WeightedGraph pairs_;
+  test::WeightedGraph top_;
+  std::unique_ptr<HierarchyExporter> exporter_;
+};
+
+// Returns the map from the names of the nodes in 'graph' to their inputs.
+std::map<string, std::vector<string>> GetInputs(const ge::GraphDef& graph) {
+  std::map<string, std::vector<string>> inputs;
+  for (const ge::Node& node : graph.node()) {
+    std::vector<string>& node_inputs = inputs[node.name()];
+    for (const ge::Edge& edge : node.edge()) {
+      node_inputs.push_back(edge.input());
+    }
+  }
+  return inputs;
+}
+
+TEST_F(HierarchyExporterTest, ExportsTopLevelWithinBudget) {
+  EXPECT_EQ(3, exporter_->NumLevels());
+  ge::GraphDef graph = exporter_->Graph(2);
+  std::map<string, std::vector<string>> expected = {{"2_0", {"1_2"}},
+                                                    {"1_2", {"2_0"}}};
+  EXPECT_EQ(expected, GetInputs(graph));
+  EXPECT_EQ("Node-Weight/20", graph.node(0).node_attr().at("label"));
+  EXPECT_EQ("true", graph.node(0).node_attr().at("isMetanode"));
+
+  // The metanode 2_0 fits within the budget, but then 1_2 does not.
+  graph = exporter_->Graph(4);
+  expected = {{"2_0", {}},
+              {"1_2", {"2_0/1_1"}},
+              {"2_0/1_0", {"1_2"}},
+              {"2_0/1_1", {"2_0/1_0"}}};
+  EXPECT_EQ(expected, GetInputs(graph));
+}
+
+TEST_F(HierarchyExporterTest, ExportsWholeHierarchy) {
+  ge::GraphDef graph = exporter_->Graph(100);
+  std::map<string, std::vector<string>> expected = {
+      {"2_0", {}},
+      {"1_2", {}},
+      {"2_0/1_0", {}},
+      {"2_0/1_1", {}},
+      {"1_2/0_4", {"2_0/1_1/0_3"}},
+      {"1_2/0_5", {"1_2/0_4"}},
+      {"2_0/1_0/0_0", {"1_2/0_5"}},
+      {"2_0/1_0/0_1", {"2_0/1_0/0_0"}},
+      {"2_0/1_1/0_2", {"2_0/1_0/0_1"}},
+      {"2_0/1_1/0_3", {"2_0/1_1/0_2"}}};
+  EXPECT_EQ(expected, GetInputs(graph));
+  EXPECT_EQ(0, graph.node(4).node_attr().count("isMetanode"));
+}
+
+TEST_F(HierarchyExporterTest, ExpandsMetanodes) {
+  ge::GraphDef graph;
+  ASSERT_TRUE(exporter_->Expand("2_0", 2, &graph).ok());
+  std::map<string, std::vector<string>> expected = {
+      {"2_0/1_0", {"1_2"}}, {"2_0/1_1", {"2_0/1_0"}}};
+  EXPECT_EQ(expected, GetInputs(graph));
+
+  ASSERT_TRUE(exporter_->Expand("2_0/1_1", 1, &graph).ok());
+  expected = {{"2_0/1_1/0_2", {"2_0/1_0"}},
+              {"2_0/1_1/0_3", {"2_0/1_1/0_2"}}};
+  EXPECT_EQ(expected, GetInputs(graph));
+
+  for (const char* name :
+       {"", "1_0", "2_0/0_1", "2_0/1_2", "2_0/1_0/0_0", "2_0/", "x", "3_0"}) {
+    EXPECT_FALSE(exporter_->Expand(name, 10, &graph).ok()) << name;
+  }
+}
+
+TEST_F(HierarchyExporterTest, RejectsInvalidNodeMaps) {
+  HierarchyExporter exporter(*graph_.GetGraph());
+  EXPECT_FALSE(exporter.AddLevel(*pairs_.GetGraph(), {{6, 0}}).ok());
+  EXPECT_FALSE(exporter.AddLevel(*pairs_.GetGraph(), {{0, 3}}).ok());
+  EXPECT_EQ(1, exporter.NumLevels());
+}
+
+// A node that is deleted by a transformation stays at the top of the
+// hierarchy.
+TEST_F(HierarchyExporterTest, AddsMorphismLevels) {
+  std::unique_ptr<graph::Morphism> morphism =
+      graph::DeleteNodes(*graph_.GetGraph(), {5});
+  HierarchyExporter exporter(*graph_.GetGraph());
+  EXPECT_TRUE(exporter.AddLevel(*morphism).ok());
+  // The input of the morphism is no longer the top level.
+  EXPECT_FALSE(exporter.AddLevel(*morphism).ok());
+  EXPECT_EQ(2, exporter.NumLevels());
+  ge::GraphDef graph = exporter.Graph(100);
+  ASSERT_EQ(11, graph.node_size());
+  EXPECT_EQ("0_5", graph.node(5).name());
+  EXPECT_EQ("1_0/0_0", graph.node(6).name());
+}
+
+}  // namespace
+}  // namespace viz
+}  // namespace morphie
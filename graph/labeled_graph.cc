@@ -30,28 +30,21 @@
 
 namespace morphie {
 
+using ast::type::TypeRegistry;
 using ast::type::Types;
 namespace type = ast::type;
 
 namespace {
-const char* const kNullStr = "null";
 const char* const kInitializationErr = "The graph is not initialized.";
 const char* const kInvalidNodeErr = "Invalid node id.";
 const char* const kInvalidEdgeErr = "Invalid edge id.";
 const char* const kInvalidIndexTagErr = "There is no index for labels tagged ";
 
-// If a tagged AST has an AST field, return the serialization of the field.
-// Otherwise, return the string "null". TaggedAST objects with different tags
-// but with no AST field will return the same label string.
-//
-// Note: If ASTs are serialized in a loop, the MessageLite::SerializeAsString
-// documentation recommends using MessageLite::SerializeToString(..) with an
-// output string argument to reduce heap fragmentation.
-static string GetSerializationOrNull(const TaggedAST& ast) {
-  if (ast.has_ast()) {
-    return ast.ast().SerializeAsString();
-  }
-  return kNullStr;
+// Returns the index key of a label, which is the flat encoding of its AST
+// field. A TaggedAST with no AST field has the null AST as key, so TaggedAST
+// objects with different tags but with no AST field have the same key.
+ast::FlatAST GetKey(const TaggedAST& label) {
+  return ast::FlatAST(label.ast());
 }
 
 // Retrieve the type corresponding to a tag in a Types map.
@@ -68,7 +61,7 @@ std::pair<bool, AST> GetTaggedType(const string& tag, const Types& types) {
 // Add a label and identifier to an index. The identifier may be either a node
 // or an edge id and the index must have the corresponding type.
 template <typename ObjectId>
-util::Status IndexObject(const TaggedAST& label, ObjectId id,
+util::Status IndexObject(const ast::FlatTaggedAST& label, ObjectId id,
                          Indexes<std::set<ObjectId>>* indexes) {
   auto index_it = indexes->find(label.tag());
   if (index_it == indexes->end()) {
@@ -76,49 +69,64 @@ util::Status IndexObject(const TaggedAST& label, ObjectId id,
                         util::StrCat(kInvalidIndexTagErr, label.tag(), "."));
   }
   Index<std::set<ObjectId>>& index = index_it->second;
-  index[GetSerializationOrNull(label)].insert(id);
+  index[label.ast()].insert(id);
   return util::Status::OK;
 }
 
-// Remove the object 'id' from the index of 'label'. The object may be a node or
-// an edge and 'label' must be of non-unique type.
+// Remove the object 'id' from the index entry 'name' of labels tagged 'tag'.
+// The object may be a node or an edge and the tag must be of non-unique type.
+// An entry without objects is removed, so that an index does not accumulate
+// entries for labels that have been updated.
 template <typename ObjectId>
-void DeIndexObject(const TaggedAST& label, ObjectId id,
+void DeIndexObject(const string& tag, const ast::FlatAST& name, ObjectId id,
                    Indexes<std::set<ObjectId>>* indexes) {
-  auto index_it = indexes->find(label.tag());
+  auto index_it = indexes->find(tag);
   Index<std::set<ObjectId>>& index = index_it->second;
-  index[GetSerializationOrNull(label)].erase(id);
+  auto name_it = index.find(name);
+  if (name_it == index.end()) {
+    return;
+  }
+  name_it->second.erase(id);
+  if (name_it->second.empty()) {
+    index.erase(name_it);
+  }
+}
+
+template <typename ObjectId>
+void DeIndexObject(const ast::FlatTaggedAST& label, ObjectId id,
+                   Indexes<std::set<ObjectId>>* indexes) {
+  DeIndexObject(label.tag(), label.ast(), id, indexes);
 }
 
 // The functions below extend the index of unique nodes or edges with a new
 // label, or remove a specific node or edge from a unique index. Unlike the
 // situation for non-unique indexes, separate functions are used for
 // manipulating unique node and edge indexes. This is because a unique node
-// index uses a serialized label as a key while a unique edge index uses a
-// triple of a source and target node and a serialized edge label as a key.
-util::Status IndexUniqueNode(const TaggedAST& label, NodeId node_id,
+// index uses a flat label as a key while a unique edge index uses a triple of
+// a source and target node and a flat edge label as a key.
+util::Status IndexUniqueNode(const ast::FlatTaggedAST& label, NodeId node_id,
                              Indexes<NodeId>* named_nodes) {
   auto index_it = named_nodes->find(label.tag());
   Index<NodeId>& named_node = index_it->second;
-  string name = GetSerializationOrNull(label);
+  const ast::FlatAST& name = label.ast();
   auto name_it = named_node.find(name);
   if (name_it != named_node.end()) {
     return util::Status(
         Code::INVALID_ARGUMENT,
         util::StrCat("A node with label ",
-                     ast::ToString(label, ast::PrintOption::kValue),
+                     ast::ToString(label.ToTaggedAST(),
+                                   ast::PrintOption::kValue),
                      " already exists."));
   }
   named_node.insert({name, node_id});
   return util::Status::OK;
 }
 
-void DeIndexUniqueNode(const TaggedAST& label, NodeId node_id,
+void DeIndexUniqueNode(const ast::FlatTaggedAST& label, NodeId node_id,
                        Indexes<NodeId>* named_nodes) {
   auto index_it = named_nodes->find(label.tag());
   Index<NodeId>& named_node = index_it->second;
-  string name = GetSerializationOrNull(label);
-  auto name_it = named_node.find(name);
+  auto name_it = named_node.find(label.ast());
   if (name_it == named_node.end()) {
     return;
   }
@@ -151,7 +159,7 @@ void DeIndexUniqueEdge(const string& tag, const Edge& edge,
 
 // Retrieve a set of identifiers from an index given a label. Returns the empty
 // set either if no index exists for label.tag(), or if an index exists but does
-// not contain the serialization of label.ast() as a key.
+// not contain the flat encoding of label.ast() as a key.
 template <typename ObjectId>
 std::set<ObjectId> GetLabeledObjects(
     const TaggedAST& label, const Indexes<std::set<ObjectId>>& indexes) {
@@ -159,7 +167,7 @@ std::set<ObjectId> GetLabeledObjects(
   if (index_it == indexes.end()) {
     return {};
   }
-  const auto label_it = index_it->second.find(GetSerializationOrNull(label));
+  const auto label_it = index_it->second.find(GetKey(label));
   if (label_it == index_it->second.end()) {
     return {};
   }
@@ -168,118 +176,113 @@ std::set<ObjectId> GetLabeledObjects(
 
 }  // namespace
 
-// Initialization creates indexes for each type of node and edge label. First,
-// check if the contents of the maps 'node_types' and 'edge_types' are types.
-// Then, create an empty index for each key value in 'node_types' and
-// 'edge_types'. For non-unique label types, the index maps strings to sets of
-// node or edge ids, and for unique label types, the index maps a string to a
-// single node or edge id.
+// The types are checked when the registry is created.
 util::Status LabeledGraph::Initialize(Types node_types,
                                       const std::set<string>& unique_nodes,
                                       Types edge_types,
                                       const std::set<string>& unique_edges,
                                       AST graph_type) {
-  string tmp_err;
-  if (!type::AreTypes(node_types, &tmp_err)) {
-    return util::Status(Code::INVALID_ARGUMENT,
-                        util::StrCat("Type error in node_types:", tmp_err));
-  }
-  if (!type::AreTypes(edge_types, &tmp_err)) {
-    return util::Status(Code::INVALID_ARGUMENT,
-                        util::StrCat("Type error in edge_types:", tmp_err));
-  }
-  if (!type::IsType(graph_type, &tmp_err)) {
-    return util::Status(Code::INVALID_ARGUMENT,
-                        util::StrCat("Type error in graph_type:", tmp_err));
-  }
-  node_types_.swap(node_types);
-  edge_types_.swap(edge_types);
-  graph_type_.Swap(&graph_type);
-  for (const string& tag : unique_nodes) {
+  std::shared_ptr<const TypeRegistry> types;
+  util::Status status = TypeRegistry::Create(
+      std::move(node_types), unique_nodes, std::move(edge_types), unique_edges,
+      std::move(graph_type), &types);
+  if (!status.ok()) {
+    return status;
+  }
+  return Initialize(std::move(types));
+}
+
+// Initialization creates an empty index for each type of node and edge label.
+// For non-unique label types, the index maps labels to sets of node or edge
+// ids, and for unique label types, the index maps a label to a single node or
+// edge id. The types themselves are shared with the registry, not copied.
+util::Status LabeledGraph::Initialize(
+    std::shared_ptr<const TypeRegistry> types) {
+  if (types == nullptr) {
+    return util::Status(Code::INVALID_ARGUMENT, "The type registry is null.");
+  }
+  types_ = std::move(types);
+  for (const string& tag : types_->unique_nodes()) {
     named_nodes_.insert({tag, Index<NodeId>()});
   }
-  for (const auto& type : node_types_) {
+  for (const auto& type : types_->node_types()) {
     node_indexes_.insert({type.first, Index<std::set<NodeId>>()});
   }
-  for (const string& tag : unique_edges) {
+  for (const string& tag : types_->unique_edges()) {
     named_edges_.insert({tag, EdgeIndex()});
   }
-  for (const auto& type : edge_types_) {
+  for (const auto& type : types_->edge_types()) {
     edge_indexes_.insert({type.first, Index<std::set<EdgeId>>()});
   }
   is_initialized_ = true;
   return util::Status::OK;
 }
 
-Types LabeledGraph::GetNodeTypes() const {
+const std::shared_ptr<const TypeRegistry>& LabeledGraph::GetTypeRegistry()
+    const {
   CHECK(is_initialized_, kInitializationErr);
-  return node_types_;
+  return types_;
 }
 
-std::set<string> LabeledGraph::GetUniqueNodeTags() const {
+const Types& LabeledGraph::GetNodeTypes() const {
   CHECK(is_initialized_, kInitializationErr);
-  std::set<string> tags;
-  // A 'tagged_index' is a pair consisting of a tag and an index.
-  for (const auto& tagged_index : named_nodes_) {
-    tags.insert(tagged_index.first);
-  }
-  return tags;
+  return types_->node_types();
+}
+
+const std::set<string>& LabeledGraph::GetUniqueNodeTags() const {
+  CHECK(is_initialized_, kInitializationErr);
+  return types_->unique_nodes();
 }
 
 std::pair<bool, AST> LabeledGraph::GetNodeType(const string& tag) const {
   CHECK(is_initialized_, kInitializationErr);
-  return GetTaggedType(tag, node_types_);
+  return GetTaggedType(tag, types_->node_types());
 }
 
-Types LabeledGraph::GetEdgeTypes() const {
+const Types& LabeledGraph::GetEdgeTypes() const {
   CHECK(is_initialized_, kInitializationErr);
-  return edge_types_;
+  return types_->edge_types();
 }
 
-std::set<string> LabeledGraph::GetUniqueEdgeTags() const {
+const std::set<string>& LabeledGraph::GetUniqueEdgeTags() const {
   CHECK(is_initialized_, kInitializationErr);
-  std::set<string> tags;
-  // A 'tagged_index' is a pair consisting of a tag and an index.
-  for (const auto& tagged_index : named_edges_) {
-    tags.insert(tagged_index.first);
-  }
-  return tags;
+  return types_->unique_edges();
 }
 
 std::pair<bool, AST> LabeledGraph::GetEdgeType(const string& tag) const {
   CHECK(is_initialized_, kInitializationErr);
-  return GetTaggedType(tag, edge_types_);
+  return GetTaggedType(tag, types_->edge_types());
 }
 
-AST LabeledGraph::GetGraphType() const {
+const AST& LabeledGraph::GetGraphType() const {
   CHECK(is_initialized_, kInitializationErr);
-  return graph_type_;
+  return types_->graph_type();
 }
 
 void LabeledGraph::SetGraphLabel(AST graph_label) {
   CHECK(is_initialized_, kInitializationErr);
   string tmp_err;
-  CHECK(type::IsTyped(graph_type_, graph_label, &tmp_err), tmp_err);
+  CHECK(type::IsTyped(types_->graph_type(), graph_label, &tmp_err), tmp_err);
   graph_label_.Swap(&graph_label);
 }
 
 NodeId LabeledGraph::FindOrAddNode(const TaggedAST& label) {
   CHECK(is_initialized_, kInitializationErr);
   string tmp_err;
-  CHECK(type::IsTyped(node_types_, label, &tmp_err), tmp_err);
+  CHECK(types_->IsTypedNode(label, &tmp_err), tmp_err);
+  ast::FlatTaggedAST flat_label(label);
   NodeId node_id;
   auto index_it = named_nodes_.find(label.tag());
   if (index_it == named_nodes_.end()) {
-    node_id = InsertNode(label);
-    IndexObject(label, node_id, &node_indexes_);
+    node_id = InsertNode(std::move(flat_label));
+    IndexObject(graph_[node_id], node_id, &node_indexes_);
     return node_id;
   }
-  string name = GetSerializationOrNull(label);
   Index<NodeId>& named_node = index_it->second;
-  auto name_it = named_node.find(name);
+  auto name_it = named_node.find(flat_label.ast());
   if (name_it == named_node.end()) {
-    node_id = InsertNode(label);
-    name_it = named_node.insert({name, node_id}).first;
+    name_it = named_node.insert({flat_label.ast(), 0}).first;
+    name_it->second = InsertNode(std::move(flat_label));
   }
   return name_it->second;
 }
@@ -288,24 +291,25 @@ util::Status LabeledGraph::UpdateNodeLabel(NodeId node_id,
                                            const TaggedAST& label) {
   CHECK(is_initialized_, kInitializationErr);
   string tmp_err;
-  if (!type::IsTyped(node_types_, label, &tmp_err)) {
+  if (!types_->IsTypedNode(label, &tmp_err)) {
     return util::Status(Code::INVALID_ARGUMENT, tmp_err);
   }
   if (!HasNode(node_id)) {
     return util::Status(Code::INVALID_ARGUMENT, kInvalidNodeErr);
   }
-  TaggedAST old_label = GetNodeLabel(node_id);
+  ast::FlatTaggedAST old_label = std::move(graph_[node_id]);
   // Update the label of the node and the relevant indexes.
-  graph_[node_id] = label;
-  if (IsUniqueNodeType(old_label)) {
+  graph_[node_id] = ast::FlatTaggedAST(label);
+  const ast::FlatTaggedAST& new_label = graph_[node_id];
+  if (named_nodes_.find(old_label.tag()) != named_nodes_.end()) {
     DeIndexUniqueNode(old_label, node_id, &named_nodes_);
   } else {
     DeIndexObject(old_label, node_id, &node_indexes_);
   }
   if (IsUniqueNodeType(label)) {
-    return IndexUniqueNode(label, node_id, &named_nodes_);
+    return IndexUniqueNode(new_label, node_id, &named_nodes_);
   } else {
-    return IndexObject(label, node_id, &node_indexes_);
+    return IndexObject(new_label, node_id, &node_indexes_);
   }
 }
 
@@ -313,21 +317,21 @@ EdgeId LabeledGraph::FindOrAddEdge(NodeId source, NodeId target,
                                    const TaggedAST& label) {
   CHECK(is_initialized_, kInitializationErr);
   string tmp_err;
-  CHECK(type::IsTyped(edge_types_, label, &tmp_err), tmp_err);
+  CHECK(types_->IsTypedEdge(label, &tmp_err), tmp_err);
+  ast::FlatTaggedAST flat_label(label);
   EdgeId edge_id;
   auto index_it = named_edges_.find(label.tag());
   if (index_it == named_edges_.end()) {
-    edge_id = InsertEdge(source, target, label);
-    IndexObject(label, edge_id, &edge_indexes_);
+    edge_id = InsertEdge(source, target, std::move(flat_label));
+    IndexObject(graph_[edge_id], edge_id, &edge_indexes_);
     return edge_id;
   }
   EdgeIndex& named_edge = index_it->second;
-  string name = GetSerializationOrNull(label);
-  Edge edge(source, target, name);
+  Edge edge(source, target, flat_label.ast());
   auto name_it = named_edge.find(edge);
   if (name_it == named_edge.end()) {
-    edge_id = InsertEdge(source, target, label);
-    name_it = named_edge.insert({Edge(source, target, name), edge_id}).first;
+    edge_id = InsertEdge(source, target, std::move(flat_label));
+    name_it = named_edge.insert({std::move(edge), edge_id}).first;
   }
   return name_it->second;
 }
@@ -336,30 +340,118 @@ util::Status LabeledGraph::UpdateEdgeLabel(EdgeId edge_id,
                                            const TaggedAST& label) {
   CHECK(is_initialized_, kInitializationErr);
   string tmp_err;
-  if (!type::IsTyped(edge_types_, label, &tmp_err)) {
+  if (!types_->IsTypedEdge(label, &tmp_err)) {
     return util::Status(Code::INVALID_ARGUMENT, tmp_err);
   }
   if (!HasEdge(edge_id)) {
     return util::Status(Code::INVALID_ARGUMENT, kInvalidEdgeErr);
   }
-  TaggedAST old_label = GetEdgeLabel(edge_id);
+  ast::FlatTaggedAST old_label = std::move(graph_[edge_id]);
   // Update the label of the edge and the relevant indexes.
-  graph_[edge_id] = label;
-  if (IsUniqueEdgeType(old_label)) {
-    string name = GetSerializationOrNull(old_label);
-    Edge edge(Source(edge_id), Target(edge_id), name);
+  graph_[edge_id] = ast::FlatTaggedAST(label);
+  const ast::FlatTaggedAST& new_label = graph_[edge_id];
+  if (named_edges_.find(old_label.tag()) != named_edges_.end()) {
+    Edge edge(Source(edge_id), Target(edge_id), old_label.ast());
     DeIndexUniqueEdge(old_label.tag(), edge, &named_edges_);
   } else {
     DeIndexObject(old_label, edge_id, &edge_indexes_);
   }
   if (IsUniqueEdgeType(label)) {
-    string name = GetSerializationOrNull(label);
-    Edge edge(Source(edge_id), Target(edge_id), name);
+    Edge edge(Source(edge_id), Target(edge_id), new_label.ast());
     return IndexUniqueEdge(label.tag(), edge, edge_id, &named_edges_);
   } else {
-    return IndexObject(label, edge_id, &edge_indexes_);
+    return IndexObject(new_label, edge_id, &edge_indexes_);
+  }
+}
+
+// The stored label is decoded, updated and encoded again. It is only replaced
+// if the update succeeds, so a failed update leaves the label unchanged.
+util::Status LabeledGraph::MutateEdgeLabel(
+    EdgeId edge_id, const std::function<void(TaggedAST*)>& update_fn) {
+  CHECK(is_initialized_, kInitializationErr);
+  ast::FlatTaggedAST& old_label = graph_[edge_id];
+  TaggedAST label = old_label.ToTaggedAST();
+  update_fn(&label);
+  const string& tag = old_label.tag();
+  string tmp_err;
+  if (label.tag() != tag) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "The tag of an edge label cannot be changed.");
+  }
+  if (!types_->IsTypedEdge(label, &tmp_err)) {
+    return util::Status(Code::INVALID_ARGUMENT, tmp_err);
+  }
+  ast::FlatTaggedAST new_label(label);
+  if (new_label.ast() != old_label.ast()) {
+    auto unique_it = named_edges_.find(tag);
+    if (unique_it == named_edges_.end()) {
+      DeIndexObject(tag, old_label.ast(), edge_id, &edge_indexes_);
+      edge_indexes_[tag][new_label.ast()].insert(edge_id);
+    } else {
+      EdgeIndex& named_edge = unique_it->second;
+      const NodeId source = ::boost::source(edge_id, graph_);
+      const NodeId target = ::boost::target(edge_id, graph_);
+      Edge edge(source, target, new_label.ast());
+      if (named_edge.find(edge) != named_edge.end()) {
+        return util::Status(Code::INVALID_ARGUMENT,
+                            "Unique edge label exists.");
+      }
+      named_edge.erase(Edge(source, target, old_label.ast()));
+      named_edge.insert({std::move(edge), edge_id});
+    }
+  }
+  old_label = std::move(new_label);
+  return util::Status::OK;
+}
+
+// The new value is written to a copy of the stored AST, which serves as the
+// new index key, so the index can be checked before the label is changed.
+util::Status LabeledGraph::MutateEdgeValue(
+    EdgeId edge_id, const std::function<void(int64_t*)>& update_fn) {
+  CHECK(is_initialized_, kInitializationErr);
+  ast::FlatTaggedAST& label = graph_[edge_id];
+  const ast::FlatNode root = label.ast().Root();
+  if (!root.HasValue() || !(root.IsInt() || root.IsTimestamp())) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "The edge label is not an integer or timestamp.");
+  }
+  const bool is_int = root.IsInt();
+  const int64_t old_value = is_int ? root.GetInt() : root.GetTimestamp();
+  int64_t new_value = old_value;
+  update_fn(&new_value);
+  if (new_value == old_value) {
+    return util::Status::OK;
+  }
+  ast::FlatAST new_ast = label.ast();
+  if (is_int) {
+    new_ast.SetInt(new_value);
+  } else {
+    new_ast.SetTimestamp(new_value);
+  }
+  const string& tag = label.tag();
+  auto unique_it = named_edges_.find(tag);
+  if (unique_it == named_edges_.end()) {
+    DeIndexObject(tag, label.ast(), edge_id, &edge_indexes_);
+    edge_indexes_[tag][std::move(new_ast)].insert(edge_id);
+  } else {
+    EdgeIndex& named_edge = unique_it->second;
+    const NodeId source = ::boost::source(edge_id, graph_);
+    const NodeId target = ::boost::target(edge_id, graph_);
+    Edge edge(source, target, new_ast);
+    if (named_edge.find(edge) != named_edge.end()) {
+      return util::Status(Code::INVALID_ARGUMENT, "Unique edge label exists.");
+    }
+    named_edge.erase(Edge(source, target, label.ast()));
+    named_edge.insert({std::move(edge), edge_id});
   }
+  if (is_int) {
+    label.mutable_ast()->SetInt(new_value);
+  } else {
+    label.mutable_ast()->SetTimestamp(new_value);
+  }
+  return util::Status::OK;
 }
+
 // In a Boost adjacency list graph that uses vectors internally (like the
 // LabeledGraph), node ids are unsigned values in the range [0, NumNodes() - 1],
 // where NumNodes() is the number of nodes in the graph.
@@ -386,12 +478,22 @@ bool LabeledGraph::HasEdge(EdgeId edge_id) const {
 // graph.
 // http://www.boost.org/doc/libs/1_37_0/libs/graph/doc/adjacency_list.html
 TaggedAST LabeledGraph::GetNodeLabel(NodeId node_id) const {
+  return GetFlatNodeLabel(node_id).ToTaggedAST();
+}
+
+TaggedAST LabeledGraph::GetEdgeLabel(EdgeId edge_id) const {
+  return GetFlatEdgeLabel(edge_id).ToTaggedAST();
+}
+
+const ast::FlatTaggedAST& LabeledGraph::GetFlatNodeLabel(
+    NodeId node_id) const {
   CHECK(is_initialized_, kInitializationErr);
   CHECK(HasNode(node_id), kInvalidNodeErr);
   return graph_[node_id];
 }
 
-TaggedAST LabeledGraph::GetEdgeLabel(EdgeId edge_id) const {
+const ast::FlatTaggedAST& LabeledGraph::GetFlatEdgeLabel(
+    EdgeId edge_id) const {
   CHECK(is_initialized_, kInitializationErr);
   CHECK(HasEdge(edge_id), kInvalidEdgeErr);
   return graph_[edge_id];
@@ -431,7 +533,7 @@ std::set<NodeId> LabeledGraph::GetNodes(const TaggedAST& label) const {
     return GetLabeledObjects(label, node_indexes_);
   }
   const Index<NodeId>& named_node = index_it->second;
-  const auto name_it = named_node.find(GetSerializationOrNull(label));
+  const auto name_it = named_node.find(GetKey(label));
   if (name_it == named_node.end()) {
     return {};
   }
@@ -445,7 +547,7 @@ std::set<EdgeId> LabeledGraph::GetEdges(const TaggedAST& label) const {
     return GetLabeledObjects(label, edge_indexes_);
   }
   const EdgeIndex& edge_index = index_it->second;
-  const string& name = GetSerializationOrNull(label);
+  const ast::FlatAST name = GetKey(label);
   std::set<EdgeId> edges;
   for (const auto& key_edge : edge_index) {
     if (key_edge.first.label == name) {
@@ -551,7 +653,7 @@ EdgeIterator LabeledGraph::EdgeSetEnd() const {
 
 int LabeledGraph::NumNodeTypes() const {
   CHECK(is_initialized_, kInitializationErr);
-  return node_types_.size();
+  return types_->node_types().size();
 }
 
 int LabeledGraph::NumUniqueNodeTypes() const {
@@ -571,7 +673,7 @@ int LabeledGraph::NumLabeledNodes(const TaggedAST& label) const {
 
 int LabeledGraph::NumEdgeTypes() const {
   CHECK(is_initialized_, kInitializationErr);
-  return edge_types_.size();
+  return types_->edge_types().size();
 }
 
 int LabeledGraph::NumUniqueEdgeTypes() const {
@@ -589,9 +691,9 @@ int LabeledGraph::NumLabeledEdges(const TaggedAST& label) const {
   return GetEdges(label).size();
 }
 
-NodeId LabeledGraph::InsertNode(TaggedAST label) {
+NodeId LabeledGraph::InsertNode(ast::FlatTaggedAST label) {
   NodeId node_id = ::boost::add_vertex(graph_);
-  graph_[node_id].Swap(&label);
+  graph_[node_id] = std::move(label);
   return node_id;
 }
 
@@ -600,9 +702,10 @@ NodeId LabeledGraph::InsertNode(TaggedAST label) {
 // whose value is relevant for graphs in which there can be at most one edge
 // between two vertices. Uniqueness in LabeledGraph depends on labels so the
 // bool value is ignored here.
-EdgeId LabeledGraph::InsertEdge(NodeId source, NodeId target, TaggedAST label) {
+EdgeId LabeledGraph::InsertEdge(NodeId source, NodeId target,
+                                ast::FlatTaggedAST label) {
   EdgeId edge_id = ::boost::add_edge(source, target, graph_).first;
-  graph_[edge_id].Swap(&label);
+  graph_[edge_id] = std::move(label);
   return edge_id;
 }
 
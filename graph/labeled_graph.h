@@ -51,13 +51,18 @@
 
 #include <boost/functional/hash/hash.hpp>
 #include <boost/graph/directed_graph.hpp>
+#include <functional>
+#include <memory>
 #include <set>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
 
 #include "base/string.h"
+#include "graph/ast.h"
+#include "graph/flat_ast.h"
 #include "graph/type_checker.h"
+#include "graph/type_registry.h"
 #include "ast.pb.h"
 #include "util/status.h"
 
@@ -69,26 +74,27 @@ using std::unordered_map;
 // The declaration below defines a Graph type using the Boost Graph Library. A
 // graph is represented as an adjacency_list. The set of nodes and set of edges
 // adjacent to a node are represented as std::vectors (boost::vecS). Node labels
-// and edge labels are TaggedASTs and the graph label is an AST.
+// and edge labels are stored in the flat encoding of graph/flat_ast.h, which
+// keeps each label in one buffer, and the graph label is an AST.
 using Graph = ::boost::adjacency_list<::boost::vecS, ::boost::vecS,
-                                      ::boost::bidirectionalS, TaggedAST,
-                                      TaggedAST, AST>;
+                                      ::boost::bidirectionalS,
+                                      ast::FlatTaggedAST, ast::FlatTaggedAST,
+                                      AST>;
 using NodeId = ::boost::graph_traits<Graph>::vertex_descriptor;
 using EdgeId = ::boost::graph_traits<Graph>::edge_descriptor;
-// An Edge consists of a source node, a target node and a string serialization
-// of the AST representing the edge label.
+// An Edge consists of a source node, a target node and the flat AST
+// representing the edge label.
 struct Edge {
-  Edge(NodeId src, NodeId tgt, const string& lbl)
+  Edge(NodeId src, NodeId tgt, const ast::FlatAST& lbl)
       : source(src), target(tgt), label(lbl) {}
 
   friend bool operator==(const Edge& a, const Edge& b) {
-    return std::tie(a.source, a.target, a.label) ==
-           std::tie(b.source, b.target, b.label);
+    return a.source == b.source && a.target == b.target && a.label == b.label;
   }
 
   NodeId source;
   NodeId target;
-  string label;
+  ast::FlatAST label;
 };
 // The hash function used by indexes that have edges as keys.
 struct EdgeHash {
@@ -97,7 +103,7 @@ struct EdgeHash {
     std::size_t seed = 0;
     boost::hash_combine(seed, edge.source);
     boost::hash_combine(seed, edge.target);
-    boost::hash_combine(seed, edge.label);
+    boost::hash_combine(seed, ast::FlatASTHash()(edge.label));
     return seed;
   }
 };
@@ -114,13 +120,14 @@ using OutEdgeIterator = ::boost::graph_traits<Graph>::out_edge_iterator;
 using OutEdgeRange = std::pair<OutEdgeIterator, OutEdgeIterator>;
 // A Graph object internally contains a map from nodes and edges to labels. An
 // index is a map from labels to sets of nodes or sets of edges. For nodes with
-// unique labels, the index maps labels to nodes. The key in an index is a
-// serialization of an AST proto.
+// unique labels, the index maps labels to nodes. The key in an index is the
+// flat encoding of the AST of a label, which is hashed and compared as a
+// single buffer.
 template <typename ObjectT>
-using Index = unordered_map<string, ObjectT>;
+using Index = unordered_map<ast::FlatAST, ObjectT, ast::FlatASTHash>;
 // There is one index for each type of node or edge label. A key in the Indexes
 // map is a string like "File" representing a tag in a TaggedAST. Importantly, a
-// key in Indexes, is not a serialization of a proto.
+// key in Indexes, is not an AST.
 template <typename ObjectT>
 using Indexes = unordered_map<string, Index<ObjectT>>;
 // The EdgeIndex below is used for unique edge labels. It is defined separately
@@ -182,22 +189,29 @@ class LabeledGraph {
                           const set<string>& unique_nodes,
                           ast::type::Types edge_types,
                           const set<string>& unique_edges, AST graph_type);
-  ast::type::Types GetNodeTypes() const;
+  // Initializes the graph with the types in 'types', which are shared with the
+  // registry and any other graph initialized with it, so the types are not
+  // copied. Returns INVALID_ARGUMENT if 'types' is null and OK otherwise.
+  util::Status Initialize(std::shared_ptr<const ast::type::TypeRegistry> types);
+  // Returns the registry holding the types of the graph. A graph of the same
+  // type can be created by initializing it with this registry.
+  const std::shared_ptr<const ast::type::TypeRegistry>& GetTypeRegistry() const;
+  const ast::type::Types& GetNodeTypes() const;
   // Returns the tags of node types that are unique.
-  set<string> GetUniqueNodeTags() const;
+  const set<string>& GetUniqueNodeTags() const;
   // Returns
   // - (true, type), if a node label of type 'type' tagged with 'tag' was
   //   declared when the graph was initialized.
   // - (false, AST()) otherwise, with the second element uninitialized.
   std::pair<bool, AST> GetNodeType(const string& tag) const;
-  ast::type::Types GetEdgeTypes() const;
+  const ast::type::Types& GetEdgeTypes() const;
   // Returns the tags of edge types that are unique.
-  set<string> GetUniqueEdgeTags() const;
+  const set<string>& GetUniqueEdgeTags() const;
   // Similar to GetNodeType(..) but for edge types.
   std::pair<bool, AST> GetEdgeType(const string& tag) const;
   // Returns an AST representing the graph type. Unlike node and edge types, a
   // graph type is an AST, not a TaggedAST.
-  AST GetGraphType() const;
+  const AST& GetGraphType() const;
   // - Crashes if graph_label does not respect the graph label type.
   void SetGraphLabel(AST graph_label);
   // Retrieves the id of a node with the given label. If label.tag() is not
@@ -219,8 +233,8 @@ class LabeledGraph {
   // A note on complexity: Adding a node with a non-unique label updates an
   // index from labels to sets of nodes. In the worst case, if all nodes have
   // the same label, this operation takes O(h + log(n)) time, where n is the
-  // number of graph nodes and h is the complexity of serializing and hashing
-  // 'label' to generate an index key.
+  // number of graph nodes and h is the complexity of hashing and comparing
+  // 'label', which is linear in the size of 'label'.
   NodeId FindOrAddNode(const TaggedAST& label);
   // Changes the label of 'node_id' to 'label'. Returns
   // - Code::INVALID_ARGUMENT if
@@ -246,6 +260,32 @@ class LabeledGraph {
   // See the comments for UpdateNodeLabel for a justification of these
   // restrictions.
   util::Status UpdateEdgeLabel(EdgeId edge_id, const TaggedAST& label);
+  // Changes the label of 'edge_id' by applying 'update_fn' to it. The stored
+  // label is decoded to a TaggedAST, type checked and encoded again after the
+  // update, which costs as much as UpdateEdgeLabel, but unlike UpdateEdgeLabel,
+  // the existence of 'edge_id' is not checked, which takes time linear in the
+  // number of edges leaving the source node. Returns
+  // - Code::INVALID_ARGUMENT if the updated label
+  //   - has a different tag, or
+  //   - is not of a valid label type, or
+  //   - is an existing, unique label in the graph.
+  //   The label is unchanged in these cases.
+  // - Requires that HasEdge(edge_id) is true.
+  util::Status MutateEdgeLabel(EdgeId edge_id,
+                               const std::function<void(TaggedAST*)>& update_fn);
+  // Changes the value of a label of 'edge_id' whose AST is an integer or a
+  // timestamp with a value by applying 'update_fn' to the value. This is the
+  // efficient way to repeatedly update a label, such as a counter. The value is
+  // changed in the stored label without decoding it and only the index entry
+  // of 'edge_id' is moved. The type of the label does not change, so the label
+  // is not type checked again. Returns
+  // - Code::INVALID_ARGUMENT if
+  //   - the AST of the label is not an integer or timestamp with a value, or
+  //   - the updated label is an existing, unique label in the graph.
+  //   The label is unchanged in these cases.
+  // - Requires that HasEdge(edge_id) is true.
+  util::Status MutateEdgeValue(EdgeId edge_id,
+                               const std::function<void(int64_t*)>& update_fn);
   // Returns true if there is a node with the given identifier in the graph.
   bool HasNode(NodeId node_id) const;
   // Returns true if there is an edge corresponding to a given identifier.  An
@@ -259,6 +299,11 @@ class LabeledGraph {
   // - Requires that HasEdge(edge_id) is true of the argument.
   // Edge ids obtained by querying this API are guaranteed to be valid.
   TaggedAST GetEdgeLabel(EdgeId edge_id) const;
+  // Return the stored labels of nodes and edges without converting them to
+  // TaggedAST protos, with the same requirements as the functions above. The
+  // references are invalidated when the graph is modified.
+  const ast::FlatTaggedAST& GetFlatNodeLabel(NodeId node_id) const;
+  const ast::FlatTaggedAST& GetFlatEdgeLabel(EdgeId edge_id) const;
   // An EdgeId contains a source and target NodeId and these two functions
   // retrieve those values.
   // - The functions require that HasEdge(edge_id) be true.
@@ -314,13 +359,11 @@ class LabeledGraph {
  private:
   // InsertNode(..) and InsertEdge(...) always modify the graph, unlike the
   // FindOrAdd functions, which might leave the graph unchanged.
-  NodeId InsertNode(TaggedAST label);
-  EdgeId InsertEdge(NodeId source, NodeId target, TaggedAST label);
+  NodeId InsertNode(ast::FlatTaggedAST label);
+  EdgeId InsertEdge(NodeId source, NodeId target, ast::FlatTaggedAST label);
 
   bool is_initialized_;
-  ast::type::Types node_types_;
-  ast::type::Types edge_types_;
-  AST graph_type_;
+  std::shared_ptr<const ast::type::TypeRegistry> types_;
   AST graph_label_;
   Graph graph_;
 
@@ -270,6 +270,31 @@ TEST_F(LabeledGraphTest, AcceptsNonEmptyNodeAndGraphTypes) {
   EXPECT_EQ(0, graph_.NumEdges());
 }
 
+// Graphs initialized with the same registry share their types but not their
+// nodes.
+TEST_F(LabeledGraphTest, SharesTypeRegistry) {
+  AST node_type = type::MakeInt("EventID", false);
+  Types node_types;
+  node_types.insert({"Event", node_type});
+  AST graph_type = type::MakeString("name", false);
+  ASSERT_TRUE(graph_
+                  .Initialize(node_types, {"Event"}, Types(),
+                              std::set<string>(), graph_type)
+                  .ok());
+  LabeledGraph other_graph;
+  EXPECT_FALSE(other_graph.Initialize(nullptr).ok());
+  ASSERT_TRUE(other_graph.Initialize(graph_.GetTypeRegistry()).ok());
+  EXPECT_EQ(graph_.GetTypeRegistry(), other_graph.GetTypeRegistry());
+  EXPECT_EQ(&graph_.GetNodeTypes(), &other_graph.GetNodeTypes());
+  EXPECT_EQ(1, other_graph.NumUniqueNodeTypes());
+  TaggedAST label;
+  label.set_tag("Event");
+  *label.mutable_ast() = value::MakeInt(1);
+  graph_.FindOrAddNode(label);
+  EXPECT_EQ(1, graph_.NumNodes());
+  EXPECT_EQ(0, other_graph.NumNodes());
+}
+
 // Initialize with a non-empty edge type.
 TEST_F(LabeledGraphTest, AcceptsNonEmptyEdgeAndGraphTypes) {
   AST edge_type = type::MakeBool("isDownload", false);
@@ -890,5 +915,75 @@ TEST_F(LabeledGraphTest, UniqueEdgeUpdateClash) {
   EXPECT_FALSE(graph_.UpdateEdgeLabel(edge2_id, freq1_label).ok());
 }
 
+// Labels of unique and non-unique type are changed in place and the indexes
+// follow the change. A change that would create a duplicate unique label or
+// change the tag is rejected and leaves the label as it was.
+TEST_F(LabeledGraphTest, MutateEdgeLabels) {
+  ASSERT_TRUE(Initialize(&graph_).ok());
+  NodeId event_id = graph_.FindOrAddNode(GetIntLabel("Event", 13));
+  NodeId file_id = graph_.FindOrAddNode(GetStringLabel("File", "bar.txt"));
+  EdgeId freq_edge =
+      graph_.FindOrAddEdge(event_id, file_id, GetIntLabel("Frequency", 1));
+  graph_.FindOrAddEdge(event_id, file_id, GetIntLabel("Frequency", 3));
+  auto increment = [](TaggedAST* label) {
+    PrimitiveValue* val = label->mutable_ast()->mutable_p_ast()->mutable_val();
+    val->set_int_val(val->int_val() + 1);
+  };
+  EXPECT_TRUE(graph_.MutateEdgeLabel(freq_edge, increment).ok());
+  EXPECT_EQ(0, graph_.GetEdges(GetIntLabel("Frequency", 1)).size());
+  std::set<EdgeId> edges = graph_.GetEdges(GetIntLabel("Frequency", 2));
+  ASSERT_EQ(1, edges.size());
+  EXPECT_EQ(freq_edge, *edges.begin());
+  // Frequency 3 already labels an edge between the same nodes.
+  EXPECT_FALSE(graph_.MutateEdgeLabel(freq_edge, increment).ok());
+  EXPECT_EQ(2, graph_.GetEdgeLabel(freq_edge).ast().p_ast().val().int_val());
+  EXPECT_EQ(1, graph_.GetEdges(GetIntLabel("Frequency", 2)).size());
+  EXPECT_FALSE(graph_.MutateEdgeLabel(freq_edge, [](TaggedAST* label) {
+                        label->set_tag("Relation");
+                      }).ok());
+  EXPECT_EQ("Frequency", graph_.GetEdgeLabel(freq_edge).tag());
+
+  EdgeId fork_edge = graph_.FindOrAddEdge(event_id, file_id,
+                                          GetStringLabel("Relation", "forks"));
+  EXPECT_TRUE(graph_.MutateEdgeLabel(fork_edge, [](TaggedAST* label) {
+                      label->mutable_ast()->mutable_p_ast()->mutable_val()
+                          ->set_string_val("child");
+                    }).ok());
+  EXPECT_EQ(0, graph_.GetEdges(GetStringLabel("Relation", "forks")).size());
+  EXPECT_EQ(1, graph_.GetEdges(GetStringLabel("Relation", "child")).size());
+}
+
+// Integer values are changed in the stored label and the indexes follow the
+// change. A value that would create a duplicate unique label is rejected, as
+// are labels that are not integers or timestamps.
+TEST_F(LabeledGraphTest, MutateEdgeValues) {
+  ASSERT_TRUE(Initialize(&graph_).ok());
+  NodeId event_id = graph_.FindOrAddNode(GetIntLabel("Event", 13));
+  NodeId file_id = graph_.FindOrAddNode(GetStringLabel("File", "bar.txt"));
+  EdgeId freq_edge =
+      graph_.FindOrAddEdge(event_id, file_id, GetIntLabel("Frequency", 1));
+  graph_.FindOrAddEdge(event_id, file_id, GetIntLabel("Frequency", 3));
+  auto increment = [](int64_t* val) { ++*val; };
+  EXPECT_TRUE(graph_.MutateEdgeValue(freq_edge, increment).ok());
+  EXPECT_EQ(0, graph_.GetEdges(GetIntLabel("Frequency", 1)).size());
+  std::set<EdgeId> edges = graph_.GetEdges(GetIntLabel("Frequency", 2));
+  ASSERT_EQ(1, edges.size());
+  EXPECT_EQ(freq_edge, *edges.begin());
+  EXPECT_EQ(2, graph_.GetFlatEdgeLabel(freq_edge).ast().Root().GetInt());
+  // Frequency 3 already labels an edge between the same nodes.
+  EXPECT_FALSE(graph_.MutateEdgeValue(freq_edge, increment).ok());
+  EXPECT_EQ(2, graph_.GetEdgeLabel(freq_edge).ast().p_ast().val().int_val());
+  EXPECT_EQ(1, graph_.GetEdges(GetIntLabel("Frequency", 2)).size());
+  EXPECT_TRUE(graph_.MutateEdgeValue(freq_edge, [](int64_t* val) {
+                      *val = 1000;
+                    }).ok());
+  EXPECT_EQ(1, graph_.GetEdges(GetIntLabel("Frequency", 1000)).size());
+
+  EdgeId fork_edge = graph_.FindOrAddEdge(event_id, file_id,
+                                          GetStringLabel("Relation", "forks"));
+  EXPECT_FALSE(graph_.MutateEdgeValue(fork_edge, increment).ok());
+  EXPECT_EQ(1, graph_.GetEdges(GetStringLabel("Relation", "forks")).size());
+}
+
 }  // namespace
 }  // namespace morphie
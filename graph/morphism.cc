@@ -14,10 +14,8 @@ std::unique_ptr<LabeledGraph> Morphism::TakeOutput() {
 
 void Morphism::CopyInputType() {
   output_graph_.reset(new LabeledGraph());
-  util::Status status = output_graph_->Initialize(
-      input_graph_.GetNodeTypes(), input_graph_.GetUniqueNodeTags(),
-      input_graph_.GetEdgeTypes(), input_graph_.GetUniqueEdgeTags(),
-      input_graph_.GetGraphType());
+  util::Status status =
+      output_graph_->Initialize(input_graph_.GetTypeRegistry());
   if (!status.ok()) {
     output_graph_.reset(nullptr);
   }
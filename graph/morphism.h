@@ -62,13 +62,17 @@ class Morphism {
   const LabeledGraph& Input() const { return input_graph_; }
   const LabeledGraph& Output() const { return *output_graph_; }
   LabeledGraph* MutableOutput() { return output_graph_.get(); }
+  // Returns the map from input nodes to the output nodes they map to.
+  const std::unordered_map<NodeId, NodeId>& NodeMap() const {
+    return node_map_;
+  }
   // Returns and gives up ownership of the output graph and clears the internal
   // maps between input and output nodes.
   std::unique_ptr<LabeledGraph> TakeOutput();
 
   // Creates a new output graph that has the same node and edge types as the
-  // input graph. An output graph that already exists will no longer be
-  // accessible.
+  // input graph, by sharing the type registry of the input graph. An output
+  // graph that already exists will no longer be accessible.
   void CopyInputType();
 
   // Returns the id of an output node with the same label as input_node. Adds a
@@ -14,6 +14,10 @@
 
 #include "graph/test_graphs.h"
 
+#include <random>
+#include <utility>
+#include <vector>
+
 #include "graph/dot_printer.h"
 #include "graph/type.h"
 #include "graph/value.h"
@@ -72,6 +76,22 @@ std::pair<bool, int> TraverseGraph(const LabeledGraph& graph, NodeId start) {
   return {false, visited_nodes.size()};
 }
 
+// Initializes 'graph' and adds nodes with the weights 0 to num_nodes - 1 to it.
+// Returns the identifiers of the nodes, which is empty if 'num_nodes' is not
+// positive or initialization fails.
+std::vector<NodeId> AddNodes(int num_nodes, WeightedGraph* graph) {
+  CHECK(graph != nullptr, "Pointer to graph is null");
+  std::vector<NodeId> nodes;
+  if (num_nodes < 1 || !graph->Initialize().ok()) {
+    return nodes;
+  }
+  nodes.reserve(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    nodes.push_back(graph->AddNode(i));
+  }
+  return nodes;
+}
+
 }  // namespace
 
 util::Status WeightedGraph::Initialize() {
@@ -157,6 +177,87 @@ void GetCycleGraph(int num_nodes, WeightedGraph* graph) {
   graph->AddEdge(*last_nodes.begin(), *first_nodes.begin(), num_nodes - 1);
 }
 
+// Random numbers are taken modulo the number of choices instead of using a
+// std::uniform_int_distribution, whose output differs between standard
+// libraries, so that graphs are the same on every platform.
+void GetRandomGraph(int num_nodes, int num_edges, uint64_t seed,
+                    WeightedGraph* graph) {
+  std::vector<NodeId> nodes = AddNodes(num_nodes, graph);
+  if (nodes.empty()) {
+    return;
+  }
+  std::mt19937_64 rng(seed);
+  for (int i = 0; i < num_edges; ++i) {
+    NodeId src = nodes[rng() % nodes.size()];
+    NodeId tgt = nodes[rng() % nodes.size()];
+    graph->AddEdge(src, tgt, i);
+  }
+}
+
+// The list 'endpoints' contains every node once and every target of an edge
+// once for each incoming edge, so a node sampled uniformly from 'endpoints' is
+// chosen with probability proportional to its in-degree plus one.
+void GetPowerLawGraph(int num_nodes, int out_degree, uint64_t seed,
+                      WeightedGraph* graph) {
+  std::vector<NodeId> nodes = AddNodes(num_nodes, graph);
+  if (nodes.empty()) {
+    return;
+  }
+  std::mt19937_64 rng(seed);
+  std::vector<NodeId> endpoints = {nodes[0]};
+  int num_edges = 0;
+  for (size_t j = 1; j < nodes.size(); ++j) {
+    const size_t num_endpoints = endpoints.size();
+    for (int k = 0; k < out_degree; ++k) {
+      NodeId tgt = endpoints[rng() % num_endpoints];
+      graph->AddEdge(nodes[j], tgt, num_edges++);
+      endpoints.push_back(tgt);
+    }
+    endpoints.push_back(nodes[j]);
+  }
+}
+
+void GetRandomDAG(int num_nodes, int num_edges, uint64_t seed,
+                  WeightedGraph* graph) {
+  std::vector<NodeId> nodes = AddNodes(num_nodes, graph);
+  if (nodes.size() < 2) {
+    return;
+  }
+  std::mt19937_64 rng(seed);
+  for (int i = 0; i < num_edges; ++i) {
+    size_t src = rng() % nodes.size();
+    size_t tgt = rng() % (nodes.size() - 1);
+    // Choose two distinct nodes and direct the edge from the lower weight.
+    if (tgt >= src) {
+      ++tgt;
+    } else {
+      std::swap(src, tgt);
+    }
+    graph->AddEdge(nodes[src], nodes[tgt], i);
+  }
+}
+
+void GetGridGraph(int num_rows, int num_columns, WeightedGraph* graph) {
+  if (num_rows < 1 || num_columns < 1) {
+    return;
+  }
+  std::vector<NodeId> nodes = AddNodes(num_rows * num_columns, graph);
+  if (nodes.empty()) {
+    return;
+  }
+  for (int r = 0; r < num_rows; ++r) {
+    for (int c = 0; c < num_columns; ++c) {
+      NodeId src = nodes[r * num_columns + c];
+      if (c + 1 < num_columns) {
+        graph->AddEdge(src, nodes[r * num_columns + c + 1], 0);
+      }
+      if (r + 1 < num_rows) {
+        graph->AddEdge(src, nodes[(r + 1) * num_columns + c], 1);
+      }
+    }
+  }
+}
+
 // A graph is a path if it satisfies the following:
 // - The graph has one fewer edges than nodes.
 // - There is a unique node with no predecessors (the start of the path)
@@ -17,6 +17,7 @@
 #ifndef LOGLE_TEST_GRAPHS_H_
 #define LOGLE_TEST_GRAPHS_H_
 
+#include <cstdint>
 #include <set>
 
 #include "base/string.h"
@@ -76,6 +77,37 @@ void GetPathGraph(int num_nodes, WeightedGraph* graph);
 // A cycle graph can be drawn as a simple cycle.
 void GetCycleGraph(int num_nodes, WeightedGraph* graph);
 
+// The following graphs are generated randomly, but each graph is determined by
+// the arguments, including the seed. A graph with k nodes has a node with
+// weight j for every j in [0, k-1], and the j-th edge added has weight j. These
+// graphs are meant for benchmarking graph algorithms at scale.
+
+// A random graph with 'num_nodes' nodes and 'num_edges' edges, each of which
+// has a source and target chosen uniformly at random. The graph may have
+// self-edges and multiple edges between two nodes.
+void GetRandomGraph(int num_nodes, int num_edges, uint64_t seed,
+                    WeightedGraph* graph);
+
+// A power-law graph with 'num_nodes' nodes, generated by preferential
+// attachment. Each node j after the first has 'out_degree' edges to nodes in
+// [0, j-1], which are chosen with probability proportional to their degree, so
+// that a few early nodes become hubs with many predecessors.
+void GetPowerLawGraph(int num_nodes, int out_degree, uint64_t seed,
+                      WeightedGraph* graph);
+
+// A random directed acyclic graph with 'num_nodes' nodes and 'num_edges' edges,
+// in which every edge j -> j' has j < j'.
+void GetRandomDAG(int num_nodes, int num_edges, uint64_t seed,
+                  WeightedGraph* graph);
+
+// A grid graph with 'num_rows' rows and 'num_columns' columns has
+//  - a node with weight r * num_columns + c for the node in row r and column c,
+//  - an edge with weight 0 from each node to the node to its right, if there
+//    is one, and
+//  - an edge with weight 1 from each node to the node below it, if there is
+//    one.
+void GetGridGraph(int num_rows, int num_columns, WeightedGraph* graph);
+
 // Returns true if 'graph' is a path graph.
 bool IsPath(const LabeledGraph& graph);
 
@@ -14,6 +14,10 @@
 
 #include "test_graphs.h"
 
+#include <algorithm>
+#include <set>
+#include <utility>
+
 #include "gtest.h"
 
 namespace morphie {
@@ -108,6 +112,87 @@ TEST(TestGraphsTest, IsCycleGraph) {
   EXPECT_FALSE(test::IsCycle(ten_path_graph));
 }
 
+// Returns the edges of 'graph' as (source weight, target weight) pairs.
+std::multiset<std::pair<int, int>> GetWeightPairs(const WeightedGraph& graph) {
+  const LabeledGraph& labeled_graph = *graph.GetGraph();
+  std::multiset<std::pair<int, int>> pairs;
+  for (auto edge_it = labeled_graph.EdgeSetBegin();
+       edge_it != labeled_graph.EdgeSetEnd(); ++edge_it) {
+    int src = labeled_graph.GetNodeLabel(labeled_graph.Source(*edge_it))
+                  .ast()
+                  .p_ast()
+                  .val()
+                  .int_val();
+    int tgt = labeled_graph.GetNodeLabel(labeled_graph.Target(*edge_it))
+                  .ast()
+                  .p_ast()
+                  .val()
+                  .int_val();
+    pairs.insert({src, tgt});
+  }
+  return pairs;
+}
+
+TEST(TestGraphsTest, CreatesRandomGraphs) {
+  WeightedGraph graph1, graph2, graph3;
+  test::GetRandomGraph(100, 400, 1, &graph1);
+  test::GetRandomGraph(100, 400, 1, &graph2);
+  test::GetRandomGraph(100, 400, 2, &graph3);
+  EXPECT_EQ(100, graph1.NumNodes());
+  EXPECT_EQ(400, graph1.NumEdges());
+  EXPECT_EQ(GetWeightPairs(graph1), GetWeightPairs(graph2));
+  EXPECT_NE(GetWeightPairs(graph1), GetWeightPairs(graph3));
+}
+
+TEST(TestGraphsTest, CreatesPowerLawGraphs) {
+  WeightedGraph graph;
+  test::GetPowerLawGraph(1000, 2, 1, &graph);
+  ASSERT_EQ(1000, graph.NumNodes());
+  ASSERT_EQ(2 * 999, graph.NumEdges());
+  const LabeledGraph& labeled_graph = *graph.GetGraph();
+  size_t max_in_degree = 0;
+  for (auto node_it = labeled_graph.NodeSetBegin();
+       node_it != labeled_graph.NodeSetEnd(); ++node_it) {
+    max_in_degree =
+        std::max(max_in_degree, labeled_graph.GetPredecessors(*node_it).size());
+  }
+  // Preferential attachment creates hubs, while the in-degrees of a random
+  // graph with the same number of edges rarely exceed 10.
+  EXPECT_LT(30, max_in_degree);
+  for (const auto& edge : GetWeightPairs(graph)) {
+    EXPECT_GT(edge.first, edge.second);
+  }
+}
+
+TEST(TestGraphsTest, CreatesDAGs) {
+  WeightedGraph graph;
+  test::GetRandomDAG(100, 400, 1, &graph);
+  EXPECT_EQ(100, graph.NumNodes());
+  EXPECT_EQ(400, graph.NumEdges());
+  for (const auto& edge : GetWeightPairs(graph)) {
+    EXPECT_LT(edge.first, edge.second);
+  }
+  WeightedGraph one_node;
+  test::GetRandomDAG(1, 10, 1, &one_node);
+  EXPECT_EQ(1, one_node.NumNodes());
+  EXPECT_EQ(0, one_node.NumEdges());
+}
+
+TEST(TestGraphsTest, CreatesGridGraphs) {
+  // The 2x3 grid {0 -> 1 -> 2, 3 -> 4 -> 5, 0 -> 3, 1 -> 4, 2 -> 5}.
+  WeightedGraph graph;
+  test::GetGridGraph(2, 3, &graph);
+  EXPECT_EQ(6, graph.NumNodes());
+  EXPECT_EQ(7, graph.NumEdges());
+  std::multiset<std::pair<int, int>> expected = {
+      {0, 1}, {1, 2}, {3, 4}, {4, 5}, {0, 3}, {1, 4}, {2, 5}};
+  EXPECT_EQ(expected, GetWeightPairs(graph));
+  // A grid with one row is a path.
+  WeightedGraph row;
+  test::GetGridGraph(1, 10, &row);
+  EXPECT_TRUE(test::IsPath(*row.GetGraph()));
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace morphie
@@ -308,6 +308,12 @@ bool IsTyped(const AST& type, const AST& val, string* err) {
   return IsTypedInternal(type, val, "", err);
 }
 
+bool IsTypedWithValidType(const AST& type, const AST& val, string* err) {
+  CHECK(err != nullptr, "");
+  err->clear();
+  return IsTypedInternal(type, val, "", err);
+}
+
 bool IsTyped(const Types& types, const TaggedAST& val, string* err) {
   CHECK(err != nullptr, "");
   err->clear();
@@ -112,6 +112,10 @@ string ToString(const Types& types);
   // a reason in '*err'.
   //   - Requires 'err' to be non-null.
 bool IsTyped(const AST& type, const AST& val, string* err);
+  // Same as the function above except that 'type' is not validated. Requires
+  // that 'type' is a type, for example because it was validated once when a
+  // TypeRegistry was created.
+bool IsTypedWithValidType(const AST& type, const AST& val, string* err);
   // Returns 'true' if the tag of 'val' exists in the map 'types' and if the AST
   // in 'val' is of the type associated with the tag. Returns 'false' otherwise
   // with a reason in '*err'.
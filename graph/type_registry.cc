@@ -0,0 +1,147 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/type_registry.h"
+
+#include "graph/value_checker.h"
+#include "util/logging.h"
+#include "util/string_utils.h"
+
+namespace morphie {
+namespace ast {
+namespace type {
+
+namespace {
+
+int GetTypeId(const string& tag, const std::unordered_map<string, int>& ids) {
+  const auto id_it = ids.find(tag);
+  return id_it == ids.end() ? TypeRegistry::kNoType : id_it->second;
+}
+
+}  // namespace
+
+const int TypeRegistry::kNoType;
+
+util::Status TypeRegistry::Create(
+    Types node_types, const std::set<string>& unique_nodes, Types edge_types,
+    const std::set<string>& unique_edges, AST graph_type,
+    std::shared_ptr<const TypeRegistry>* registry) {
+  string err;
+  if (!AreTypes(node_types, &err)) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        util::StrCat("Type error in node_types:", err));
+  }
+  if (!AreTypes(edge_types, &err)) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        util::StrCat("Type error in edge_types:", err));
+  }
+  if (!IsType(graph_type, &err)) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        util::StrCat("Type error in graph_type:", err));
+  }
+  std::shared_ptr<TypeRegistry> new_registry(new TypeRegistry());
+  new_registry->node_types_.swap(node_types);
+  new_registry->edge_types_.swap(edge_types);
+  new_registry->unique_nodes_ = unique_nodes;
+  new_registry->unique_edges_ = unique_edges;
+  new_registry->graph_type_.Swap(&graph_type);
+  for (const auto& tagged_type : new_registry->node_types_) {
+    new_registry->node_type_ids_[tagged_type.first] =
+        new_registry->Intern(tagged_type.second);
+  }
+  for (const auto& tagged_type : new_registry->edge_types_) {
+    new_registry->edge_type_ids_[tagged_type.first] =
+        new_registry->Intern(tagged_type.second);
+  }
+  *registry = std::move(new_registry);
+  return util::Status::OK;
+}
+
+int TypeRegistry::NodeTypeId(const string& tag) const {
+  return GetTypeId(tag, node_type_ids_);
+}
+
+int TypeRegistry::EdgeTypeId(const string& tag) const {
+  return GetTypeId(tag, edge_type_ids_);
+}
+
+const TypeInfo& TypeRegistry::GetTypeInfo(int type_id) const {
+  CHECK(type_id >= 0 && type_id < NumTypes(), "Invalid type id.");
+  return infos_[type_id];
+}
+
+bool TypeRegistry::IsTypedNode(const TaggedAST& label, string* err) const {
+  return IsTyped(NodeTypeId(label.tag()), node_types_, label, err);
+}
+
+bool TypeRegistry::IsTypedEdge(const TaggedAST& label, string* err) const {
+  return IsTyped(EdgeTypeId(label.tag()), edge_types_, label, err);
+}
+
+// Labels that match their TypeInfo at the root are accepted here. Any other
+// label is passed to type::IsTyped, which explains the failure, so the error
+// messages are those of the type checker.
+bool TypeRegistry::IsTyped(int type_id, const Types& types,
+                           const TaggedAST& label, string* err) const {
+  CHECK(err != nullptr, "");
+  if (type_id != kNoType) {
+    const TypeInfo& info = infos_[type_id];
+    if (!label.has_ast() || IsNull(label.ast())) {
+      // A missing AST is a null value, while a null AST only has a null type.
+      if (label.has_ast() ? IsNull(info.type) : info.is_nullable) {
+        err->clear();
+        return true;
+      }
+    } else if (info.is_primitive) {
+      const PrimitiveAST& p_ast = label.ast().p_ast();
+      if (label.ast().has_p_ast() && p_ast.type() == info.primitive_type &&
+          (p_ast.has_val() ? value::IsPrimitive(info.primitive_type, p_ast.val())
+                           : info.is_nullable)) {
+        err->clear();
+        return true;
+      }
+    } else if (info.type.has_c_ast() && label.ast().has_c_ast()) {
+      const CompositeAST& c_ast = label.ast().c_ast();
+      if (c_ast.op() == info.op &&
+          (info.op != Operator::TUPLE || c_ast.arg_size() == info.arity ||
+           c_ast.arg_size() == 0) &&
+          IsTypedWithValidType(info.type, label.ast(), err)) {
+        return true;
+      }
+    }
+  }
+  return type::IsTyped(types, label, err);
+}
+
+int TypeRegistry::Intern(const AST& type) {
+  auto id_it = type_ids_.find(type);
+  if (id_it != type_ids_.end()) {
+    return id_it->second;
+  }
+  const int type_id = infos_.size();
+  type_ids_.insert({type, type_id});
+  TypeInfo info;
+  info.type = type;
+  info.is_nullable = type.is_nullable();
+  info.is_primitive = type.has_p_ast();
+  info.primitive_type = type.p_ast().type();
+  info.op = type.c_ast().op();
+  info.arity = type.c_ast().arg_size();
+  infos_.push_back(std::move(info));
+  return type_id;
+}
+
+}  // namespace type
+}  // namespace ast
+}  // namespace morphie
@@ -0,0 +1,139 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// A TypeRegistry holds the type of a graph: the node, edge and graph label
+// types and the tags of unique node and edge labels. A registry is validated
+// once when it is created and cannot be modified afterwards, so graphs of the
+// same type, such as the input and output of a transformation, can share one
+// registry through a std::shared_ptr instead of copying every type AST.
+//
+// Each distinct type AST is interned: it is stored once and identified by an
+// integer type id, however many tags have that type. Properties of a type that
+// are otherwise recomputed from the AST, such as whether it is nullable, its
+// primitive type or operator and its arity, are computed once and stored in a
+// TypeInfo. LabeledGraph checks the labels of new nodes and edges with
+// IsTypedNode and IsTypedEdge, which use these properties instead of validating
+// the type of every label again.
+//
+// Example.
+//   std::shared_ptr<const TypeRegistry> registry;
+//   util::Status status = TypeRegistry::Create(
+//       node_types, unique_nodes, edge_types, unique_edges, graph_type,
+//       &registry);
+//   LabeledGraph graph1, graph2;
+//   graph1.Initialize(registry);
+//   graph2.Initialize(registry);  // Shares the types of 'graph1'.
+#ifndef LOGLE_TYPE_REGISTRY_H_
+#define LOGLE_TYPE_REGISTRY_H_
+
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "base/string.h"
+#include "graph/ast.h"
+#include "graph/type_checker.h"
+#include "ast.pb.h"
+#include "util/status.h"
+
+namespace morphie {
+namespace ast {
+namespace type {
+
+// The properties of an interned type.
+struct TypeInfo {
+  AST type;
+  bool is_nullable;
+  // True for primitive types, in which case 'primitive_type' is set. False for
+  // composite types, in which case 'op' and 'arity' are set, and for the null
+  // type.
+  bool is_primitive;
+  PrimitiveType primitive_type;
+  Operator op;
+  // The number of arguments of a composite type and 0 for other types.
+  int arity;
+};
+
+class TypeRegistry {
+ public:
+  // The id returned for tags that have no type.
+  static const int kNoType = -1;
+
+  // Creates a registry of the given types. Returns
+  // - INVALID_ARGUMENT if 'node_types' or 'edge_types' contain malformed types
+  //   or 'graph_type' is not a type.
+  // - OK otherwise, in which case '*registry' is set to the new registry.
+  // The time taken is linear in the size of the types.
+  static util::Status Create(Types node_types,
+                             const std::set<string>& unique_nodes,
+                             Types edge_types,
+                             const std::set<string>& unique_edges,
+                             AST graph_type,
+                             std::shared_ptr<const TypeRegistry>* registry);
+
+  TypeRegistry(const TypeRegistry&) = delete;
+  TypeRegistry& operator=(const TypeRegistry&) = delete;
+
+  const Types& node_types() const { return node_types_; }
+  const Types& edge_types() const { return edge_types_; }
+  const std::set<string>& unique_nodes() const { return unique_nodes_; }
+  const std::set<string>& unique_edges() const { return unique_edges_; }
+  const AST& graph_type() const { return graph_type_; }
+
+  // Return the id of the type of node or edge labels tagged with 'tag', or
+  // kNoType if there is no such type. Tags with equal types have the same id.
+  int NodeTypeId(const string& tag) const;
+  int EdgeTypeId(const string& tag) const;
+  // Returns the number of distinct node and edge types. Type ids are the
+  // integers from 0 to NumTypes() - 1.
+  int NumTypes() const { return infos_.size(); }
+  // Requires that 0 <= type_id < NumTypes().
+  const TypeInfo& GetTypeInfo(int type_id) const;
+
+  // Return true if the tag of 'label' has a node or edge type and the AST of
+  // 'label' has that type. Otherwise return false with a reason in '*err', which
+  // must be non-null. Unlike type::IsTyped, the type is not validated again and
+  // the root of the label is checked against its TypeInfo, so primitive labels
+  // are checked without traversing the type.
+  bool IsTypedNode(const TaggedAST& label, string* err) const;
+  bool IsTypedEdge(const TaggedAST& label, string* err) const;
+
+ private:
+  TypeRegistry() {}
+
+  // Returns true if 'label' has the type with id 'type_id', where 'types' is
+  // the map in which the tag of 'label' is looked up to explain a failure.
+  bool IsTyped(int type_id, const Types& types, const TaggedAST& label,
+               string* err) const;
+
+  // Returns the id of 'type', which is interned if it has not been seen yet.
+  int Intern(const AST& type);
+
+  Types node_types_;
+  Types edge_types_;
+  std::set<string> unique_nodes_;
+  std::set<string> unique_edges_;
+  AST graph_type_;
+  std::unordered_map<string, int> node_type_ids_;
+  std::unordered_map<string, int> edge_type_ids_;
+  std::unordered_map<AST, int, ASTHash, ASTEqual> type_ids_;
+  std::vector<TypeInfo> infos_;
+};
+
+}  // namespace type
+}  // namespace ast
+}  // namespace morphie
+
+#endif  // LOGLE_TYPE_REGISTRY_H_
@@ -0,0 +1,149 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "graph/type_registry.h"
+
+#include <vector>
+
+#include "graph/type.h"
+#include "graph/type_checker.h"
+#include "graph/value.h"
+#include "gtest.h"
+
+namespace morphie {
+namespace ast {
+namespace type {
+namespace {
+
+// Creates a registry in which the node types "File" and "Directory" and the
+// edge type "Contains" have the same type.
+util::Status CreateRegistry(std::shared_ptr<const TypeRegistry>* registry) {
+  Types node_types;
+  AST path = MakeList("Path", true, MakeString("Part", false));
+  node_types.insert({"File", path});
+  node_types.insert({"Directory", path});
+  std::vector<AST> fields = {MakeTimestamp("Time", false),
+                             MakeInt("Pid", true)};
+  node_types.insert({"Event", MakeTuple("Event", false, fields)});
+  Types edge_types;
+  edge_types.insert({"Contains", path});
+  edge_types.insert({"Writes", MakeBool("Success", false)});
+  return TypeRegistry::Create(node_types, {"File"}, edge_types, {},
+                              MakeString("Machine", false), registry);
+}
+
+TEST(TypeRegistryTest, InternsTypes) {
+  std::shared_ptr<const TypeRegistry> registry;
+  ASSERT_TRUE(CreateRegistry(&registry).ok());
+  EXPECT_EQ(3, registry->NumTypes());
+  EXPECT_EQ(3, registry->node_types().size());
+  EXPECT_EQ(2, registry->edge_types().size());
+  EXPECT_EQ(1, registry->unique_nodes().count("File"));
+  EXPECT_TRUE(registry->unique_edges().empty());
+  const int path_id = registry->NodeTypeId("File");
+  EXPECT_EQ(path_id, registry->NodeTypeId("Directory"));
+  EXPECT_EQ(path_id, registry->EdgeTypeId("Contains"));
+  EXPECT_NE(path_id, registry->NodeTypeId("Event"));
+  EXPECT_EQ(TypeRegistry::kNoType, registry->NodeTypeId("Contains"));
+  EXPECT_EQ(TypeRegistry::kNoType, registry->EdgeTypeId("Missing"));
+}
+
+TEST(TypeRegistryTest, ComputesTypeProperties) {
+  std::shared_ptr<const TypeRegistry> registry;
+  ASSERT_TRUE(CreateRegistry(&registry).ok());
+  const TypeInfo& path = registry->GetTypeInfo(registry->NodeTypeId("File"));
+  EXPECT_TRUE(Equal(registry->node_types().at("File"), path.type));
+  EXPECT_TRUE(path.is_nullable);
+  EXPECT_FALSE(path.is_primitive);
+  EXPECT_EQ(Operator::LIST, path.op);
+  EXPECT_EQ(1, path.arity);
+  const TypeInfo& event = registry->GetTypeInfo(registry->NodeTypeId("Event"));
+  EXPECT_FALSE(event.is_nullable);
+  EXPECT_EQ(Operator::TUPLE, event.op);
+  EXPECT_EQ(2, event.arity);
+  const TypeInfo& success =
+      registry->GetTypeInfo(registry->EdgeTypeId("Writes"));
+  EXPECT_TRUE(success.is_primitive);
+  EXPECT_EQ(PrimitiveType::BOOL, success.primitive_type);
+  EXPECT_EQ(0, success.arity);
+}
+
+// The registry accepts and rejects the same labels as the type checker, with
+// the same error messages.
+TEST(TypeRegistryTest, ChecksLabelsLikeTheTypeChecker) {
+  std::shared_ptr<const TypeRegistry> registry;
+  ASSERT_TRUE(CreateRegistry(&registry).ok());
+  AST path = value::MakeEmptyList();
+  value::Append(registry->node_types().at("File"), value::MakeString("tmp"),
+                &path);
+  AST event;
+  event.mutable_c_ast()->set_op(Operator::TUPLE);
+  *event.mutable_c_ast()->add_arg() = value::MakeTimestampFromUnixMicros(1);
+  *event.mutable_c_ast()->add_arg() = value::MakeInt(2);
+  AST short_event;
+  short_event.mutable_c_ast()->set_op(Operator::TUPLE);
+  *short_event.mutable_c_ast()->add_arg() = value::MakeInt(2);
+  const std::vector<AST> values = {
+      AST(), value::MakeBool(true), value::MakeInt(1),
+      value::MakePrimitiveNull(PrimitiveType::BOOL), value::MakeEmptyList(),
+      path, event, short_event, value::MakeNullTuple(2)};
+  const std::vector<string> node_tags = {"File", "Event", "Missing"};
+  const std::vector<string> edge_tags = {"Contains", "Writes", "Missing"};
+  for (const AST& val : values) {
+    for (int i = 0; i < 3; ++i) {
+      for (bool has_ast : {false, true}) {
+        TaggedAST label;
+        label.set_tag(node_tags[i]);
+        if (has_ast) {
+          *label.mutable_ast() = val;
+        }
+        string err, expected_err;
+        EXPECT_EQ(IsTyped(registry->node_types(), label, &expected_err),
+                  registry->IsTypedNode(label, &err))
+            << label.DebugString();
+        EXPECT_EQ(expected_err, err);
+        label.set_tag(edge_tags[i]);
+        EXPECT_EQ(IsTyped(registry->edge_types(), label, &expected_err),
+                  registry->IsTypedEdge(label, &err))
+            << label.DebugString();
+        EXPECT_EQ(expected_err, err);
+      }
+    }
+  }
+  TaggedAST label;
+  label.set_tag("Writes");
+  *label.mutable_ast() = value::MakeBool(false);
+  string err;
+  EXPECT_TRUE(registry->IsTypedEdge(label, &err));
+  EXPECT_FALSE(registry->IsTypedNode(label, &err));
+}
+
+TEST(TypeRegistryTest, RejectsMalformedTypes) {
+  Types node_types;
+  node_types.insert({"Event", AST()});
+  std::shared_ptr<const TypeRegistry> registry;
+  util::Status status =
+      TypeRegistry::Create(node_types, {}, Types(), {},
+                           MakeString("Machine", false), &registry);
+  EXPECT_EQ(Code::INVALID_ARGUMENT, status.code());
+  EXPECT_EQ(nullptr, registry);
+  status = TypeRegistry::Create(Types(), {}, Types(), {}, AST(), &registry);
+  EXPECT_EQ(Code::INVALID_ARGUMENT, status.code());
+  EXPECT_EQ(nullptr, registry);
+}
+
+}  // namespace
+}  // namespace type
+}  // namespace ast
+}  // namespace morphie
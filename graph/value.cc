@@ -16,6 +16,7 @@
 #include "graph/value.h"
 
 #include <algorithm>
+#include <utility>
 
 #include "graph/ast.h"
 #include "graph/type_checker.h"
@@ -241,19 +242,46 @@ void Insert(const AST& type, const AST& arg, AST* set) {
   CheckContainer(Operator::SET, type, arg, set);
   AST new_arg = arg;
   Canonicalize(&new_arg);
-  string arg_str = new_arg.SerializeAsString();
 
   bool has_arg = std::any_of(set->mutable_c_ast()->mutable_arg()->begin(),
                              set->mutable_c_ast()->mutable_arg()->end(),
-                             [&arg_str](AST& old_arg) {
+                             [&new_arg](AST& old_arg) {
                                Canonicalize(&old_arg);
-                               return old_arg.SerializeAsString() == arg_str;
+                               return ast::Equal(old_arg, new_arg);
                              });
   if (!has_arg) {
     AppendToContainer(type, new_arg, set);
   }
 }
 
+SetBuilder::SetBuilder(const AST& type) : type_(type) {
+  CHECK(ast::IsSet(type), kSetTypeErr);
+  string err;
+  CHECK((type::IsType(type, &err)), err);
+}
+
+void SetBuilder::Add(const AST& arg) {
+  string err;
+  CHECK((type::IsTyped(type_.c_ast().arg(0), arg, &err)), err);
+  AST element = arg;
+  Canonicalize(&element);
+  elements_.insert(std::move(element));
+}
+
+AST SetBuilder::Build() const {
+  AST set = MakeEmptySet();
+  auto* args = set.mutable_c_ast()->mutable_arg();
+  args->Reserve(elements_.size());
+  for (const AST& element : elements_) {
+    *args->Add() = element;
+  }
+  std::sort(args->pointer_begin(), args->pointer_end(),
+            [](const AST* arg1, const AST* arg2) {
+              return ast::Compare(*arg1, *arg2) < 0;
+            });
+  return set;
+}
+
 AST MakeNullTuple(int num_fields) {
   CHECK(num_fields >= 0, "");
   AST ast = MakeCompositeNull(Operator::TUPLE);
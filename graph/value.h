@@ -32,8 +32,10 @@
 #define LOGLE_VALUE_H_
 
 #include <cstdint>
+#include <unordered_set>
 
 #include "base/string.h"
+#include "graph/ast.h"
 #include "ast.pb.h"
 
 namespace morphie {
@@ -126,10 +128,41 @@ AST MakeEmptySet();
 // - 'set' is not null and '*set' is a value of type 'type'.
 // Complexity: linear time in the number of set elements and size of these
 // elements. This method checks if an element is already in '*set' by
-// traversing and canonicalizing set elements. Since these sets are intended
-// to be extremely small, a naive implementation is used for now.
+// traversing and canonicalizing set elements, so it is only suitable for small
+// sets. Use a SetBuilder to construct larger sets.
 void Insert(const AST& type, const AST& arg, AST* set);
 
+// A SetBuilder builds a set from elements that are added one at a time. Each
+// element is type checked and canonicalized once when it is added, duplicates
+// are removed with a hash set and the elements are sorted once when the set is
+// built. Building a set of n elements takes O(s + n log(n)) time, where s is
+// the total size of the elements, while n calls to Insert() take O(n * s) time.
+//
+//   AST type = type::MakeSet("Ids", false, type::MakeInt("Id", false));
+//   SetBuilder builder(type);
+//   builder.Add(MakeInt(2));
+//   builder.Add(MakeInt(1));
+//   builder.Add(MakeInt(2));
+//   AST ids = builder.Build();  // The canonical set value {1, 2}.
+class SetBuilder {
+ public:
+  // Requires that 'type' is a type of the form set(arg_type), where 'arg_type'
+  // is a type.
+  explicit SetBuilder(const AST& type);
+
+  // Adds 'arg' to the set if an equal element has not been added. Requires
+  // that 'arg' is a value of type 'arg_type'.
+  void Add(const AST& arg);
+  // Returns the number of distinct elements that have been added.
+  int Size() const { return static_cast<int>(elements_.size()); }
+  // Returns the set of the elements that have been added, in canonical form.
+  AST Build() const;
+
+ private:
+  AST type_;
+  std::unordered_set<AST, ASTHash, ASTEqual> elements_;
+};
+
 // Return a tuple with 'num_fields' uninitialized fields. Complexity: constant
 // time.
 AST MakeNullTuple(int num_fields);
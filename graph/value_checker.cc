@@ -112,7 +112,7 @@ bool IsContainerLike(const CompositeAST& c_ast, const string& path,
   return is_value;
 }
 
-bool IsomorphicPrimitive(PrimitiveAST val1, PrimitiveAST val2) {
+bool IsomorphicPrimitive(const PrimitiveAST& val1, const PrimitiveAST& val2) {
   if (val1.type() == val2.type()) {
     if (!val1.has_val() && !val2.has_val()) {
       return true;
@@ -133,15 +133,32 @@ bool IsomorphicPrimitive(PrimitiveAST val1, PrimitiveAST val2) {
   return false;
 }
 
-bool IsomorphicComposite(CompositeAST val1, CompositeAST val2) {
+// Checks isomorphism of ASTs that are known to be values, so that arguments of
+// composite ASTs are not checked to be values again at every level.
+bool IsomorphicValues(const AST& val1, const AST& val2);
+
+bool IsomorphicComposite(const CompositeAST& val1, const CompositeAST& val2) {
   if (val1.op() != val2.op() || val1.arg_size() != val2.arg_size()) {
     return false;
   }
-  bool is_isomorphic = true;
-  for (int i = 0; i < val1.arg_size() && is_isomorphic; ++i) {
-    is_isomorphic = Isomorphic(val1.arg(i), val2.arg(i));
+  for (int i = 0; i < val1.arg_size(); ++i) {
+    if (!IsomorphicValues(val1.arg(i), val2.arg(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsomorphicValues(const AST& val1, const AST& val2) {
+  if (ast::IsNull(val1) && ast::IsNull(val2)) {
+    return true;
+  } else if (val1.has_p_ast() && val2.has_p_ast()) {
+    return IsomorphicPrimitive(val1.p_ast(), val2.p_ast());
+  } else if (val1.has_c_ast() && val2.has_c_ast()) {
+    return IsomorphicComposite(val1.c_ast(), val2.c_ast());
+  } else {
+    return false;
   }
-  return is_isomorphic;
 }
 
 void CanonicalizeInterval(CompositeAST* val) {
@@ -161,28 +178,27 @@ void CanonicalizeContainer(CompositeAST* val) {
   }
 }
 
-// Sort the argument list of a set and remove duplicates.
+// Sort the argument list of a set in place and remove duplicates. Sorting
+// permutes pointers to the arguments, so no argument is copied.
 void CanonicalizeSet(CompositeAST* val) {
   CHECK(val->op() == Operator::SET, "");
-  std::vector<string> elements;
-  elements.reserve(val->arg_size());
-  string serialized_val;
-  for (AST& arg : *(val->mutable_arg())) {
+  auto* args = val->mutable_arg();
+  for (AST& arg : *args) {
     Canonicalize(&arg);
-    arg.SerializeToString(&serialized_val);
-    elements.push_back(serialized_val);
   }
-  std::sort(elements.begin(), elements.end());
-  auto end_itr = std::unique(elements.begin(), elements.end());
-  elements.erase(end_itr, elements.end());
-  val->clear_arg();
-  AST arg;
-  AST* arg_ptr;
-  for (const auto& str_val : elements) {
-    arg.ParseFromString(str_val);
-    arg_ptr = val->add_arg();
-    *arg_ptr = arg;
+  std::sort(args->pointer_begin(), args->pointer_end(),
+            [](const AST* arg1, const AST* arg2) {
+              return ast::Compare(*arg1, *arg2) < 0;
+            });
+  int num_unique = 0;
+  for (int i = 0; i < args->size(); ++i) {
+    if (num_unique == 0 ||
+        !ast::Equal(args->Get(num_unique - 1), args->Get(i))) {
+      args->SwapElements(num_unique, i);
+      ++num_unique;
+    }
   }
+  args->DeleteSubrange(num_unique, args->size() - num_unique);
 }
 
 void CanonicalizeComposite(CompositeAST* val) {
@@ -242,16 +258,7 @@ bool LT(const PrimitiveAST& val1, const PrimitiveAST& val2) {
 bool Isomorphic(const AST& val1, const AST& val2) {
   string tmp_err;
   CHECK(IsValue(val1, &tmp_err), "");
-  CHECK(IsValue(val1, &tmp_err), "");
-  if (ast::IsNull(val1) && ast::IsNull(val2)) {
-    return true;
-  } else if (val1.has_p_ast() && val2.has_p_ast()) {
-    return IsomorphicPrimitive(val1.p_ast(), val2.p_ast());
-  } else if (val1.has_c_ast() && val2.has_c_ast()) {
-    return IsomorphicComposite(val1.c_ast(), val2.c_ast());
-  } else {
-    return false;
-  }
+  return IsomorphicValues(val1, val2);
 }
 
 void Canonicalize(AST* val) {
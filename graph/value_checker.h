@@ -123,8 +123,8 @@ bool Isomorphic(const AST& val1, const AST& val2);
 // A value AST is in canonical form if:
 // - the empty interval is represented as interval(null).
 // - LIST and TUPLE contents are in canonical form.
-// - SET elements are in canonical form and occur in the lexicographic order
-//   of their serialized protobuf representations.
+// - SET elements are in canonical form, are distinct and occur in the order
+//   given by ast::Compare.
 //
 // Transforms a value AST to canonical form. Requires that val is not null.
 void Canonicalize(AST* val);
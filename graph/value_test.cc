@@ -320,6 +320,35 @@ TEST_F(ValueTest, ConstructsSets) {
   EXPECT_EQ(Size(val_), 2);
 }
 
+// A set built by a SetBuilder is the canonical form of the set obtained by
+// inserting the same elements.
+TEST_F(ValueTest, BuildsSets) {
+  type_ = type::MakeSet("foo", true, type::MakeInt("Element", true));
+  SetBuilder builder(type_);
+  EXPECT_EQ(0, builder.Size());
+  EXPECT_EQ(0, Size(builder.Build()));
+  val_ = MakeEmptySet();
+  for (int i : {3, -1, 3, 10, 0, -1}) {
+    builder.Add(MakeInt(i));
+    Insert(type_, MakeInt(i), &val_);
+  }
+  EXPECT_EQ(4, builder.Size());
+  AST set = builder.Build();
+  EXPECT_TRUE(type::IsTyped(type_, set, &err_));
+  ASSERT_EQ(4, Size(set));
+  EXPECT_EQ(-1, GetInt(set.c_ast().arg(0)));
+  EXPECT_EQ(10, GetInt(set.c_ast().arg(3)));
+  Canonicalize(&val_);
+  EXPECT_TRUE(ast::Equal(val_, set));
+}
+
+// Crashes if an element of the wrong type is added.
+TEST(ValueDeathTest, SetBuilderRequiresTypedArgument) {
+  SetBuilder builder(
+      type::MakeSet("foo", true, type::MakeBool("Element", true)));
+  EXPECT_DEATH({ builder.Add(MakeInt(5)); }, ".*");
+}
+
 static AST GetTupleType() {
   std::vector<AST> field_asts;
   field_asts.emplace_back(type::MakeBool("First", true));
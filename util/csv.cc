@@ -12,18 +12,209 @@
 // License for the specific language governing permissions and limitations under
 // the License.
 #include "util/csv.h"
-#include <boost/exception/exception.hpp>  // NOLINT
-#include <boost/tokenizer.hpp>  // NOLINT
 
-#include <sstream>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <deque>
+#include <mutex>
+#include <thread>
 
-// The Clang compiler does not support exceptions. Boost is compiled with Clang,
-// the client is required to define this function.
-// void boost::throw_exception(std::exception const& e) {}
+#include "util/time_utils.h"
+
+namespace {
+
+// The size of the first block of input read by the parser.
+const size_t kInitialBufferSize = 1 << 20;
+
+const char kEscape = '\\';
+const char kNewline = '\n';
+const char kQuote = '"';
+
+// Appends the unescaped value of 'raw' to 'out'. The tokenizer has already
+// checked that every escape sequence in 'raw' is valid, so the sequences can be
+// translated without further checks.
+void AppendUnescaped(morphie::util::StringPiece raw, std::string* out) {
+  const char* c = raw.begin();
+  while (c != raw.end()) {
+    // Copy the characters up to the next quote or escape at once.
+    const char* run = c;
+    while (c != raw.end() && *c != kQuote && *c != kEscape) {
+      ++c;
+    }
+    out->append(run, c - run);
+    if (c == raw.end()) {
+      break;
+    }
+    if (*c == kEscape) {
+      ++c;
+      out->push_back(*c == 'n' ? kNewline : *c);
+    }
+    ++c;
+  }
+}
+
+// Returns true and stores the microseconds since the Unix epoch in 'value' if
+// 'field' is an RFC3339 timestamp.
+bool ParseTimestamp(morphie::util::StringPiece field, int64_t* value) {
+  // The longest valid timestamp is much shorter than the buffer, so a field
+  // that does not fit is not a timestamp. The copy is needed because the time
+  // functions expect a terminated string.
+  char buffer[64];
+  if (field.size() >= sizeof(buffer)) {
+    return false;
+  }
+  std::memcpy(buffer, field.data(), field.size());
+  buffer[field.size()] = '\0';
+  return morphie::util::RFC3339ToUnixMicros(buffer, value);
+}
+
+// A chunk of input that ends at a record boundary.
+struct Chunk {
+  size_t sequence_number;
+  // The input, followed by a newline and one block of padding.
+  std::vector<char> data;
+  // The number of bytes of input in 'data'.
+  size_t size;
+  // True if the chunk ends at the end of the input rather than after a
+  // newline.
+  bool is_last;
+};
+
+// A bounded queue of chunks that the reading thread fills and the worker
+// threads drain.
+class ChunkQueue {
+ public:
+  explicit ChunkQueue(size_t capacity) : capacity_(capacity), closed_(false) {}
+
+  // Adds 'chunk' to the queue, waiting while the queue is full.
+  void Push(std::unique_ptr<Chunk> chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this]() { return chunks_.size() < capacity_; });
+    chunks_.push_back(std::move(chunk));
+    not_empty_.notify_one();
+  }
+
+  // Removes and returns the oldest chunk, waiting while the queue is empty.
+  // Returns nullptr once the queue is closed and empty.
+  std::unique_ptr<Chunk> Pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !chunks_.empty(); });
+    if (chunks_.empty()) {
+      return nullptr;
+    }
+    std::unique_ptr<Chunk> chunk = std::move(chunks_.front());
+    chunks_.pop_front();
+    not_full_.notify_one();
+    return chunk;
+  }
+
+  // Signals that no more chunks will be added.
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<std::unique_ptr<Chunk>> chunks_;
+  bool closed_;
+};
+
+}  // namespace
 
 namespace morphie {
 namespace util {
 
+bool ParseInt64(StringPiece field, int64_t* value) {
+  const char* c = field.begin();
+  const bool is_negative = c != field.end() && *c == '-';
+  if (c != field.end() && (*c == '-' || *c == '+')) {
+    ++c;
+  }
+  if (c == field.end()) {
+    return false;
+  }
+  const uint64_t limit =
+      static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + is_negative;
+  uint64_t magnitude = 0;
+  for (; c != field.end(); ++c) {
+    const unsigned digit = static_cast<unsigned char>(*c) - '0';
+    if (digit > 9 || magnitude > (limit - digit) / 10) {
+      return false;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+  *value = is_negative ? static_cast<int64_t>(0 - magnitude)
+                       : static_cast<int64_t>(magnitude);
+  return true;
+}
+
+const vector<StringPiece>& Record::fields() const {
+  for (size_t i = 0; num_escaped_ > 0 && i < is_escaped_.size(); ++i) {
+    if (is_escaped_[i]) {
+      Unescape(i);
+    }
+  }
+  return fields_;
+}
+
+StringPiece Record::field(size_t index) const {
+  if (num_escaped_ > 0 && is_escaped_[index]) {
+    Unescape(index);
+  }
+  return fields_[index];
+}
+
+void Record::AddField(const char* begin, const char* end, bool is_escaped) {
+  fields_.emplace_back(begin, end - begin);
+  if (is_escaped || num_escaped_ > 0) {
+    is_escaped_.resize(fields_.size(), false);
+    is_escaped_.back() = is_escaped;
+    num_escaped_ += is_escaped;
+  }
+}
+
+void Record::SetField(size_t index, const char* begin, const char* end,
+                      bool is_escaped) {
+  fields_[index] = StringPiece(begin, end - begin);
+  if (is_escaped) {
+    is_escaped_.resize(fields_.size(), false);
+    is_escaped_[index] = true;
+    ++num_escaped_;
+  }
+}
+
+void Record::Clear() {
+  fields_.clear();
+  is_escaped_.clear();
+  num_escaped_ = 0;
+  arena_.clear();
+  num_columns_ = 0;
+  status_ = util::Status::OK;
+}
+
+void Record::SetError(const string& message) {
+  Clear();
+  status_ = util::Status(
+      Code::INVALID_ARGUMENT,
+      message + " Record at line " + std::to_string(line_number_) +
+          ", byte offset " + std::to_string(byte_offset_) + ".");
+}
+
+void Record::Unescape(size_t index) const {
+  const size_t start = arena_.size();
+  AppendUnescaped(fields_[index], &arena_);
+  fields_[index] = StringPiece(arena_.data() + start, arena_.size() - start);
+  is_escaped_[index] = false;
+  --num_escaped_;
+}
+
 CSVParser::Iterator& CSVParser::Iterator::operator++() {
   parser_->Advance();
   return *this;
@@ -33,6 +224,14 @@ CSVParser::CSVParser(std::istream* input) : CSVParser(input, ',') {}
 
 CSVParser::CSVParser(std::istream* input, char delim)
     : delim_(delim),
+      scan_fn_(scan::GetBlockScanFn()),
+      pos_(0),
+      end_(0),
+      buffer_offset_(0),
+      line_number_(1),
+      next_entry_(0),
+      input_done_(false),
+      at_first_record_(false),
       begin_iter_(this, false),
       end_iter_(this, true),
       state_(State::kReading) {
@@ -47,7 +246,44 @@ void CSVParser::Init(std::istream* input) {
     return;
   }
   input_.reset(input);
+  buffer_.resize(kInitialBufferSize + scan::kBlockSize);
+  buffer_[end_] = kNewline;
   Advance();
+  at_first_record_ = state_ != State::kOutputEmpty;
+}
+
+util::Status CSVParser::Project(const vector<ColumnSpec>& columns) {
+  if (!at_first_record_) {
+    return util::Status(Code::INVALID_ARGUMENT,
+                        "Columns can only be projected at the header.");
+  }
+  const vector<StringPiece>& header = record_.fields();
+  vector<int> projected_index(header.size(), -1);
+  size_t num_indexed = 0;
+  for (size_t i = 0; i < columns.size(); ++i) {
+    const string& name = columns[i].name;
+    const auto column_it = std::find(header.begin(), header.end(), name);
+    if (column_it == header.end()) {
+      return util::Status(Code::INVALID_ARGUMENT,
+                          "No column named " + name + ".");
+    }
+    if (std::find(column_it + 1, header.end(), name) != header.end()) {
+      return util::Status(Code::INVALID_ARGUMENT,
+                          "More than one column named " + name + ".");
+    }
+    const size_t column = column_it - header.begin();
+    if (projected_index[column] >= 0) {
+      return util::Status(Code::INVALID_ARGUMENT,
+                          "Column " + name + " is projected more than once.");
+    }
+    projected_index[column] = i;
+    num_indexed = std::max(num_indexed, column + 1);
+  }
+  projected_index.resize(num_indexed);
+  projection_ = columns;
+  projected_index_ = std::move(projected_index);
+  record_.int64_fields_.resize(columns.size());
+  return util::Status::OK;
 }
 
 // The parser begins in the kReading state and makes the following state
@@ -61,7 +297,8 @@ void CSVParser::Init(std::istream* input) {
 // The transitions from kInputEmpty and kOutputEmpty are not based on other
 // conditions.
 void CSVParser::Advance() {
-  record_.fields_.clear();
+  record_.Clear();
+  at_first_record_ = false;
   switch (state_) {
     case State::kOutputEmpty:
       return;
@@ -70,18 +307,12 @@ void CSVParser::Advance() {
       return;
     }
     case State::kReading: {
-      string line;
-      std::getline(*input_, line);
-      try {
-        boost::escaped_list_separator<char> sep("\\", string(1, delim_), "\"");
-        boost::tokenizer<boost::escaped_list_separator<char>> tokenizer(line,
-                                                                        sep);
-        record_.fields_.assign(tokenizer.begin(), tokenizer.end());
-      } catch (boost::exception& e) {
-        record_.status_ =
-            util::Status(Code::INVALID_ARGUMENT, "Error tokenizing line.");
+      Scan scan = TokenizeRecord();
+      while (scan == Scan::kNeedInput) {
+        Refill();
+        scan = TokenizeRecord();
       }
-      if (!input_->good()) {
+      if (scan == Scan::kEndOfInput) {
         input_.reset(nullptr);
         state_ = State::kInputEmpty;
       }
@@ -89,5 +320,276 @@ void CSVParser::Advance() {
   }
 }
 
+// The tokenizer implements the semantics of an escaped list separator.
+//  - A backslash followed by the letter n is a newline. A backslash followed
+//    by a quote, the delimiter or a backslash is that character. Any other
+//    use of a backslash is an error.
+//  - A quote that is not escaped toggles whether the tokenizer is inside a
+//    quoted string and is not part of the field.
+//  - A delimiter outside a quoted string ends a field and a newline outside a
+//    quoted string ends a record. A quoted string that is not closed at the
+//    end of the input is an error.
+//  - An empty line has no fields.
+// The index already contains the boundaries of fields according to these rules
+// and marks fields that contain a quote or a backslash. Such fields are only
+// rewritten when the client accesses them, unless they are in a numeric
+// column.
+CSVParser::Scan CSVParser::TokenizeRecord() {
+  if (next_entry_ == index_.size()) {
+    return Scan::kNeedInput;
+  }
+  if (!projection_.empty()) {
+    record_.fields_.resize(projection_.size());
+  }
+  const char* const line = buffer_.data() + pos_;
+  const char* const limit = buffer_.data() + end_;
+  const char* field = line;
+  size_t column = 0;
+  size_t num_quoted_newlines = 0;
+  for (;;) {
+    const uint64_t entry = index_[next_entry_++];
+    const char* const c = buffer_.data() + (entry & scan::kOffsetMask);
+    const bool is_escaped = (entry & scan::kEscapedFlag) != 0;
+    if ((entry & scan::kQuotedNewlineFlag) != 0) {
+      ++num_quoted_newlines;
+      continue;
+    }
+    if ((entry & scan::kNewlineFlag) == 0) {
+      AddField(column++, field, c, is_escaped);
+      field = c + 1;
+      continue;
+    }
+    if (c == limit && !input_done_) {
+      record_.Clear();
+      return Scan::kNeedInput;
+    }
+    if (c != line) {
+      AddField(column++, field, c, is_escaped);
+    }
+    record_.num_columns_ = column;
+    record_.line_number_ = line_number_;
+    record_.byte_offset_ = buffer_offset_ + pos_;
+    line_number_ += 1 + num_quoted_newlines;
+    if ((entry & scan::kMalformedFlag) != 0) {
+      record_.SetError("Error tokenizing record.");
+    } else {
+      if (record_.num_escaped_ > 0) {
+        // Unescaping never lengthens a field, so this capacity suffices for
+        // all fields of the record.
+        record_.arena_.reserve(c - line);
+      }
+      if (!projection_.empty()) {
+        FinishProjectedRecord();
+      }
+    }
+    if (c == limit) {
+      pos_ = end_;
+      return Scan::kEndOfInput;
+    }
+    pos_ = c - buffer_.data() + 1;
+    return Scan::kNewline;
+  }
+}
+
+void CSVParser::AddField(size_t column, const char* begin, const char* end,
+                         bool is_escaped) {
+  if (projection_.empty()) {
+    record_.AddField(begin, end, is_escaped);
+  } else if (column < projected_index_.size() &&
+             projected_index_[column] >= 0) {
+    record_.SetField(projected_index_[column], begin, end, is_escaped);
+  }
+}
+
+// A record that fails the checks has no fields but retains the number of
+// columns in its line.
+void CSVParser::FinishProjectedRecord() {
+  string error;
+  if (record_.num_columns_ < projected_index_.size()) {
+    error = "Line is missing columns.";
+  }
+  for (size_t i = 0; error.empty() && i < projection_.size(); ++i) {
+    const ColumnSpec& column = projection_[i];
+    bool is_converted = true;
+    if (column.type == ColumnType::kInt64) {
+      is_converted = ParseInt64(record_.field(i), &record_.int64_fields_[i]);
+    } else if (column.type == ColumnType::kTimestamp) {
+      is_converted =
+          ParseTimestamp(record_.field(i), &record_.int64_fields_[i]);
+    }
+    if (!is_converted) {
+      error = "Invalid value in column " + column.name + ".";
+    }
+  }
+  if (!error.empty()) {
+    const size_t num_columns = record_.num_columns_;
+    record_.SetError(error);
+    record_.num_columns_ = num_columns;
+  }
+}
+
+void CSVParser::Refill() {
+  const size_t num_unconsumed = end_ - pos_;
+  if (pos_ > 0) {
+    std::memmove(buffer_.data(), buffer_.data() + pos_, num_unconsumed);
+    buffer_offset_ += pos_;
+    pos_ = 0;
+    end_ = num_unconsumed;
+  }
+  // The last block of the buffer is reserved for the sentinel and padding.
+  size_t capacity = buffer_.size() - scan::kBlockSize;
+  if (end_ == capacity) {
+    capacity *= 2;
+    buffer_.resize(capacity + scan::kBlockSize);
+  }
+  input_->read(buffer_.data() + end_, capacity - end_);
+  end_ += input_->gcount();
+  if (!input_->good()) {
+    input_done_ = true;
+  }
+  buffer_[end_] = kNewline;
+  index_.clear();
+  next_entry_ = 0;
+  scan::IndexStructurals(scan_fn_, delim_, buffer_.data(), buffer_.data(),
+                         buffer_.data() + end_, &index_);
+}
+
+void RecordBatch::Tokenize(const vector<uint64_t>& index) {
+  const char* const base = data_.data();
+  const char* line = base;
+  const char* field = base;
+  size_t record_begin = 0;
+  for (const uint64_t entry : index) {
+    const char* const c = base + (entry & scan::kOffsetMask);
+    const bool is_escaped = (entry & scan::kEscapedFlag) != 0;
+    if ((entry & scan::kQuotedNewlineFlag) != 0) {
+      continue;
+    }
+    if ((entry & scan::kNewlineFlag) == 0) {
+      AddField(field, c, is_escaped);
+      field = c + 1;
+      continue;
+    }
+    if (c != line) {
+      AddField(field, c, is_escaped);
+    }
+    const bool ok = (entry & scan::kMalformedFlag) == 0;
+    if (!ok) {
+      fields_.resize(record_begin);
+    }
+    record_ends_.push_back(fields_.size());
+    record_ok_.push_back(ok);
+    record_begin = fields_.size();
+    line = field = c + 1;
+  }
+}
+
+void RecordBatch::AddField(const char* begin, const char* end,
+                           bool is_escaped) {
+  if (!is_escaped) {
+    fields_.emplace_back(begin, end - begin);
+    return;
+  }
+  // Unescaping never lengthens a field, so the size of the chunk suffices for
+  // all fields of the batch.
+  if (arena_.capacity() < data_.size()) {
+    arena_.reserve(data_.size());
+  }
+  const size_t start = arena_.size();
+  AppendUnescaped(StringPiece(begin, end - begin), &arena_);
+  fields_.emplace_back(arena_.data() + start, arena_.size() - start);
+}
+
+const size_t ParallelCSVParser::kDefaultChunkSize;
+
+ParallelCSVParser::ParallelCSVParser(std::istream* input, char delim,
+                                     int num_threads)
+    : ParallelCSVParser(input, delim, num_threads, kDefaultChunkSize) {}
+
+ParallelCSVParser::ParallelCSVParser(std::istream* input, char delim,
+                                     int num_threads, size_t chunk_size)
+    : input_(input),
+      delim_(delim),
+      num_threads_(num_threads),
+      chunk_size_(std::max<size_t>(chunk_size, 1)) {
+  if (num_threads_ <= 0) {
+    num_threads_ = std::max<int>(std::thread::hardware_concurrency(), 1);
+  }
+}
+
+// The calling thread reads the input while the workers parse it. Every chunk
+// but the last ends with the last newline outside a quoted string read into it
+// and the bytes after that newline begin the next chunk.
+util::Status ParallelCSVParser::Parse(const BatchFn& batch_fn) {
+  if (input_ == nullptr || !input_->good()) {
+    return util::Status(Code::INVALID_ARGUMENT, "Input is null.");
+  }
+  const scan::BlockScanFn scan_fn = scan::GetBlockScanFn();
+  // Two chunks per thread keep the workers busy while the next chunk is read.
+  ChunkQueue queue(2 * num_threads_);
+  vector<std::thread> workers;
+  for (int i = 0; i < num_threads_; ++i) {
+    workers.emplace_back([this, i, scan_fn, &queue, &batch_fn]() {
+      vector<uint64_t> index;
+      for (std::unique_ptr<Chunk> chunk = queue.Pop(); chunk != nullptr;
+           chunk = queue.Pop()) {
+        RecordBatch batch;
+        batch.sequence_number_ = chunk->sequence_number;
+        batch.data_ = std::move(chunk->data);
+        const char* const base = batch.data_.data();
+        // The last chunk is terminated by the sentinel newline.
+        const size_t end = chunk->is_last ? chunk->size : chunk->size - 1;
+        index.clear();
+        scan::IndexStructurals(scan_fn, delim_, base, base, base + end, &index);
+        batch.Tokenize(index);
+        batch_fn(i, batch);
+      }
+    });
+  }
+  vector<char> carry;
+  size_t sequence_number = 0;
+  bool input_done = false;
+  while (!input_done) {
+    std::unique_ptr<Chunk> chunk(new Chunk);
+    vector<char>& data = chunk->data;
+    data.swap(carry);
+    size_t size = data.size();
+    size_t record_end = 0;
+    // Read until the chunk contains the end of a record or the input is
+    // exhausted. The amount read doubles with every attempt, so the chunk is
+    // scanned a constant number of times on average.
+    for (;;) {
+      const size_t read_size = std::max(chunk_size_, size);
+      data.resize(size + read_size + 1 + scan::kBlockSize);
+      input_->read(data.data() + size, read_size);
+      size += input_->gcount();
+      if (!input_->good()) {
+        input_done = true;
+        record_end = size;
+        break;
+      }
+      const char* const last_record_end = scan::FindLastRecordEnd(
+          scan_fn, delim_, data.data(), data.data() + size);
+      if (last_record_end != nullptr) {
+        record_end = last_record_end - data.data();
+        break;
+      }
+    }
+    carry.assign(data.begin() + record_end, data.begin() + size);
+    data.resize(record_end + 1 + scan::kBlockSize);
+    data[record_end] = kNewline;
+    chunk->sequence_number = sequence_number++;
+    chunk->size = record_end;
+    chunk->is_last = input_done;
+    queue.Push(std::move(chunk));
+  }
+  queue.Close();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  input_.reset(nullptr);
+  return util::Status::OK;
+}
+
 }  // namespace util
 }  // namespace morphie
@@ -13,7 +13,7 @@
 // the License.
 
 // This file defines a simple parser for Comma Separated Values and a Record
-// that stores values extracted from a single line of input. Both the parser and
+// that stores values extracted from a single record of input. Both the parser and
 // the record support range-based iterartion. The parser uses the double-quote
 // symbol as an escape character and backslash to escape the quote symbol.
 //
@@ -23,7 +23,7 @@
 //   CSVParser parser(input);
 //   for (const Record& record : parser) {
 //     if (!record.ok()) continue;
-//     for (const string& field : record) {
+//     for (StringPiece field : record) {
 //       // Use the field.
 //     }
 //   }
@@ -47,47 +47,170 @@
 //
 // The parser currently allows for a delimiter to be provided as input but fixes
 // the escape character to be the quote symbol " and backslash for escaping
-// the quote symbol.
+// the quote symbol. A backslash may also escape the delimiter, the backslash
+// itself, or the letter n, which denotes a newline. As in RFC 4180, a newline
+// inside a quoted string is part of the field, so a record may span several
+// lines of input.
+//
+// Fields are not copied out of the input. The parser reads the input in large
+// blocks into a buffer it reuses, locates all field boundaries in a block with
+// the vectorized scan in csv_scan.h, and a Record refers to its fields with
+// StringPiece objects pointing into that buffer. A field containing quotes or
+// escape sequences is unescaped into scratch memory owned by the Record the
+// first time it is accessed. The fields of a Record are therefore only valid
+// until the parser advances to the next Record and a client that needs a
+// field for longer has to copy it.
+//
+// A client that only needs some columns of the input can project records onto
+// those columns by the names in the header. Fields in other columns are only
+// located, never unescaped or copied, and fields in columns of numeric type are
+// converted while the record is tokenized.
+//
+// Example 3.
+//   CSVParser parser(new std::ifstream(path));
+//   // The first record is the header.
+//   util::Status status = parser.Project(
+//       {{"user", ColumnType::kString}, {"count", ColumnType::kInt64}});
+//   for (auto it = ++parser.begin(); it != parser.end(); ++it) {
+//     if (!it->ok()) continue;
+//     StringPiece user = it->field(0);
+//     int64_t count = it->int64_field(1);
+//   }
+//
+// Large inputs can be parsed on several threads with a ParallelCSVParser, which
+// splits the input into chunks that end at record boundaries and hands each
+// chunk, as a RecordBatch, to a function called on a pool of worker threads.
+//
+// Example 4.
+//   ParallelCSVParser parser(new std::ifstream(path), ',', 4);
+//   util::Status status = parser.Parse(
+//       [](int thread_index, const RecordBatch& batch) {
+//         for (size_t i = 0; i < batch.size(); ++i) {
+//           RecordBatch::RecordView record = batch[i];
+//           // Use record.field(j) for j < record.size().
+//         }
+//       });
 #ifndef LOGLE_UTIL_CSV_H_
 #define LOGLE_UTIL_CSV_H_
 
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <memory>
 #include <vector>
 
 #include "base/string.h"
+#include "util/csv_scan.h"
 #include "util/status.h"
+#include "util/string_piece.h"
 
 namespace morphie {
 namespace util {
 
 using std::vector;
 
-// A Record object consists of a vector of strings and a status object. If the
-// status is ok(), the vector contains fields obtained by parsing one line of
+// The types to which the fields of a projected column can be converted.
+enum class ColumnType {
+  // The unescaped field.
+  kString,
+  // A decimal integer that fits in 64 bits.
+  kInt64,
+  // An RFC3339 timestamp, converted to microseconds since the Unix epoch.
+  kTimestamp,
+};
+
+// A column selected by its name in the header of the input.
+struct ColumnSpec {
+  string name;
+  ColumnType type;
+};
+
+// Returns true and stores the value of 'field' in 'value' if 'field' consists
+// of an optional sign followed by decimal digits and its value fits in 64 bits.
+// This is the conversion applied to fields in columns of type kInt64.
+bool ParseInt64(StringPiece field, int64_t* value);
+
+// A Record object consists of a vector of fields and a status object. If the
+// status is ok(), the vector contains fields obtained by parsing one record of
 // CSV input. If the status is not ok(), an error occurred when the Record was
-// being populated. Both fields and status are set by the CSV parser and cannot
-// be modified by the client.
+// being populated and the error message contains the position of the record.
+// Both fields and status are set by the CSV parser and cannot be modified by
+// the client.
 class Record {
  public:
+  Record()
+      : num_escaped_(0), num_columns_(0), line_number_(0), byte_offset_(0) {}
+
   // Functions that enable range-based iteration over fields.
-  vector<string>::const_iterator begin() const { return fields_.begin(); }
-  vector<string>::const_iterator end() const { return fields_.end(); }
+  vector<StringPiece>::const_iterator begin() const { return fields().begin(); }
+  vector<StringPiece>::const_iterator end() const { return fields().end(); }
 
-  const vector<string>& fields() const { return fields_; }
+  // Returns all fields of the record, unescaping any that have not yet been
+  // accessed.
+  const vector<StringPiece>& fields() const;
+  // Returns the field at position 'index', unescaping only that field if
+  // necessary. Requires that 'index' is less than size().
+  StringPiece field(size_t index) const;
+  // Returns the value of the field at position 'index' in a column of type
+  // kInt64 or kTimestamp. Requires that the parser projects records onto
+  // columns, that the column at 'index' has one of these types and that the
+  // record is ok().
+  int64_t int64_field(size_t index) const { return int64_fields_[index]; }
+  // Returns the number of fields in the record. Does not unescape fields.
+  size_t size() const { return fields_.size(); }
+  // Returns the number of fields in the record of input, which differs from
+  // size() if the parser projects records onto columns.
+  size_t num_columns() const { return num_columns_; }
+  // Returns the line, counting from 1, and the byte offset, counting from 0,
+  // at which the record begins in the input.
+  size_t line_number() const { return line_number_; }
+  size_t byte_offset() const { return byte_offset_; }
   bool ok() const { return status_.ok(); }
+  const util::Status& status() const { return status_; }
 
  private:
   friend class CSVParser;
-  vector<string> fields_;
+
+  // Adds the field between 'begin' and 'end'. If 'is_escaped' is true, the
+  // field is in raw form and has to be unescaped before it is accessed.
+  void AddField(const char* begin, const char* end, bool is_escaped);
+  // Sets the field at 'index' to the field between 'begin' and 'end'.
+  void SetField(size_t index, const char* begin, const char* end,
+                bool is_escaped);
+  // Removes all fields and resets the status. Does not change the position.
+  void Clear();
+  // Removes all fields and sets the status to an error with 'message' and the
+  // position of the record.
+  void SetError(const string& message);
+  // Replaces the raw field at 'index' with its unescaped value.
+  void Unescape(size_t index) const;
+
+  // A field that contains quotes or escape sequences is stored in the raw form
+  // in which it occurs in the input until it is first accessed. The entry in
+  // 'is_escaped_' for such a field is true. Since most fields are not escaped,
+  // 'is_escaped_' is only populated once an escaped field has been added and
+  // entries past its end are false.
+  mutable vector<StringPiece> fields_;
+  mutable vector<char> is_escaped_;
+  mutable size_t num_escaped_;
+  // Scratch memory for unescaped fields. The parser reserves enough capacity
+  // for all fields of a record before the record is made available, so the
+  // arena is never reallocated while fields point into it.
+  mutable string arena_;
+  // The values of fields in numeric columns, indexed like 'fields_'.
+  vector<int64_t> int64_fields_;
+  size_t num_columns_;
+  size_t line_number_;
+  size_t byte_offset_;
   util::Status status_;
 };
 
-// The CSVParser extracts fields, line by line, from an input stream. At any
-// given time, the parser only stores fields extracted from a single line in
-// memory, so processing CSV input with a large number of lines is not an issue.
+// The CSVParser extracts fields, record by record, from an input stream. At any
+// given time, the parser only stores a block of the input in memory, so
+// processing CSV input with a large number of lines is not an issue. The block
+// grows if a single record does not fit in it, so the memory used is
+// proportional to the size of the largest record.
 //
 // The parser owns the input stream and provides an iterator interface for
 // processing the stream. There can only be one, non-end position.
@@ -101,7 +224,7 @@ class CSVParser {
     explicit Iterator(CSVParser* parser, bool is_end)
         : parser_(parser), is_end_(is_end) {}
 
-    // Parse the next line of the input. Does nothing if already at the end.
+    // Parse the next record of the input. Does nothing if already at the end.
     Iterator& operator++();
 
     const Record& operator*() { return parser_->record_; }
@@ -142,6 +265,17 @@ class CSVParser {
   Iterator begin() const { return begin_iter_; }
   Iterator end() const { return end_iter_; }
 
+  // Projects all records after the current one onto 'columns'. The current
+  // record must be the first record of the input, which is the header that
+  // names the columns. Field i of a projected record is the field in the
+  // column named 'columns[i].name', converted to 'columns[i].type'. A record
+  // that lacks one of the columns or has a field that cannot be converted is
+  // not ok(). Returns
+  //  * OK : if every column occurs exactly once in the header.
+  //  * INVALID_ARGUMENT : otherwise, or if the parser has advanced past the
+  //    first record, with the reason in the error message.
+  util::Status Project(const vector<ColumnSpec>& columns);
+
  private:
   // The state of the parser. The parser is one step ahead of the client reading
   // parsed fields, so it needs to track when the input has been exhaused but
@@ -155,18 +289,181 @@ class CSVParser {
     kOutputEmpty,
   };
 
+  // The result of scanning the buffer for the next record.
+  enum class Scan {
+    // A record terminated by a newline was found.
+    kNewline,
+    // A record terminated by the end of the input was found.
+    kEndOfInput,
+    // The buffer ends before the record does and more input has to be read.
+    kNeedInput,
+  };
+
   void Init(std::istream* istream);
-  // Parses the next line of the input and updates the parser's state.
+  // Parses the next record of the input and updates the parser's state.
   void Advance();
+  // Tokenizes the record beginning at 'pos_' into 'record_' using the entries
+  // of 'index_'. On success, advances 'pos_' past the record.
+  Scan TokenizeRecord();
+  // Adds the field between 'begin' and 'end', which is in column 'column' of
+  // the input, to 'record_' if the column is projected.
+  void AddField(size_t column, const char* begin, const char* end,
+                bool is_escaped);
+  // Checks that 'record_' has all projected columns and converts the fields
+  // of numeric columns. Sets the status of 'record_' if either fails.
+  void FinishProjectedRecord();
+  // Moves unconsumed input to the front of the buffer, reads more input after
+  // it, growing the buffer if it is full, and indexes the buffer.
+  void Refill();
 
   std::unique_ptr<std::istream> input_;
   const char delim_;
+  const scan::BlockScanFn scan_fn_;
+  // The buffer holds the input between 'pos_', the beginning of the next
+  // record, and 'end_'. The byte at 'end_' is always a newline that serves as a
+  // sentinel, so the last record in the buffer is always terminated. The
+  // buffer extends for one block past the sentinel, so the scan can read whole
+  // blocks.
+  vector<char> buffer_;
+  size_t pos_;
+  size_t end_;
+  // The offset in the input of the beginning of the buffer and the line of the
+  // input on which the record at 'pos_' begins.
+  size_t buffer_offset_;
+  size_t line_number_;
+  // The structural characters in the buffer and the next one to process.
+  vector<uint64_t> index_;
+  size_t next_entry_;
+  // True once the input stream has been exhausted.
+  bool input_done_;
+  // True while the current record is the first record of the input.
+  bool at_first_record_;
+  // The projected columns and, for each column of the input up to the last
+  // projected one, the position of the column in a projected record or -1 if
+  // it is not projected. Both are empty if records are not projected.
+  vector<ColumnSpec> projection_;
+  vector<int> projected_index_;
   Record record_;
   Iterator begin_iter_;
   Iterator end_iter_;
   State state_;
 };
 
+// A RecordBatch holds the records parsed from one chunk of the input of a
+// ParallelCSVParser. The batch owns the chunk and fields refer to it, so unlike
+// the fields of a Record, they remain valid for the lifetime of the batch.
+// Fields are unescaped when the batch is parsed.
+//
+// Batches are numbered in the order in which their chunks occur in the input.
+// The pair of the sequence number of a batch and the position of a record in
+// the batch is the ordinal of the record, so records from different batches
+// can be put back into input order.
+class RecordBatch {
+ public:
+  // A view of one record of a batch with the accessors of a Record.
+  class RecordView {
+   public:
+    vector<StringPiece>::const_iterator begin() const { return begin_; }
+    vector<StringPiece>::const_iterator end() const { return end_; }
+    StringPiece field(size_t index) const { return begin_[index]; }
+    size_t size() const { return end_ - begin_; }
+    bool ok() const { return ok_; }
+
+   private:
+    friend class RecordBatch;
+
+    RecordView(vector<StringPiece>::const_iterator begin,
+               vector<StringPiece>::const_iterator end, bool ok)
+        : begin_(begin), end_(end), ok_(ok) {}
+
+    vector<StringPiece>::const_iterator begin_;
+    vector<StringPiece>::const_iterator end_;
+    bool ok_;
+  };
+
+  RecordBatch() : sequence_number_(0) {}
+
+  size_t sequence_number() const { return sequence_number_; }
+  // Returns the number of records in the batch.
+  size_t size() const { return record_ends_.size(); }
+  // Returns the record at position 'index'. Requires that 'index' is less than
+  // size(). A record that could not be tokenized has no fields and is not ok().
+  RecordView operator[](size_t index) const {
+    const size_t begin = index == 0 ? 0 : record_ends_[index - 1];
+    return RecordView(fields_.begin() + begin,
+                      fields_.begin() + record_ends_[index],
+                      record_ok_[index] != 0);
+  }
+
+ private:
+  friend class ParallelCSVParser;
+
+  // Tokenizes 'data_' into records using the entries of 'index', the last of
+  // which is the newline that ends the last record.
+  void Tokenize(const vector<uint64_t>& index);
+  // Adds the field between 'begin' and 'end' to the last record, unescaping
+  // it into 'arena_' if 'is_escaped' is true.
+  void AddField(const char* begin, const char* end, bool is_escaped);
+
+  size_t sequence_number_;
+  // The chunk of input, followed by a newline and padding for the scan.
+  vector<char> data_;
+  // The fields of all records. Record i consists of the fields from
+  // 'record_ends_[i - 1]' up to 'record_ends_[i]'.
+  vector<StringPiece> fields_;
+  vector<size_t> record_ends_;
+  vector<char> record_ok_;
+  // Unescaped fields. Capacity for the whole chunk is reserved before the
+  // first field is unescaped, so the arena is never reallocated.
+  string arena_;
+};
+
+// The ParallelCSVParser parses its input on several threads. The thread calling
+// Parse() reads the input in chunks of about 'chunk_size' bytes, each of which
+// is cut back to the end of its last record, and queues them for a pool of
+// worker threads that index, tokenize and unescape a chunk and pass the
+// resulting RecordBatch to a client function. The input is parsed in two
+// passes. The reading thread only tracks which characters are inside quoted
+// strings, which is enough to find the newlines that end records, and the
+// workers do the full tokenization. A chunk grows if it does not contain the
+// end of a record. Since every chunk begins at a record boundary, the records
+// and their fields are exactly those a CSVParser produces for the same
+// input.
+//
+// The number of chunks that have been read but not parsed is bounded, so the
+// memory used is proportional to the number of threads times the chunk size.
+class ParallelCSVParser {
+ public:
+  // The function called for every batch. The first argument, in the range
+  // [0, num_threads), identifies the worker thread that makes the call. Calls
+  // from different threads are concurrent, so batches arrive in no particular
+  // order, but every thread receives its batches in the order of their
+  // sequence numbers. With a single thread, batches arrive in input order.
+  using BatchFn = std::function<void(int, const RecordBatch&)>;
+
+  // The default size of a chunk.
+  static const size_t kDefaultChunkSize = 1 << 20;
+
+  // The ParallelCSVParser takes ownership of 'input'. If 'num_threads' is not
+  // positive, one thread is used per processor.
+  ParallelCSVParser(std::istream* input, char delim, int num_threads);
+  ParallelCSVParser(std::istream* input, char delim, int num_threads,
+                    size_t chunk_size);
+
+  int num_threads() const { return num_threads_; }
+
+  // Parses the input and calls 'batch_fn' for every batch. Returns after all
+  // calls have completed. Returns an INVALID_ARGUMENT status if the input is
+  // null or has already been parsed.
+  util::Status Parse(const BatchFn& batch_fn);
+
+ private:
+  std::unique_ptr<std::istream> input_;
+  const char delim_;
+  int num_threads_;
+  const size_t chunk_size_;
+};
+
 }  // namespace util
 }  // namespace morphie
 
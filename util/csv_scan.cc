@@ -0,0 +1,274 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "util/csv_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LOGLE_CSV_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const char kEscape = '\\';
+const char kNewline = '\n';
+const char kQuote = '"';
+
+// Bits at even positions.
+const uint64_t kEvenBits = 0x5555555555555555ULL;
+
+// Returns the mask of bits strictly below position 'i'.
+inline uint64_t BitsBelow(int i) { return (1ULL << i) - 1; }
+
+// Returns the mask of bits strictly above position 'i'.
+inline uint64_t BitsAbove(int i) { return i == 63 ? 0 : ~0ULL << (i + 1); }
+
+inline int CountTrailingZeros(uint64_t bits) { return __builtin_ctzll(bits); }
+
+}  // namespace
+
+namespace morphie {
+namespace util {
+namespace scan {
+
+void ScanBlockScalar(const char* block, char delim, BlockMasks* masks) {
+  *masks = BlockMasks();
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    const uint64_t bit = 1ULL << i;
+    const char c = block[i];
+    masks->delim |= (c == delim) ? bit : 0;
+    masks->newline |= (c == kNewline) ? bit : 0;
+    masks->quote |= (c == kQuote) ? bit : 0;
+    masks->escape |= (c == kEscape) ? bit : 0;
+    masks->letter_n |= (c == 'n') ? bit : 0;
+  }
+}
+
+#if defined(LOGLE_CSV_SCAN_X86) && defined(__SSE2__)
+
+namespace {
+
+// Returns a 16-bit mask of the bytes in 'chunk' equal to 'c'.
+inline uint64_t MatchSSE2(__m128i chunk, char c) {
+  return static_cast<uint16_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c))));
+}
+
+}  // namespace
+
+void ScanBlockSSE2(const char* block, char delim, BlockMasks* masks) {
+  *masks = BlockMasks();
+  for (int i = 0; i < 4; ++i) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+    const int shift = 16 * i;
+    masks->delim |= MatchSSE2(chunk, delim) << shift;
+    masks->newline |= MatchSSE2(chunk, kNewline) << shift;
+    masks->quote |= MatchSSE2(chunk, kQuote) << shift;
+    masks->escape |= MatchSSE2(chunk, kEscape) << shift;
+    masks->letter_n |= MatchSSE2(chunk, 'n') << shift;
+  }
+}
+
+#else
+
+void ScanBlockSSE2(const char* block, char delim, BlockMasks* masks) {
+  ScanBlockScalar(block, delim, masks);
+}
+
+#endif
+
+#if defined(LOGLE_CSV_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+
+namespace {
+
+// AVX2 code is compiled for this function only, so that the rest of the
+// program runs on processors without AVX2.
+__attribute__((target("avx2"))) inline uint64_t MatchAVX2(__m256i chunk,
+                                                          char c) {
+  return static_cast<uint32_t>(
+      _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c))));
+}
+
+}  // namespace
+
+__attribute__((target("avx2"))) void ScanBlockAVX2(const char* block,
+                                                   char delim,
+                                                   BlockMasks* masks) {
+  const __m256i low =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  const __m256i high =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+  masks->delim = MatchAVX2(low, delim) | MatchAVX2(high, delim) << 32;
+  masks->newline = MatchAVX2(low, kNewline) | MatchAVX2(high, kNewline) << 32;
+  masks->quote = MatchAVX2(low, kQuote) | MatchAVX2(high, kQuote) << 32;
+  masks->escape = MatchAVX2(low, kEscape) | MatchAVX2(high, kEscape) << 32;
+  masks->letter_n = MatchAVX2(low, 'n') | MatchAVX2(high, 'n') << 32;
+}
+
+BlockScanFn GetBlockScanFn() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return ScanBlockAVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return ScanBlockSSE2;
+  }
+  return ScanBlockScalar;
+}
+
+#else
+
+void ScanBlockAVX2(const char* block, char delim, BlockMasks* masks) {
+  ScanBlockScalar(block, delim, masks);
+}
+
+BlockScanFn GetBlockScanFn() { return ScanBlockScalar; }
+
+#endif
+
+// The prefix sum over exclusive or is computed by doubling the distance over
+// which bits are combined in each step.
+uint64_t PrefixXor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+// A sequence of escape characters escapes every other character in it, starting
+// with the second, and escapes the character after it if the length of the
+// sequence is odd. Adding the first bit of each sequence that starts at an odd
+// position to the escape mask makes the carry propagate to the end of the
+// sequence, which identifies sequences by the parity of their start position.
+uint64_t FindEscaped(uint64_t escape, uint64_t* prev_escaped) {
+  // An escape character that is itself escaped does not begin a sequence.
+  escape &= ~*prev_escaped;
+  const uint64_t follows_escape = escape << 1 | *prev_escaped;
+  const uint64_t odd_sequence_starts = escape & ~kEvenBits & ~follows_escape;
+  uint64_t sequences_starting_on_even_bits = odd_sequence_starts + escape;
+  *prev_escaped = sequences_starting_on_even_bits < escape ? 1 : 0;
+  const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+  return (kEvenBits ^ invert_mask) & follows_escape;
+}
+
+// The function processes one block at a time and keeps the following state for
+// the field and record that are open at the end of a block.
+//  - Whether the field contains a quote or an escape character.
+//  - Whether the record contains an invalid escape sequence.
+//  - Whether the last character of the block is escaped or in a quoted string.
+// A block that continues a quoted string from the previous block belongs to a
+// field that contains a quote, so only blocks without quotes and escapes in
+// their fields take the fast path.
+void IndexStructurals(BlockScanFn scan_fn, char delim, const char* base,
+                      const char* begin, const char* end,
+                      std::vector<uint64_t>* index) {
+  uint64_t prev_escaped = 0;
+  uint64_t prev_in_quote = 0;
+  bool field_is_escaped = false;
+  bool record_is_malformed = false;
+  BlockMasks masks;
+  for (const char* block = begin; block <= end; block += kBlockSize) {
+    scan_fn(block, delim, &masks);
+    // Ignore the bytes after 'end'.
+    const bool is_last = end - block < static_cast<ptrdiff_t>(kBlockSize);
+    const uint64_t valid = is_last ? (2ULL << (end - block)) - 1 : ~0ULL;
+    const uint64_t end_bit = is_last ? 1ULL << (end - block) : 0;
+    const uint64_t escaped = FindEscaped(masks.escape & valid, &prev_escaped);
+    const uint64_t in_quote =
+        PrefixXor(masks.quote & ~escaped & valid) ^ prev_in_quote;
+    prev_in_quote = (in_quote >> 63) ? ~0ULL : 0;
+    const uint64_t quoted_newline = masks.newline & in_quote & ~end_bit & valid;
+    const uint64_t newline = (masks.newline & ~in_quote & valid) | end_bit;
+    const uint64_t has_escape = (masks.quote | masks.escape) & valid;
+    // An escape sequence other than those listed, or the end of the input
+    // inside a quoted string.
+    const uint64_t invalid =
+        (escaped & ~(masks.letter_n | masks.quote | masks.delim |
+                     masks.escape)) |
+        (in_quote & end_bit);
+    uint64_t structurals =
+        (masks.delim & ~escaped & ~in_quote & valid) | newline;
+    if (!field_is_escaped && !record_is_malformed &&
+        (has_escape | invalid) == 0) {
+      // Most blocks contain no quotes or escapes, so only the offset and
+      // whether the entry is a newline have to be recorded.
+      for (; structurals != 0; structurals &= structurals - 1) {
+        const int i = CountTrailingZeros(structurals);
+        index->push_back(static_cast<uint64_t>(block + i - base) |
+                         ((newline >> i) & 1) << 63);
+      }
+      continue;
+    }
+    // Masks of the bits in the open field and record.
+    uint64_t in_field = ~0ULL;
+    uint64_t in_record = ~0ULL;
+    for (uint64_t entries = structurals | quoted_newline; entries != 0;
+         entries &= entries - 1) {
+      const int i = CountTrailingZeros(entries);
+      const uint64_t bit = 1ULL << i;
+      uint64_t entry = static_cast<uint64_t>(block + i - base);
+      if (quoted_newline & bit) {
+        index->push_back(entry | kQuotedNewlineFlag);
+        continue;
+      }
+      if (field_is_escaped || (has_escape & in_field & BitsBelow(i)) != 0) {
+        entry |= kEscapedFlag;
+      }
+      field_is_escaped = false;
+      in_field = BitsAbove(i);
+      if (newline & bit) {
+        entry |= kNewlineFlag;
+        if (record_is_malformed ||
+            (invalid & in_record & (BitsBelow(i) | bit)) != 0) {
+          entry |= kMalformedFlag;
+        }
+        record_is_malformed = false;
+        in_record = BitsAbove(i);
+      }
+      index->push_back(entry);
+    }
+    field_is_escaped = field_is_escaped || (has_escape & in_field) != 0;
+    record_is_malformed = record_is_malformed || (invalid & in_record) != 0;
+  }
+}
+
+const char* FindLastRecordEnd(BlockScanFn scan_fn, char delim,
+                              const char* begin, const char* end) {
+  uint64_t prev_escaped = 0;
+  uint64_t prev_in_quote = 0;
+  const char* last_newline = nullptr;
+  BlockMasks masks;
+  for (const char* block = begin; block < end; block += kBlockSize) {
+    scan_fn(block, delim, &masks);
+    const uint64_t valid = (end - block < static_cast<ptrdiff_t>(kBlockSize))
+                               ? BitsBelow(end - block)
+                               : ~0ULL;
+    const uint64_t escaped = FindEscaped(masks.escape & valid, &prev_escaped);
+    const uint64_t in_quote =
+        PrefixXor(masks.quote & ~escaped & valid) ^ prev_in_quote;
+    prev_in_quote = (in_quote >> 63) ? ~0ULL : 0;
+    const uint64_t newline = masks.newline & ~in_quote & valid;
+    if (newline != 0) {
+      last_newline = block + 63 - __builtin_clzll(newline);
+    }
+  }
+  return last_newline == nullptr ? nullptr : last_newline + 1;
+}
+
+}  // namespace scan
+}  // namespace util
+}  // namespace morphie
@@ -0,0 +1,115 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// This file defines the functions the CSV parser uses to find structural
+// characters in its input. The input is processed in blocks of 64 bytes. For
+// each block, a 64-bit mask is computed for each character of interest, with
+// bit i of the mask set if byte i of the block is that character. Quoted
+// regions and escaped characters are then derived from the masks with a
+// constant number of arithmetic operations per block, in the style of the
+// simdjson parser, so the cost of finding field boundaries does not depend on
+// how many of them there are.
+//
+// The masks are computed with SSE2 or AVX2 instructions where the processor
+// supports them, and with a portable scalar loop otherwise. The best available
+// implementation is chosen when the program runs.
+#ifndef LOGLE_UTIL_CSV_SCAN_H_
+#define LOGLE_UTIL_CSV_SCAN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace morphie {
+namespace util {
+namespace scan {
+
+// The number of bytes processed at once.
+const size_t kBlockSize = 64;
+
+// Masks of the characters in a block that are significant to the tokenizer.
+struct BlockMasks {
+  uint64_t delim;
+  uint64_t newline;
+  uint64_t quote;
+  uint64_t escape;
+  // The letter n, which can follow an escape to denote a newline.
+  uint64_t letter_n;
+};
+
+// A function that computes the masks for the 64 bytes beginning at 'block'.
+typedef void (*BlockScanFn)(const char* block, char delim, BlockMasks* masks);
+
+// Implementations of BlockScanFn. ScanBlockSSE2 and ScanBlockAVX2 require that
+// the processor supports the respective instruction set and fall back to
+// ScanBlockScalar on platforms where the instructions do not exist.
+void ScanBlockScalar(const char* block, char delim, BlockMasks* masks);
+void ScanBlockSSE2(const char* block, char delim, BlockMasks* masks);
+void ScanBlockAVX2(const char* block, char delim, BlockMasks* masks);
+
+// Returns the fastest implementation of BlockScanFn supported by the processor.
+BlockScanFn GetBlockScanFn();
+
+// Returns a mask in which bit i is the exclusive or of bits 0 through i of
+// 'bits'. If 'bits' is a mask of quote characters, the result has a bit set for
+// every opening quote and every character inside a quoted string.
+uint64_t PrefixXor(uint64_t bits);
+
+// Returns a mask of the characters in a block that are escaped, meaning they
+// are preceded by an odd number of consecutive escape characters. The argument
+// 'escape' is the mask of escape characters in the block. The argument
+// 'prev_escaped' carries state between consecutive blocks. It must be zero for
+// the first block and is updated to be 1 if the first character of the next
+// block is escaped.
+uint64_t FindEscaped(uint64_t escape, uint64_t* prev_escaped);
+
+// The index of structural characters generated by IndexStructurals consists of
+// the offsets of delimiters and newlines that separate fields. The high bits of
+// each entry are used for the flags below.
+//
+// The entry is a newline and ends a record.
+const uint64_t kNewlineFlag = 1ULL << 63;
+// The field ending at this entry contains a quote or an escape character.
+const uint64_t kEscapedFlag = 1ULL << 62;
+// The record ending at this newline contains an invalid escape sequence or a
+// quoted string that is not closed.
+const uint64_t kMalformedFlag = 1ULL << 61;
+// The entry is a newline inside a quoted string, which is part of a field. The
+// entry only serves to count the lines a record spans.
+const uint64_t kQuotedNewlineFlag = 1ULL << 60;
+const uint64_t kOffsetMask = kQuotedNewlineFlag - 1;
+
+// Appends to 'index' one entry for each delimiter and newline outside a quoted
+// string between 'begin' and 'end', one entry with kQuotedNewlineFlag for each
+// newline inside a quoted string, and an entry for 'end' itself, which must be
+// a newline and ends the last record even if it is inside a quoted string.
+// Offsets are relative to 'base'. 'begin' must be the beginning of a record.
+// Requires that the memory from 'begin' up to the end of the block containing
+// 'end' can be read.
+void IndexStructurals(BlockScanFn scan_fn, char delim, const char* base,
+                      const char* begin, const char* end,
+                      std::vector<uint64_t>* index);
+
+// Returns a pointer one past the last newline outside a quoted string between
+// 'begin', which must be the beginning of a record, and 'end', or nullptr if
+// there is no such newline. Requires that the memory from 'begin' up to the end
+// of the block containing 'end' can be read.
+const char* FindLastRecordEnd(BlockScanFn scan_fn, char delim,
+                              const char* begin, const char* end);
+
+}  // namespace scan
+}  // namespace util
+}  // namespace morphie
+
+#endif  // LOGLE_UTIL_CSV_SCAN_H_
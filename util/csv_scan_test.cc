@@ -0,0 +1,209 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "util/csv_scan.h"
+
+#include <random>
+#include <vector>
+
+#include "base/string.h"
+#include "gtest.h"
+
+namespace morphie {
+namespace util {
+namespace scan {
+namespace {
+
+// Returns a random string of length 'size' over an alphabet that makes
+// structural characters frequent.
+string RandomInput(size_t size, std::mt19937* rng) {
+  const string alphabet = "ab,,\"\"\\\\n\n";
+  std::uniform_int_distribution<size_t> dist(0, alphabet.size() - 1);
+  string input;
+  for (size_t i = 0; i < size; ++i) {
+    input.push_back(alphabet[dist(*rng)]);
+  }
+  return input;
+}
+
+// Computes the index of 'input' one character at a time.
+std::vector<uint64_t> ReferenceIndex(const string& input, char delim) {
+  std::vector<uint64_t> index;
+  bool in_quote = false;
+  bool field_is_escaped = false;
+  bool record_is_malformed = false;
+  for (size_t i = 0; i < input.size(); ++i) {
+    const char c = input[i];
+    const bool is_last = i + 1 == input.size();
+    if (c == '\n' && in_quote && !is_last) {
+      index.push_back(i | kQuotedNewlineFlag);
+    } else if (c == '\n') {
+      record_is_malformed = record_is_malformed || in_quote;
+      uint64_t entry = i | kNewlineFlag;
+      entry |= field_is_escaped ? kEscapedFlag : 0;
+      entry |= record_is_malformed ? kMalformedFlag : 0;
+      index.push_back(entry);
+      in_quote = field_is_escaped = record_is_malformed = false;
+    } else if (c == '\\') {
+      field_is_escaped = true;
+      const char next = input[i + 1];
+      if (next == 'n' || next == '"' || next == delim || next == '\\') {
+        ++i;
+      } else {
+        record_is_malformed = true;
+      }
+    } else if (c == delim && !in_quote) {
+      index.push_back(i | (field_is_escaped ? kEscapedFlag : 0));
+      field_is_escaped = false;
+    } else if (c == '"') {
+      field_is_escaped = true;
+      in_quote = !in_quote;
+    }
+  }
+  return index;
+}
+
+// Returns the index computed by IndexStructurals for 'input', which must end
+// with a newline.
+std::vector<uint64_t> VectorIndex(BlockScanFn scan_fn, const string& input,
+                                  char delim) {
+  string padded = input + string(kBlockSize, 'x');
+  std::vector<uint64_t> index;
+  IndexStructurals(scan_fn, delim, padded.data(), padded.data(),
+                   padded.data() + input.size() - 1, &index);
+  return index;
+}
+
+TEST(CSVScanTest, BlockScanFnsAgree) {
+  std::mt19937 rng(1);
+  for (int i = 0; i < 1000; ++i) {
+    const string block = RandomInput(kBlockSize, &rng);
+    BlockMasks scalar, sse2, avx2;
+    ScanBlockScalar(block.data(), ',', &scalar);
+    ScanBlockSSE2(block.data(), ',', &sse2);
+    GetBlockScanFn()(block.data(), ',', &avx2);
+    EXPECT_EQ(scalar.delim, sse2.delim);
+    EXPECT_EQ(scalar.newline, sse2.newline);
+    EXPECT_EQ(scalar.quote, sse2.quote);
+    EXPECT_EQ(scalar.escape, sse2.escape);
+    EXPECT_EQ(scalar.letter_n, sse2.letter_n);
+    EXPECT_EQ(scalar.delim, avx2.delim);
+    EXPECT_EQ(scalar.newline, avx2.newline);
+    EXPECT_EQ(scalar.quote, avx2.quote);
+    EXPECT_EQ(scalar.escape, avx2.escape);
+    EXPECT_EQ(scalar.letter_n, avx2.letter_n);
+  }
+}
+
+TEST(CSVScanTest, PrefixXor) {
+  EXPECT_EQ(0, PrefixXor(0));
+  EXPECT_EQ(~0ULL, PrefixXor(1));
+  // Two quotes enclose the characters between them.
+  EXPECT_EQ(0x0eULL, PrefixXor(0x12ULL));
+  EXPECT_EQ(1ULL << 63, PrefixXor(1ULL << 63));
+}
+
+TEST(CSVScanTest, FindEscaped) {
+  std::mt19937 rng(2);
+  std::uniform_int_distribution<uint64_t> dist;
+  for (int i = 0; i < 1000; ++i) {
+    // Make runs of escape characters likely by combining random masks.
+    const uint64_t escape1 = dist(rng) | dist(rng);
+    const uint64_t escape2 = dist(rng) | dist(rng);
+    uint64_t prev_escaped = 0;
+    const uint64_t escaped1 = FindEscaped(escape1, &prev_escaped);
+    const uint64_t escaped2 = FindEscaped(escape2, &prev_escaped);
+    // Compute the escaped characters one bit at a time.
+    uint64_t expected1 = 0, expected2 = 0;
+    bool is_escaped = false;
+    for (int j = 0; j < 128; ++j) {
+      const uint64_t escape = j < 64 ? escape1 : escape2;
+      uint64_t* expected = j < 64 ? &expected1 : &expected2;
+      const uint64_t bit = 1ULL << (j % 64);
+      if (is_escaped) {
+        *expected |= bit;
+        is_escaped = false;
+      } else {
+        is_escaped = (escape & bit) != 0;
+      }
+    }
+    EXPECT_EQ(expected1, escaped1);
+    EXPECT_EQ(expected2, escaped2);
+  }
+}
+
+TEST(CSVScanTest, IndexExamples) {
+  const std::vector<uint64_t> expected = {1, 5 | kEscapedFlag | kNewlineFlag};
+  EXPECT_EQ(expected, VectorIndex(ScanBlockScalar, "a,\",\"\n", ','));
+  // An escaped delimiter and a delimiter in a quoted string are not field
+  // boundaries.
+  EXPECT_EQ(std::vector<uint64_t>({4 | kEscapedFlag | kNewlineFlag}),
+            VectorIndex(ScanBlockScalar, "\\,\"\"\n", ','));
+  EXPECT_EQ(std::vector<uint64_t>({2 | kEscapedFlag | kMalformedFlag |
+                                   kNewlineFlag}),
+            VectorIndex(ScanBlockScalar, "a\\\n", ','));
+  // A newline in a quoted string is part of a field.
+  EXPECT_EQ(std::vector<uint64_t>({2 | kQuotedNewlineFlag, 5 | kEscapedFlag,
+                                   7 | kNewlineFlag}),
+            VectorIndex(ScanBlockScalar, "\"a\nb\",c\n", ','));
+  // The end of the input inside a quoted string ends a malformed record.
+  EXPECT_EQ(std::vector<uint64_t>({1 | kQuotedNewlineFlag,
+                                   3 | kEscapedFlag | kMalformedFlag |
+                                       kNewlineFlag}),
+            VectorIndex(ScanBlockScalar, "\"\na\n", ','));
+}
+
+// Random inputs exercise quotes, escapes and records that span blocks.
+TEST(CSVScanTest, IndexMatchesReference) {
+  std::mt19937 rng(3);
+  for (int i = 0; i < 1000; ++i) {
+    const string input = RandomInput(i, &rng) + "\n";
+    const std::vector<uint64_t> expected = ReferenceIndex(input, ',');
+    EXPECT_EQ(expected, VectorIndex(ScanBlockScalar, input, ','));
+    EXPECT_EQ(expected, VectorIndex(ScanBlockSSE2, input, ','));
+    EXPECT_EQ(expected, VectorIndex(GetBlockScanFn(), input, ','));
+  }
+}
+
+// Returns the offset one past the last newline outside a quoted string in
+// 'input', or 0 if there is none.
+size_t ReferenceRecordEnd(const string& input, char delim) {
+  const std::vector<uint64_t> index = ReferenceIndex(input + "\n", delim);
+  size_t record_end = 0;
+  for (const uint64_t entry : index) {
+    const size_t offset = entry & kOffsetMask;
+    if ((entry & kNewlineFlag) != 0 && offset < input.size()) {
+      record_end = offset + 1;
+    }
+  }
+  return record_end;
+}
+
+TEST(CSVScanTest, FindLastRecordEnd) {
+  std::mt19937 rng(4);
+  for (int i = 0; i < 1000; ++i) {
+    const string input = RandomInput(i, &rng);
+    const string padded = input + string(kBlockSize, 'x');
+    const char* record_end =
+        FindLastRecordEnd(GetBlockScanFn(), ',', padded.data(),
+                          padded.data() + input.size());
+    const size_t expected = ReferenceRecordEnd(input, ',');
+    EXPECT_EQ(expected,
+              record_end == nullptr ? 0 : record_end - padded.data());
+  }
+}
+
+}  // namespace
+}  // namespace scan
+}  // namespace util
+}  // namespace morphie
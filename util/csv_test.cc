@@ -13,7 +13,11 @@
 // the License.
 #include "util/csv.h"
 
+#include <algorithm>
+#include <mutex>
+#include <random>
 #include <sstream>
+#include <utility>
 
 #include "gtest.h"
 
@@ -27,6 +31,7 @@ TEST(CSVTest, RecordAPI) {
   EXPECT_TRUE(r.ok());
   EXPECT_EQ(r.begin(), r.end());
   EXPECT_TRUE(r.fields().empty());
+  EXPECT_EQ(0, r.size());
 }
 
 TEST(CSVTest, Initialization) {
@@ -218,6 +223,280 @@ TEST(CSVTest, EscapedInput) {
   TestParser(',', input, results);
 }
 
+// Fields can be accessed individually, in which case only the field accessed is
+// unescaped.
+TEST(CSVTest, FieldAccess) {
+  auto ss = new std::stringstream(R"(a,"b,c",\"d\",e)");
+  CSVParser parser(ss);
+  const Record& record = *parser.begin();
+  ASSERT_EQ(4, record.size());
+  EXPECT_EQ("e", record.field(3));
+  EXPECT_EQ(R"("d")", record.field(2));
+  EXPECT_EQ("a", record.field(0));
+  EXPECT_EQ("b,c", record.field(1));
+  // Accessing all fields after some have been unescaped is consistent with
+  // accessing them individually.
+  std::vector<string> fields(record.begin(), record.end());
+  EXPECT_EQ((std::vector<string>{"a", "b,c", R"("d")", "e"}), fields);
+}
+
+// A malformed line results in a record with an error status, but does not
+// affect the records after it.
+TEST(CSVTest, MalformedLine) {
+  auto ss = new std::stringstream("a,b\\n\na\\tb\nc,d\\");
+  CSVParser parser(ss);
+  auto record_it = parser.begin();
+  EXPECT_TRUE(record_it->ok());
+  EXPECT_EQ("b\n", record_it->field(1));
+  ++record_it;
+  EXPECT_FALSE(record_it->ok());
+  EXPECT_EQ(0, record_it->size());
+  ++record_it;
+  // A backslash at the end of the input is also an error.
+  EXPECT_FALSE(record_it->ok());
+  ++record_it;
+  EXPECT_EQ(parser.end(), record_it);
+}
+
+// A newline in a quoted string is part of a field and records report the line
+// and byte offset at which they begin.
+TEST(CSVTest, MultiLineRecords) {
+  auto ss = new std::stringstream("a,\"b\nc\n\",d\ne,f\n\"g\\th\"\n\"i\nj");
+  CSVParser parser(ss);
+  auto record_it = parser.begin();
+  std::vector<string> fields(record_it->begin(), record_it->end());
+  EXPECT_EQ((std::vector<string>{"a", "b\nc\n", "d"}), fields);
+  EXPECT_EQ(1, record_it->line_number());
+  EXPECT_EQ(0, record_it->byte_offset());
+  ++record_it;
+  ASSERT_EQ(2, record_it->size());
+  EXPECT_EQ(4, record_it->line_number());
+  EXPECT_EQ(11, record_it->byte_offset());
+  // Errors contain the position of the malformed record.
+  ++record_it;
+  EXPECT_FALSE(record_it->ok());
+  EXPECT_NE(string::npos,
+            record_it->status().message().find("line 5, byte offset 15"));
+  // A quoted string that is not closed at the end of the input is an error.
+  ++record_it;
+  EXPECT_FALSE(record_it->ok());
+  EXPECT_EQ(6, record_it->line_number());
+  ++record_it;
+  EXPECT_EQ(parser.end(), record_it);
+}
+
+// Lines that are longer than the block of input read at once by the parser are
+// parsed correctly.
+TEST(CSVTest, LongLines) {
+  const string long_field(3 << 20, 'x');
+  const string quoted_field = "\"" + string(1 << 20, ',') + "\"";
+  string input;
+  for (int i = 0; i < 3; ++i) {
+    input += long_field + "," + quoted_field + "\n";
+  }
+  auto ss = new std::stringstream(input);
+  CSVParser parser(ss);
+  int num_lines = 0;
+  for (const auto& record : parser) {
+    if (record.size() == 0) {
+      continue;
+    }
+    ASSERT_EQ(2, record.size());
+    EXPECT_EQ(long_field, record.field(0));
+    EXPECT_EQ(string(1 << 20, ','), record.field(1));
+    ++num_lines;
+  }
+  EXPECT_EQ(3, num_lines);
+  // A record with a quoted field that spans many lines and several blocks.
+  string lines;
+  for (int i = 0; i < (1 << 18); ++i) {
+    lines += "line\n";
+  }
+  CSVParser multi_line_parser(
+      new std::stringstream("a\n\"" + lines + "\",b\nc"));
+  auto record_it = multi_line_parser.begin();
+  ++record_it;
+  ASSERT_EQ(2, record_it->size());
+  EXPECT_EQ(lines, record_it->field(0));
+  ++record_it;
+  EXPECT_EQ(3 + (1 << 18), record_it->line_number());
+}
+
+TEST(CSVTest, ProjectedColumns) {
+  auto ss = new std::stringstream(
+      "name,\"skip\",time,count\n"
+      "a,\"x,y\",2015-06-01T00:00:00+00:00,-3\n"
+      "\"b,c\",\\n,1970-01-01T00:00:01+00:00,\"9223372036854775807\"\n"
+      "d,,2015-06-01T00:00:00+00:00\n"
+      "e,,2015-06-01,5\n"
+      "f,,2015-06-01T00:00:00+00:00,5x,extra");
+  CSVParser parser(ss);
+  auto record_it = parser.begin();
+  // Columns may be projected in any order.
+  EXPECT_TRUE(parser
+                  .Project({{"count", ColumnType::kInt64},
+                            {"name", ColumnType::kString},
+                            {"time", ColumnType::kTimestamp}})
+                  .ok());
+  ++record_it;
+  ASSERT_TRUE(record_it->ok());
+  ASSERT_EQ(3, record_it->size());
+  EXPECT_EQ(4, record_it->num_columns());
+  EXPECT_EQ(-3, record_it->int64_field(0));
+  EXPECT_EQ("a", record_it->field(1));
+  EXPECT_EQ(1433116800000000, record_it->int64_field(2));
+  // Fields in quotes are unescaped before they are converted.
+  ++record_it;
+  ASSERT_TRUE(record_it->ok());
+  EXPECT_EQ(INT64_MAX, record_it->int64_field(0));
+  EXPECT_EQ("b,c", record_it->field(1));
+  EXPECT_EQ(1000000, record_it->int64_field(2));
+  // Records with missing columns or values that cannot be converted are not
+  // ok.
+  for (size_t num_columns : {3, 4, 5}) {
+    ++record_it;
+    EXPECT_FALSE(record_it->ok());
+    EXPECT_EQ(0, record_it->size());
+    EXPECT_EQ(num_columns, record_it->num_columns());
+  }
+  ++record_it;
+  EXPECT_EQ(parser.end(), record_it);
+}
+
+TEST(CSVTest, ProjectedIntegers) {
+  const std::vector<std::pair<string, bool>> inputs = {
+      {"0", true},
+      {"+17", true},
+      {"-9223372036854775808", true},
+      {"9223372036854775808", false},
+      {"-9223372036854775809", false},
+      {"", false},
+      {"-", false},
+      {" 1", false},
+      {"1.5", false}};
+  string input = "n\n";
+  for (const auto& entry : inputs) {
+    input += "\"" + entry.first + "\"\n";
+  }
+  CSVParser parser(new std::stringstream(input));
+  auto record_it = parser.begin();
+  ASSERT_TRUE(parser.Project({{"n", ColumnType::kInt64}}).ok());
+  for (const auto& entry : inputs) {
+    ++record_it;
+    ASSERT_NE(parser.end(), record_it);
+    EXPECT_EQ(entry.second, record_it->ok()) << entry.first;
+    if (entry.second) {
+      EXPECT_EQ(std::stoll(entry.first), record_it->int64_field(0));
+    }
+  }
+}
+
+TEST(CSVTest, InvalidProjection) {
+  CSVParser null_parser(nullptr);
+  EXPECT_FALSE(null_parser.Project({{"a", ColumnType::kString}}).ok());
+  CSVParser parser(new std::stringstream("a,b,a\n1,2,3"));
+  auto record_it = parser.begin();
+  // Columns that do not exist or are not unique cannot be projected.
+  EXPECT_FALSE(parser.Project({{"c", ColumnType::kString}}).ok());
+  EXPECT_FALSE(parser.Project({{"a", ColumnType::kString}}).ok());
+  EXPECT_FALSE(parser
+                   .Project({{"b", ColumnType::kString},
+                             {"b", ColumnType::kInt64}})
+                   .ok());
+  // A failed projection leaves records unchanged.
+  ++record_it;
+  EXPECT_EQ(3, record_it->size());
+  EXPECT_FALSE(parser.Project({{"b", ColumnType::kString}}).ok());
+}
+
+// A record as a list of fields and whether it was tokenized successfully.
+using ParsedRecord = std::pair<std::vector<string>, bool>;
+
+std::vector<ParsedRecord> ParseSequentially(const string& input) {
+  std::vector<ParsedRecord> records;
+  CSVParser parser(new std::stringstream(input));
+  for (const Record& record : parser) {
+    records.emplace_back(
+        std::vector<string>(record.begin(), record.end()), record.ok());
+  }
+  return records;
+}
+
+// Parses 'input' with a ParallelCSVParser and returns the records in the order
+// of their ordinals.
+std::vector<ParsedRecord> ParseInParallel(const string& input, int num_threads,
+                                          size_t chunk_size) {
+  std::mutex mutex;
+  std::vector<std::pair<size_t, std::vector<ParsedRecord>>> batches;
+  ParallelCSVParser parser(new std::stringstream(input), ',', num_threads,
+                           chunk_size);
+  util::Status status =
+      parser.Parse([&mutex, &batches](int, const RecordBatch& batch) {
+        std::vector<ParsedRecord> records;
+        for (size_t i = 0; i < batch.size(); ++i) {
+          RecordBatch::RecordView record = batch[i];
+          records.emplace_back(
+              std::vector<string>(record.begin(), record.end()), record.ok());
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        batches.emplace_back(batch.sequence_number(), std::move(records));
+      });
+  EXPECT_TRUE(status.ok());
+  std::sort(batches.begin(), batches.end());
+  std::vector<ParsedRecord> records;
+  for (size_t i = 0; i < batches.size(); ++i) {
+    EXPECT_EQ(i, batches[i].first);
+    records.insert(records.end(), batches[i].second.begin(),
+                   batches[i].second.end());
+  }
+  return records;
+}
+
+TEST(ParallelCSVTest, Initialization) {
+  ParallelCSVParser null_parser(nullptr, ',', 2);
+  EXPECT_FALSE(null_parser.Parse([](int, const RecordBatch&) {}).ok());
+  ParallelCSVParser parser(new std::stringstream(""), ',', 0);
+  EXPECT_LE(1, parser.num_threads());
+  int num_records = 0;
+  EXPECT_TRUE(parser
+                  .Parse([&num_records](int, const RecordBatch& batch) {
+                    num_records += batch.size();
+                  })
+                  .ok());
+  // As with the CSVParser, an empty input contains one, empty record.
+  EXPECT_EQ(1, num_records);
+  // The input can only be parsed once.
+  EXPECT_FALSE(parser.Parse([](int, const RecordBatch&) {}).ok());
+}
+
+// The parallel parser produces the same records as the sequential parser for
+// any split of the input into chunks, including chunks smaller than a record.
+TEST(ParallelCSVTest, MatchesSequentialParser) {
+  const std::vector<string> fields = {
+      "a",         "bc",        "",      R"("d,e")",   R"(\"f\")",
+      R"(g\n)",    R"(h\t)",    R"("i)", "\"j\nk\""};
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<size_t> field_dist(0, fields.size() - 1);
+  std::uniform_int_distribution<int> length_dist(0, 5);
+  string input;
+  for (int i = 0; i < 500; ++i) {
+    const int num_fields = length_dist(rng);
+    for (int j = 0; j < num_fields; ++j) {
+      input += (j == 0 ? "" : ",") + fields[field_dist(rng)];
+    }
+    input += "\n";
+  }
+  const std::vector<ParsedRecord> expected = ParseSequentially(input);
+  for (size_t chunk_size : {1, 7, 64, 1000, 1 << 20}) {
+    for (int num_threads : {1, 3}) {
+      EXPECT_EQ(expected, ParseInParallel(input, num_threads, chunk_size));
+    }
+  }
+  // An input that ends with a newline has an empty last record.
+  EXPECT_EQ(ParseSequentially(input + "x\n"),
+            ParseInParallel(input + "x\n", 2, 100));
+}
+
 }  // unnamed namespace
 }  // namespace util
 }  // namespace morphie
@@ -0,0 +1,435 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "util/json_events.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "util/string_utils.h"
+
+namespace morphie {
+namespace util {
+
+namespace {
+
+// The number of bytes read from the input at a time.
+const size_t kBufferSize = 1 << 16;
+
+// Returns true if 'text' is a number in the JSON grammar.
+bool IsNumber(const string& text) {
+  size_t i = 0;
+  const size_t size = text.size();
+  auto digits = [&text, &i, size]() {
+    const size_t begin = i;
+    while (i < size && text[i] >= '0' && text[i] <= '9') {
+      ++i;
+    }
+    return i > begin;
+  };
+  if (i < size && text[i] == '-') {
+    ++i;
+  }
+  if (i < size && text[i] == '0') {
+    ++i;
+  } else if (!digits()) {
+    return false;
+  }
+  if (i < size && text[i] == '.') {
+    ++i;
+    if (!digits()) {
+      return false;
+    }
+  }
+  if (i < size && (text[i] == 'e' || text[i] == 'E')) {
+    ++i;
+    if (i < size && (text[i] == '+' || text[i] == '-')) {
+      ++i;
+    }
+    if (!digits()) {
+      return false;
+    }
+  }
+  return i == size;
+}
+
+// Appends the UTF-8 encoding of 'code_point' to 'out'.
+void AppendUTF8(uint32_t code_point, string* out) {
+  if (code_point < 0x80) {
+    out->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out->push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else if (code_point < 0x10000) {
+    out->push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else {
+    out->push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+}
+
+// The parser reads the input into a buffer and keeps a stack of the arrays and
+// objects that are open. The grammar of JSON is processed by a loop over the
+// tokens of the input, with the expected token given by the state below.
+class JSONEventParser {
+ public:
+  JSONEventParser(std::istream* input, JSONEventHandler* handler)
+      : input_(input),
+        handler_(handler),
+        buffer_(kBufferSize),
+        pos_(0),
+        end_(0),
+        offset_(0) {}
+
+  Status Parse();
+
+ private:
+  enum class State {
+    // A value, or the end of the array if the array was just opened.
+    kValue,
+    kFirstValue,
+    // A key, or the end of the object if the object was just opened.
+    kKey,
+    kFirstKey,
+    // A comma or the end of the enclosing array or object.
+    kAfterValue,
+  };
+
+  // Returns the next character without consuming it, or -1 at the end of the
+  // input.
+  int Peek() {
+    if (pos_ == end_ && !Refill()) {
+      return -1;
+    }
+    return static_cast<unsigned char>(buffer_[pos_]);
+  }
+
+  int Get() {
+    const int c = Peek();
+    if (c >= 0) {
+      ++pos_;
+    }
+    return c;
+  }
+
+  bool Refill() {
+    offset_ += end_;
+    pos_ = end_ = 0;
+    if (!*input_) {
+      return false;
+    }
+    input_->read(buffer_.data(), buffer_.size());
+    end_ = static_cast<size_t>(input_->gcount());
+    return end_ > 0;
+  }
+
+  // The offset in the input of the next character.
+  size_t Offset() const { return offset_ + pos_; }
+
+  Status Error(const string& message) const {
+    return Error(message, Offset());
+  }
+
+  Status Error(const string& message, size_t offset) const {
+    return Status(Code::INVALID_ARGUMENT,
+                  StrCat("Invalid JSON at byte offset ",
+                         std::to_string(offset), ": ", message));
+  }
+
+  // Skips whitespace and comments. Returns an error for an unterminated
+  // comment.
+  Status SkipSpace();
+  // Reads a string whose opening quote has been consumed.
+  Status ReadString(string* value);
+  Status ReadHexDigits(uint32_t* code_unit);
+  Status ReadLiteral(string* text);
+  // Reads a value and reports it if it is a string or a literal, or reports
+  // the start of an array or object and updates 'state_'.
+  Status ReadValue();
+
+  std::istream* input_;
+  JSONEventHandler* handler_;
+  std::vector<char> buffer_;
+  size_t pos_;
+  size_t end_;
+  // The offset in the input of the beginning of the buffer.
+  size_t offset_;
+  State state_;
+  // The open arrays and objects, as the characters that open them.
+  std::vector<char> containers_;
+  // Scratch space for strings.
+  string token_;
+};
+
+Status JSONEventParser::SkipSpace() {
+  while (true) {
+    const int c = Peek();
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      Get();
+      continue;
+    }
+    if (c != '/') {
+      return Status::OK;
+    }
+    Get();
+    const int kind = Get();
+    if (kind == '/') {
+      for (int d = Get(); d >= 0 && d != '\n'; d = Get()) {
+      }
+    } else if (kind == '*') {
+      int prev = 0;
+      int d = Get();
+      for (; d >= 0 && !(prev == '*' && d == '/'); d = Get()) {
+        prev = d;
+      }
+      if (d < 0) {
+        return Error("Unterminated comment.");
+      }
+    } else {
+      return Error("Unexpected '/'.");
+    }
+  }
+}
+
+Status JSONEventParser::ReadHexDigits(uint32_t* code_unit) {
+  *code_unit = 0;
+  for (int i = 0; i < 4; ++i) {
+    const int c = Get();
+    uint32_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return Error("Invalid unicode escape sequence.");
+    }
+    *code_unit = (*code_unit << 4) | digit;
+  }
+  return Status::OK;
+}
+
+Status JSONEventParser::ReadString(string* value) {
+  value->clear();
+  while (true) {
+    // Copy the characters up to the next quote or escape in one step.
+    size_t run_end = pos_;
+    while (run_end < end_ && buffer_[run_end] != '"' &&
+           buffer_[run_end] != '\\' &&
+           static_cast<unsigned char>(buffer_[run_end]) >= 0x20) {
+      ++run_end;
+    }
+    value->append(buffer_.data() + pos_, run_end - pos_);
+    pos_ = run_end;
+    const int c = Get();
+    if (c == '"') {
+      return Status::OK;
+    }
+    if (c < 0) {
+      return Error("Unterminated string.");
+    }
+    if (c != '\\') {
+      if (c < 0x20) {
+        return Error("Control character in string.");
+      }
+      value->push_back(static_cast<char>(c));
+      continue;
+    }
+    const int escaped = Get();
+    switch (escaped) {
+      case '"':
+      case '\\':
+      case '/':
+        value->push_back(static_cast<char>(escaped));
+        break;
+      case 'b':
+        value->push_back('\b');
+        break;
+      case 'f':
+        value->push_back('\f');
+        break;
+      case 'n':
+        value->push_back('\n');
+        break;
+      case 'r':
+        value->push_back('\r');
+        break;
+      case 't':
+        value->push_back('\t');
+        break;
+      case 'u': {
+        uint32_t code_point;
+        Status status = ReadHexDigits(&code_point);
+        if (!status.ok()) {
+          return status;
+        }
+        // A high surrogate is combined with the low surrogate that follows.
+        if (code_point >= 0xd800 && code_point < 0xdc00) {
+          uint32_t low;
+          if (Get() != '\\' || Get() != 'u') {
+            return Error("Unpaired surrogate in unicode escape sequence.");
+          }
+          status = ReadHexDigits(&low);
+          if (!status.ok()) {
+            return status;
+          }
+          if (low < 0xdc00 || low >= 0xe000) {
+            return Error("Unpaired surrogate in unicode escape sequence.");
+          }
+          code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+        }
+        AppendUTF8(code_point, value);
+        break;
+      }
+      default:
+        return Error("Invalid escape sequence.");
+    }
+  }
+}
+
+Status JSONEventParser::ReadLiteral(string* text) {
+  text->clear();
+  const size_t begin = Offset();
+  for (int c = Peek(); (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+                       (c >= 'A' && c <= 'Z') || c == '-' || c == '+' ||
+                       c == '.';
+       c = Peek()) {
+    text->push_back(static_cast<char>(Get()));
+  }
+  if (*text == "true" || *text == "false" || *text == "null" ||
+      IsNumber(*text)) {
+    return Status::OK;
+  }
+  return Error(text->empty() ? "Expected a value."
+                             : StrCat("Invalid literal ", *text, "."),
+               begin);
+}
+
+Status JSONEventParser::ReadValue() {
+  const int c = Peek();
+  if (c == '{') {
+    Get();
+    containers_.push_back('{');
+    state_ = State::kFirstKey;
+    return handler_->StartObject();
+  }
+  if (c == '[') {
+    Get();
+    containers_.push_back('[');
+    state_ = State::kFirstValue;
+    return handler_->StartArray();
+  }
+  state_ = State::kAfterValue;
+  Status status;
+  if (c == '"') {
+    Get();
+    status = ReadString(&token_);
+    return status.ok() ? handler_->String(token_) : status;
+  }
+  status = ReadLiteral(&token_);
+  return status.ok() ? handler_->Literal(token_) : status;
+}
+
+Status JSONEventParser::Parse() {
+  state_ = State::kValue;
+  Status status;
+  do {
+    status = SkipSpace();
+    if (!status.ok()) {
+      return status;
+    }
+    const int c = Peek();
+    switch (state_) {
+      case State::kFirstValue:
+        if (c == ']') {
+          Get();
+          containers_.pop_back();
+          state_ = State::kAfterValue;
+          status = handler_->EndArray();
+          break;
+        }
+        status = ReadValue();
+        break;
+      case State::kValue:
+        status = ReadValue();
+        break;
+      case State::kFirstKey:
+        if (c == '}') {
+          Get();
+          containers_.pop_back();
+          state_ = State::kAfterValue;
+          status = handler_->EndObject();
+          break;
+        }
+      // Fall through.
+      case State::kKey:
+        if (Get() != '"') {
+          return Error("Expected a key.");
+        }
+        status = ReadString(&token_);
+        if (!status.ok()) {
+          return status;
+        }
+        status = SkipSpace();
+        if (!status.ok()) {
+          return status;
+        }
+        if (Get() != ':') {
+          return Error("Expected ':' after a key.");
+        }
+        state_ = State::kValue;
+        status = handler_->Key(token_);
+        break;
+      case State::kAfterValue:
+        Get();
+        if (c == ',') {
+          state_ = containers_.back() == '{' ? State::kKey : State::kValue;
+        } else if (c == '}' && containers_.back() == '{') {
+          containers_.pop_back();
+          status = handler_->EndObject();
+        } else if (c == ']' && containers_.back() == '[') {
+          containers_.pop_back();
+          status = handler_->EndArray();
+        } else {
+          return Error("Expected ',' or the end of an array or object.");
+        }
+        break;
+    }
+    if (!status.ok()) {
+      return status;
+    }
+  } while (!containers_.empty() || state_ != State::kAfterValue);
+  status = SkipSpace();
+  if (!status.ok()) {
+    return status;
+  }
+  if (Peek() >= 0) {
+    return Error("Unexpected data after the end of the document.");
+  }
+  return Status::OK;
+}
+
+}  // namespace
+
+Status ParseJSONEvents(std::istream* input, JSONEventHandler* handler) {
+  JSONEventParser parser(input, handler);
+  return parser.Parse();
+}
+
+}  // namespace util
+}  // namespace morphie
@@ -0,0 +1,71 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// This file defines an event-driven parser for JSON. Unlike a parser that
+// builds a Json::Value, this parser does not keep the document in memory. It
+// reports the structure of the document to a handler as it reads the input, so
+// the memory used is proportional to the depth of nesting of the document and
+// the length of its longest string.
+//
+// Example. The document
+//   {"a": [1, "b"], "c": null}
+// is reported as the sequence of calls
+//   StartObject(), Key("a"), StartArray(), Literal("1"), String("b"),
+//   EndArray(), Key("c"), Literal("null"), EndObject().
+//
+// The parser accepts C and C++ style comments outside of strings, as the
+// Json::Reader used elsewhere does.
+#ifndef LOGLE_UTIL_JSON_EVENTS_H_
+#define LOGLE_UTIL_JSON_EVENTS_H_
+
+#include <istream>
+
+#include "base/string.h"
+#include "util/status.h"
+
+namespace morphie {
+namespace util {
+
+// A JSONEventHandler receives the events of a document read by
+// ParseJSONEvents. Parsing stops at the first event for which the handler
+// returns a status other than OK.
+class JSONEventHandler {
+ public:
+  virtual ~JSONEventHandler() {}
+
+  virtual Status StartObject() = 0;
+  virtual Status EndObject() = 0;
+  virtual Status StartArray() = 0;
+  virtual Status EndArray() = 0;
+  // Called with the unescaped key of a member of an object before the events
+  // for the value of the member.
+  virtual Status Key(const string& key) = 0;
+  // Called with the unescaped contents of a string value.
+  virtual Status String(const string& value) = 0;
+  // Called for numbers and the literals true, false and null, with the text
+  // that represents them in the input.
+  virtual Status Literal(const string& text) = 0;
+};
+
+// Reads a single JSON value from 'input' and reports it to 'handler'. Returns
+//  - INVALID_ARGUMENT if the input is not a JSON value followed only by
+//    whitespace and comments, with the byte offset of the error in the message.
+//  - the status returned by the handler if it is not OK.
+//  - OK otherwise.
+Status ParseJSONEvents(std::istream* input, JSONEventHandler* handler);
+
+}  // namespace util
+}  // namespace morphie
+
+#endif  // LOGLE_UTIL_JSON_EVENTS_H_
@@ -0,0 +1,132 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+#include "util/json_events.h"
+
+#include <sstream>
+
+#include "gtest.h"
+#include "util/string_utils.h"
+
+namespace morphie {
+namespace util {
+namespace {
+
+// Records the events of a document as a string.
+class RecordingHandler : public JSONEventHandler {
+ public:
+  Status StartObject() override { return Record("{"); }
+  Status EndObject() override { return Record("}"); }
+  Status StartArray() override { return Record("["); }
+  Status EndArray() override { return Record("]"); }
+  Status Key(const string& key) override { return Record("K:" + key); }
+  Status String(const string& value) override { return Record("S:" + value); }
+  Status Literal(const string& text) override { return Record("L:" + text); }
+
+  string events() const { return events_; }
+
+ private:
+  Status Record(const string& event) {
+    StrAppend(&events_, event, " ");
+    return Status::OK;
+  }
+
+  string events_;
+};
+
+// Returns the events of 'input' or the error message if parsing fails.
+string Events(const string& input) {
+  std::istringstream stream(input);
+  RecordingHandler handler;
+  Status status = ParseJSONEvents(&stream, &handler);
+  return status.ok() ? handler.events() : status.message();
+}
+
+bool IsValid(const string& input) {
+  std::istringstream stream(input);
+  RecordingHandler handler;
+  return ParseJSONEvents(&stream, &handler).ok();
+}
+
+TEST(JSONEventsTest, ReportsStructure) {
+  EXPECT_EQ("{ K:a [ L:1 S:b ] K:c L:null } ",
+            Events(R"({"a": [1, "b"], "c": null})"));
+  EXPECT_EQ("{ } ", Events("{}"));
+  EXPECT_EQ("[ [ ] { } ] ", Events(" [[], {}] "));
+  EXPECT_EQ("L:-1.5e+3 ", Events("-1.5e+3"));
+  EXPECT_EQ("L:true ", Events("true"));
+}
+
+TEST(JSONEventsTest, UnescapesStrings) {
+  EXPECT_EQ("S:a\"b\\c/d\n ", Events(R"("a\"b\\c\/d\n")"));
+  EXPECT_EQ("S:\xc3\xa9\xe2\x82\xac ", Events(R"("\u00e9\u20ac")"));
+  // A surrogate pair encodes a character outside the basic multilingual plane.
+  EXPECT_EQ("S:\xf0\x9f\x98\x80 ", Events(R"("\ud83d\ude00")"));
+}
+
+TEST(JSONEventsTest, SkipsComments) {
+  EXPECT_EQ("{ K:a L:1 } ", Events("// Comment.\n{\"a\": /* 2 */ 1}\n"));
+}
+
+TEST(JSONEventsTest, RejectsInvalidInput) {
+  EXPECT_FALSE(IsValid(""));
+  EXPECT_FALSE(IsValid("{"));
+  EXPECT_FALSE(IsValid("{\"a\" 1}"));
+  EXPECT_FALSE(IsValid("{\"a\": 1,}"));
+  EXPECT_FALSE(IsValid("[1 2]"));
+  EXPECT_FALSE(IsValid("[1]]"));
+  EXPECT_FALSE(IsValid("{1: 2}"));
+  EXPECT_FALSE(IsValid("\"abc"));
+  EXPECT_FALSE(IsValid("\"\\x\""));
+  EXPECT_FALSE(IsValid("\"\\ud83d\""));
+  EXPECT_FALSE(IsValid("01"));
+  EXPECT_FALSE(IsValid("nul"));
+  EXPECT_FALSE(IsValid("/* a"));
+  EXPECT_NE(string::npos, Events("[1, x]").find("byte offset 4"));
+}
+
+// Strings and documents longer than the buffer of the parser are read across
+// refills of the buffer.
+TEST(JSONEventsTest, LongInput) {
+  const string long_string(200000, 'x');
+  EXPECT_EQ(StrCat("[ S:", long_string, " ] "),
+            Events(StrCat("[\"", long_string, "\"]")));
+  string input = "[";
+  string expected = "[ ";
+  for (int i = 0; i < 50000; ++i) {
+    StrAppend(&input, i == 0 ? "" : ",", std::to_string(i));
+    StrAppend(&expected, "L:", std::to_string(i), " ");
+  }
+  StrAppend(&input, "]");
+  StrAppend(&expected, "] ");
+  EXPECT_EQ(expected, Events(input));
+}
+
+// The handler can stop parsing.
+TEST(JSONEventsTest, StopsAtHandlerError) {
+  class StopAtArray : public RecordingHandler {
+   public:
+    Status StartArray() override {
+      return Status(Code::INVALID_ARGUMENT, "No arrays.");
+    }
+  };
+  std::istringstream stream("{\"a\": [1]}");
+  StopAtArray handler;
+  Status status = ParseJSONEvents(&stream, &handler);
+  EXPECT_EQ("No arrays.", status.message());
+  EXPECT_EQ("{ K:a ", handler.events());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace morphie
@@ -0,0 +1,40 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "util/parallel.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace morphie {
+namespace util {
+
+void ParallelForChunks(size_t size, int num_threads, const ChunkFn& fn) {
+  const size_t num_chunks = num_threads > 1 ? num_threads : 1;
+  auto chunk_begin = [size, num_chunks](size_t chunk) {
+    return size / num_chunks * chunk + std::min(chunk, size % num_chunks);
+  };
+  std::vector<std::thread> workers;
+  for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+    workers.emplace_back(fn, chunk, chunk_begin(chunk), chunk_begin(chunk + 1));
+  }
+  fn(0, 0, chunk_begin(1));
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+}  // namespace util
+}  // namespace morphie
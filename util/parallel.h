@@ -0,0 +1,49 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+
+// Utilities for splitting work on a range of indices across threads.
+#ifndef LOGLE_UTIL_PARALLEL_H_
+#define LOGLE_UTIL_PARALLEL_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace morphie {
+namespace util {
+
+// A function that processes the indices in [begin, end), which is the chunk
+// with index 'chunk' of a range.
+using ChunkFn = std::function<void(int chunk, size_t begin, size_t end)>;
+
+// Splits [0, size) into max(num_threads, 1) consecutive chunks whose sizes
+// differ by at most one and calls 'fn' once for each chunk, with the chunks
+// numbered in order. The first chunk is processed on the calling thread and
+// every other chunk on a thread of its own. Returns after all chunks have been
+// processed. Chunks may be empty if 'size' is smaller than 'num_threads'.
+//
+// Example. Summing up a vector with partial sums in chunk order.
+//   std::vector<int64_t> sums(num_threads);
+//   ParallelForChunks(values.size(), num_threads,
+//                     [&](int chunk, size_t begin, size_t end) {
+//                       for (size_t i = begin; i < end; ++i) {
+//                         sums[chunk] += values[i];
+//                       }
+//                     });
+void ParallelForChunks(size_t size, int num_threads, const ChunkFn& fn);
+
+}  // namespace util
+}  // namespace morphie
+
+#endif  // LOGLE_UTIL_PARALLEL_H_
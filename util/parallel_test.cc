@@ -0,0 +1,59 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "util/parallel.h"
+
+#include <utility>
+#include <vector>
+
+#include "gtest.h"
+
+namespace morphie {
+namespace util {
+namespace {
+
+// Returns the chunks of [0, size) as (begin, end) pairs in chunk order.
+std::vector<std::pair<size_t, size_t>> Chunks(size_t size, int num_threads) {
+  std::vector<std::pair<size_t, size_t>> chunks(
+      num_threads > 1 ? num_threads : 1);
+  ParallelForChunks(size, num_threads,
+                    [&chunks](int chunk, size_t begin, size_t end) {
+                      chunks[chunk] = {begin, end};
+                    });
+  return chunks;
+}
+
+TEST(ParallelTest, SplitsRangeIntoConsecutiveChunks) {
+  using Chunk = std::pair<size_t, size_t>;
+  EXPECT_EQ(std::vector<Chunk>({{0, 10}}), Chunks(10, 1));
+  EXPECT_EQ(std::vector<Chunk>({{0, 10}}), Chunks(10, 0));
+  EXPECT_EQ(std::vector<Chunk>({{0, 4}, {4, 7}, {7, 10}}), Chunks(10, 3));
+  EXPECT_EQ(std::vector<Chunk>({{0, 1}, {1, 2}, {2, 2}, {2, 2}}),
+            Chunks(2, 4));
+  EXPECT_EQ(std::vector<Chunk>({{0, 0}, {0, 0}}), Chunks(0, 2));
+}
+
+TEST(ParallelTest, ProcessesEveryIndexOnce) {
+  std::vector<int> counts(1000, 0);
+  ParallelForChunks(counts.size(), 7, [&counts](int, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ++counts[i];
+    }
+  });
+  EXPECT_EQ(std::vector<int>(1000, 1), counts);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace morphie
@@ -0,0 +1,96 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// A StringPiece is a pointer to a sequence of characters together with a
+// length. It does not own the characters it points to, so the memory it refers
+// to must outlive the StringPiece. The class is a stand-in for std::string_view,
+// which is not available in C++11, and only supports the operations required
+// by the rest of this code base.
+//
+// Example.
+//   string data = "abc,def";
+//   StringPiece piece(data.data() + 4, 3);
+//   EXPECT_EQ("def", piece);
+//   string copy = piece.ToString();
+#ifndef LOGLE_UTIL_STRING_PIECE_H_
+#define LOGLE_UTIL_STRING_PIECE_H_
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+
+#include "base/string.h"
+
+namespace morphie {
+namespace util {
+
+class StringPiece {
+ public:
+  StringPiece() : data_(nullptr), size_(0) {}
+  // Implicit conversions from C strings and strings are intentional, so that a
+  // StringPiece can be compared with and passed in place of either.
+  StringPiece(const char* str)  // NOLINT
+      : data_(str), size_(str == nullptr ? 0 : std::strlen(str)) {}
+  StringPiece(const string& str)  // NOLINT
+      : data_(str.data()), size_(str.size()) {}
+  StringPiece(const char* data, size_t size) : data_(data), size_(size) {}
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const char* begin() const { return data_; }
+  const char* end() const { return data_ + size_; }
+  char operator[](size_t i) const { return data_[i]; }
+
+  // Returns a copy of the characters referred to by this StringPiece.
+  string ToString() const { return string(data_, size_); }
+  explicit operator string() const { return ToString(); }
+
+  // Returns a negative number, zero or a positive number if this StringPiece is
+  // respectively less than, equal to or greater than 'that' in lexicographic
+  // order.
+  int compare(StringPiece that) const {
+    size_t min_size = size_ < that.size_ ? size_ : that.size_;
+    int result = min_size == 0 ? 0 : std::memcmp(data_, that.data_, min_size);
+    if (result != 0) {
+      return result;
+    }
+    return size_ < that.size_ ? -1 : (size_ > that.size_ ? 1 : 0);
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+inline bool operator==(StringPiece x, StringPiece y) {
+  return x.size() == y.size() &&
+         (x.size() == 0 || std::memcmp(x.data(), y.data(), x.size()) == 0);
+}
+
+inline bool operator!=(StringPiece x, StringPiece y) { return !(x == y); }
+
+inline bool operator<(StringPiece x, StringPiece y) {
+  return x.compare(y) < 0;
+}
+
+inline std::ostream& operator<<(std::ostream& out, StringPiece piece) {
+  return out.write(piece.data(), piece.size());
+}
+
+}  // namespace util
+}  // namespace morphie
+
+#endif  // LOGLE_UTIL_STRING_PIECE_H_